@@ -0,0 +1,723 @@
+#include <algorithm>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBTypes.h"
+
+const double LS_BIT_RATE = 1.5e6;
+const double FS_BIT_RATE = 12e6;
+
+USBBusGenerator::USBBusGenerator( USBSpeed busSpeed, U32 sampleRate, U32 seed )
+    : mBusSpeed( busSpeed ), mSampleRate( sampleRate ), mRandom( seed ), mTime( 0 ), mNextFrame( 0 ), mFrameNumber( 0 ), mNumPackets( 0 )
+{
+    // the bus starts idle
+    mStates[ 0 ] = mInitialStates[ 0 ] = busSpeed == FULL_SPEED ? BS_High : BS_Low;
+    mStates[ 1 ] = mInitialStates[ 1 ] = busSpeed == FULL_SPEED ? BS_Low : BS_High;
+}
+
+U32 USBBusGenerator::Random()
+{
+    mRandom = mRandom * 1664525 + 1013904223;
+    return mRandom >> 8;
+}
+
+void USBBusGenerator::SetLines( USBBitState dp, USBBitState dm )
+{
+    const USBBitState states[ 2 ] = { dp, dm };
+    for( int lc = 0; lc < 2; ++lc )
+    {
+        if( mStates[ lc ] != states[ lc ] )
+        {
+            mStates[ lc ] = states[ lc ];
+            mEdges[ lc ].push_back( U64( mTime + 0.5 ) );
+        }
+    }
+}
+
+void USBBusGenerator::SetJ()
+{
+    if( mBusSpeed == FULL_SPEED )
+        SetLines( BS_High, BS_Low );
+    else
+        SetLines( BS_Low, BS_High );
+}
+
+void USBBusGenerator::SetSE0()
+{
+    SetLines( BS_Low, BS_Low );
+}
+
+void USBBusGenerator::ToggleLines()
+{
+    SetLines( InvertBitState( mStates[ 0 ] ), InvertBitState( mStates[ 1 ] ) );
+}
+
+void USBBusGenerator::Advance( double bits, USBSpeed speed )
+{
+    mTime += bits * mSampleRate / ( speed == FULL_SPEED ? FS_BIT_RATE : LS_BIT_RATE );
+}
+
+void USBBusGenerator::Idle( double bits )
+{
+    SetJ();
+    Advance( bits, mBusSpeed );
+}
+
+void USBBusGenerator::Reset()
+{
+    SetSE0();
+    mTime += mSampleRate * 0.015;
+    SetJ();
+    mTime += mSampleRate * 0.001;
+    mNextFrame = mTime;
+}
+
+void USBBusGenerator::KeepFrames()
+{
+    while( mTime >= mNextFrame )
+    {
+        if( mBusSpeed == FULL_SPEED )
+        {
+            const U16 frame = mFrameNumber++ & 0x7ff;
+            const U16 field = U16( frame | USBPacket::CalcCRC5( frame ) << 11 );
+            const U8 bytes[] = { 0x80, PID_SOF, U8( field ), U8( field >> 8 ) };
+            Packet( std::vector<U8>( bytes, bytes + sizeof( bytes ) ), FULL_SPEED, true );
+        }
+        else
+        {
+            SetSE0();
+            Advance( 2, LOW_SPEED );
+            Idle( 4 );
+        }
+
+        mNextFrame += mSampleRate * 0.001;
+    }
+}
+
+void USBBusGenerator::Bits( const std::vector<U8>& bytes, USBSpeed speed )
+{
+    // NRZI with bit stuffing
+    int ones = 0;
+    for( size_t bc = 0; bc < bytes.size(); ++bc )
+    {
+        U8 byte = bytes[ bc ];
+        for( int bitc = 0; bitc < 8; ++bitc, byte >>= 1 )
+        {
+            if( byte & 1 )
+            {
+                ++ones;
+            }
+            else
+            {
+                ToggleLines();
+                ones = 0;
+            }
+
+            Advance( 1, speed );
+
+            if( ones == 6 )
+            {
+                ToggleLines();
+                Advance( 1, speed );
+                ones = 0;
+            }
+        }
+    }
+}
+
+void USBBusGenerator::Packet( const std::vector<U8>& bytes, USBSpeed speed, bool fromHost )
+{
+    SetJ();
+
+    // the hub only passes low speed packets from the host after a PRE, which has no EOP
+    if( speed == LOW_SPEED && mBusSpeed == FULL_SPEED && fromHost )
+    {
+        const U8 pre[] = { 0x80, PID_PRE };
+        Bits( std::vector<U8>( pre, pre + sizeof( pre ) ), FULL_SPEED );
+        Idle( 4 );
+    }
+
+    Bits( bytes, speed );
+
+    SetSE0();
+    Advance( 2, speed );
+    SetJ();
+    Advance( 3, speed );
+
+    ++mNumPackets;
+}
+
+void USBBusGenerator::Token( USB_PID pid, int addr, int endp, USBSpeed speed )
+{
+    const U16 addrEndp = U16( addr | endp << 7 );
+    const U16 field = U16( addrEndp | USBPacket::CalcCRC5( addrEndp ) << 11 );
+    const U8 bytes[] = { 0x80, U8( pid ), U8( field ), U8( field >> 8 ) };
+    Packet( std::vector<U8>( bytes, bytes + sizeof( bytes ) ), speed, true );
+}
+
+void USBBusGenerator::Data( USB_PID pid, const std::vector<U8>& payload, USBSpeed speed, bool fromHost, bool badCrc )
+{
+    U16 crc = 0xffff;
+    for( size_t bc = 0; bc < payload.size(); ++bc )
+    {
+        for( U8 bit = 1; bit != 0; bit <<= 1 )
+        {
+            const bool xorBit = ( ( payload[ bc ] & bit ) != 0 ) != ( ( crc & 1 ) != 0 );
+            crc >>= 1;
+            if( xorBit )
+                crc ^= 0xA001;
+        }
+    }
+
+    crc = ~crc;
+    if( badCrc )
+        crc ^= 0x0100;
+
+    std::vector<U8> bytes;
+    bytes.reserve( payload.size() + 4 );
+    bytes.push_back( 0x80 );
+    bytes.push_back( U8( pid ) );
+    bytes.insert( bytes.end(), payload.begin(), payload.end() );
+    bytes.push_back( U8( crc ) );
+    bytes.push_back( U8( crc >> 8 ) );
+
+    Packet( bytes, speed, fromHost );
+}
+
+void USBBusGenerator::Handshake( USB_PID pid, USBSpeed speed, bool fromHost )
+{
+    const U8 bytes[] = { 0x80, U8( pid ) };
+    Packet( std::vector<U8>( bytes, bytes + sizeof( bytes ) ), speed, fromHost );
+}
+
+void USBBusGenerator::Glitch( int line, U32 samples )
+{
+    SetJ();
+    SetLines( line == 0 ? InvertBitState( mStates[ 0 ] ) : mStates[ 0 ], line == 1 ? InvertBitState( mStates[ 1 ] ) : mStates[ 1 ] );
+    mTime += samples;
+    Idle( 4 );
+}
+
+//
+// the corpora
+//
+
+namespace
+{
+    const U8 DeviceDescriptor[] = { 0x12, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 0x08, 0x34, 0x12,
+                                    0x78, 0x56, 0x00, 0x01, 0x01, 0x02, 0x00, 0x01 };
+
+    const U8 ConfigDescriptor[] = { 0x09, 0x02, 0x22, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32, // configuration
+                                    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x02, 0x00, // interface
+                                    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x32, 0x00, // HID
+                                    0x07, 0x05, 0x81, 0x03, 0x04, 0x00, 0x0A };           // endpoint
+
+    // a three button mouse
+    const U8 ReportDescriptor[] = { 0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19,
+                                    0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+                                    0x95, 0x01, 0x75, 0x05, 0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15,
+                                    0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06, 0xC0, 0xC0 };
+
+    // a gamepad with report ID 1: 8 buttons, X and Y, a hat switch, and a 32 bit dial which is not byte aligned; the
+    // report takes 11 bytes, so the dial is split between the two packets of an 8 byte endpoint
+    const U8 GamepadReportDescriptor[] = { 0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01, 0x05, 0x09, 0x19, 0x01, 0x29, 0x08, 0x15,
+                                           0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31,
+                                           0x16, 0x00, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x81, 0x02, 0x09, 0x39, 0x15,
+                                           0x00, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x09, 0x37, 0x17, 0x00, 0x00, 0x00,
+                                           0x80, 0x27, 0xFF, 0xFF, 0xFF, 0x7F, 0x75, 0x20, 0x95, 0x01, 0x81, 0x02, 0x75, 0x04, 0x95,
+                                           0x01, 0x81, 0x03, 0xC0 };
+
+    const U8 LangIds[] = { 0x04, 0x03, 0x09, 0x04 };
+
+    const char* const Strings[] = { "Saleae", "Benchmark Mouse" };
+
+    // the mouse again, with the usage page pushed eight deep first
+    const U8 PushReportDescriptor[] = { 0x05, 0x01, 0xA4, 0x05, 0x09, 0xA4, 0x05, 0x0C, 0xA4, 0x05, 0x01, 0xA4, 0x05, 0x09, 0xA4,
+                                        0x05, 0x0C, 0xA4, 0x05, 0x01, 0xA4, 0x05, 0x09, 0xA4, 0x05, 0x0C, 0xB4, 0xB4, 0xB4, 0xB4,
+                                        0xB4, 0xB4, 0xB4, 0xB4, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19,
+                                        0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01,
+                                        0x75, 0x05, 0x81, 0x01, 0xC0, 0xC0 };
+
+    struct Device
+    {
+        USBSpeed speed;
+        int maxPacket;
+        bool dataToggle; // of the interrupt endpoint
+    };
+
+    std::vector<U8> Bytes( const U8* pBytes, size_t size )
+    {
+        return std::vector<U8>( pBytes, pBytes + size );
+    }
+
+    std::vector<U8> StringDescriptor( const char* str )
+    {
+        std::vector<U8> desc( 2 );
+        for( ; *str != 0; ++str )
+        {
+            desc.push_back( U8( *str ) );
+            desc.push_back( 0 );
+        }
+
+        desc[ 0 ] = U8( desc.size() );
+        desc[ 1 ] = 0x03;
+        return desc;
+    }
+
+    std::vector<U8> RandomBytes( USBBusGenerator& gen, size_t size )
+    {
+        std::vector<U8> bytes( size );
+        for( size_t bc = 0; bc < size; ++bc )
+            bytes[ bc ] = U8( gen.Random() );
+
+        return bytes;
+    }
+
+    // a setup, the IN stages of the data and the status stage
+    void ControlRead( USBBusGenerator& gen, const Device& dev, int addr, const U8 setup[ 8 ], const std::vector<U8>& data )
+    {
+        const U16 wLength = U16( setup[ 6 ] | setup[ 7 ] << 8 );
+        const size_t length = data.size() < wLength ? data.size() : wLength;
+
+        gen.KeepFrames();
+        gen.Token( PID_SETUP, addr, 0, dev.speed );
+        gen.Data( PID_DATA0, Bytes( setup, 8 ), dev.speed, true );
+        gen.Handshake( PID_ACK, dev.speed, false );
+
+        bool data1 = true;
+        for( size_t offset = 0;; offset += dev.maxPacket )
+        {
+            const size_t chunk = length - offset < size_t( dev.maxPacket ) ? length - offset : dev.maxPacket;
+
+            gen.KeepFrames();
+            gen.Token( PID_IN, addr, 0, dev.speed );
+            gen.Data( data1 ? PID_DATA1 : PID_DATA0, std::vector<U8>( data.begin() + offset, data.begin() + offset + chunk ), dev.speed,
+                      false );
+            gen.Handshake( PID_ACK, dev.speed, true );
+            data1 = !data1;
+
+            if( chunk < size_t( dev.maxPacket ) || offset + chunk == length )
+                break;
+        }
+
+        gen.KeepFrames();
+        gen.Token( PID_OUT, addr, 0, dev.speed );
+        gen.Data( PID_DATA1, std::vector<U8>(), dev.speed, true );
+        gen.Handshake( PID_ACK, dev.speed, false );
+    }
+
+    // a setup and the status stage
+    void ControlWrite( USBBusGenerator& gen, const Device& dev, int addr, const U8 setup[ 8 ] )
+    {
+        gen.KeepFrames();
+        gen.Token( PID_SETUP, addr, 0, dev.speed );
+        gen.Data( PID_DATA0, Bytes( setup, 8 ), dev.speed, true );
+        gen.Handshake( PID_ACK, dev.speed, false );
+
+        gen.KeepFrames();
+        gen.Token( PID_IN, addr, 0, dev.speed );
+        gen.Data( PID_DATA1, std::vector<U8>(), dev.speed, false );
+        gen.Handshake( PID_ACK, dev.speed, true );
+    }
+
+    void GetDescriptor( USBBusGenerator& gen, const Device& dev, int addr, U8 type, U8 index, U16 length,
+                        const std::vector<U8>& desc )
+    {
+        // the strings in English
+        const U16 langId = index != 0 && type == 0x03 ? 0x0409 : 0;
+        const U8 setup[ 8 ] = { 0x80, 0x06, index, type, U8( langId ), U8( langId >> 8 ), U8( length ), U8( length >> 8 ) };
+        ControlRead( gen, dev, addr, setup, desc );
+    }
+
+    // polls the interrupt endpoint, which has a report one time in reportEvery
+    void PollInterrupt( USBBusGenerator& gen, Device& dev, int addr, U32 reportEvery )
+    {
+        gen.KeepFrames();
+        gen.Token( PID_IN, addr, 1, dev.speed );
+
+        if( gen.Random() % reportEvery != 0 )
+        {
+            gen.Handshake( PID_NAK, dev.speed, false );
+            return;
+        }
+
+        gen.Data( dev.dataToggle ? PID_DATA1 : PID_DATA0, RandomBytes( gen, 3 ), dev.speed, false );
+        gen.Handshake( PID_ACK, dev.speed, true );
+        dev.dataToggle = !dev.dataToggle;
+    }
+
+    void Enumerate( USBBusGenerator& gen, Device& dev, int addr, const std::vector<U8>& configDesc, const std::vector<U8>& reportDesc )
+    {
+        std::vector<U8> deviceDesc = Bytes( DeviceDescriptor, sizeof( DeviceDescriptor ) );
+        deviceDesc[ 7 ] = U8( dev.maxPacket );
+
+        GetDescriptor( gen, dev, 0, 0x01, 0, 64, deviceDesc );
+
+        const U8 setAddress[ 8 ] = { 0x00, 0x05, U8( addr ), 0x00, 0x00, 0x00, 0x00, 0x00 };
+        ControlWrite( gen, dev, 0, setAddress );
+
+        GetDescriptor( gen, dev, addr, 0x01, 0, 18, deviceDesc );
+        GetDescriptor( gen, dev, addr, 0x02, 0, 9, configDesc );
+        GetDescriptor( gen, dev, addr, 0x02, 0, 0xff, configDesc );
+        GetDescriptor( gen, dev, addr, 0x03, 0, 0xff, Bytes( LangIds, sizeof( LangIds ) ) );
+        GetDescriptor( gen, dev, addr, 0x03, 1, 0xff, StringDescriptor( Strings[ 0 ] ) );
+        GetDescriptor( gen, dev, addr, 0x03, 2, 0xff, StringDescriptor( Strings[ 1 ] ) );
+
+        const U8 setConfiguration[ 8 ] = { 0x00, 0x09, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+        ControlWrite( gen, dev, addr, setConfiguration );
+
+        const U8 setIdle[ 8 ] = { 0x21, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+        ControlWrite( gen, dev, addr, setIdle );
+
+        const U8 getReport[ 8 ] = { 0x81, 0x06, 0x00, 0x22, 0x00, 0x00, U8( reportDesc.size() + 0x40 ), 0x00 };
+        ControlRead( gen, dev, addr, getReport, reportDesc );
+
+        dev.dataToggle = false;
+    }
+
+    // the mouse
+    void Enumerate( USBBusGenerator& gen, Device& dev, int addr )
+    {
+        Enumerate( gen, dev, addr, Bytes( ConfigDescriptor, sizeof( ConfigDescriptor ) ),
+                   Bytes( ReportDescriptor, sizeof( ReportDescriptor ) ) );
+    }
+
+    void BuildEnumeration( USBBusGenerator& gen, double seconds, bool noisy )
+    {
+        Device dev = { gen.GetBusSpeed(), gen.GetBusSpeed() == FULL_SPEED ? 64 : 8, false };
+        for( int addr = 1; gen.GetSeconds() < seconds; addr = addr % 127 + 1 )
+        {
+            gen.Reset();
+            Enumerate( gen, dev, addr );
+
+            // and some reports
+            for( int pc = 0; pc < 32; ++pc )
+            {
+                PollInterrupt( gen, dev, addr, 2 );
+                gen.Idle( 20 );
+
+                if( !noisy )
+                    continue;
+
+                const U32 r = gen.Random() % 16;
+                if( r < 4 )
+                {
+                    gen.Glitch( r & 1, 1 + r / 2 );
+                }
+                else if( r == 4 )
+                {
+                    // a bad CRC
+                    gen.Token( PID_OUT, addr, 2, dev.speed );
+                    gen.Data( PID_DATA0, RandomBytes( gen, 8 ), dev.speed, true, true );
+                }
+                else if( r == 5 )
+                {
+                    // a packet cut short
+                    std::vector<U8> bytes = RandomBytes( gen, 3 );
+                    bytes[ 0 ] = 0x80;
+                    bytes[ 1 ] = PID_DATA1;
+                    gen.Packet( bytes, dev.speed, true );
+                }
+            }
+        }
+    }
+
+    void BuildResetStorm( USBBusGenerator& gen, double seconds )
+    {
+        Device dev = { gen.GetBusSpeed(), gen.GetBusSpeed() == FULL_SPEED ? 64 : 8, false };
+        std::vector<U8> deviceDesc = Bytes( DeviceDescriptor, sizeof( DeviceDescriptor ) );
+        deviceDesc[ 7 ] = U8( dev.maxPacket );
+
+        for( int addr = 1; gen.GetSeconds() < seconds; addr = addr % 127 + 1 )
+        {
+            gen.Reset();
+            GetDescriptor( gen, dev, 0, 0x01, 0, 64, deviceDesc );
+
+            const U8 setAddress[ 8 ] = { 0x00, 0x05, U8( addr ), 0x00, 0x00, 0x00, 0x00, 0x00 };
+            ControlWrite( gen, dev, 0, setAddress );
+
+            if( gen.Random() % 2 == 0 )
+            {
+                GetDescriptor( gen, dev, addr, 0x03, 1, 0xff, StringDescriptor( Strings[ 0 ] ) );
+                continue;
+            }
+
+            // the configuration descriptor, cut after its first packet by the next reset
+            const U8 setup[ 8 ] = { 0x80, 0x06, 0x00, 0x02, 0x00, 0x00, 0xff, 0x00 };
+            gen.KeepFrames();
+            gen.Token( PID_SETUP, addr, 0, dev.speed );
+            gen.Data( PID_DATA0, Bytes( setup, 8 ), dev.speed, true );
+            gen.Handshake( PID_ACK, dev.speed, false );
+
+            gen.KeepFrames();
+            gen.Token( PID_IN, addr, 0, dev.speed );
+            gen.Data( PID_DATA1, Bytes( ConfigDescriptor, dev.maxPacket ), dev.speed, false );
+            gen.Handshake( PID_ACK, dev.speed, true );
+        }
+    }
+
+    // an address no device has
+    int GetFreeAddress( USBBusGenerator& gen, const std::vector<int>& addrs )
+    {
+        for( ;; )
+        {
+            const int addr = 1 + gen.Random() % 127;
+            if( std::find( addrs.begin(), addrs.end(), addr ) == addrs.end() )
+                return addr;
+        }
+    }
+
+    void BuildAddressChurn( USBBusGenerator& gen, double seconds )
+    {
+        const size_t MAX_DEVICES = 32;
+
+        Device dev = { FULL_SPEED, 64, false };
+        std::vector<int> addrs; // of the devices
+
+        gen.Reset();
+        do
+        {
+            const U32 r = gen.Random();
+
+            // a new device
+            if( addrs.empty() || ( addrs.size() < MAX_DEVICES && r % 8 == 0 ) )
+            {
+                addrs.push_back( GetFreeAddress( gen, addrs ) );
+                Enumerate( gen, dev, addrs.back() );
+                continue;
+            }
+
+            // a device moves
+            int& addr = addrs[ r % addrs.size() ];
+            const int newAddr = GetFreeAddress( gen, addrs );
+
+            const U8 setAddress[ 8 ] = { 0x00, 0x05, U8( newAddr ), 0x00, 0x00, 0x00, 0x00, 0x00 };
+            ControlWrite( gen, dev, addr, setAddress );
+            addr = newAddr;
+
+            // and reads strings no device had before
+            char str[ 32 ];
+            const int length = 4 + gen.Random() % 24;
+            for( int cc = 0; cc < length; ++cc )
+                str[ cc ] = char( 'a' + gen.Random() % 26 );
+            str[ length ] = 0;
+
+            GetDescriptor( gen, dev, addr, 0x03, U8( 1 + gen.Random() % 16 ), 0xff, StringDescriptor( str ) );
+
+            const U8 getReport[ 8 ] = { 0x81, 0x06, 0x00, 0x22, 0x00, 0x00, sizeof( PushReportDescriptor ) + 0x40, 0x00 };
+            ControlRead( gen, dev, addr, getReport, Bytes( PushReportDescriptor, sizeof( PushReportDescriptor ) ) );
+        } while( gen.GetSeconds() < seconds );
+    }
+
+    void BuildBulk( USBBusGenerator& gen, double seconds )
+    {
+        Device dev = { FULL_SPEED, 64, false };
+        gen.Reset();
+        Enumerate( gen, dev, 1 );
+
+        bool outToggle = false;
+        for( U32 tc = 0; gen.GetSeconds() < seconds; ++tc )
+        {
+            gen.KeepFrames();
+
+            // mostly OUT, with an IN every fourth
+            const bool in = tc % 4 == 3;
+            gen.Token( in ? PID_IN : PID_OUT, 1, in ? 3 : 2, FULL_SPEED );
+            gen.Data( ( in ? dev.dataToggle : outToggle ) ? PID_DATA1 : PID_DATA0, RandomBytes( gen, 64 ), FULL_SPEED, !in );
+            gen.Handshake( PID_ACK, FULL_SPEED, in );
+
+            if( in )
+                dev.dataToggle = !dev.dataToggle;
+            else
+                outToggle = !outToggle;
+        }
+    }
+
+    void BuildInterrupt( USBBusGenerator& gen, double seconds )
+    {
+        const int NUM_DEVICES = 4;
+        Device devs[ NUM_DEVICES ];
+
+        gen.Reset();
+        for( int dc = 0; dc < NUM_DEVICES; ++dc )
+        {
+            devs[ dc ].speed = gen.GetBusSpeed();
+            devs[ dc ].maxPacket = gen.GetBusSpeed() == FULL_SPEED ? 64 : 8;
+            Enumerate( gen, devs[ dc ], dc + 1 );
+        }
+
+        // every device every ms, with a report one time in eight
+        while( gen.GetSeconds() < seconds )
+        {
+            for( int dc = 0; dc < NUM_DEVICES; ++dc )
+                PollInterrupt( gen, devs[ dc ], dc + 1, 8 );
+
+            gen.Idle( gen.GetBusSpeed() == FULL_SPEED ? 11000 : 1350 );
+        }
+    }
+
+    void BuildMixed( USBBusGenerator& gen, double seconds )
+    {
+        // a full speed device and a low speed device behind a hub
+        Device fs = { FULL_SPEED, 64, false };
+        Device ls = { LOW_SPEED, 8, false };
+
+        gen.Reset();
+        Enumerate( gen, fs, 1 );
+        Enumerate( gen, ls, 2 );
+
+        bool outToggle = false;
+        while( gen.GetSeconds() < seconds )
+        {
+            PollInterrupt( gen, ls, 2, 4 );
+
+            for( int tc = 0; tc < 8; ++tc )
+            {
+                gen.KeepFrames();
+                gen.Token( PID_OUT, 1, 2, FULL_SPEED );
+                gen.Data( outToggle ? PID_DATA1 : PID_DATA0, RandomBytes( gen, 64 ), FULL_SPEED, true );
+                gen.Handshake( PID_ACK, FULL_SPEED, false );
+                outToggle = !outToggle;
+            }
+
+            gen.Idle( 2000 );
+        }
+    }
+
+    void BuildGamepad( USBBusGenerator& gen, double seconds )
+    {
+        Device dev = { gen.GetBusSpeed(), 8, false };
+
+        // the configuration of the mouse with the report descriptor of the gamepad and an 8 byte endpoint
+        std::vector<U8> configDesc = Bytes( ConfigDescriptor, sizeof( ConfigDescriptor ) );
+        configDesc[ 25 ] = sizeof( GamepadReportDescriptor );
+        configDesc[ 31 ] = 8;
+
+        gen.Reset();
+        Enumerate( gen, dev, 1, configDesc, Bytes( GamepadReportDescriptor, sizeof( GamepadReportDescriptor ) ) );
+
+        // polled every ms, with a report one time in two
+        while( gen.GetSeconds() < seconds )
+        {
+            if( gen.Random() % 2 != 0 )
+            {
+                gen.KeepFrames();
+                gen.Token( PID_IN, 1, 1, dev.speed );
+                gen.Handshake( PID_NAK, dev.speed, false );
+            }
+            else
+            {
+                std::vector<U8> report = RandomBytes( gen, 11 );
+                report[ 0 ] = 0x01;
+
+                for( size_t offset = 0; offset < report.size(); offset += 8 )
+                {
+                    const size_t end = std::min<size_t>( offset + 8, report.size() );
+
+                    gen.KeepFrames();
+                    gen.Token( PID_IN, 1, 1, dev.speed );
+                    gen.Data( dev.dataToggle ? PID_DATA1 : PID_DATA0, std::vector<U8>( report.begin() + offset, report.begin() + end ),
+                              dev.speed, false );
+                    gen.Handshake( PID_ACK, dev.speed, true );
+                    dev.dataToggle = !dev.dataToggle;
+                }
+            }
+
+            gen.Idle( gen.GetBusSpeed() == FULL_SPEED ? 11000 : 1350 );
+        }
+    }
+}
+
+const char* GetCorpusName( USBCorpusKind kind )
+{
+    static const char* Names[ CK_Count ] = { "enumeration", "bulk", "interrupt", "noisy", "mixed", "reset-storm", "address-churn",
+                                             "gamepad" };
+    return Names[ kind ];
+}
+
+bool BuildCorpus( USBBusGenerator& gen, USBCorpusKind kind, double seconds )
+{
+    switch( kind )
+    {
+    case CK_Enumeration:
+        BuildEnumeration( gen, seconds, false );
+        break;
+    case CK_Bulk:
+        // no bulk endpoints and no hubs for low speed devices
+        if( gen.GetBusSpeed() != FULL_SPEED )
+            return false;
+        BuildBulk( gen, seconds );
+        break;
+    case CK_Interrupt:
+        BuildInterrupt( gen, seconds );
+        break;
+    case CK_Noisy:
+        BuildEnumeration( gen, seconds, true );
+        break;
+    case CK_Mixed:
+        if( gen.GetBusSpeed() != FULL_SPEED )
+            return false;
+        BuildMixed( gen, seconds );
+        break;
+    case CK_ResetStorm:
+        BuildResetStorm( gen, seconds );
+        break;
+    case CK_AddressChurn:
+        if( gen.GetBusSpeed() != FULL_SPEED )
+            return false;
+        BuildAddressChurn( gen, seconds );
+        break;
+    case CK_Gamepad:
+        BuildGamepad( gen, seconds );
+        break;
+    default:
+        return false;
+    }
+
+    // the decoder needs an edge after the last packet to see its end
+    gen.Idle( 100 );
+    gen.Glitch( 0, 1 );
+    gen.Idle( 100 );
+
+    return true;
+}
+
+//
+// USBEdgeVectorSource
+//
+
+USBEdgeVectorSource::USBEdgeVectorSource( USBBitState initialState, const std::vector<U64>& edges, U64 endSample )
+    : mEdges( edges ), mEndSample( endSample ), mNextEdge( 0 ), mSample( 0 ), mState( initialState )
+{
+}
+
+void USBEdgeVectorSource::AdvanceToNextEdge()
+{
+    if( mNextEdge < mEdges.size() )
+    {
+        mSample = mEdges[ mNextEdge++ ];
+        mState = InvertBitState( mState );
+    }
+    else
+    {
+        mSample = mEndSample;
+    }
+}
+
+void USBEdgeVectorSource::AdvanceToAbsPosition( U64 sample )
+{
+    for( ; mNextEdge < mEdges.size() && mEdges[ mNextEdge ] <= sample; ++mNextEdge )
+        mState = InvertBitState( mState );
+
+    if( sample > mSample )
+        mSample = sample;
+}
+
+bool USBEdgeVectorSource::WouldAdvancingCauseTransition( U32 numSamples )
+{
+    return mNextEdge < mEdges.size() && mEdges[ mNextEdge ] <= mSample + numSamples;
+}
+
+bool USBEdgeVectorSource::WouldAdvancingToAbsPositionCauseTransition( U64 sample )
+{
+    return mNextEdge < mEdges.size() && mEdges[ mNextEdge ] <= sample;
+}
@@ -0,0 +1,179 @@
+#ifndef USB_BENCHMARK_CORPUS_H
+#define USB_BENCHMARK_CORPUS_H
+
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+#include "USBEdgeSource.h"
+#include "USBFrameSink.h"
+
+// Synthetic bus traffic for the decode benchmarks. Unlike the simulation data generator, which loops over a
+// short recording, this builds the traffic from transactions with random payloads, so each kind of corpus
+// stresses a different part of the decoder. The random numbers come from a fixed seed, so a corpus is the
+// same on every run and every machine.
+class USBBusGenerator
+{
+  public:
+    USBBusGenerator( USBSpeed busSpeed, U32 sampleRate, U32 seed );
+
+    USBSpeed GetBusSpeed() const
+    {
+        return mBusSpeed;
+    }
+
+    U32 Random();
+
+    // the bus
+    void Idle( double bits );
+    void Reset();
+
+    // a SOF on a full speed bus or a keep-alive on a low speed bus for every ms that passed
+    void KeepFrames();
+
+    // a packet with SYNC and EOP; a low speed packet from the host on a full speed bus gets a PRE before it
+    void Packet( const std::vector<U8>& bytes, USBSpeed speed, bool fromHost );
+    void Token( USB_PID pid, int addr, int endp, USBSpeed speed );
+    void Data( USB_PID pid, const std::vector<U8>& payload, USBSpeed speed, bool fromHost, bool badCrc = false );
+    void Handshake( USB_PID pid, USBSpeed speed, bool fromHost );
+
+    // a pulse of a few samples on one line while the bus is idle
+    void Glitch( int line, U32 samples );
+
+    // the capture
+    USBBitState GetInitialState( int line ) const
+    {
+        return mInitialStates[ line ];
+    }
+
+    const std::vector<U64>& GetEdges( int line ) const
+    {
+        return mEdges[ line ];
+    }
+
+    U64 GetEndSample() const
+    {
+        return U64( mTime + 0.5 );
+    }
+
+    U64 GetNumPackets() const
+    {
+        return mNumPackets;
+    }
+
+    double GetSeconds() const
+    {
+        return mTime / mSampleRate;
+    }
+
+  private:
+    void SetLines( USBBitState dp, USBBitState dm );
+    void SetJ();
+    void SetSE0();
+    void ToggleLines();
+    void Advance( double bits, USBSpeed speed );
+    void Bits( const std::vector<U8>& bytes, USBSpeed speed );
+
+    USBSpeed mBusSpeed;
+    U32 mSampleRate;
+    U32 mRandom;
+
+    double mTime; // in samples
+    double mNextFrame;
+    U16 mFrameNumber;
+
+    USBBitState mInitialStates[ 2 ];
+    USBBitState mStates[ 2 ];
+    std::vector<U64> mEdges[ 2 ];
+    U64 mNumPackets;
+};
+
+enum USBCorpusKind
+{
+    CK_Enumeration,  // devices enumerated over and over: the control transfers decoder
+    CK_Bulk,         // back to back bulk packets of the largest size
+    CK_Interrupt,    // interrupt endpoints polled every frame, mostly NAKed
+    CK_Noisy,        // enumerations with glitches, bad CRCs and cut packets
+    CK_Mixed,        // low speed devices behind a hub on a full speed bus, with PRE packets
+    CK_ResetStorm,   // bus resets in the middle of the enumerations, as fast as they come
+    CK_AddressChurn, // devices behind hubs which move from address to address, reading new strings each time
+    CK_Gamepad,      // HID reports which take two packets, with a field across the packet boundary
+
+    CK_Count
+};
+
+const char* GetCorpusName( USBCorpusKind kind );
+
+// false for a corpus which doesn't exist at the speed of the bus
+bool BuildCorpus( USBBusGenerator& gen, USBCorpusKind kind, double seconds );
+
+// One line of a generated corpus.
+class USBEdgeVectorSource : public USBEdgeSource
+{
+  public:
+    USBEdgeVectorSource( USBBitState initialState, const std::vector<U64>& edges, U64 endSample );
+
+    virtual U64 GetSampleNumber()
+    {
+        return mSample;
+    }
+
+    virtual USBBitState GetBitState()
+    {
+        return mState;
+    }
+
+    // the end of the capture once there are no more edges
+    virtual U64 GetSampleOfNextEdge()
+    {
+        return mNextEdge < mEdges.size() ? mEdges[ mNextEdge ] : mEndSample;
+    }
+
+    virtual void AdvanceToNextEdge();
+    virtual void AdvanceToAbsPosition( U64 sample );
+    virtual bool WouldAdvancingCauseTransition( U32 numSamples );
+    virtual bool WouldAdvancingToAbsPositionCauseTransition( U64 sample );
+
+    virtual bool DoMoreTransitionsExistInCurrentData()
+    {
+        return mNextEdge < mEdges.size();
+    }
+
+  private:
+    const std::vector<U64>& mEdges;
+    U64 mEndSample;
+    size_t mNextEdge;
+    U64 mSample;
+    USBBitState mState;
+};
+
+// Counts the frames instead of keeping them.
+class USBCountingSink : public USBFrameSink
+{
+  public:
+    USBCountingSink() : mNumFrames( 0 ), mNumErrors( 0 )
+    {
+    }
+
+    virtual void AddFrame( const USBFrame& f )
+    {
+        ++mNumFrames;
+        mNumErrors += f.mType == FT_Error;
+    }
+
+    U64 GetNumFrames() const
+    {
+        return mNumFrames;
+    }
+
+    U64 GetNumErrors() const
+    {
+        return mNumErrors;
+    }
+
+  private:
+    U64 mNumFrames;
+    U64 mNumErrors;
+};
+
+#endif // USB_BENCHMARK_CORPUS_H
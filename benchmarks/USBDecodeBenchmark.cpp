@@ -0,0 +1,81 @@
+// Measures the decode throughput of each kind of synthetic traffic, at both bus speeds and at every
+// decode level. The corpora come from a fixed seed, so the numbers of two builds can be compared
+// line by line. The output is CSV, one line per corpus, speed and level; the time is the best of the runs.
+// The peak heap is that of the decoder and the sink during one decode, over the heap before it.
+//
+// usage: usb_decode_benchmark [seconds of traffic] [runs] [sample rate]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBHeapCounter.h"
+
+static const char* LevelNames[] = { "packets", "bytes", "signals", "control" };
+static const USBDecodeLevel Levels[] = { OUT_PACKETS, OUT_BYTES, OUT_SIGNALS, OUT_CONTROL_TRANSFERS };
+
+int main( int argc, char* argv[] )
+{
+    const double seconds = argc > 1 ? atof( argv[ 1 ] ) : 1.0;
+    const int runs = argc > 2 ? atoi( argv[ 2 ] ) : 3;
+    const U32 sampleRate = argc > 3 ? U32( strtoul( argv[ 3 ], NULL, 10 ) ) : 24000000;
+
+    printf( "corpus,speed,level,samples,edges,packets,frames,errors,decode_s,samples_per_s,packets_per_s,frames_per_s,peak_heap_kb\n" );
+
+    const USBSpeed speeds[] = { LOW_SPEED, FULL_SPEED };
+    for( int kc = 0; kc < CK_Count; ++kc )
+    {
+        for( int sc = 0; sc < 2; ++sc )
+        {
+            USBBusGenerator gen( speeds[ sc ], sampleRate, 0x5a1eae + kc );
+            if( !BuildCorpus( gen, USBCorpusKind( kc ), seconds ) )
+                continue;
+
+            const U64 numSamples = gen.GetEndSample();
+            const U64 numEdges = gen.GetEdges( 0 ).size() + gen.GetEdges( 1 ).size();
+
+            for( size_t lc = 0; lc < sizeof( Levels ) / sizeof( Levels[ 0 ] ); ++lc )
+            {
+                double best = 0;
+                U64 numFrames = 0;
+                U64 numErrors = 0;
+                size_t peakHeap = 0;
+                for( int rc = 0; rc < runs; ++rc )
+                {
+                    const S64 heapBefore = GetHeapBytes();
+                    ResetPeakHeap();
+
+                    USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), numSamples );
+                    USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), numSamples );
+                    USBCountingSink sink;
+                    USBDecoder decoder( &sink, sampleRate, speeds[ sc ], Levels[ lc ] );
+
+                    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                    decoder.Decode( &dp, &dm );
+                    const double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+                    if( rc == 0 || secs < best )
+                        best = secs;
+
+                    numFrames = sink.GetNumFrames();
+                    numErrors = sink.GetNumErrors();
+                    peakHeap = size_t( GetPeakHeapBytes() - heapBefore );
+                }
+
+                if( best <= 0 )
+                    best = 1e-9;
+
+                printf( "%s,%s,%s,%llu,%llu,%llu,%llu,%llu,%.6f,%.0f,%.0f,%.0f,%llu\n", GetCorpusName( USBCorpusKind( kc ) ),
+                        speeds[ sc ] == LOW_SPEED ? "low" : "full", LevelNames[ lc ], ( unsigned long long )numSamples,
+                        ( unsigned long long )numEdges, ( unsigned long long )gen.GetNumPackets(), ( unsigned long long )numFrames,
+                        ( unsigned long long )numErrors, best, numSamples / best, gen.GetNumPackets() / best, numFrames / best,
+                        ( unsigned long long )( peakHeap / 1024 ) );
+                fflush( stdout );
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+// Decodes the synthetic corpora of the benchmarks, and any capture files given, at every decode level, and
+// compares a digest of the output with the golden digests. The digest covers every frame (type, flags,
+// samples and data) and every bit marker, in order, so any change to the decoded output shows up. Only the
+// output decides whether a case passes. The golden times are those of the machine which recorded them, so
+// the decode time is only checked with --max-slowdown, against goldens recorded on the same machine.
+//
+// usage: usb_decode_regression [options] [capture files]
+//
+//   --golden <file>          the golden digests (benchmarks/golden/decode.golden)
+//   --record                 write the digests and times of this run as the golden ones
+//   --max-slowdown <ratio>   fail a case which is this much slower than its golden time, e.g. 1.5
+//   --runs <n>               the time is the best of n runs (3)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBEdgeCapture.h"
+
+#ifndef USB_GOLDEN_FILE
+#define USB_GOLDEN_FILE "benchmarks/golden/decode.golden"
+#endif
+
+static const char* LevelNames[] = { "packets", "bytes", "signals", "control" };
+static const USBDecodeLevel Levels[] = { OUT_PACKETS, OUT_BYTES, OUT_SIGNALS, OUT_CONTROL_TRANSFERS };
+
+// FNV-1a of the output
+class USBDigestSink : public USBFrameSink
+{
+  public:
+    USBDigestSink() : mDigest( 0xcbf29ce484222325ull ), mNumFrames( 0 )
+    {
+    }
+
+    virtual void AddFrame( const USBFrame& f )
+    {
+        Add( f.mType );
+        Add( f.mFlags );
+        Add( f.mStartingSampleInclusive );
+        Add( f.mEndingSampleInclusive );
+        Add( f.mData1 );
+
+        // the control transfer fields point to their static name, which moves from run to run
+        if( f.mType == FT_ControlTransferField )
+        {
+            for( const char* pName = reinterpret_cast<const char*>( f.mData2 ); pName != NULL && *pName != 0; ++pName )
+                Add( U8( *pName ) );
+        }
+        else
+        {
+            Add( f.mData2 );
+        }
+
+        ++mNumFrames;
+    }
+
+    virtual void AddBitMarker( U64 sample, USBBitMarker type )
+    {
+        // the values of the SDK's markers, which the golden digests were made with
+        Add( sample );
+        Add( type == BM_Zero ? 11 : type == BM_One ? 10 : 7 );
+    }
+
+    U64 GetDigest() const
+    {
+        return mDigest;
+    }
+
+    U64 GetNumFrames() const
+    {
+        return mNumFrames;
+    }
+
+  private:
+    void Add( U64 value )
+    {
+        // byte by byte, so the digest doesn't depend on the byte order of the machine
+        for( int bc = 0; bc < 8; ++bc, value >>= 8 )
+        {
+            mDigest ^= value & 0xff;
+            mDigest *= 0x100000001b3ull;
+        }
+    }
+
+    U64 mDigest;
+    U64 mNumFrames;
+};
+
+struct Result
+{
+    U64 digest;
+    U64 numFrames;
+    double ms;
+};
+
+struct Golden
+{
+    double seconds;
+    U32 sampleRate;
+    std::map<std::string, Result> results;
+};
+
+static bool ReadGolden( const char* path, Golden& golden )
+{
+    FILE* pFile = fopen( path, "r" );
+    if( pFile == NULL )
+        return false;
+
+    char line[ 512 ];
+    while( fgets( line, sizeof( line ), pFile ) != NULL )
+    {
+        char name[ 256 ];
+        unsigned long long digest, numFrames;
+        double value;
+        Result res;
+        if( line[ 0 ] == '#' )
+            continue;
+        else if( sscanf( line, "seconds %lf", &value ) == 1 )
+            golden.seconds = value;
+        else if( sscanf( line, "rate %lf", &value ) == 1 )
+            golden.sampleRate = U32( value );
+        else if( sscanf( line, "%255s %llx %llu %lf", name, &digest, &numFrames, &res.ms ) == 4 )
+        {
+            res.digest = digest;
+            res.numFrames = numFrames;
+            golden.results[ name ] = res;
+        }
+    }
+
+    fclose( pFile );
+    return true;
+}
+
+static bool WriteGolden( const char* path, const Golden& golden )
+{
+    FILE* pFile = fopen( path, "w" );
+    if( pFile == NULL )
+        return false;
+
+    fprintf( pFile, "# written by usb_decode_regression --record: <case> <digest> <frames> <decode ms>\n" );
+    fprintf( pFile, "seconds %g\nrate %u\n", golden.seconds, golden.sampleRate );
+    for( std::map<std::string, Result>::const_iterator i = golden.results.begin(); i != golden.results.end(); ++i )
+        fprintf( pFile, "%s %016llx %llu %.3f\n", i->first.c_str(), ( unsigned long long )i->second.digest,
+                 ( unsigned long long )i->second.numFrames, i->second.ms );
+
+    return fclose( pFile ) == 0;
+}
+
+// decodes the lines runs times and keeps the best time
+template <typename MakeSources> static Result Run( MakeSources makeSources, U32 sampleRate, USBSpeed speed, USBDecodeLevel level, int runs )
+{
+    Result res = { 0, 0, 0 };
+    for( int rc = 0; rc < runs; ++rc )
+    {
+        USBDigestSink sink;
+        USBDecoder decoder( &sink, sampleRate, speed, level );
+
+        USBEdgeSource* pDP;
+        USBEdgeSource* pDM;
+        makeSources( pDP, pDM );
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        decoder.Decode( pDP, pDM );
+        const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+
+        delete pDP;
+        delete pDM;
+
+        if( rc == 0 || ms < res.ms )
+            res.ms = ms;
+
+        res.digest = sink.GetDigest();
+        res.numFrames = sink.GetNumFrames();
+    }
+
+    return res;
+}
+
+struct CorpusSources
+{
+    const USBBusGenerator* pGen;
+
+    void operator()( USBEdgeSource*& pDP, USBEdgeSource*& pDM ) const
+    {
+        pDP = new USBEdgeVectorSource( pGen->GetInitialState( 0 ), pGen->GetEdges( 0 ), pGen->GetEndSample() );
+        pDM = new USBEdgeVectorSource( pGen->GetInitialState( 1 ), pGen->GetEdges( 1 ), pGen->GetEndSample() );
+    }
+};
+
+struct CaptureSources
+{
+    const USBEdgeCaptureFile* pFile;
+
+    void operator()( USBEdgeSource*& pDP, USBEdgeSource*& pDM ) const
+    {
+        pDP = new USBEdgeCaptureSource( pFile, ECL_DP, pFile->GetFirstSample() );
+        pDM = new USBEdgeCaptureSource( pFile, ECL_DM, pFile->GetFirstSample() );
+    }
+};
+
+int main( int argc, char* argv[] )
+{
+    const char* pGoldenFile = USB_GOLDEN_FILE;
+    bool record = false;
+    double maxSlowdown = 0;
+    int runs = 3;
+    std::vector<const char*> captures;
+
+    for( int ac = 1; ac < argc; ++ac )
+    {
+        const char* pValue = ac + 1 < argc ? argv[ ac + 1 ] : NULL;
+        if( strcmp( argv[ ac ], "--record" ) == 0 )
+            record = true;
+        else if( strcmp( argv[ ac ], "--golden" ) == 0 && pValue != NULL )
+            pGoldenFile = argv[ ++ac ];
+        else if( strcmp( argv[ ac ], "--max-slowdown" ) == 0 && pValue != NULL )
+            maxSlowdown = atof( argv[ ++ac ] );
+        else if( strcmp( argv[ ac ], "--runs" ) == 0 && pValue != NULL && atoi( pValue ) > 0 )
+            runs = atoi( argv[ ++ac ] );
+        else if( argv[ ac ][ 0 ] != '-' )
+            captures.push_back( argv[ ac ] );
+        else
+        {
+            fprintf( stderr, "usage: usb_decode_regression [--golden <file>] [--record] [--max-slowdown <ratio>] [--runs <n>] "
+                             "[capture files]\n" );
+            return 2;
+        }
+    }
+
+    Golden golden;
+    golden.seconds = 0.2;
+    golden.sampleRate = 24000000;
+    if( !ReadGolden( pGoldenFile, golden ) && !record )
+    {
+        fprintf( stderr, "usb_decode_regression: can't read %s\n", pGoldenFile );
+        return 1;
+    }
+
+    std::map<std::string, Result> results;
+
+    // the synthetic corpora, built from the same seeds as the benchmark
+    const USBSpeed speeds[] = { LOW_SPEED, FULL_SPEED };
+    for( int kc = 0; kc < CK_Count; ++kc )
+    {
+        for( int sc = 0; sc < 2; ++sc )
+        {
+            USBBusGenerator gen( speeds[ sc ], golden.sampleRate, 0x5a1eae + kc );
+            if( !BuildCorpus( gen, USBCorpusKind( kc ), golden.seconds ) )
+                continue;
+
+            const CorpusSources sources = { &gen };
+            for( size_t lc = 0; lc < sizeof( Levels ) / sizeof( Levels[ 0 ] ); ++lc )
+            {
+                const std::string name = std::string( GetCorpusName( USBCorpusKind( kc ) ) ) + "-" +
+                                         ( speeds[ sc ] == LOW_SPEED ? "low" : "full" ) + "-" + LevelNames[ lc ];
+                results[ name ] = Run( sources, golden.sampleRate, speeds[ sc ], Levels[ lc ], runs );
+            }
+        }
+    }
+
+    // the captures are named by their file; they are decoded at full speed
+    for( size_t cc = 0; cc < captures.size(); ++cc )
+    {
+        USBEdgeCaptureFile file;
+        if( !file.Open( captures[ cc ] ) )
+        {
+            fprintf( stderr, "usb_decode_regression: %s: %s\n", captures[ cc ], file.GetError().c_str() );
+            return 1;
+        }
+
+        const char* pName = strrchr( captures[ cc ], '/' );
+        pName = pName != NULL ? pName + 1 : captures[ cc ];
+
+        const CaptureSources sources = { &file };
+        for( size_t lc = 0; lc < sizeof( Levels ) / sizeof( Levels[ 0 ] ); ++lc )
+            results[ std::string( pName ) + "-" + LevelNames[ lc ] ] = Run( sources, file.GetSampleRate(), FULL_SPEED, Levels[ lc ], runs );
+    }
+
+    if( record )
+    {
+        for( std::map<std::string, Result>::const_iterator i = results.begin(); i != results.end(); ++i )
+            golden.results[ i->first ] = i->second;
+
+        if( !WriteGolden( pGoldenFile, golden ) )
+        {
+            fprintf( stderr, "usb_decode_regression: can't write %s\n", pGoldenFile );
+            return 1;
+        }
+
+        printf( "recorded %u cases in %s\n", U32( results.size() ), pGoldenFile );
+        return 0;
+    }
+
+    int numFailed = 0;
+    for( std::map<std::string, Result>::const_iterator i = results.begin(); i != results.end(); ++i )
+    {
+        const Result& res = i->second;
+        std::map<std::string, Result>::const_iterator g = golden.results.find( i->first );
+
+        const char* pStatus = "ok";
+        if( g == golden.results.end() )
+            pStatus = "NO GOLDEN";
+        else if( res.digest != g->second.digest || res.numFrames != g->second.numFrames )
+            pStatus = "OUTPUT CHANGED";
+        // a few ms of slack for the short cases
+        else if( maxSlowdown > 0 && res.ms > g->second.ms * maxSlowdown + 5 )
+            pStatus = "SLOWER";
+
+        numFailed += strcmp( pStatus, "ok" ) != 0;
+
+        if( g == golden.results.end() )
+            printf( "%-32s %-14s %016llx %8llu frames %10.3f ms\n", i->first.c_str(), pStatus, ( unsigned long long )res.digest,
+                    ( unsigned long long )res.numFrames, res.ms );
+        else
+            printf( "%-32s %-14s %016llx %8llu frames %10.3f ms (golden %.3f ms, x%.2f)\n", i->first.c_str(), pStatus,
+                    ( unsigned long long )res.digest, ( unsigned long long )res.numFrames, res.ms, g->second.ms,
+                    g->second.ms > 0 ? res.ms / g->second.ms : 0 );
+    }
+
+    printf( "%d of %u cases failed\n", numFailed, U32( results.size() ) );
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// Measures the cost of making the bubble text for each type of analyzer frame and for
+// each control transfer field formatter.
+//
+// usage: usb_format_benchmark [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "USBFrameFormatters.h"
+#include "USBTypes.h"
+#include "USBControlTransfers.h"
+
+struct FieldCase
+{
+    USBCtrlTransFieldType mFormatter;
+    const char* mName;
+    U32 mValue;
+};
+
+static const FieldCase FieldCases[] = {
+    { Fld_bmRequestType, "bmRequestType", 0x01 },
+    { Fld_bmRequestType_NoData, "bmRequestType_NoData", 0x01 },
+    { Fld_bRequest_Standard, "bRequest_Standard", 0x01 },
+    { Fld_bRequest_HID, "bRequest_HID", 0x01 },
+    { Fld_bRequest_CDC, "bRequest_CDC", 0x01 },
+    { Fld_bRequest_Class, "bRequest_Class", 0x01 },
+    { Fld_bRequest_Vendor, "bRequest_Vendor", 0x01 },
+    { Fld_wValue_Descriptor, "wValue_Descriptor", 0x0200 },
+    { Fld_wValue_Address, "wValue_Address", 0x01 },
+    { Fld_wValue_HIDGetIdle, "wValue_HIDGetIdle", 0x01 },
+    { Fld_wValue_HIDSetIdle, "wValue_HIDSetIdle", 0x01 },
+    { Fld_wValue_HIDSetProtocol, "wValue_HIDSetProtocol", 0x01 },
+    { Fld_wValue_HIDGetSetReport, "wValue_HIDGetSetReport", 0x01 },
+    { Fld_HID_bCountryCode, "HID_bCountryCode", 0x01 },
+    { Fld_bDescriptorType, "bDescriptorType", 0x02 },
+    { Fld_bDescriptorType_Other, "bDescriptorType_Other", 0x01 },
+    { Fld_bMaxPower, "bMaxPower", 0x01 },
+    { Fld_wLANGID, "wLANGID", 0x0409 },
+    { Fld_wIndex_InterfaceNum, "wIndex_InterfaceNum", 0x01 },
+    { Fld_wIndex_Endpoint, "wIndex_Endpoint", 0x01 },
+    { Fld_wVendorId, "wVendorId", 0x413c },
+    { Fld_bmAttributes_Endpoint, "bmAttributes_Endpoint", 0x01 },
+    { Fld_bmAttributes_Config, "bmAttributes_Config", 0x01 },
+    { Fld_bEndpointAddress, "bEndpointAddress", 0x01 },
+    { Fld_BCD, "BCD", 0x0110 },
+    { Fld_ClassCode, "ClassCode", 0x03 },
+    { Fld_Wchar, "Wchar", 0x0041 },
+    { Fld_String, "String", 2 },
+    { Fld_HIDSubClass, "HIDSubClass", 0x01 },
+    { Fld_HIDProtocol, "HIDProtocol", 0x01 },
+    { Fld_CDC_DescriptorSubtype, "CDC_DescriptorSubtype", 0x01 },
+    { Fld_CDC_bmCapabilities_Call, "CDC_bmCapabilities_Call", 0x01 },
+    { Fld_CDC_bmCapabilities_AbstractCtrl, "CDC_bmCapabilities_AbstractCtrl", 0x01 },
+    { Fld_CDC_bmCapabilities_DataLine, "CDC_bmCapabilities_DataLine", 0x01 },
+    { Fld_CDC_bRingerVolSteps, "CDC_bRingerVolSteps", 0x01 },
+    { Fld_CDC_bmCapabilities_TelOpModes, "CDC_bmCapabilities_TelOpModes", 0x01 },
+    { Fld_CDC_bmCapabilities_TelCallStateRep, "CDC_bmCapabilities_TelCallStateRep", 0x01 },
+    { Fld_CDC_bmOptions, "CDC_bmOptions", 0x01 },
+    { Fld_CDC_bPhysicalInterface, "CDC_bPhysicalInterface", 0x01 },
+    { Fld_CDC_bProtocol, "CDC_bProtocol", 0x01 },
+    { Fld_CDC_bmCapabilities_MultiChannel, "CDC_bmCapabilities_MultiChannel", 0x01 },
+    { Fld_CDC_bmCapabilities_CAPIControl, "CDC_bmCapabilities_CAPIControl", 0x01 },
+    { Fld_CDC_bmEthernetStatistics, "CDC_bmEthernetStatistics", 0x1fffffff },
+    { Fld_CDC_wNumberMCFilters, "CDC_wNumberMCFilters", 0x01 },
+    { Fld_CDC_bmDataCapabilities, "CDC_bmDataCapabilities", 0x01 },
+    { Fld_CDC_bmATMDeviceStatistics, "CDC_bmATMDeviceStatistics", 0x01 },
+    { Fld_CDC_Data_AbstractState, "CDC_Data_AbstractState", 0x01 },
+    { Fld_CDC_Data_CountrySetting, "CDC_Data_CountrySetting", 0x01 },
+    { Fld_CDC_dwDTERate, "CDC_dwDTERate", 115200 },
+    { Fld_CDC_bCharFormat, "CDC_bCharFormat", 0x01 },
+    { Fld_CDC_bParityType, "CDC_bParityType", 0x01 },
+    { Fld_CDC_bDataBits, "CDC_bDataBits", 0x01 },
+    { Fld_CDC_dwRingerBitmap, "CDC_dwRingerBitmap", 0x01 },
+    { Fld_CDC_OperationMode, "CDC_OperationMode", 0x01 },
+    { Fld_CDC_dwLineState, "CDC_dwLineState", 0x01 },
+    { Fld_CDC_dwCallState, "CDC_dwCallState", 0x01 },
+    { Fld_CDC_wValue_CommFeatureSelector, "CDC_wValue_CommFeatureSelector", 0x01 },
+    { Fld_CDC_wValue_DisconnectConnect, "CDC_wValue_DisconnectConnect", 0x01 },
+    { Fld_CDC_wValue_RelayConfig, "CDC_wValue_RelayConfig", 0x01 },
+    { Fld_CDC_wValue_EnableDisable, "CDC_wValue_EnableDisable", 0x01 },
+    { Fld_CDC_wValue_Cycles, "CDC_wValue_Cycles", 0x01 },
+    { Fld_CDC_wValue_Timing, "CDC_wValue_Timing", 0x01 },
+    { Fld_CDC_wValue_NumberOfRings, "CDC_wValue_NumberOfRings", 0x01 },
+    { Fld_CDC_wValue_ControlSignalBitmap, "CDC_wValue_ControlSignalBitmap", 0x01 },
+    { Fld_CDC_wValue_DurationOfBreak, "CDC_wValue_DurationOfBreak", 0x01 },
+    { Fld_CDC_wValue_OperationParms, "CDC_wValue_OperationParms", 0x01 },
+    { Fld_CDC_wValue_LineStateChange, "CDC_wValue_LineStateChange", 0x01 },
+    { Fld_CDC_wValue_UnitParameterStructure, "CDC_wValue_UnitParameterStructure", 0x01 },
+    { Fld_CDC_wValue_NumberOfFilters, "CDC_wValue_NumberOfFilters", 0x01 },
+    { Fld_CDC_wValue_FilterNumber, "CDC_wValue_FilterNumber", 0x01 },
+    { Fld_CDC_wValue_PacketFilterBitmap, "CDC_wValue_PacketFilterBitmap", 0x01 },
+    { Fld_CDC_wValue_EthFeatureSelector, "CDC_wValue_EthFeatureSelector", 0x01 },
+    { Fld_CDC_wValue_ATMDataFormat, "CDC_wValue_ATMDataFormat", 0x01 },
+    { Fld_CDC_wValue_ATMFeatureSelector, "CDC_wValue_ATMFeatureSelector", 0x01 },
+    { Fld_CDC_wValue_ATMVCFeatureSelector, "CDC_wValue_ATMVCFeatureSelector", 0x01 },
+};
+
+// nanoseconds per GetFrameDesc call
+static double TimeFrame( const USBFrame& f, int iterations, const USBStringDescriptorMap& stringDescriptors )
+{
+    std::vector<std::string> results;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( int cnt = 0; cnt < iterations; cnt++ )
+        GetFrameDesc( f, DB_Hexadecimal, results, stringDescriptors );
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>( end - start ).count() / iterations;
+}
+
+static USBFrame MakeFrame( U8 type, U64 data1, U64 data2 )
+{
+    USBFrame f;
+    f.mStartingSampleInclusive = 0;
+    f.mEndingSampleInclusive = 100;
+    f.mType = type;
+    f.mFlags = FF_None;
+    f.mData1 = data1;
+    f.mData2 = data2;
+    return f;
+}
+
+static void Report( const char* kind, const char* name, double ns, double& worst )
+{
+    printf( "%-6s %-40s %10.1f ns\n", kind, name, ns );
+    if( ns > worst )
+        worst = ns;
+}
+
+int main( int argc, char* argv[] )
+{
+    const int iterations = argc > 1 ? atoi( argv[ 1 ] ) : 100000;
+
+    USBStringDescriptorMap stringDescriptors;
+    stringDescriptors[ std::make_pair( 1, 2 ) ] = "USB Keyboard";
+
+    double worst = 0;
+
+    // the plain frame types
+    Report( "frame", "Signal", TimeFrame( MakeFrame( FT_Signal, S_J, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "SYNC", TimeFrame( MakeFrame( FT_SYNC, 0, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "PID", TimeFrame( MakeFrame( FT_PID, PID_SETUP, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "FrameNum", TimeFrame( MakeFrame( FT_FrameNum, 0x123, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "AddrEndp", TimeFrame( MakeFrame( FT_AddrEndp, 1, 2 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "EOP", TimeFrame( MakeFrame( FT_EOP, 0, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "Reset", TimeFrame( MakeFrame( FT_Reset, 0, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "CRC5", TimeFrame( MakeFrame( FT_CRC5, 0x1f, 0x1f ), iterations, stringDescriptors ), worst );
+    Report( "frame", "CRC16 (bad)", TimeFrame( MakeFrame( FT_CRC16, 0x1234, 0x4321 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "KeepAlive", TimeFrame( MakeFrame( FT_KeepAlive, 0, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "Byte", TimeFrame( MakeFrame( FT_Byte, 0xa5, 0 ), iterations, stringDescriptors ), worst );
+    Report( "frame", "Error", TimeFrame( MakeFrame( FT_Error, 0, 0 ), iterations, stringDescriptors ), worst );
+
+    // HID report descriptor items
+    const U8 hidItems[][ 3 ] = { { 0x05, 0x01, 0x00 }, { 0x09, 0x06, 0x00 }, { 0xa1, 0x01, 0x00 }, { 0x81, 0x02, 0x00 } };
+    const char* hidNames[] = { "HID Usage Page", "HID Usage", "HID Collection", "HID Input" };
+    for( size_t cnt = 0; cnt < sizeof( hidItems ) / sizeof( hidItems[ 0 ] ); cnt++ )
+    {
+        USBHidRepDescItemFrame f;
+        f.mStartingSampleInclusive = 0;
+        f.mEndingSampleInclusive = 100;
+        f.PackFrame( hidItems[ cnt ], 1, 0x01 );
+        Report( "frame", hidNames[ cnt ], TimeFrame( f, iterations, stringDescriptors ), worst );
+    }
+
+    // control transfer fields, one per formatter
+    for( size_t cnt = 0; cnt < sizeof( FieldCases ) / sizeof( FieldCases[ 0 ] ); cnt++ )
+    {
+        USBCtrlTransFieldFrame f;
+        f.mStartingSampleInclusive = 0;
+        f.mEndingSampleInclusive = 100;
+        f.PackFrame( FieldCases[ cnt ].mValue, 2, 1, FieldCases[ cnt ].mFormatter, FieldCases[ cnt ].mName );
+        Report( "field", FieldCases[ cnt ].mName, TimeFrame( f, iterations, stringDescriptors ), worst );
+    }
+
+    printf( "worst case %.1f ns per frame\n", worst );
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Compares the number and time formatting primitives with the helpers they replace: the SDK's
+// GetNumberString and GetTimeString, and int2str_sal which wraps the number into a std::string.
+// It first checks that they make the same strings as the SDK it is linked with, and exits with 1
+// if they don't; built with the real SDK, this is what shows the fast paths are safe to use.
+//
+// usage: usb_format_primitives_benchmark [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string.h>
+#include <string>
+
+#include <AnalyzerHelpers.h>
+
+#include "USBFormat.h"
+#include "USBTypes.h"
+
+static volatile U32 Sink; // keeps the compiler from dropping the formatted strings
+
+// the same bases in the types of the SDK and of the decoder core
+static const DisplayBase SdkBases[] = { Hexadecimal, Decimal, Binary, ASCII };
+static const USBDisplayBase Bases[] = { DB_Hexadecimal, DB_Decimal, DB_Binary, DB_ASCII };
+static const char* BaseNames[] = { "hex", "dec", "bin", "ascii" };
+static const int Widths[] = { 5, 7, 8, 11, 16 };
+
+static double GetElapsedNs( std::chrono::steady_clock::time_point start, int iterations )
+{
+    return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / iterations;
+}
+
+// the way int2str_sal used to format numbers
+static std::string OldInt2Str( const U64 i, DisplayBase base, const int max_bits )
+{
+    char number_str[ 256 ];
+    AnalyzerHelpers::GetNumberString( i, base, max_bits, number_str, sizeof( number_str ) );
+    return number_str;
+}
+
+// the strings which differ from the SDK's
+static int CheckNumbers()
+{
+    static const U64 values[] = { 0, 1, 9, 10, 0x1f, 0x20, 0x41, 0x7e, 0x7f, 0x80, 0xff, 0x0123456789abcdefull, ~0ull };
+
+    int num_diffs = 0;
+    for( size_t bc = 0; bc < sizeof( Bases ) / sizeof( Bases[ 0 ] ); bc++ )
+    {
+        for( int bits = 1; bits <= 64; bits++ )
+        {
+            for( size_t vc = 0; vc < sizeof( values ) / sizeof( values[ 0 ] ); vc++ )
+            {
+                const U64 val = bits < 64 ? values[ vc ] & ( ( 1ull << bits ) - 1 ) : values[ vc ];
+                const std::string sdk_str = OldInt2Str( val, SdkBases[ bc ], bits );
+
+                char number_str[ 128 ];
+                FormatNumber( number_str, sizeof( number_str ), val, Bases[ bc ], bits );
+                if( sdk_str != number_str && num_diffs++ < 10 )
+                    printf( "%s %d bits: SDK \"%s\", FormatNumber \"%s\"\n", BaseNames[ bc ], bits, sdk_str.c_str(), number_str );
+            }
+        }
+    }
+
+    return num_diffs;
+}
+
+static int CheckTimes()
+{
+    const U32 sample_rates[] = { 1000, 24000000, 100000000, 500000000, 1000000000 };
+    const U64 trigger_sample = 5000000000ull;
+
+    int num_diffs = 0;
+    for( size_t rc = 0; rc < sizeof( sample_rates ) / sizeof( sample_rates[ 0 ] ); rc++ )
+    {
+        const U32 sample_rate = sample_rates[ rc ];
+        const U64 steps[] = { 0, 1, 7, sample_rate - 1ull, sample_rate, sample_rate * 10ull + 1, sample_rate * 90000ull + 7 };
+
+        USBTimeFormatter time_fmt( trigger_sample, sample_rate );
+        for( int sign = 1; sign >= -1; sign -= 2 )
+        {
+            for( size_t sc = 0; sc < sizeof( steps ) / sizeof( steps[ 0 ] ); sc++ )
+            {
+                if( sign < 0 && steps[ sc ] > trigger_sample )
+                    continue;
+
+                const U64 sample = sign > 0 ? trigger_sample + steps[ sc ] : trigger_sample - steps[ sc ];
+
+                char time_str[ 128 ];
+                AnalyzerHelpers::GetTimeString( sample, trigger_sample, sample_rate, time_str, sizeof( time_str ) );
+                const char* pFormatted = time_fmt.Format( sample );
+                if( strcmp( time_str, pFormatted ) != 0 && num_diffs++ < 10 )
+                    printf( "%u Hz sample %llu: SDK \"%s\", USBTimeFormatter \"%s\"\n", sample_rate, ( unsigned long long )sample,
+                            time_str, pFormatted );
+            }
+        }
+    }
+
+    return num_diffs;
+}
+
+static void BenchmarkNumbers( int iterations )
+{
+    printf( "%-6s %5s %14s %14s %14s\n", "base", "bits", "old [ns]", "int2str [ns]", "buffer [ns]" );
+
+    for( size_t bc = 0; bc < sizeof( Bases ) / sizeof( Bases[ 0 ] ); bc++ )
+    {
+        for( size_t wc = 0; wc < sizeof( Widths ) / sizeof( Widths[ 0 ] ); wc++ )
+        {
+            const DisplayBase sdk_base = SdkBases[ bc ];
+            const USBDisplayBase base = Bases[ bc ];
+            const int bits = Widths[ wc ];
+            const U64 mask = ( 1ull << bits ) - 1;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for( int cnt = 0; cnt < iterations; cnt++ )
+                Sink += U32( OldInt2Str( U64( cnt ) & mask, sdk_base, bits ).size() );
+            const double old_ns = GetElapsedNs( start, iterations );
+
+            start = std::chrono::steady_clock::now();
+            for( int cnt = 0; cnt < iterations; cnt++ )
+                Sink += U32( int2str_sal( U64( cnt ) & mask, base, bits ).size() );
+            const double int2str_ns = GetElapsedNs( start, iterations );
+
+            char number_str[ 128 ];
+            start = std::chrono::steady_clock::now();
+            for( int cnt = 0; cnt < iterations; cnt++ )
+                Sink += U32( FormatNumber( number_str, sizeof( number_str ), U64( cnt ) & mask, base, bits ) );
+            const double buffer_ns = GetElapsedNs( start, iterations );
+
+            printf( "%-6s %5d %14.1f %14.1f %14.1f\n", BaseNames[ bc ], bits, old_ns, int2str_ns, buffer_ns );
+        }
+    }
+}
+
+static void BenchmarkTimes( int iterations )
+{
+    // the distance between consecutive export lines: bytes, packets and SOFs
+    const U32 sample_rates[] = { 24000000, 100000000, 500000000 };
+    const U64 steps[] = { 16, 1000, 1000000 };
+
+    printf( "\n%12s %10s %14s %14s\n", "rate [Hz]", "step", "SDK [ns]", "incr [ns]" );
+
+    for( size_t rc = 0; rc < sizeof( sample_rates ) / sizeof( sample_rates[ 0 ] ); rc++ )
+    {
+        for( size_t sc = 0; sc < sizeof( steps ) / sizeof( steps[ 0 ] ); sc++ )
+        {
+            const U32 sample_rate = sample_rates[ rc ];
+            const U64 trigger_sample = 1000;
+
+            char time_str[ 128 ];
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for( int cnt = 0; cnt < iterations; cnt++ )
+            {
+                AnalyzerHelpers::GetTimeString( cnt * steps[ sc ], trigger_sample, sample_rate, time_str, sizeof( time_str ) );
+                Sink += time_str[ 0 ];
+            }
+            const double sdk_ns = GetElapsedNs( start, iterations );
+
+            USBTimeFormatter time_fmt( trigger_sample, sample_rate );
+            start = std::chrono::steady_clock::now();
+            for( int cnt = 0; cnt < iterations; cnt++ )
+                Sink += time_fmt.Format( cnt * steps[ sc ] )[ 0 ];
+            const double incr_ns = GetElapsedNs( start, iterations );
+
+            printf( "%12u %10llu %14.1f %14.1f\n", sample_rate, ( unsigned long long )steps[ sc ], sdk_ns, incr_ns );
+        }
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    const int iterations = argc > 1 ? atoi( argv[ 1 ] ) : 1000000;
+
+    const int num_number_diffs = CheckNumbers();
+    const int num_time_diffs = CheckTimes();
+    if( num_number_diffs != 0 || num_time_diffs != 0 )
+    {
+        printf( "%d numbers and %d times differ from the SDK\n", num_number_diffs, num_time_diffs );
+        return 1;
+    }
+
+    printf( "the numbers and times are the same as the SDK's\n\n" );
+
+    BenchmarkNumbers( iterations );
+    BenchmarkTimes( iterations );
+
+    return 0;
+}
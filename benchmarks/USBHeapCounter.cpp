@@ -0,0 +1,59 @@
+#include <stdlib.h>
+#include <new>
+
+#include "USBHeapCounter.h"
+
+static thread_local S64 HeapBytes = 0;
+static thread_local S64 PeakHeapBytes = 0;
+
+// the size is kept in front of the block, for the delete
+static const size_t HEAP_HEADER = 16;
+
+void* operator new( size_t size )
+{
+    size_t* p = ( size_t* )malloc( size + HEAP_HEADER );
+    if( p == NULL )
+        throw std::bad_alloc();
+
+    *p = size;
+    HeapBytes += S64( size );
+    if( HeapBytes > PeakHeapBytes )
+        PeakHeapBytes = HeapBytes;
+
+    return ( char* )p + HEAP_HEADER;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+    if( ptr == NULL )
+        return;
+
+    size_t* p = ( size_t* )( ( char* )ptr - HEAP_HEADER );
+    HeapBytes -= S64( *p );
+    free( p );
+}
+
+void* operator new[]( size_t size )
+{
+    return operator new( size );
+}
+
+void operator delete[]( void* ptr ) noexcept
+{
+    operator delete( ptr );
+}
+
+S64 GetHeapBytes()
+{
+    return HeapBytes;
+}
+
+S64 GetPeakHeapBytes()
+{
+    return PeakHeapBytes;
+}
+
+void ResetPeakHeap()
+{
+    PeakHeapBytes = HeapBytes;
+}
@@ -0,0 +1,17 @@
+#ifndef USB_HEAP_COUNTER_H
+#define USB_HEAP_COUNTER_H
+
+#include "USBCoreTypes.h"
+
+// The heap of the calling thread, counted by USBHeapCounter.cpp which replaces operator new and delete, so only
+// the programs built with it count. It is counted by the allocations, so it doesn't depend on the allocator or
+// the page size, and the heap of each decode can be told apart from the others in the same process. A block
+// freed on another thread than the one which took it counts on the thread which freed it, so the counts are
+// signed; a thread which decodes on its own data has them right.
+S64 GetHeapBytes();
+
+// the most heap of the thread since its last ResetPeakHeap
+S64 GetPeakHeapBytes();
+void ResetPeakHeap();
+
+#endif // USB_HEAP_COUNTER_H
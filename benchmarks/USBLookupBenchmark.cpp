@@ -0,0 +1,94 @@
+// Compares the indexed vendor and language ID lookups with a binary search over the same entries,
+// which is how they used to be found. Half of the lookups are IDs in the tables, half are random.
+//
+// usage: usb_lookup_benchmark [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "USBLookupTables.h"
+
+static volatile U32 Sink; // keeps the compiler from dropping the lookups
+
+struct IdName
+{
+    U16 id;
+    const char* name;
+
+    bool operator<( const IdName& rhs ) const
+    {
+        return id < rhs.id;
+    }
+};
+
+typedef const char* ( *LookupFunc )( U16 id );
+
+// rebuilds the sorted table from the lookup function
+static std::vector<IdName> GetTable( LookupFunc lookup )
+{
+    std::vector<IdName> table;
+    for( U32 id = 0; id <= 0xffff; id++ )
+    {
+        const char* name = lookup( U16( id ) );
+        if( strcmp( name, "<unknown>" ) != 0 )
+        {
+            IdName entry = { U16( id ), name };
+            table.push_back( entry );
+        }
+    }
+
+    return table;
+}
+
+static const char* BinarySearch( const std::vector<IdName>& table, U16 id )
+{
+    IdName srch = { id, NULL };
+    std::vector<IdName>::const_iterator res = std::lower_bound( table.begin(), table.end(), srch );
+    if( res != table.end() && res->id == id )
+        return res->name;
+
+    return "<unknown>";
+}
+
+static void Benchmark( const char* name, LookupFunc lookup, int iterations )
+{
+    const std::vector<IdName> table = GetTable( lookup );
+
+    std::vector<U16> ids;
+    srand( 1 );
+    for( int cnt = 0; cnt < 4096; cnt++ )
+        ids.push_back( cnt % 2 == 0 ? table[ rand() % table.size() ].id : U16( rand() ) );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( int cnt = 0; cnt < iterations; cnt++ )
+        Sink += BinarySearch( table, ids[ cnt % ids.size() ] )[ 0 ];
+    const double search_ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for( int cnt = 0; cnt < iterations; cnt++ )
+        Sink += lookup( ids[ cnt % ids.size() ] )[ 0 ];
+    const double index_ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / iterations;
+
+    printf( "%-8s %6u entries %14.1f %14.1f\n", name, U32( table.size() ), search_ns, index_ns );
+}
+
+// the built-in vendor names only
+static const char* GetBuiltInVendorName( U16 vendorID )
+{
+    return GetVendorName( vendorID, NULL );
+}
+
+int main( int argc, char* argv[] )
+{
+    const int iterations = argc > 1 ? atoi( argv[ 1 ] ) : 10000000;
+
+    printf( "%-8s %14s %14s %14s\n", "table", "", "search [ns]", "index [ns]" );
+    Benchmark( "vendor", GetBuiltInVendorName, iterations );
+    Benchmark( "lang", GetLangName, iterations );
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Decodes each kind of synthetic traffic at 1x, 10x, 100x and 1000x of a base length, and fits the decode time,
+// the time of each stage of the decoder and the heap it takes against the number of edges. A time or a heap
+// which grows faster than linearly means some state of the decoder grows with the capture, which a long capture
+// makes slow or runs out of memory with, so its fitted exponent is flagged. The reset storm and the address churn
+// corpora are there for the state which is kept by address and across resets.
+//
+// The measurements are CSV on stdout, one line per corpus and length; the fits go to stderr, and the exit code
+// is 1 if one of them is flagged. The lengths of the dense corpora which would have more than the max edges
+// are skipped, so they are fitted over the shorter lengths only.
+//
+// usage: usb_scalability_benchmark [base seconds] [largest factor] [max exponent] [max edges]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBHeapCounter.h"
+#include "USBPerfCounters.h"
+
+// Keeps the string descriptors the way the analyzer results do, since they are kept by address too.
+class USBScalingSink : public USBCountingSink
+{
+  public:
+    virtual void AddStringDescriptor( int addr, int id, const std::string& stringDesc )
+    {
+        mStringDescriptors[ std::make_pair( addr, id ) ] = stringDesc;
+    }
+
+    virtual void CopyStringDescriptors( int fromAddr, int toAddr )
+    {
+        if( fromAddr == toAddr )
+            return;
+
+        std::map<std::pair<int, int>, std::string>::const_iterator i = mStringDescriptors.lower_bound( std::make_pair( fromAddr, 0 ) );
+        for( ; i != mStringDescriptors.end() && i->first.first == fromAddr; ++i )
+            mStringDescriptors[ std::make_pair( toAddr, i->first.second ) ] = i->second;
+    }
+
+  private:
+    std::map<std::pair<int, int>, std::string> mStringDescriptors;
+};
+
+// what is fitted against the edges
+enum Metric
+{
+    M_DecodeTime = PS_Count, // the stages come first
+    M_PeakHeap,
+    M_RetainedHeap,
+
+    M_Count
+};
+
+struct Measurement
+{
+    double edges;
+    double values[ M_Count ]; // seconds or bytes
+};
+
+static const char* GetMetricName( int metric )
+{
+    if( metric < PS_Count )
+        return USBPerfCounters::GetStageName( USBPerfStage( metric ) );
+
+    static const char* names[] = { "decode time", "peak heap", "retained heap" };
+    return names[ metric - M_DecodeTime ];
+}
+
+// Below this the numbers are mostly noise and fixed costs. A stage which takes a small part of the decode is
+// the difference of two much larger times, so it needs a share of the decode.
+static bool IsAboveFloor( const Measurement& m, int metric )
+{
+    if( metric == M_PeakHeap || metric == M_RetainedHeap )
+        return m.values[ metric ] >= 64 * 1024;
+
+    if( metric < PS_Count && m.values[ metric ] < m.values[ M_DecodeTime ] * 0.05 )
+        return false;
+
+    return m.values[ metric ] >= 0.002;
+}
+
+// the slope of log(value) against log(edges), of the measurements above the floor; false with fewer than two
+static bool FitExponent( const std::vector<Measurement>& measurements, int metric, double& exponent )
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    for( size_t mc = 0; mc < measurements.size(); ++mc )
+    {
+        if( !IsAboveFloor( measurements[ mc ], metric ) || measurements[ mc ].edges <= 0 )
+            continue;
+
+        const double x = log( measurements[ mc ].edges );
+        const double y = log( measurements[ mc ].values[ metric ] );
+        sx += x, sy += y, sxx += x * x, sxy += x * y;
+        ++n;
+    }
+
+    const double d = n * sxx - sx * sx;
+    if( n < 2 || d <= 0 )
+        return false;
+
+    exponent = ( n * sxy - sx * sy ) / d;
+    return true;
+}
+
+int main( int argc, char* argv[] )
+{
+    const double baseSeconds = argc > 1 ? atof( argv[ 1 ] ) : 0.01;
+    const U32 largestFactor = argc > 2 ? U32( strtoul( argv[ 2 ], NULL, 10 ) ) : 1000;
+    const double maxExponent = argc > 3 ? atof( argv[ 3 ] ) : 1.3;
+    const U64 maxEdges = argc > 4 ? strtoull( argv[ 4 ], NULL, 10 ) : 32000000;
+    const U32 sampleRate = 24000000;
+
+    if( baseSeconds <= 0 || largestFactor < 10 || maxExponent <= 0 || maxEdges == 0 )
+    {
+        fprintf( stderr, "usage: usb_scalability_benchmark [base seconds] [largest factor] [max exponent] [max edges]\n" );
+        return 2;
+    }
+
+    printf( "corpus,factor,seconds,edges,frames,decode_s,ns_per_edge,peak_heap_kb,retained_heap_kb" );
+    for( int sc = 0; sc < PS_Count; ++sc )
+    {
+        std::string name = USBPerfCounters::GetStageName( USBPerfStage( sc ) );
+        for( size_t cc = 0; cc < name.size(); ++cc )
+            name[ cc ] = name[ cc ] == ' ' ? '_' : name[ cc ];
+
+        printf( ",%s_s", name.c_str() );
+    }
+
+    printf( "\n" );
+
+    std::vector<std::string> flagged;
+    for( int kc = 0; kc < CK_Count; ++kc )
+    {
+        const USBCorpusKind kind = USBCorpusKind( kc );
+        std::vector<Measurement> measurements;
+
+        // a corpus is about as dense at every length, so the edges of the next one are known from the last one
+        double edgesPerSecond = 0;
+        for( U32 factor = 1; factor <= largestFactor; factor *= 10 )
+        {
+            if( edgesPerSecond * baseSeconds * factor > maxEdges )
+            {
+                fprintf( stderr, "%-14s skipped %ux, it has more than %llu edges\n", GetCorpusName( kind ), factor,
+                         ( unsigned long long )maxEdges );
+                break;
+            }
+
+            // the same seeds as the other benchmarks; every corpus exists at full speed
+            USBBusGenerator gen( FULL_SPEED, sampleRate, 0x5a1eae + kc );
+            BuildCorpus( gen, kind, baseSeconds * factor );
+
+            Measurement m;
+            m.edges = double( gen.GetEdges( 0 ).size() + gen.GetEdges( 1 ).size() );
+            edgesPerSecond = m.edges / gen.GetSeconds();
+
+            // the decode time without the counters, the best of a few runs for all but the longest
+            const int runs = factor < largestFactor ? 3 : 1;
+            double best = 0;
+            U64 numFrames = 0;
+            for( int rc = 0; rc < runs; ++rc )
+            {
+                USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), gen.GetEndSample() );
+                USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), gen.GetEndSample() );
+                USBScalingSink sink;
+                USBDecoder decoder( &sink, sampleRate, FULL_SPEED, OUT_CONTROL_TRANSFERS );
+
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                decoder.Decode( &dp, &dm );
+                const double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+                if( rc == 0 || secs < best )
+                    best = secs;
+
+                numFrames = sink.GetNumFrames();
+            }
+
+            m.values[ M_DecodeTime ] = best;
+
+            // and the stages and the heap with them; every call is timed, since the estimates of the sampled
+            // stages vary more from run to run than the growth which is looked for
+            for( int rc = 0; rc < runs; ++rc )
+            {
+                const S64 heapBefore = GetHeapBytes();
+                ResetPeakHeap();
+
+                USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), gen.GetEndSample() );
+                USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), gen.GetEndSample() );
+                USBScalingSink sink;
+                USBPerfCounters perf;
+                perf.SetSampling( false );
+                USBDecoder decoder( &sink, sampleRate, FULL_SPEED, OUT_CONTROL_TRANSFERS );
+                decoder.SetPerfCounters( &perf );
+                decoder.Decode( &dp, &dm );
+
+                // what the decoder and the sink keep after the decode
+                m.values[ M_PeakHeap ] = double( GetPeakHeapBytes() - heapBefore );
+                m.values[ M_RetainedHeap ] = double( GetHeapBytes() - heapBefore );
+
+                for( int sc = 0; sc < PS_Count; ++sc )
+                {
+                    const double secs = perf.GetSelfNanoseconds( USBPerfStage( sc ) ) / 1e9;
+                    if( rc == 0 || secs < m.values[ sc ] )
+                        m.values[ sc ] = secs;
+                }
+            }
+
+            printf( "%s,%u,%g,%.0f,%llu,%.6f,%.1f,%.0f,%.0f", GetCorpusName( kind ), factor, gen.GetSeconds(), m.edges,
+                    ( unsigned long long )numFrames, m.values[ M_DecodeTime ], m.edges > 0 ? m.values[ M_DecodeTime ] * 1e9 / m.edges : 0.0,
+                    m.values[ M_PeakHeap ] / 1024, m.values[ M_RetainedHeap ] / 1024 );
+            for( int sc = 0; sc < PS_Count; ++sc )
+                printf( ",%.6f", m.values[ sc ] );
+
+            printf( "\n" );
+            fflush( stdout );
+
+            measurements.push_back( m );
+        }
+
+        for( int mc = 0; mc < M_Count; ++mc )
+        {
+            double exponent;
+            if( !FitExponent( measurements, mc, exponent ) )
+                continue;
+
+            const bool superlinear = exponent > maxExponent;
+            fprintf( stderr, "%-14s %-16s exponent %5.2f%s\n", GetCorpusName( kind ), GetMetricName( mc ), exponent,
+                     superlinear ? "  SUPERLINEAR" : "" );
+
+            if( superlinear )
+                flagged.push_back( std::string( GetCorpusName( kind ) ) + " " + GetMetricName( mc ) );
+        }
+    }
+
+    for( size_t fc = 0; fc < flagged.size(); ++fc )
+        fprintf( stderr, "superlinear: %s\n", flagged[ fc ].c_str() );
+
+    return flagged.empty() ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#ifndef USB_FUZZ_BUDGET_H
+#define USB_FUZZ_BUDGET_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// The time the decode of a fuzz input may take: a fixed time for the setup and the end of the capture, and a
+// time for each byte of the input. A watchdog thread is armed with the budget before the decode, and aborts
+// once it runs out, so the fuzzer keeps the input like a crash; that is a hang, or a path which is quadratic in
+// something the input controls. libFuzzer's -timeout catches hangs too, but only after seconds. A decode
+// without optimization takes up to about three quarters of the budget; it can be changed with USB_FUZZ_NS_PER_BYTE
+// and USB_FUZZ_FIXED_MS.
+class USBFuzzBudget
+{
+  public:
+    // arms the watchdog with the budget of an input of size bytes
+    USBFuzzBudget( const char* pWhat, size_t size ) : mpWhat( pWhat ), mSize( size ), mBegin( std::chrono::steady_clock::now() )
+    {
+        const std::chrono::nanoseconds budget( static_cast<long long>( GetBudgetNs( size ) ) );
+        GetWatchdog().Arm( pWhat, size, mBegin + budget );
+    }
+
+    ~USBFuzzBudget()
+    {
+        GetWatchdog().Disarm();
+    }
+
+    // disarms the watchdog, and aborts if the decode took longer than the budget of the input
+    void Check() const
+    {
+        GetWatchdog().Disarm();
+
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - mBegin ).count();
+        const double budgetNs = GetBudgetNs( mSize );
+        if( ns <= budgetNs )
+            return;
+
+        fprintf( stderr, "%s: the decode of %u bytes took %.3f ms, over the budget of %.3f ms (%.0f ns per byte)\n", mpWhat,
+                 unsigned( mSize ), ns / 1e6, budgetNs / 1e6, mSize > 0 ? ns / mSize : 0.0 );
+        abort();
+    }
+
+    static double GetBudgetNs( size_t size )
+    {
+        return GetFixedMs() * 1e6 + GetNsPerByte() * size;
+    }
+
+  private:
+    // waits for the deadline of the decode which is running, and aborts if the decode is still running then
+    class Watchdog
+    {
+      public:
+        Watchdog() : mArmed( false ), mpWhat( NULL ), mSize( 0 )
+        {
+            std::thread( &Watchdog::Run, this ).detach();
+        }
+
+        void Arm( const char* pWhat, size_t size, std::chrono::steady_clock::time_point deadline )
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mArmed = true;
+            mpWhat = pWhat;
+            mSize = size;
+            mDeadline = deadline;
+            mWake.notify_one();
+        }
+
+        void Disarm()
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mArmed = false;
+        }
+
+      private:
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock( mMutex );
+            for( ;; )
+            {
+                if( !mArmed )
+                    mWake.wait( lock );
+                else if( std::chrono::steady_clock::now() < mDeadline )
+                    mWake.wait_until( lock, mDeadline );
+                else
+                {
+                    fprintf( stderr, "%s: the decode of %u bytes is still running after its budget of %.3f ms\n", mpWhat,
+                             unsigned( mSize ), GetBudgetNs( mSize ) / 1e6 );
+                    abort();
+                }
+            }
+        }
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        bool mArmed;
+        const char* mpWhat;
+        size_t mSize;
+        std::chrono::steady_clock::time_point mDeadline;
+    };
+
+    // never deleted, so the thread doesn't outlive it at exit
+    static Watchdog& GetWatchdog()
+    {
+        static Watchdog* pWatchdog = new Watchdog();
+        return *pWatchdog;
+    }
+
+    static double GetNsPerByte()
+    {
+        static const double nsPerByte = GetEnv( "USB_FUZZ_NS_PER_BYTE", 25000 );
+        return nsPerByte;
+    }
+
+    static double GetFixedMs()
+    {
+        static const double fixedMs = GetEnv( "USB_FUZZ_FIXED_MS", 20 );
+        return fixedMs;
+    }
+
+    static double GetEnv( const char* pName, double defaultValue )
+    {
+        const char* pValue = getenv( pName );
+        return pValue != NULL && atof( pValue ) > 0 ? atof( pValue ) : defaultValue;
+    }
+
+    const char* mpWhat;
+    size_t mSize;
+    std::chrono::steady_clock::time_point mBegin;
+};
+
+#endif // USB_FUZZ_BUDGET_H
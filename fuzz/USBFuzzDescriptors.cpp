@@ -0,0 +1,80 @@
+// Fuzzes the control transfer parser with whole control transfers, so the bytes reach the descriptor, class and
+// HID report descriptor parsers instead of stopping at a bad CRC or an unexpected packet. The device model keeps
+// what the transfers before set, such as the interfaces of a configuration and the address.
+//
+// The first byte of the input picks the max packet size of endpoint 0. The rest is a list of transfers, each the
+// eight bytes of the setup packet, the length of the data stage in two bytes (little endian) and its bytes. The
+// data stage goes the way bmRequestType says, and is cut to the bytes the input has left.
+
+#include <stdint.h>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBFuzzBudget.h"
+
+static void Transaction( USBBusGenerator& gen, USB_PID token, int addr, USB_PID data, const std::vector<U8>& payload, bool fromHost )
+{
+    gen.KeepFrames();
+    gen.Token( token, addr, 0, FULL_SPEED );
+    gen.Data( data, payload, FULL_SPEED, fromHost );
+    gen.Handshake( PID_ACK, FULL_SPEED, !fromHost );
+}
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* pData, size_t size )
+{
+    if( size < 1 )
+        return 0;
+
+    static const size_t maxPacketSizes[] = { 8, 16, 32, 64 };
+    const size_t maxPacket = maxPacketSizes[ pData[ 0 ] & 0x03 ];
+    const U32 sampleRate = 24000000;
+
+    USBBusGenerator gen( FULL_SPEED, sampleRate, 0 );
+    gen.Reset();
+
+    int addr = 0;
+    for( size_t bc = 1; bc + 10 <= size; )
+    {
+        const std::vector<U8> setup( pData + bc, pData + bc + 8 );
+        size_t length = pData[ bc + 8 ] | pData[ bc + 9 ] << 8;
+        bc += 10;
+
+        if( length > size - bc )
+            length = size - bc;
+
+        const std::vector<U8> data( pData + bc, pData + bc + length );
+        bc += length;
+
+        const bool deviceToHost = ( setup[ 0 ] & 0x80 ) != 0;
+        Transaction( gen, PID_SETUP, addr, PID_DATA0, setup, true );
+
+        // the data stage in packets of the max packet size, without a zero length packet at the end
+        bool data1 = true;
+        for( size_t offset = 0; offset < data.size(); offset += maxPacket )
+        {
+            const size_t chunk = data.size() - offset < maxPacket ? data.size() - offset : maxPacket;
+            const std::vector<U8> payload( data.begin() + offset, data.begin() + offset + chunk );
+            Transaction( gen, deviceToHost ? PID_IN : PID_OUT, addr, data1 ? PID_DATA1 : PID_DATA0, payload, !deviceToHost );
+            data1 = !data1;
+        }
+
+        // the status stage goes the other way
+        Transaction( gen, deviceToHost ? PID_OUT : PID_IN, addr, PID_DATA1, std::vector<U8>(), deviceToHost );
+
+        // a SET_ADDRESS moves the device once its status stage is done
+        if( setup[ 0 ] == 0x00 && setup[ 1 ] == 0x05 )
+            addr = setup[ 2 ] & 0x7f;
+    }
+
+    USBFuzzBudget budget( "usb_fuzz_descriptors", size );
+
+    USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), gen.GetEndSample() );
+    USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), gen.GetEndSample() );
+    USBCountingSink sink;
+    USBDecoder decoder( &sink, sampleRate, FULL_SPEED, OUT_CONTROL_TRANSFERS );
+    decoder.Decode( &dp, &dm );
+
+    budget.Check();
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Fuzzes the signal filter and the packet decoder with raw line states, which are mostly not USB at all: glitches,
+// SE1, bits of any length and packets cut anywhere.
+//
+// The first byte of the input picks the speed, the decode level and the sample rate. Each byte after it is one
+// state of the lines for a time: the low two bits are the state (J, K, SE0 or SE1) and the high six bits the
+// time, in quarter bits of the bus speed less one.
+
+#include <stdint.h>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBFuzzBudget.h"
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* pData, size_t size )
+{
+    if( size < 1 )
+        return 0;
+
+    static const U32 sampleRates[] = { 24000000, 12000000, 100000000, 500000000 };
+    static const USBDecodeLevel levels[] = { OUT_PACKETS, OUT_BYTES, OUT_SIGNALS, OUT_CONTROL_TRANSFERS };
+
+    const USBSpeed speed = ( pData[ 0 ] & 0x01 ) != 0 ? LOW_SPEED : FULL_SPEED;
+    const USBDecodeLevel level = levels[ ( pData[ 0 ] >> 1 ) & 0x03 ];
+    const U32 sampleRate = sampleRates[ ( pData[ 0 ] >> 3 ) & 0x03 ];
+    const double quarterBit = sampleRate / ( speed == FULL_SPEED ? 12e6 : 1.5e6 ) / 4;
+
+    // J is D+ high on a full speed bus and D- high on a low speed bus
+    const USBBitState j = speed == FULL_SPEED ? BS_High : BS_Low;
+    const USBBitState dpStates[] = { j, InvertBitState( j ), BS_Low, BS_High };
+    const USBBitState dmStates[] = { InvertBitState( j ), j, BS_Low, BS_High };
+
+    // every state is at least a sample long, so the edges of a line never fall on the same sample
+    std::vector<U64> edges[ 2 ];
+    USBBitState states[ 2 ] = { dpStates[ 0 ], dmStates[ 0 ] };
+    double time = 0;
+    for( size_t bc = 1; bc < size; ++bc )
+    {
+        const USBBitState next[ 2 ] = { dpStates[ pData[ bc ] & 0x03 ], dmStates[ pData[ bc ] & 0x03 ] };
+        for( int lc = 0; lc < 2; ++lc )
+        {
+            if( next[ lc ] != states[ lc ] )
+                edges[ lc ].push_back( U64( time ) );
+
+            states[ lc ] = next[ lc ];
+        }
+
+        const double dur = ( ( pData[ bc ] >> 2 ) + 1 ) * quarterBit;
+        time += dur < 1 ? 1 : dur;
+    }
+
+    USBFuzzBudget budget( "usb_fuzz_edges", size );
+
+    USBEdgeVectorSource dp( dpStates[ 0 ], edges[ 0 ], U64( time ) + 1 );
+    USBEdgeVectorSource dm( dmStates[ 0 ], edges[ 1 ], U64( time ) + 1 );
+    USBCountingSink sink;
+    USBDecoder decoder( &sink, sampleRate, speed, level );
+    decoder.Decode( &dp, &dm );
+
+    budget.Check();
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Runs a harness without libFuzzer, for compilers which don't have it: it replays the inputs of the files given,
+// such as the crashes and the corpus of a fuzzer run, and with --random it also runs that many inputs made by
+// mutating those files, or random ones without them. This finds no more than random testing does, but the
+// harnesses build and run everywhere. An input which crashes or goes over its time budget is named on stderr
+// and written to crash-input, to replay it.
+//
+// usage: usb_fuzz_<harness> [--random <n>] [--seed <n>] [--max-len <n>] [input files]
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "USBFuzzBudget.h"
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* pData, size_t size );
+
+// the input which is running and its name, for the crash handler
+static const std::vector<uint8_t>* CurrentInput = NULL;
+static std::string CurrentName;
+
+static void OnCrash( int sig )
+{
+    if( CurrentInput != NULL )
+    {
+        FILE* pFile = fopen( "crash-input", "wb" );
+        if( pFile != NULL )
+        {
+            if( !CurrentInput->empty() )
+                fwrite( &( *CurrentInput )[ 0 ], 1, CurrentInput->size(), pFile );
+
+            fclose( pFile );
+            fprintf( stderr, "the input, %s, is in crash-input\n", CurrentName.c_str() );
+        }
+    }
+
+    signal( sig, SIG_DFL );
+    raise( sig );
+}
+
+static void Run( const std::vector<uint8_t>& data, const std::string& name )
+{
+    CurrentName = name;
+    CurrentInput = &data;
+    LLVMFuzzerTestOneInput( data.empty() ? NULL : &data[ 0 ], data.size() );
+    CurrentInput = NULL;
+}
+
+static bool ReadFile( const char* path, std::vector<uint8_t>& data )
+{
+    FILE* pFile = fopen( path, "rb" );
+    if( pFile == NULL )
+        return false;
+
+    uint8_t buffer[ 4096 ];
+    size_t read;
+    data.clear();
+    while( ( read = fread( buffer, 1, sizeof( buffer ), pFile ) ) > 0 )
+        data.insert( data.end(), buffer, buffer + read );
+
+    fclose( pFile );
+    return true;
+}
+
+class Random
+{
+  public:
+    explicit Random( uint32_t seed ) : mState( seed )
+    {
+    }
+
+    uint32_t Next( uint32_t range )
+    {
+        mState = mState * 1664525 + 1013904223;
+        return range > 0 ? ( mState >> 8 ) % range : 0;
+    }
+
+  private:
+    uint32_t mState;
+};
+
+// flips, changes, inserts and removes a few bytes, or joins two inputs
+static void Mutate( std::vector<uint8_t>& data, const std::vector<std::vector<uint8_t> >& inputs, size_t maxLen, Random& rnd )
+{
+    const int numMutations = 1 + rnd.Next( 8 );
+    for( int mc = 0; mc < numMutations; ++mc )
+    {
+        const size_t pos = rnd.Next( uint32_t( data.size() + 1 ) );
+        switch( rnd.Next( 5 ) )
+        {
+        case 0:
+            if( pos < data.size() )
+                data[ pos ] ^= uint8_t( 1 << rnd.Next( 8 ) );
+            break;
+        case 1:
+            if( pos < data.size() )
+                data[ pos ] = uint8_t( rnd.Next( 256 ) );
+            break;
+        case 2:
+            data.insert( data.begin() + pos, uint8_t( rnd.Next( 256 ) ) );
+            break;
+        case 3:
+            if( pos < data.size() )
+                data.erase( data.begin() + pos );
+            break;
+        default:
+            if( !inputs.empty() )
+            {
+                const std::vector<uint8_t>& other = inputs[ rnd.Next( uint32_t( inputs.size() ) ) ];
+                data.insert( data.begin() + pos, other.begin(), other.end() );
+            }
+            break;
+        }
+    }
+
+    if( data.size() > maxLen )
+        data.resize( maxLen );
+}
+
+int main( int argc, char* argv[] )
+{
+    unsigned long numRandom = 0;
+    uint32_t seed = 1;
+    size_t maxLen = 4096;
+    std::vector<const char*> paths;
+
+    for( int ac = 1; ac < argc; ++ac )
+    {
+        const char* pValue = ac + 1 < argc ? argv[ ac + 1 ] : NULL;
+        if( strcmp( argv[ ac ], "--random" ) == 0 && pValue != NULL )
+            numRandom = strtoul( argv[ ++ac ], NULL, 10 );
+        else if( strcmp( argv[ ac ], "--seed" ) == 0 && pValue != NULL )
+            seed = uint32_t( strtoul( argv[ ++ac ], NULL, 10 ) );
+        else if( strcmp( argv[ ac ], "--max-len" ) == 0 && pValue != NULL && atoi( pValue ) > 0 )
+            maxLen = size_t( atoi( argv[ ++ac ] ) );
+        else if( argv[ ac ][ 0 ] != '-' )
+            paths.push_back( argv[ ac ] );
+        else
+        {
+            fprintf( stderr, "usage: %s [--random <n>] [--seed <n>] [--max-len <n>] [input files]\n", argv[ 0 ] );
+            return 2;
+        }
+    }
+
+    signal( SIGABRT, OnCrash );
+    signal( SIGSEGV, OnCrash );
+    signal( SIGFPE, OnCrash );
+
+    std::vector<std::vector<uint8_t> > inputs( paths.size() );
+    for( size_t pc = 0; pc < paths.size(); ++pc )
+    {
+        if( !ReadFile( paths[ pc ], inputs[ pc ] ) )
+        {
+            fprintf( stderr, "can't read %s\n", paths[ pc ] );
+            return 1;
+        }
+
+        Run( inputs[ pc ], paths[ pc ] );
+    }
+
+    // the input closest to its time budget, which includes making the edges here
+    double maxBudgetUsed = 0;
+    Random rnd( seed );
+    for( unsigned long rc = 0; rc < numRandom; ++rc )
+    {
+        std::vector<uint8_t> data;
+        if( !inputs.empty() )
+        {
+            data = inputs[ rnd.Next( uint32_t( inputs.size() ) ) ];
+        }
+        else
+        {
+            data.resize( rnd.Next( uint32_t( maxLen ) ) );
+            for( size_t bc = 0; bc < data.size(); ++bc )
+                data[ bc ] = uint8_t( rnd.Next( 256 ) );
+        }
+
+        Mutate( data, inputs, maxLen, rnd );
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        Run( data, "random input " + std::to_string( rc + 1 ) + " of seed " + std::to_string( seed ) );
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - begin ).count();
+
+        if( ns / USBFuzzBudget::GetBudgetNs( data.size() ) > maxBudgetUsed )
+            maxBudgetUsed = ns / USBFuzzBudget::GetBudgetNs( data.size() );
+    }
+
+    printf( "ran %u inputs and %lu random ones", unsigned( inputs.size() ), numRandom );
+    if( numRandom > 0 )
+        printf( ", in at most %.1f%% of the time budget", maxBudgetUsed * 100 );
+
+    printf( "\n" );
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Fuzzes the packet handlers with well formed signals of packets with any content: PIDs which don't belong where
+// they are, tokens to any pipe, data packets of any length and transfers which stop anywhere.
+//
+// The first byte of the input picks the speed of the bus and the decode level. The rest is a list of packets,
+// each a header byte and the bytes of the packet after the SYNC. The low six bits of the header are the number
+// of bytes. With bit 7 set the packet gets a good CRC: the bytes are a token PID, the address and the endpoint,
+// or a data PID and the payload. With bit 6 set the bus is reset before the packet.
+
+#include <stdint.h>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBFuzzBudget.h"
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* pData, size_t size )
+{
+    if( size < 1 )
+        return 0;
+
+    static const USBDecodeLevel levels[] = { OUT_PACKETS, OUT_BYTES, OUT_SIGNALS, OUT_CONTROL_TRANSFERS };
+
+    const USBSpeed speed = ( pData[ 0 ] & 0x01 ) != 0 ? LOW_SPEED : FULL_SPEED;
+    const USBDecodeLevel level = levels[ ( pData[ 0 ] >> 1 ) & 0x03 ];
+    const U32 sampleRate = 24000000;
+
+    USBBusGenerator gen( speed, sampleRate, 0 );
+    gen.Idle( 16 );
+
+    for( size_t bc = 1; bc < size; )
+    {
+        const U8 header = pData[ bc++ ];
+        const size_t length = header & 0x3f;
+        if( length > size - bc )
+            break;
+
+        const std::vector<U8> bytes( pData + bc, pData + bc + length );
+        bc += length;
+
+        if( ( header & 0x40 ) != 0 )
+            gen.Reset();
+
+        const USB_PID pid = bytes.empty() ? PID_ACK : USB_PID( bytes[ 0 ] );
+        if( ( header & 0x80 ) == 0 || bytes.empty() )
+        {
+            std::vector<U8> packet( 1, 0x80 );
+            packet.insert( packet.end(), bytes.begin(), bytes.end() );
+            gen.Packet( packet, speed, true );
+        }
+        else if( pid == PID_IN || pid == PID_OUT || pid == PID_SETUP || pid == PID_SOF )
+        {
+            gen.Token( pid, bytes.size() > 1 ? bytes[ 1 ] & 0x7f : 0, bytes.size() > 2 ? bytes[ 2 ] & 0x0f : 0, speed );
+        }
+        else
+        {
+            gen.Data( pid, std::vector<U8>( bytes.begin() + 1, bytes.end() ), speed, false );
+        }
+
+        gen.Idle( 2 );
+    }
+
+    USBFuzzBudget budget( "usb_fuzz_packets", size );
+
+    USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), gen.GetEndSample() );
+    USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), gen.GetEndSample() );
+    USBCountingSink sink;
+    USBDecoder decoder( &sink, sampleRate, speed, level );
+    decoder.Decode( &dp, &dm );
+
+    budget.Check();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Fuzzes the HID report decoder: a device with one HID interface sends a report descriptor of any content through
+// GET_DESCRIPTOR, so it is compiled into the report layout, and then reports of any content on the interrupt IN
+// endpoint of that interface, which are decoded with the layout.
+//
+// The first byte of the input picks the speed of the bus with bit 7, and the max packet size of the interrupt
+// endpoint with the low six bits, plus one; a low speed endpoint has at most eight bytes. The next two bytes are
+// the length of the report descriptor (little endian), and its bytes follow. The rest is a list of interrupt
+// packets, each a length byte and the payload, the length cut to the max packet size.
+
+#include <stdint.h>
+#include <vector>
+
+#include "USBBenchmarkCorpus.h"
+#include "USBDecoder.h"
+#include "USBFuzzBudget.h"
+
+static void Transaction( USBBusGenerator& gen, USBSpeed speed, USB_PID token, int addr, int endp, USB_PID data,
+                         const std::vector<U8>& payload, bool fromHost )
+{
+    gen.KeepFrames();
+    gen.Token( token, addr, endp, speed );
+    gen.Data( data, payload, speed, fromHost );
+    gen.Handshake( PID_ACK, speed, !fromHost );
+}
+
+// a control transfer to endpoint 0, with its data stage in packets of maxPacket bytes
+static void ControlTransfer( USBBusGenerator& gen, USBSpeed speed, int addr, size_t maxPacket, const U8 setup[ 8 ],
+                             const std::vector<U8>& data )
+{
+    const bool deviceToHost = ( setup[ 0 ] & 0x80 ) != 0;
+    Transaction( gen, speed, PID_SETUP, addr, 0, PID_DATA0, std::vector<U8>( setup, setup + 8 ), true );
+
+    bool data1 = true;
+    for( size_t offset = 0; offset < data.size(); offset += maxPacket )
+    {
+        const size_t chunk = data.size() - offset < maxPacket ? data.size() - offset : maxPacket;
+        const std::vector<U8> payload( data.begin() + offset, data.begin() + offset + chunk );
+        Transaction( gen, speed, deviceToHost ? PID_IN : PID_OUT, addr, 0, data1 ? PID_DATA1 : PID_DATA0, payload, !deviceToHost );
+        data1 = !data1;
+    }
+
+    Transaction( gen, speed, deviceToHost ? PID_OUT : PID_IN, addr, 0, PID_DATA1, std::vector<U8>(), deviceToHost );
+}
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* pData, size_t size )
+{
+    if( size < 3 )
+        return 0;
+
+    const USBSpeed speed = ( pData[ 0 ] & 0x80 ) != 0 ? LOW_SPEED : FULL_SPEED;
+    size_t maxPacket = ( pData[ 0 ] & 0x3f ) + 1;
+    if( speed == LOW_SPEED && maxPacket > 8 )
+        maxPacket = 8;
+
+    const size_t controlMaxPacket = speed == LOW_SPEED ? 8 : 64;
+    const U32 sampleRate = 24000000;
+
+    USBBusGenerator gen( speed, sampleRate, 0 );
+    gen.Reset();
+
+    // the device is at address 1, with interface 0 of the HID class and its interrupt IN endpoint 1
+    const U8 setAddress[ 8 ] = { 0x00, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    const U8 config[] = { 0x09, 0x02, 0x22, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,  // configuration
+                          0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00,  // interface
+                          0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x00, 0x00,  // HID
+                          0x07, 0x05, 0x81, 0x03, U8( maxPacket ), 0x00, 0x0A }; // endpoint
+    const U8 getConfig[ 8 ] = { 0x80, 0x06, 0x00, 0x02, 0x00, 0x00, sizeof( config ), 0x00 };
+    const U8 setConfig[ 8 ] = { 0x00, 0x09, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    ControlTransfer( gen, speed, 0, controlMaxPacket, setAddress, std::vector<U8>() );
+    ControlTransfer( gen, speed, 1, controlMaxPacket, getConfig, std::vector<U8>( config, config + sizeof( config ) ) );
+    ControlTransfer( gen, speed, 1, controlMaxPacket, setConfig, std::vector<U8>() );
+
+    // the report descriptor
+    size_t bc = 3;
+    size_t descLength = pData[ 1 ] | pData[ 2 ] << 8;
+    if( descLength > size - bc )
+        descLength = size - bc;
+
+    const std::vector<U8> reportDesc( pData + bc, pData + bc + descLength );
+    bc += descLength;
+
+    const U8 getReportDesc[ 8 ] = { 0x81, 0x06, 0x00, 0x22, 0x00, 0x00, U8( descLength ), U8( descLength >> 8 ) };
+    ControlTransfer( gen, speed, 1, controlMaxPacket, getReportDesc, reportDesc );
+
+    // the reports
+    bool data1 = false;
+    while( bc < size )
+    {
+        size_t length = pData[ bc++ ] % ( maxPacket + 1 );
+        if( length > size - bc )
+            length = size - bc;
+
+        const std::vector<U8> payload( pData + bc, pData + bc + length );
+        bc += length;
+
+        Transaction( gen, speed, PID_IN, 1, 1, data1 ? PID_DATA1 : PID_DATA0, payload, false );
+        data1 = !data1;
+    }
+
+    USBFuzzBudget budget( "usb_fuzz_reports", size );
+
+    USBEdgeVectorSource dp( gen.GetInitialState( 0 ), gen.GetEdges( 0 ), gen.GetEndSample() );
+    USBEdgeVectorSource dm( gen.GetInitialState( 1 ), gen.GetEdges( 1 ), gen.GetEndSample() );
+    USBCountingSink sink;
+    USBDecoder decoder( &sink, sampleRate, speed, OUT_CONTROL_TRANSFERS );
+    decoder.Decode( &dp, &dm );
+
+    budget.Check();
+    return 0;
+}
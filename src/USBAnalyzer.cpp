@@ -5,6 +5,7 @@
 
 #include "USBAnalyzer.h"
 #include "USBAnalyzerSettings.h"
+#include "USBDecoder.h"
 
 USBAnalyzer::USBAnalyzer() : mSimulationInitilized( false )
 {
@@ -32,123 +33,62 @@ bool FrameLessThan( const Frame& lhs, const Frame& rhs )
     return lhs.mStartingSampleInclusive < rhs.mStartingSampleInclusive;
 }
 
-U64 USBAnalyzer::SendPacketToHandler( USBPacket& pckt )
+void USBAnalyzer::ResultsFrameSink::AddFrame( const USBFrame& f )
 {
-    if( pckt.IsTokenPacket() )
-    {
-        mCtrlTransLastPipe.addr = pckt.GetAddress();
-        mCtrlTransLastPipe.endp = pckt.GetEndpoint();
-    }
+    Frame frame;
+    frame.mStartingSampleInclusive = f.mStartingSampleInclusive;
+    frame.mEndingSampleInclusive = f.mEndingSampleInclusive;
+    frame.mData1 = f.mData1;
+    frame.mData2 = f.mData2;
+    frame.mType = f.mType;
+    frame.mFlags = f.mFlags;
+
+    mAnalyzer->mResults->AddFrame( frame );
+}
 
-    // only control transfers and no SOF or PRE packets
-    if( mCtrlTransLastPipe.endp == 0 && pckt.mPID != PID_SOF && pckt.mPID != PID_PRE )
-    {
-        // do we have this address/enpoint already?
-        USBPipeHandler::iterator srch( mCtrlTransPacketHandlers.find( mCtrlTransLastPipe ) );
+void USBAnalyzer::ResultsFrameSink::CommitFrames()
+{
+    mAnalyzer->mResults->CommitResults();
+}
 
-        // is this a new address?
-        if( srch == mCtrlTransPacketHandlers.end() )
-        {
-            srch = mCtrlTransPacketHandlers.insert( std::make_pair( mCtrlTransLastPipe, USBControlTransferPacketHandler() ) ).first;
-            srch->second.Init( mResults.get(), mCtrlTransLastPipe.addr );
-        }
+void USBAnalyzer::ResultsFrameSink::AddBitMarker( U64 sample, USBBitMarker markerType )
+{
+    AnalyzerResults::MarkerType marker = markerType == BM_Zero  ? AnalyzerResults::Zero
+                                         : markerType == BM_One ? AnalyzerResults::One
+                                                                : AnalyzerResults::ErrorX;
+    mAnalyzer->mResults->AddMarker( sample, marker, mAnalyzer->mSettings.mDPChannel );
+}
 
-        return srch->second.HandleControlTransfer( pckt );
-    }
+void USBAnalyzer::ResultsFrameSink::AddStringDescriptor( int addr, int id, const std::string& stringDesc )
+{
+    mAnalyzer->mResults->AddStringDescriptor( addr, id, stringDesc );
+}
 
-    return pckt.AddPacketFrames( mResults.get() );
+void USBAnalyzer::ResultsFrameSink::CopyStringDescriptors( int fromAddr, int toAddr )
+{
+    mAnalyzer->mResults->CopyStringDescriptors( fromAddr, toAddr );
+}
+
+void USBAnalyzer::ResultsFrameSink::ReportProgress( U64 sample )
+{
+    mAnalyzer->ReportProgress( sample );
+    mAnalyzer->CheckIfThreadShouldExit();
 }
 
 void USBAnalyzer::WorkerThread()
 {
     // get the channel pointers
-    mDP = GetAnalyzerChannelData( mSettings.mDPChannel );
-    mDM = GetAnalyzerChannelData( mSettings.mDMChannel );
-
-    USBSignalFilter sf( this, mResults.get(), &mSettings, mDP, mDM, mSettings.mSpeed );
+    ChannelEdgeSource dp( GetAnalyzerChannelData( mSettings.mDPChannel ) );
+    ChannelEdgeSource dm( GetAnalyzerChannelData( mSettings.mDMChannel ) );
 
-    const double BIT_DUR = mSettings.mSpeed == FULL_SPEED ? FS_BIT_DUR : LS_BIT_DUR;
-    const double SAMPLE_DUR = 1e9 / GetSampleRate(); // 1 sample duration in ns
-    const double BIT_SAMPLES = BIT_DUR / SAMPLE_DUR;
+    ResultsFrameSink sink( this );
+    USBDecoder decoder( &sink, GetSampleRate(), mSettings.mSpeed, mSettings.mDecodeLevel );
 
-    ResetUSB();
+    mPerfCounters.Clear();
+    if( mSettings.mPerfCounters )
+        decoder.SetPerfCounters( &mPerfCounters );
 
-    USBSignalState s;
-    USBPacket pckt;
-    U64 lastFrameEnd = 0;
-    while( sf.HasMoreData() )
-    {
-        s = sf.GetState();
-
-        if( mSettings.mDecodeLevel == OUT_SIGNALS )
-        {
-            s.AddFrame( mResults.get() );
-        }
-        else
-        {
-            if( lastFrameEnd == 0 )
-                lastFrameEnd = s.mSampleBegin;
-
-            // if this is a data signal
-            if( sf.IsDataSignal( s ) )
-            {
-                // try reading an entire USB packet by parsing subsequent data signals
-                if( sf.GetPacket( pckt, s ) )
-                {
-                    if( mSettings.mDecodeLevel == OUT_CONTROL_TRANSFERS )
-                        lastFrameEnd = SendPacketToHandler( pckt );
-                    else if( mSettings.mDecodeLevel == OUT_PACKETS )
-                        lastFrameEnd = pckt.AddPacketFrames( mResults.get() );
-                    else if( mSettings.mDecodeLevel == OUT_BYTES )
-                        lastFrameEnd = pckt.AddRawByteFrames( mResults.get() );
-                }
-                else
-                {
-                    lastFrameEnd = pckt.AddErrorFrame( mResults.get() );
-                }
-            }
-            else if( mSettings.mSpeed == LOW_SPEED // is this a LS Keep-alive?
-                     && s.mState == S_SE0 && s.GetNumBits( LOW_SPEED ) == 2 )
-            {
-                Frame f;
-                f.mStartingSampleInclusive = lastFrameEnd;
-                f.mEndingSampleInclusive = s.mSampleEnd;
-                f.mType = FT_KeepAlive;
-                f.mFlags = FF_None;
-                f.mData1 = f.mData2 = 0;
-
-                mResults->AddFrame( f );
-                mResults->CommitResults();
-
-                lastFrameEnd = s.mSampleEnd;
-            }
-            else if( s.mState == S_SE0 && s.mDur > 1e7 )
-            { // Reset?   dur > 10 ms
-
-                Frame f;
-                f.mStartingSampleInclusive = lastFrameEnd;
-                f.mEndingSampleInclusive = s.mSampleEnd;
-                f.mType = FT_Reset;
-                f.mFlags = FF_None;
-                f.mData1 = f.mData2 = 0;
-
-                mResults->AddFrame( f );
-                mResults->CommitResults();
-
-                lastFrameEnd = s.mSampleEnd;
-
-                ResetUSB();
-            }
-            else if( s.mState == S_J )
-            { // Idle
-
-                lastFrameEnd = s.mSampleEnd;
-            }
-        }
-
-        ReportProgress( s.mSampleEnd );
-        CheckIfThreadShouldExit();
-    }
+    decoder.Decode( &dp, &dm );
 }
 
 bool USBAnalyzer::NeedsRerun()
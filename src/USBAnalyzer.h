@@ -2,13 +2,15 @@
 #define USB_ANALYZER_H
 
 #include <Analyzer.h>
+#include <AnalyzerChannelData.h>
 
 #include "USBAnalyzerSettings.h"
 #include "USBAnalyzerResults.h"
 #include "USBSimulationDataGenerator.h"
 
-#include "USBTypes.h"
-#include "USBControlTransfers.h"
+#include "USBEdgeSource.h"
+#include "USBFrameSink.h"
+#include "USBPerfCounters.h"
 
 class USBAnalyzer : public Analyzer2
 {
@@ -23,65 +25,96 @@ class USBAnalyzer : public Analyzer2
     virtual const char* GetAnalyzerName() const;
     virtual bool NeedsRerun();
 
-    std::string GetTimeStr( U64 sample )
+    // of the last decode, if the settings turned them on
+    const USBPerfCounters& GetPerfCounters() const
     {
-        char time_str[ 128 ];
-        AnalyzerHelpers::GetTimeString( sample, GetTriggerSample(), GetSampleRate(), time_str, sizeof( time_str ) );
-
-        return time_str;
+        return mPerfCounters;
     }
 
   protected: // functions
     virtual void SetupResults();
 
-    struct USBPipe
+    // reads a channel of the capture
+    class ChannelEdgeSource : public USBEdgeSource
     {
-        int addr;
-        int endp;
+      public:
+        ChannelEdgeSource( AnalyzerChannelData* pChannel ) : mChannel( pChannel )
+        {
+        }
 
-        USBPipe()
+        virtual U64 GetSampleNumber()
         {
-            Clear();
+            return mChannel->GetSampleNumber();
         }
 
-        void Clear()
+        virtual USBBitState GetBitState()
         {
-            addr = endp = 0;
+            return mChannel->GetBitState() == BIT_HIGH ? BS_High : BS_Low;
         }
 
-        bool operator<( const USBPipe& rhs ) const
+        virtual U64 GetSampleOfNextEdge()
         {
-            if( addr == rhs.addr )
-                return endp < rhs.endp;
+            return mChannel->GetSampleOfNextEdge();
+        }
 
-            return addr < rhs.addr;
+        virtual void AdvanceToNextEdge()
+        {
+            mChannel->AdvanceToNextEdge();
+        }
+
+        virtual void AdvanceToAbsPosition( U64 sample )
+        {
+            mChannel->AdvanceToAbsPosition( sample );
+        }
+
+        virtual bool WouldAdvancingCauseTransition( U32 numSamples )
+        {
+            return mChannel->WouldAdvancingCauseTransition( numSamples );
         }
-    };
 
-    // address to packet handler
-    typedef std::map<USBPipe, USBControlTransferPacketHandler> USBPipeHandler;
+        virtual bool WouldAdvancingToAbsPositionCauseTransition( U64 sample )
+        {
+            return mChannel->WouldAdvancingToAbsPositionCauseTransition( sample );
+        }
 
-    USBPipeHandler mCtrlTransPacketHandlers;
-    USBPipe mCtrlTransLastPipe;
+        virtual bool DoMoreTransitionsExistInCurrentData()
+        {
+            return mChannel->DoMoreTransitionsExistInCurrentData();
+        }
 
-    U64 SendPacketToHandler( USBPacket& pckt );
+      protected:
+        AnalyzerChannelData* mChannel;
+    };
 
-    void ResetUSB()
+    // passes the decoded frames on to the results, and lets the app stop the decoder
+    class ResultsFrameSink : public USBFrameSink
     {
-        mCtrlTransPacketHandlers.clear();
-        mCtrlTransLastPipe.Clear();
-    }
+      public:
+        ResultsFrameSink( USBAnalyzer* pAnalyzer ) : mAnalyzer( pAnalyzer )
+        {
+        }
+
+        virtual void AddFrame( const USBFrame& f );
+        virtual void CommitFrames();
+        virtual void AddBitMarker( U64 sample, USBBitMarker markerType );
+        virtual void AddStringDescriptor( int addr, int id, const std::string& stringDesc );
+        virtual void CopyStringDescriptors( int fromAddr, int toAddr );
+        virtual void ReportProgress( U64 sample );
+
+      protected:
+        USBAnalyzer* mAnalyzer;
+    };
 
   protected: // vars
     USBAnalyzerSettings mSettings;
     std::auto_ptr<USBAnalyzerResults> mResults;
 
-    AnalyzerChannelData* mDP;
-    AnalyzerChannelData* mDM;
 
     USBSimulationDataGenerator mSimulationDataGenerator;
 
     bool mSimulationInitilized;
+
+    USBPerfCounters mPerfCounters;
 };
 
 extern "C" ANALYZER_EXPORT const char* __cdecl GetAnalyzerName();
@@ -1,9 +1,14 @@
 #ifndef USB_ANALYZER_RESULTS_H
 #define USB_ANALYZER_RESULTS_H
 
+#include <mutex>
+
 #include <AnalyzerResults.h>
 
 #include "USBTypes.h"
+#include "USBBubbleTextCache.h"
+#include "USBFrameFormatters.h"
+#include "USBIdsDatabase.h"
 
 class USBAnalyzer;
 class USBAnalyzerSettings;
@@ -21,25 +26,42 @@ class USBAnalyzerResults : public AnalyzerResults
     void GenerateExportFilePackets( const char* file, DisplayBase display_base );
     void GenerateExportFileBytes( const char* file, DisplayBase display_base );
     void GenerateExportFileSignals( const char* file, DisplayBase display_base );
+    void GenerateExportFileUsbmon( const char* file, bool binary );
+    void GenerateExportFileColumns( const char* file );
+    void GenerateExportFilePerfCounters( const char* file );
 
     virtual void GenerateFrameTabularText( U64 frame_index, DisplayBase display_base );
     virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
     virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
 
-    void AddStringDescriptor( int addr, int id, const std::string& stringdesc )
-    {
-        mAllStringDescriptors[ std::make_pair( addr, id ) ] = stringdesc;
-    }
+    void AddStringDescriptor( int addr, int id, const std::string& stringdesc );
+
+    // gives the device at to_addr the string descriptors read from the device at from_addr
+    void CopyStringDescriptors( int from_addr, int to_addr );
 
     double GetSampleTime( S64 sample ) const;
-    std::string GetSampleTimeStr( S64 sample ) const;
 
-    typedef std::map<std::pair<U8, U8>, std::string> USBStringContainer;
+    typedef USBStringDescriptorMap USBStringContainer;
 
   protected: // functions
+    void SetStringDescriptor( int addr, int id, const std::string& stringdesc );
+
   protected: // vars
     USBAnalyzerSettings* mSettings;
 
+    // the usb.ids file of the settings, or the database they share; mpUsbIds is NULL if there is none or it
+    // can't be opened, and only the built-in names are used
+    USBIdsDatabase mUsbIds;
+    USBIdsDatabase* mpUsbIds;
+
+    // the worker thread adds the string descriptors while the UI thread makes the bubble text with them, so
+    // this guards mAllStringDescriptors, the bubble cache and the generations
+    std::mutex mStringDescriptorsMutex;
+
+    USBBubbleTextCache mBubbleCache;
+    U32 mBubbleCacheGeneration;       // mStringDescriptorsGeneration when the cache was filled
+    U32 mStringDescriptorsGeneration; // incremented on every change of mAllStringDescriptors
+
   public:
     USBAnalyzer* mAnalyzer;
 
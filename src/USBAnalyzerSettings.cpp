@@ -2,10 +2,16 @@
 
 #include "USBAnalyzerSettings.h"
 #include "USBAnalyzerResults.h"
+#include "USBIdsDatabase.h"
 #include "USBTypes.h"
 
 USBAnalyzerSettings::USBAnalyzerSettings()
-    : mDMChannel( UNDEFINED_CHANNEL ), mDPChannel( UNDEFINED_CHANNEL ), mSpeed( LOW_SPEED ), mDecodeLevel( OUT_CONTROL_TRANSFERS )
+    : mDMChannel( UNDEFINED_CHANNEL ),
+      mDPChannel( UNDEFINED_CHANNEL ),
+      mSpeed( LOW_SPEED ),
+      mDecodeLevel( OUT_CONTROL_TRANSFERS ),
+      mPerfCounters( false ),
+      mpSharedUsbIds( NULL )
 {
     // init the interface
     mDPChannelInterface.SetTitleAndTooltip( "D+", "USB D+ (green)" );
@@ -28,15 +34,39 @@ USBAnalyzerSettings::USBAnalyzerSettings()
 
     mDecodeLevelInterface.SetNumber( OUT_CONTROL_TRANSFERS );
 
+    mUsbIdsFileInterface.SetTitleAndTooltip( "usb.ids file (optional)",
+                                             "A usb.ids file with newer vendor and HID usage names than the built-in ones" );
+    mUsbIdsFileInterface.SetTextType( AnalyzerSettingInterfaceText::FilePath );
+    mUsbIdsFileInterface.SetText( "" );
+
+    mPerfCountersInterface.SetTitleAndTooltip( "Performance counters",
+                                               "Time the stages of the decoder, for the performance counters export (debug)" );
+    mPerfCountersInterface.SetCheckBoxText( "Collect performance counters" );
+    mPerfCountersInterface.SetValue( mPerfCounters );
+
     // add the interface
     AddInterface( &mDPChannelInterface );
     AddInterface( &mDMChannelInterface );
     AddInterface( &mSpeedInterface );
     AddInterface( &mDecodeLevelInterface );
+    AddInterface( &mUsbIdsFileInterface );
+    AddInterface( &mPerfCountersInterface );
 
     // describe export
-    AddExportOption( 0, "Export as text file" );
-    AddExportExtension( 0, "text", "txt" );
+    AddExportOption( EXP_TEXT, "Export as text file" );
+    AddExportExtension( EXP_TEXT, "text", "txt" );
+
+    AddExportOption( EXP_USBMON_TEXT, "Export as usbmon text" );
+    AddExportExtension( EXP_USBMON_TEXT, "usbmon text", "mon" );
+
+    AddExportOption( EXP_USBMON_BINARY, "Export as usbmon binary" );
+    AddExportExtension( EXP_USBMON_BINARY, "usbmon binary", "bin" );
+
+    AddExportOption( EXP_COLUMNS, "Export packets as binary columns" );
+    AddExportExtension( EXP_COLUMNS, "binary columns", "usbcol" );
+
+    AddExportOption( EXP_PERF_COUNTERS, "Export the performance counters (debug)" );
+    AddExportExtension( EXP_PERF_COUNTERS, "text", "txt" );
 
     ClearChannels();
 
@@ -73,6 +103,17 @@ bool USBAnalyzerSettings::SetSettingsFromInterfaces()
         return false;
     }
 
+    // only checked here, the results open the file of their settings
+    USBIdsDatabase usbIds;
+    if( *mUsbIdsFileInterface.GetText() != '\0' && !usbIds.Open( mUsbIdsFileInterface.GetText() ) )
+    {
+        SetErrorText( "Could not open the usb.ids file." );
+        return false;
+    }
+
+    mUsbIdsFile = mUsbIdsFileInterface.GetText();
+    mPerfCounters = mPerfCountersInterface.GetValue();
+
     ClearChannels();
 
     AddChannel( mDPChannel, "D+", true );
@@ -87,6 +128,8 @@ void USBAnalyzerSettings::UpdateInterfacesFromSettings()
     mDMChannelInterface.SetChannel( mDMChannel );
     mSpeedInterface.SetNumber( mSpeed );
     mDecodeLevelInterface.SetNumber( mDecodeLevel );
+    mUsbIdsFileInterface.SetText( mUsbIdsFile.c_str() );
+    mPerfCountersInterface.SetValue( mPerfCounters );
 }
 
 void USBAnalyzerSettings::LoadSettings( const char* settings )
@@ -103,6 +146,15 @@ void USBAnalyzerSettings::LoadSettings( const char* settings )
     text_archive >> s;
     mDecodeLevel = USBDecodeLevel( s );
 
+    // not in the settings of older versions
+    const char* usb_ids_file;
+    if( text_archive >> &usb_ids_file )
+        mUsbIdsFile = usb_ids_file;
+
+    // nor this
+    if( !( text_archive >> mPerfCounters ) )
+        mPerfCounters = false;
+
     ClearChannels();
 
     AddChannel( mDPChannel, "D+", true );
@@ -119,6 +171,8 @@ const char* USBAnalyzerSettings::SaveSettings()
     text_archive << mDMChannel;
     text_archive << mSpeed;
     text_archive << mDecodeLevel;
+    text_archive << mUsbIdsFile.c_str();
+    text_archive << mPerfCounters;
 
     return SetReturnString( text_archive.GetString() );
 }
@@ -1,11 +1,15 @@
 #ifndef USB_ANALYZER_SETTINGS_H
 #define USB_ANALYZER_SETTINGS_H
 
+#include <string>
+
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
 
 #include "USBTypes.h"
 
+class USBIdsDatabase;
+
 class USBAnalyzerSettings : public AnalyzerSettings
 {
   public:
@@ -23,6 +27,12 @@ class USBAnalyzerSettings : public AnalyzerSettings
 
     USBSpeed mSpeed;
     USBDecodeLevel mDecodeLevel;
+    std::string mUsbIdsFile; // optional, empty for the built-in names only
+    bool mPerfCounters;      // debug: time the stages of the decoder, for the performance counters export
+
+    // an open usb.ids database which the results use instead of opening mUsbIdsFile, for the programs which
+    // decode many captures with the same names; not owned, and not saved with the settings
+    USBIdsDatabase* mpSharedUsbIds;
 
   protected:
     AnalyzerSettingInterfaceChannel mDPChannelInterface;
@@ -30,6 +40,8 @@ class USBAnalyzerSettings : public AnalyzerSettings
 
     AnalyzerSettingInterfaceNumberList mSpeedInterface;
     AnalyzerSettingInterfaceNumberList mDecodeLevelInterface;
+    AnalyzerSettingInterfaceText mUsbIdsFileInterface;
+    AnalyzerSettingInterfaceBool mPerfCountersInterface;
 };
 
 #endif // USB_ANALYZER_SETTINGS_H
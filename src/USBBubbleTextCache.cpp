@@ -0,0 +1,42 @@
+#include "USBBubbleTextCache.h"
+
+const std::vector<std::string>* USBBubbleTextCache::Find( U64 frame_index, DisplayBase display_base )
+{
+    std::map<Key, std::list<Entry>::iterator>::iterator srch = mIndex.find( Key( frame_index, display_base ) );
+    if( srch == mIndex.end() )
+        return NULL;
+
+    // move it to the front
+    mEntries.splice( mEntries.begin(), mEntries, srch->second );
+
+    return &srch->second->mResults;
+}
+
+const std::vector<std::string>& USBBubbleTextCache::Insert( U64 frame_index, DisplayBase display_base,
+                                                            std::vector<std::string>& results )
+{
+    Key key( frame_index, display_base );
+
+    std::map<Key, std::list<Entry>::iterator>::iterator srch = mIndex.find( key );
+    if( srch != mIndex.end() )
+    {
+        mEntries.splice( mEntries.begin(), mEntries, srch->second );
+    }
+    else
+    {
+        // drop the least recently used
+        if( mEntries.size() >= mCapacity )
+        {
+            mIndex.erase( mEntries.back().mKey );
+            mEntries.pop_back();
+        }
+
+        mEntries.push_front( Entry() );
+        mEntries.front().mKey = key;
+        mIndex[ key ] = mEntries.begin();
+    }
+
+    mEntries.front().mResults.swap( results );
+
+    return mEntries.front().mResults;
+}
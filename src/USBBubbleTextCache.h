@@ -0,0 +1,47 @@
+#ifndef USB_BUBBLE_TEXT_CACHE_H
+#define USB_BUBBLE_TEXT_CACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+// LRU cache of the bubble strings generated for a frame and display base.
+// Redraws ask for the same frames over and over, and some of them (control transfer fields)
+// are expensive to format.
+class USBBubbleTextCache
+{
+  public:
+    USBBubbleTextCache( size_t capacity = 4096 ) : mCapacity( capacity )
+    {
+    }
+
+    // returns NULL if the strings are not in the cache
+    const std::vector<std::string>* Find( U64 frame_index, DisplayBase display_base );
+
+    // takes the contents of results and returns the cached copy
+    const std::vector<std::string>& Insert( U64 frame_index, DisplayBase display_base, std::vector<std::string>& results );
+
+    void Clear()
+    {
+        mEntries.clear();
+        mIndex.clear();
+    }
+
+  private:
+    typedef std::pair<U64, DisplayBase> Key;
+
+    struct Entry
+    {
+        Key mKey;
+        std::vector<std::string> mResults;
+    };
+
+    size_t mCapacity;
+    std::list<Entry> mEntries; // most recently used first
+    std::map<Key, std::list<Entry>::iterator> mIndex;
+};
+
+#endif // USB_BUBBLE_TEXT_CACHE_H
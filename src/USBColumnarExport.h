@@ -0,0 +1,49 @@
+#ifndef USB_COLUMNAR_EXPORT_H
+#define USB_COLUMNAR_EXPORT_H
+
+#include "USBCoreTypes.h"
+
+// Layout of the binary packet export. Everything is little endian and each column starts at an
+// 8 byte aligned file offset, so reader tools can mmap the file and use the columns as plain arrays:
+//
+//   USBColumnarHeader
+//   the column arrays, mNumPackets elements each, starting at mColumnOffsets[ column ]
+//   the payload blob, starting at mPayloadOffset
+//
+// The payload of packet n is COL_PayloadLength[ n ] bytes at mPayloadOffset + COL_PayloadOffset[ n ].
+
+const char USB_COLUMNAR_MAGIC[ 8 ] = { 'S', 'A', 'L', 'U', 'S', 'B', 'P', 'K' };
+const U32 USB_COLUMNAR_VERSION = 1;
+
+enum USBColumn
+{
+    COL_SampleBegin,   // U64
+    COL_SampleEnd,     // U64
+    COL_PayloadOffset, // U64, offset into the payload blob
+    COL_FrameNum,      // U16, 0xffff if not a SOF packet
+    COL_PayloadLength, // U16
+    COL_PID,           // U8
+    COL_Address,       // U8, 0xff if not a token packet
+    COL_Endpoint,      // U8, 0xff if not a token packet
+    COL_CRCStatus,     // U8, USBCRCStatus
+
+    COL_Count
+};
+
+struct USBColumnarHeader
+{
+    char mMagic[ 8 ];
+    U32 mVersion;
+    U32 mHeaderSize; // sizeof( USBColumnarHeader ) of the writer
+
+    U64 mSampleRate;
+    S64 mTriggerSample;
+
+    U64 mNumPackets;
+    U64 mPayloadOffset;
+    U64 mPayloadSize;
+
+    U64 mColumnOffsets[ COL_Count ];
+};
+
+#endif // USB_COLUMNAR_EXPORT_H
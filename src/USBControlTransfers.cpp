@@ -1,15 +1,13 @@
 #include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <limits>
 #include <locale>
 #include <codecvt>
+#include <string.h>
 
-#include <AnalyzerChannelData.h>
-#include <AnalyzerHelpers.h>
-
-#include "USBAnalyzer.h"
-#include "USBAnalyzerResults.h"
+#include "USBFrameSink.h"
 #include "USBTypes.h"
+#include "USBControlTransfers.h"
 #include "USBLookupTables.h"
 
 void USBCtrlTransFieldFrame::PackFrame( U32 data, U8 numBytes, U8 address, USBCtrlTransFieldType formatter, const char* name )
@@ -46,6 +44,13 @@ void USBHidRepDescItemFrame::PackFrame( const U8* pItem, U16 indentLevel, U16 us
     mData2 |= indentLevel;
 }
 
+void USBHidRepDescItemFrame::PackIncompleteFrame( const U8* pItem, U8 numBytes )
+{
+    // mData1 contains the bytes we have, mData2 their number
+    memcpy( &mData1, pItem, numBytes );
+    mData2 = numBytes;
+}
+
 U32 USBPacket::GetDataPayload( int offset, int bcnt ) const
 {
     U32 ret_val = 0;
@@ -62,7 +67,8 @@ U32 USBPacket::GetDataPayload( int offset, int bcnt ) const
     return ret_val;
 }
 
-Frame USBPacket::GetDataPayloadField( int offset, int bcnt, U8 address, const char* name, USBCtrlTransFieldType formatter, U8 flags ) const
+USBFrame USBPacket::GetDataPayloadField( int offset, int bcnt, U8 address, const char* name, USBCtrlTransFieldType formatter,
+                                         U8 flags ) const
 {
     USBCtrlTransFieldFrame f;
     f.mFlags = flags;
@@ -74,20 +80,7 @@ Frame USBPacket::GetDataPayloadField( int offset, int bcnt, U8 address, const ch
     return f;
 }
 
-Frame USBPacket::GetHIDItem( int offset, int bcnt, U8* pItem, U16 indentLevel, U16 usagePage, U8 flags ) const
-{
-    USBHidRepDescItemFrame f;
-    f.mFlags = flags;
-    f.mStartingSampleInclusive = mBitBeginSamples[ 16 + offset * 8 ];          // first data bit
-    f.mEndingSampleInclusive = mBitBeginSamples[ 16 + ( offset + bcnt ) * 8 ]; // first bit after
-
-    if( ( flags & 0x3F ) != FF_FieldIncomplete )
-        f.PackFrame( pItem, indentLevel, usagePage );
-
-    return f;
-}
-
-void USBPacket::AddStandardSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address )
+void USBPacket::AddStandardSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address )
 {
     U8 bRequestType = GetDataPayload( 0, 1 );
     U8 bRequest = GetDataPayload( 1, 1 );
@@ -98,45 +91,45 @@ void USBPacket::AddStandardSetupPacketFrame( USBAnalyzerResults* pResults, USBCo
     bool isRecipientEndpoint = ( bRequestType & 0x1f ) == 2;
 
     if( wLength )
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
 
-    pResults->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", Fld_bRequest_Standard ) );
+    pSink->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", Fld_bRequest_Standard ) );
 
     if( bRequest == SET_DESCRIPTOR || bRequest == GET_DESCRIPTOR )
-        pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_Descriptor ) );
+        pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_Descriptor ) );
     else if( bRequest == SET_ADDRESS )
-        pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_Address ) );
+        pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_Address ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
+        pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
 
     U8 hiByte = GetDataPayload( 3, 1 );
     U8 loByte = GetDataPayload( 2, 1 );
     if( isRecipientInterface )
     {
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
     }
     else if( isRecipientEndpoint )
     {
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
     }
     else if( bRequest == GET_DESCRIPTOR )
     {
         if( hiByte == DT_STRING && loByte != 0 )
-            pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wLANGID ) );
+            pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wLANGID ) );
         else
-            pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
+            pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
     }
     else
     {
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
     }
 
-    pResults->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
+    pSink->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
 }
 
-void USBPacket::AddClassSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address )
+void USBPacket::AddClassSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address )
 {
     U8 bRequestType = GetDataPayload( 0, 1 );
     U8 bRequest = GetDataPayload( 1, 1 );
@@ -154,9 +147,9 @@ void USBPacket::AddClassSetupPacketFrame( USBAnalyzerResults* pResults, USBContr
     bool isCDC = interfaceClassCode == CC_CDCData || interfaceClassCode == CC_CommunicationsAndCDCControl;
 
     if( wLength )
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
 
     USBCtrlTransFieldType fldType = Fld_bRequest_Class;
     if( interfaceClassCode == CC_HID )
@@ -164,20 +157,20 @@ void USBPacket::AddClassSetupPacketFrame( USBAnalyzerResults* pResults, USBContr
     else if( interfaceClassCode == CC_CDCData || interfaceClassCode == CC_CommunicationsAndCDCControl )
         fldType = Fld_bRequest_CDC;
 
-    pResults->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", fldType ) );
+    pSink->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", fldType ) );
 
     if( interfaceClassCode == CC_HID )
     {
         if( bRequest == SET_IDLE )
-            pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDSetIdle ) );
+            pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDSetIdle ) );
         else if( bRequest == GET_IDLE )
-            pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDGetIdle ) );
+            pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDGetIdle ) );
         else if( bRequest == SET_PROTOCOL )
-            pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDSetProtocol ) );
+            pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDSetProtocol ) );
         else if( bRequest == SET_REPORT || bRequest == GET_REPORT )
-            pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDGetSetReport ) );
+            pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", Fld_wValue_HIDGetSetReport ) );
         else
-            pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
+            pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
     }
     else if( isCDC )
     {
@@ -222,26 +215,26 @@ void USBPacket::AddClassSetupPacketFrame( USBAnalyzerResults* pResults, USBContr
         else if( bRequest == GET_ATM_VC_STATISTICS )
             fldType = Fld_CDC_wValue_ATMVCFeatureSelector;
 
-        pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", fldType ) );
+        pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue", fldType ) );
     }
     else
     {
-        pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
+        pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
     }
 
     U8 hiByte = GetDataPayload( 3, 1 );
     U8 loByte = GetDataPayload( 2, 1 );
     if( isRecipientInterface )
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
     else if( isRecipientEndpoint )
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
 
-    pResults->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
+    pSink->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
 }
 
-void USBPacket::AddVendorSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address )
+void USBPacket::AddVendorSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address )
 {
     U8 bRequestType = GetDataPayload( 0, 1 );
     U8 bRequest = GetDataPayload( 1, 1 );
@@ -252,57 +245,57 @@ void USBPacket::AddVendorSetupPacketFrame( USBAnalyzerResults* pResults, USBCont
     bool isRecipientEndpoint = ( bRequestType & 0x1f ) == 2;
 
     if( wLength )
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType, FF_SetupBegin ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
+        pSink->AddFrame( GetDataPayloadField( 0, 1, address, "bmRequestType", Fld_bmRequestType_NoData, FF_SetupBegin ) );
 
-    pResults->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", Fld_bRequest_Vendor ) );
+    pSink->AddFrame( GetDataPayloadField( 1, 1, address, "bRequest", Fld_bRequest_Vendor ) );
 
-    pResults->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
+    pSink->AddFrame( GetDataPayloadField( 2, 2, address, "wValue" ) );
 
     U8 hiByte = GetDataPayload( 3, 1 );
     U8 loByte = GetDataPayload( 2, 1 );
     if( isRecipientInterface )
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_InterfaceNum ) );
     else if( isRecipientEndpoint )
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex", Fld_wIndex_Endpoint ) );
     else
-        pResults->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
+        pSink->AddFrame( GetDataPayloadField( 4, 2, address, "wIndex" ) );
 
-    pResults->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
+    pSink->AddFrame( GetDataPayloadField( 6, 2, address, "wLength" ) );
 }
 
-U64 USBPacket::AddSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address )
+U64 USBPacket::AddSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address )
 {
-    AddSyncAndPidFrames( pResults );
+    AddSyncAndPidFrames( pSink );
 
     U8 bRequestType = GetDataPayload( 0, 1 );
 
     if( ( ( bRequestType >> 5 ) & 0x03 ) == 0 )
-        AddStandardSetupPacketFrame( pResults, parser, address );
+        AddStandardSetupPacketFrame( pSink, parser, address );
     else if( ( ( bRequestType >> 5 ) & 0x03 ) == 1 )
-        AddClassSetupPacketFrame( pResults, parser, address );
+        AddClassSetupPacketFrame( pSink, parser, address );
     else if( ( ( bRequestType >> 5 ) & 0x03 ) == 2 )
-        AddVendorSetupPacketFrame( pResults, parser, address );
+        AddVendorSetupPacketFrame( pSink, parser, address );
 
-    AddCRC16Frame( pResults );
-    AddEOPFrame( pResults );
+    AddCRC16Frame( pSink );
+    AddEOPFrame( pSink );
 
-    pResults->CommitResults();
+    pSink->CommitFrames();
 
     return mSampleEnd;
 }
 
-U64 USBPacket::AddDataStageFrames( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address )
+U64 USBPacket::AddDataStageFrames( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address )
 {
-    AddSyncAndPidFrames( pResults );
+    AddSyncAndPidFrames( pSink );
 
     parser.ParseDataPacket( *this );
 
-    AddCRC16Frame( pResults );
-    AddEOPFrame( pResults );
+    AddCRC16Frame( pSink );
+    AddEOPFrame( pSink );
 
-    pResults->CommitResults();
+    pSink->CommitFrames();
 
     return mSampleEnd;
 }
@@ -313,44 +306,39 @@ void USBRequest::SetFromPacket( USBPacket& p )
     bRequest = p.GetDataPayload( 1, 1 );
     wValue = p.GetDataPayload( 2, 2 );
     wIndex = p.GetDataPayload( 4, 2 );
-    wLength = p.GetDataPayload( 5, 2 );
+    wLength = p.GetDataPayload( 6, 2 );
 }
 
 void USBControlTransferParser::ResetParser()
 {
-    mParsedOffset = mDescBytes = 0;
+    mStageData.clear();
+    mStageSamples.clear();
+    mPacketBegin = mParseOffset = 0;
+
+    mDescBegin = mDescEnd = 0;
     mDescType = DT_Undefined;
     mDescSubtype = DST_Undefined;
-    mLeftover = 0;
+    mDescSchema = NULL;
+    mDescFieldCnt = 0;
 
     mRequest.Clear();
 
     mAddress = 0;
 
-    pPacket = NULL;
-    mPacketDataBytes = mPacketOffset = 0;
-
-    mHidRepDescBytes = 0;
-    memset( mHidRepDescItem, 0, sizeof mHidRepDescItem );
     mHidIndentLevel = mHidItemCnt = 0;
     mHidUsagePageStack.clear();
-}
-
-USBClassCodes USBControlTransferParser::GetClassCodeForInterface( U8 iface ) const
-{
-    USBInterfaceClassesContainer::const_iterator srch( mInterfaceClasses.find( iface ) );
 
-    if( srch == mInterfaceClasses.end() )
-        return CC_DeferredToInterface;
-
-    return srch->second;
+    mStageHash = 0;
+    mHasStageHash = false;
+    mStageReplayed = false;
+    mpPacketResult = NULL;
 }
 
 bool USBControlTransferParser::IsCDCClassRequest() const
 {
     if( mRequest.IsClassRequest() && mRequest.IsRecipientInterface() )
     {
-        USBClassCodes classCode = GetClassCodeForInterface( mRequest.GetInterfaceNum() );
+        U8 classCode = GetClassForInterface( mRequest.GetInterfaceNum() );
 
         return classCode == CC_CDCData || classCode == CC_CommunicationsAndCDCControl;
     }
@@ -358,930 +346,477 @@ bool USBControlTransferParser::IsCDCClassRequest() const
     return false;
 }
 
-bool USBControlTransferParser::ParseStringDescriptor()
+U32 USBControlTransferParser::GetStageData( int offset, int numBytes ) const
 {
-    // if this is a supported language table desriptor or actual string descriptor
-    if( mRequest.GetRequestedDescriptorIndex() == 0 )
-    {
-        while( mDescBytes > mParsedOffset && mPacketDataBytes > mPacketOffset )
-        {
-            pResults->AddFrame( pPacket->GetDataPayloadField( mPacketOffset, 2, mAddress, "wLANGID", Fld_wLANGID ) );
-            mPacketOffset += 2;
-            mParsedOffset += 2;
-        }
-    }
-    else
-    {
-        if( mParsedOffset == 2 )
-            utf16StringDescriptor.clear();
+    U32 ret_val = 0;
+    for( int bc = numBytes - 1; bc >= 0; --bc )
+        ret_val = ( ret_val << 8 ) | mStageData[ offset + bc ];
 
-        // the actual UNICODE string
-        while( mDescBytes > mParsedOffset && mPacketDataBytes > mPacketOffset )
-        {
-            char16_t code_unit = static_cast<char16_t>( pPacket->GetDataPayload( mPacketOffset, 2 ) );
-            utf16StringDescriptor.push_back( code_unit );
+    return ret_val;
+}
 
-            pResults->AddFrame( pPacket->GetDataPayloadField( mPacketOffset, 2, mAddress, "wchar", Fld_Wchar ) );
-            mPacketOffset += 2;
-            mParsedOffset += 2;
-        }
+void USBControlTransferParser::SetFrameSamples( USBFrame& f, int offset, int numBytes ) const
+{
+    // a field that started in the previous packet is shown only over its bytes in the last packet
+    f.mStartingSampleInclusive = mStageSamples[ std::max( offset, mPacketBegin ) ].begin;
+    f.mEndingSampleInclusive = mStageSamples[ offset + numBytes - 1 ].end;
+}
 
-        // do we have the entire string?
-        if( mDescBytes == mParsedOffset )
-        {
-            std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
-            std::string utf8_string_descriptor = convert.to_bytes( utf16StringDescriptor );
-            pResults->AddStringDescriptor( mAddress, mRequest.GetRequestedDescriptorIndex(), utf8_string_descriptor );
-        }
+void USBControlTransferParser::AddStageFrame( USBFrame& f, int offset, int numBytes )
+{
+    SetFrameSamples( f, offset, numBytes );
+    pSink->AddFrame( f );
+
+    if( mpPacketResult != NULL )
+    {
+        USBStageFrame frame = { f, std::max( offset, mPacketBegin ), offset + numBytes - 1 };
+        mpPacketResult->frames.push_back( frame );
     }
-    // return true if we've finished parsing the string descriptor, according to the parsed bLength
-    return mDescBytes == mParsedOffset;
 }
 
-void USBControlTransferParser::ParseUnknownResponse()
+bool USBControlTransferParser::AddField( int numBytes, const char* name, USBCtrlTransFieldType formatter, U8 flags )
 {
-    USBCtrlTransFieldFrame f;
-    f.mFlags = FF_None;
-    f.mType = FT_ControlTransferField;
+    // if the field continues in the next packet, we make a frame with the bytes we have so far
+    const bool isComplete = mParseOffset + numBytes <= int( mStageData.size() );
+    if( !isComplete )
+    {
+        numBytes = int( mStageData.size() ) - mParseOffset;
+        flags = FF_FieldIncomplete;
+    }
 
-    while( mPacketDataBytes > mPacketOffset ) // more data in packet?
+    if( IsInLastPacket( mParseOffset, numBytes ) )
     {
-        f.mStartingSampleInclusive = *( pPacket->mBitBeginSamples.begin() + ( mPacketOffset + 2 ) * 8 );
-        f.mEndingSampleInclusive = *( pPacket->mBitBeginSamples.begin() + ( mPacketOffset + 3 ) * 8 );
+        USBCtrlTransFieldFrame f;
+        f.mFlags = flags;
+        f.PackFrame( GetStageData( mParseOffset, numBytes ), numBytes, mAddress, formatter, name );
 
-        f.PackFrame( pPacket->mData[ mPacketOffset + 2 ], 1, mAddress, Fld_None, "byte" );
+        AddStageFrame( f, mParseOffset, numBytes );
+    }
 
-        pResults->AddFrame( f );
+    if( isComplete )
+        mParseOffset += numBytes;
 
-        ++mPacketOffset;
-        ++mParsedOffset;
-    }
+    return isComplete;
 }
 
-USBStructField DeviceDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bcdUSB", 2, Fld_BCD },
-    { "bDeviceClass", 1, Fld_ClassCode },
-    { "bDeviceSubClass", 1, Fld_None },
-    { "bDeviceProtocol", 1, Fld_None },
-    { "bMaxPacketSize0", 1, Fld_None },
-    { "idVendor", 2, Fld_wVendorId },
-    { "idProduct", 2, Fld_None },
-    { "bcdDevice", 2, Fld_BCD },
-    { "iManufacturer", 1, Fld_String },
-    { "iProduct", 1, Fld_String },
-    { "iSerialNumber", 1, Fld_String },
-    { "bNumConfigurations", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField DeviceQualifierDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bcdUSB", 2, Fld_BCD },
-    { "bDeviceClass", 1, Fld_ClassCode },
-    { "bDeviceSubClass", 1, Fld_None },
-    { "bDeviceProtocol", 1, Fld_None },
-    { "bMaxPacketSize0", 1, Fld_None },
-    { "bNumConfigurations", 1, Fld_None },
-    { "bReserved", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField ConfigurationDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "wTotalLength", 2, Fld_None },
-    { "bNumInterfaces", 1, Fld_None },
-    { "bConfigurationValue", 1, Fld_None },
-    { "iConfiguration", 1, Fld_String },
-    { "bmAttributes", 1, Fld_bmAttributes_Config },
-    { "bMaxPower", 1, Fld_bMaxPower },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField InterfaceDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bInterfaceNumber", 1, Fld_None },
-    { "bAlternateSetting", 1, Fld_None },
-    { "bNumEndpoints", 1, Fld_None },
-    { "bInterfaceClass", 1, Fld_ClassCode },
-    { "bInterfaceSubClass", 1, Fld_None },
-    { "bInterfaceProtocol", 1, Fld_None },
-    { "iInterface", 1, Fld_String },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField EndpointDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bEndpointAddress", 1, Fld_bEndpointAddress },
-    { "bmAttributes", 1, Fld_bmAttributes_Endpoint },
-    { "wMaxPacketSize", 2, Fld_None },
-    { "bInterval", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField HIDDescriptorFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bcdHID", 2, Fld_BCD },
-    { "bCountryCode", 1, Fld_HID_bCountryCode },
-    { "bNumDescriptors", 1, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-
-    // these are optional and depend of the number of HID class descriptors for this interface
-    // we have enough for 16
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-    { "bDescriptorType", 1, Fld_bDescriptorType },
-    { "wDescriptorLength", 2, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-//
-// CDC descriptors
-//
-
-USBStructField CDCHeaderFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bcdCDC", 2, Fld_BCD },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCCallManagementFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_Call },
-    { "bDataInterface", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCAbstractControlManagementFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_AbstractCtrl },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCDirectLineManagementFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_DataLine },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCTelephoneRingerFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bRingerVolSteps", 1, Fld_CDC_bRingerVolSteps },
-    { "bNumRingerPatterns", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCTelephoneOperationalModesFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_TelOpModes },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCTelephoneCallStateReportingFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_TelCallStateRep },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCUnionFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bMasterInterface", 1, Fld_None },
-    { "bSlaveInterface0", 1, Fld_None },
-    { "bSlaveInterface1", 1, Fld_None },
-    { "bSlaveInterface2", 1, Fld_None },
-    { "bSlaveInterface3", 1, Fld_None },
-    { "bSlaveInterface4", 1, Fld_None },
-    { "bSlaveInterface5", 1, Fld_None },
-    { "bSlaveInterface6", 1, Fld_None },
-    { "bSlaveInterface7", 1, Fld_None },
-    { "bSlaveInterface8", 1, Fld_None },
-    { "bSlaveInterface9", 1, Fld_None },
-    { "bSlaveInterface10", 1, Fld_None },
-    { "bSlaveInterface11", 1, Fld_None },
-    { "bSlaveInterface12", 1, Fld_None },
-    { "bSlaveInterface13", 1, Fld_None },
-    { "bSlaveInterface14", 1, Fld_None },
-    { "bSlaveInterface15", 1, Fld_None },
-    { "bSlaveInterface16", 1, Fld_None },
-    { "bSlaveInterface17", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCCountrySelectionFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "iCountryCodeRelDate", 1, Fld_String },
-    { "wCountryCode0", 2, Fld_None },
-    { "wCountryCode1", 2, Fld_None },
-    { "wCountryCode2", 2, Fld_None },
-    { "wCountryCode3", 2, Fld_None },
-    { "wCountryCode4", 2, Fld_None },
-    { "wCountryCode5", 2, Fld_None },
-    { "wCountryCode6", 2, Fld_None },
-    { "wCountryCode7", 2, Fld_None },
-    { "wCountryCode8", 2, Fld_None },
-    { "wCountryCode9", 2, Fld_None },
-    { "wCountryCode10", 2, Fld_None },
-    { "wCountryCode11", 2, Fld_None },
-    { "wCountryCode12", 2, Fld_None },
-    { "wCountryCode13", 2, Fld_None },
-    { "wCountryCode14", 2, Fld_None },
-    { "wCountryCode15", 2, Fld_None },
-    { "wCountryCode16", 2, Fld_None },
-    { "wCountryCode17", 2, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCUSBTerminalFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bEntityId", 1, Fld_None },
-    { "bInInterfaceNo", 1, Fld_None },
-    { "bOutInterfaceNo", 1, Fld_None },
-    { "bmOptions", 1, Fld_CDC_bmOptions },
-    { "bChildId0", 1, Fld_None },
-    { "bChildId1", 1, Fld_None },
-    { "bChildId2", 1, Fld_None },
-    { "bChildId3", 1, Fld_None },
-    { "bChildId4", 1, Fld_None },
-    { "bChildId5", 1, Fld_None },
-    { "bChildId6", 1, Fld_None },
-    { "bChildId7", 1, Fld_None },
-    { "bChildId8", 1, Fld_None },
-    { "bChildId9", 1, Fld_None },
-    { "bChildId10", 1, Fld_None },
-    { "bChildId11", 1, Fld_None },
-    { "bChildId12", 1, Fld_None },
-    { "bChildId13", 1, Fld_None },
-    { "bChildId14", 1, Fld_None },
-    { "bChildId15", 1, Fld_None },
-    { "bChildId16", 1, Fld_None },
-    { "bChildId17", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCNetworkChannelTerminalFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bEntityId", 1, Fld_None },
-    { "iName", 1, Fld_String },
-    { "bChannelIndex", 1, Fld_None },
-    { "bPhysicalInterface", 1, Fld_CDC_bPhysicalInterface },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCProtocolUnitFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bEntityId", 1, Fld_None },
-    { "bProtocol", 1, Fld_CDC_bProtocol },
-    { "bOutInterfaceNo", 1, Fld_None },
-    { "bmOptions", 1, Fld_CDC_bmOptions },
-    { "bChildId0", 1, Fld_None },
-    { "bChildId1", 1, Fld_None },
-    { "bChildId2", 1, Fld_None },
-    { "bChildId3", 1, Fld_None },
-    { "bChildId4", 1, Fld_None },
-    { "bChildId5", 1, Fld_None },
-    { "bChildId6", 1, Fld_None },
-    { "bChildId7", 1, Fld_None },
-    { "bChildId8", 1, Fld_None },
-    { "bChildId9", 1, Fld_None },
-    { "bChildId10", 1, Fld_None },
-    { "bChildId11", 1, Fld_None },
-    { "bChildId12", 1, Fld_None },
-    { "bChildId13", 1, Fld_None },
-    { "bChildId14", 1, Fld_None },
-    { "bChildId15", 1, Fld_None },
-    { "bChildId16", 1, Fld_None },
-    { "bChildId17", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCExtensionUnitFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bEntityId", 1, Fld_None },
-    { "bExtensionCode", 1, Fld_None },
-    { "iName", 1, Fld_String },
-    { "bChildId0", 1, Fld_None },
-    { "bChildId1", 1, Fld_None },
-    { "bChildId2", 1, Fld_None },
-    { "bChildId3", 1, Fld_None },
-    { "bChildId4", 1, Fld_None },
-    { "bChildId5", 1, Fld_None },
-    { "bChildId6", 1, Fld_None },
-    { "bChildId7", 1, Fld_None },
-    { "bChildId8", 1, Fld_None },
-    { "bChildId9", 1, Fld_None },
-    { "bChildId10", 1, Fld_None },
-    { "bChildId11", 1, Fld_None },
-    { "bChildId12", 1, Fld_None },
-    { "bChildId13", 1, Fld_None },
-    { "bChildId14", 1, Fld_None },
-    { "bChildId15", 1, Fld_None },
-    { "bChildId16", 1, Fld_None },
-    { "bChildId17", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCMultiChannelFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_MultiChannel },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCCAPIControlFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_CAPIControl },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCEthernetNetworkingFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "iMACAddress", 1, Fld_String },
-    { "bmEthernetStatistics", 4, Fld_CDC_bmEthernetStatistics },
-    { "wMaxSegmentSize", 2, Fld_None },
-    { "wNumberMCFilters", 2, Fld_CDC_wNumberMCFilters },
-    { "bNumberPowerFilters", 2, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCATMNetworkingFields[] = {
-    //{"bLength",				1, Fld_None},
-    //{"bDescriptorType",		1, Fld_None},
-    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
-
-    { "iEndSystemIdentifier", 1, Fld_String },
-    { "bmDataCapabilities", 1, Fld_CDC_bmDataCapabilities },
-    { "bmATMDeviceStatistics", 1, Fld_CDC_bmATMDeviceStatistics },
-    { "wType2MaxSegmentSize", 2, Fld_None },
-    { "wType3MaxSegmentSize", 2, Fld_None },
-    { "wMaxVC", 2, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-//
-// CDC data payloads
-//
-
-USBStructField CDCLineCodingFields[] = {
-    { "dwDTERate", 4, Fld_CDC_dwDTERate },
-    { "bCharFormat", 1, Fld_CDC_bCharFormat },
-    { "bParityType", 1, Fld_CDC_bParityType },
-    { "bDataBits", 1, Fld_CDC_bDataBits },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCAbstractStateFields[] = {
-    { "ABSTRACT_STATE", 2, Fld_CDC_Data_AbstractState },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCCountrySettingFields[] = {
-    { "COUNTRY_SETTING", 2, Fld_CDC_Data_CountrySetting },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCRingerConfigFields[] = {
-    { "dwRingerBitmap", 4, Fld_CDC_dwRingerBitmap },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCOperationModeFields[] = {
-    { "Operation mode", 4, Fld_CDC_OperationMode },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCLineParmsFields[] = {
-    { "wLength", 2, Fld_None },
-    { "dwRingerBitmap", 4, Fld_CDC_dwRingerBitmap },
-    { "dwLineState", 4, Fld_CDC_dwLineState },
-    { "dwCallState0", 4, Fld_CDC_dwCallState },
-    { "dwCallState1", 4, Fld_CDC_dwCallState },
-    { "dwCallState2", 4, Fld_CDC_dwCallState },
-    { "dwCallState3", 4, Fld_CDC_dwCallState },
-    { "dwCallState4", 4, Fld_CDC_dwCallState },
-    { "dwCallState5", 4, Fld_CDC_dwCallState },
-    { "dwCallState6", 4, Fld_CDC_dwCallState },
-    { "dwCallState7", 4, Fld_CDC_dwCallState },
-    { "dwCallState8", 4, Fld_CDC_dwCallState },
-    { "dwCallState9", 4, Fld_CDC_dwCallState },
-    { "dwCallState10", 4, Fld_CDC_dwCallState },
-    { "dwCallState11", 4, Fld_CDC_dwCallState },
-    { "dwCallState12", 4, Fld_CDC_dwCallState },
-    { "dwCallState13", 4, Fld_CDC_dwCallState },
-    { "dwCallState14", 4, Fld_CDC_dwCallState },
-    { "dwCallState15", 4, Fld_CDC_dwCallState },
-    { "dwCallState16", 4, Fld_CDC_dwCallState },
-    { "dwCallState17", 4, Fld_CDC_dwCallState },
-    { "dwCallState18", 4, Fld_CDC_dwCallState },
-    { "dwCallState19", 4, Fld_CDC_dwCallState },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCUnitParameterFields[] = {
-    { "bEntityId", 1, Fld_None },
-    { "bParameterIndex", 1, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCUnsignedIntFields[] = {
-    { "uint32", 4, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-USBStructField CDCATMDefaultVCFields[] = {
-    { "VPI", 1, Fld_None },
-    { "VCI", 2, Fld_None },
-
-    { NULL, 0, Fld_None },
-};
-
-void USBControlTransferParser::ParseStructure( USBStructField* descFields )
+bool USBControlTransferParser::ParseBytes( int end )
 {
-    int descFldCnt = 0;
-    int descFldOffset = 2; // we already handled bLength and bDescriptorType in the caller
-
-    // find the first non-parsed or partially parsed descriptor field in this packet
-    while( descFldOffset < mParsedOffset && descFields[ descFldCnt ].numBytes != 0 ) // haven't reached the last field?
+    while( mParseOffset < end )
     {
-        int fldBytes = descFields[ descFldCnt ].numBytes;
+        if( !AddField( 1, "byte" ) )
+            return false;
+    }
+
+    return true;
+}
 
-        // did we get the LS byte in the previous packet?
-        if( fldBytes > 1 && descFldOffset + fldBytes > mParsedOffset )
+bool USBControlTransferParser::ParseStringDescriptor()
+{
+    // if this is a supported language table desriptor or actual string descriptor
+    if( mRequest.GetRequestedDescriptorIndex() == 0 )
+    {
+        while( mParseOffset + 2 <= mDescEnd )
+        {
+            if( !AddField( 2, "wLANGID", Fld_wLANGID ) )
+                return false;
+        }
+    }
+    else
+    {
+        // the actual UNICODE string
+        while( mParseOffset + 2 <= mDescEnd )
         {
-            U8 bytesRemaining = mParsedOffset - descFldOffset;
+            if( !AddField( 2, "wchar", Fld_Wchar ) )
+                return false;
 
-            USBCtrlTransFieldFrame f;
-            f.mFlags = FF_None;
-            f.mStartingSampleInclusive = pPacket->mBitBeginSamples[ 16 ];
-            f.mEndingSampleInclusive = pPacket->mBitBeginSamples[ 16 + bytesRemaining * 8 ];
+            // do we have the entire string?
+            if( mParseOffset + 2 > mDescEnd )
+            {
+                std::u16string utf16_string_descriptor;
+                for( int offset = mDescBegin + 2; offset < mParseOffset; offset += 2 )
+                    utf16_string_descriptor.push_back( static_cast<char16_t>( GetStageData( offset, 2 ) ) );
 
-            U32 newVal = pPacket->GetDataPayload( 0, bytesRemaining ) << ( fldBytes - bytesRemaining ) * 8;
-            newVal = newVal | mLeftover;
-            f.PackFrame( newVal, 2, mAddress, descFields[ descFldCnt ].formatter, descFields[ descFldCnt ].name );
+                // the conversion throws on a surrogate without its other half, so those become U+FFFD
+                for( size_t cc = 0; cc < utf16_string_descriptor.size(); ++cc )
+                {
+                    const char16_t c = utf16_string_descriptor[ cc ];
+                    const bool isHigh = c >= 0xD800 && c < 0xDC00;
+                    const bool isNextLow = cc + 1 < utf16_string_descriptor.size() && utf16_string_descriptor[ cc + 1 ] >= 0xDC00 &&
+                                           utf16_string_descriptor[ cc + 1 ] < 0xE000;
+
+                    if( isHigh && isNextLow )
+                        ++cc;
+                    else if( c >= 0xD800 && c < 0xE000 )
+                        utf16_string_descriptor[ cc ] = 0xFFFD;
+                }
 
-            pResults->AddFrame( f );
+                std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
+                std::string utf8_string_descriptor = convert.to_bytes( utf16_string_descriptor );
+                pSink->AddStringDescriptor( mAddress, mRequest.GetRequestedDescriptorIndex(), utf8_string_descriptor );
 
-            ++mPacketOffset;
-            ++mParsedOffset;
+                if( mpPacketResult != NULL )
+                {
+                    mpPacketResult->hasStringDescriptor = true;
+                    mpPacketResult->stringDescriptor = utf8_string_descriptor;
+                }
+            }
         }
-
-        descFldOffset += fldBytes;
-        ++descFldCnt;
     }
 
-    while( descFields[ descFldCnt ].numBytes != 0 // haven't reached the last field?
-           && mDescBytes > mParsedOffset          // more bytes in descriptor?
-           && mPacketDataBytes > mPacketOffset    // more data in packet?
-           && mDescBytes >=
-                  mParsedOffset +
-                      descFields[ descFldCnt ].numBytes ) // the next field won't consume more than we have in the received descriptor
+    // an odd bLength leaves a byte which is not part of a character
+    return ParseBytes( mDescEnd );
+}
+
+bool USBControlTransferParser::ParseStructure()
+{
+    for( ; mDescFieldCnt < mDescSchema->numFields; ++mDescFieldCnt )
     {
-        int fldBytes = descFields[ descFldCnt ].numBytes;
+        const USBSchemaField& field = mDescSchema->fields[ mDescFieldCnt ];
 
-        USBCtrlTransFieldType formatter = descFields[ descFldCnt ].formatter;
+        // the field won't consume more than the descriptor has
+        if( mDescBegin + field.end > mDescEnd )
+            break;
 
-        // get the interface number and interface class/subclass
-        if( descFields == InterfaceDescriptorFields )
+        USBCtrlTransFieldType formatter = field.formatter;
+
+        // the subclass and protocol of HID interfaces have their own formatters
+        if( mDescType == DT_INTERFACE && mStageData[ mDescBegin + 5 ] == CC_HID ) // bInterfaceClass
         {
-            if( descFldCnt == 0 ) // bInterfaceNumber
-                mInterfaceNumber = pPacket->GetDataPayload( mPacketOffset, 1 );
-            else if( descFldCnt == 3 ) // bInterfaceClass
-                mInterfaceClasses[ mInterfaceNumber ] = ( USBClassCodes )pPacket->GetDataPayload( mPacketOffset, 1 );
-            else if( descFldCnt == 4 && mInterfaceClasses[ mInterfaceNumber ] == CC_HID ) // bInterfaceSubClass
+            if( field.offset == 6 ) // bInterfaceSubClass
                 formatter = Fld_HIDSubClass;
-            else if( descFldCnt == 5 && mInterfaceClasses[ mInterfaceNumber ] == CC_HID ) // bInterfaceProtocol
+            else if( field.offset == 7 ) // bInterfaceProtocol
                 formatter = Fld_HIDProtocol;
         }
 
-        // does this field spill over into the next packet?
-        U8 flags = 0;
-        if( fldBytes > mPacketDataBytes - mPacketOffset )
-        {
-            fldBytes = mPacketDataBytes - mPacketOffset;
-            mLeftover = pPacket->GetDataPayload( mPacketOffset, fldBytes );
-
-            flags = FF_FieldIncomplete;
-        }
-
-        pResults->AddFrame(
-            pPacket->GetDataPayloadField( mPacketOffset, fldBytes, mAddress, descFields[ descFldCnt ].name, formatter, flags ) );
-
-        mPacketOffset += fldBytes;
-        mParsedOffset += fldBytes;
-        descFldOffset += fldBytes;
-
-        ++descFldCnt;
+        if( !AddField( field.end - field.offset, field.name, formatter ) )
+            return false;
     }
+
+    return true;
 }
 
-void USBControlTransferParser::ParseStandardDescriptor()
+bool USBControlTransferParser::ParseStandardDescriptor()
 {
-    USBStructField* descFields = NULL;
-    if( mDescType == DT_DEVICE )
-        descFields = DeviceDescriptorFields;
-    else if( mDescType == DT_DEVICE_QUALIFIER )
-        descFields = DeviceQualifierDescriptorFields;
-    else if( mDescType == DT_CONFIGURATION || mDescType == DT_OTHER_SPEED_CONFIGURATION )
-        descFields = ConfigurationDescriptorFields;
-    else if( mDescType == DT_INTERFACE )
-        descFields = InterfaceDescriptorFields;
-    else if( mDescType == DT_ENDPOINT )
-        descFields = EndpointDescriptorFields;
-    else if( mDescType == DT_HID && mInterfaceClasses[ mInterfaceNumber ] == CC_HID )
-        descFields = HIDDescriptorFields;
-    else if( mDescType == DT_CDC_CS_INTERFACE ||
-             mDescType == DT_CDC_CS_ENDPOINT && ( mInterfaceClasses[ mInterfaceNumber ] == CC_CommunicationsAndCDCControl ||
-                                                  mInterfaceClasses[ mInterfaceNumber ] == CC_CDCData ) )
+    if( mDescSchema == NULL )
     {
-        if( mDescSubtype == DST_HEADER )
-            descFields = CDCHeaderFields;
-        else if( mDescSubtype == DST_CALL_MANAGEMENT )
-            descFields = CDCCallManagementFields;
-        else if( mDescSubtype == DST_ABSTRACT_CONTROL_MANAGEMENT )
-            descFields = CDCAbstractControlManagementFields;
-        else if( mDescSubtype == DST_DIRECT_LINE_MANAGEMENT )
-            descFields = CDCDirectLineManagementFields;
-        else if( mDescSubtype == DST_TELEPHONE_RINGER )
-            descFields = CDCTelephoneRingerFields;
-        else if( mDescSubtype == DST_TELEPHONE_CALL_AND_LINE_STATE )
-            descFields = CDCTelephoneCallStateReportingFields;
-        else if( mDescSubtype == DST_UNION )
-            descFields = CDCUnionFields;
-        else if( mDescSubtype == DST_COUNTRY_SELECTION )
-            descFields = CDCCountrySelectionFields;
-        else if( mDescSubtype == DST_TELEPHONE_OPERATIONAL_MODES )
-            descFields = CDCTelephoneOperationalModesFields;
-        else if( mDescSubtype == DST_USB_TERMINAL )
-            descFields = CDCUSBTerminalFields;
-        else if( mDescSubtype == DST_NETWORK_CHANNEL_TERMINAL )
-            descFields = CDCNetworkChannelTerminalFields;
-        else if( mDescSubtype == DST_PROTOCOL_UNIT )
-            descFields = CDCProtocolUnitFields;
-        else if( mDescSubtype == DST_EXTENSION_UNIT )
-            descFields = CDCExtensionUnitFields;
-        else if( mDescSubtype == DST_MULTI_CHANNEL_MANAGEMENT )
-            descFields = CDCMultiChannelFields;
-        else if( mDescSubtype == DST_CAPI_CONTROL_MANAGEMENT )
-            descFields = CDCCAPIControlFields;
-        else if( mDescSubtype == DST_ETHERNET_NETWORKING )
-            descFields = CDCEthernetNetworkingFields;
-        else if( mDescSubtype == DST_ATM_NETWORKING )
-            descFields = CDCATMNetworkingFields;
+        mDescSchema = FindDescriptorSchema( mDescType, GetParsedInterfaceClass(), mDescSubtype );
+
+        // skip the fields we already parsed with the descriptor header, like bDescriptorSubtype
+        if( mDescSchema != NULL )
+            mDescFieldCnt = mDescSchema->FindField( mParseOffset - mDescBegin );
     }
 
-    if( descFields )
-        ParseStructure( descFields );
+    if( mDescSchema != NULL && !ParseStructure() )
+        return false;
 
-    // parse the rest of the descriptor or packet as raw bytes
+    // parse the rest of the descriptor as raw bytes
+    return ParseBytes( mDescEnd );
+}
 
-    while( mDescBytes > mParsedOffset            // more bytes in descriptor?
-           && mPacketDataBytes > mPacketOffset ) // more data in packet?
+void USBControlTransferParser::ParseStandardDescriptors()
+{
+    // GET_DESCRIPTOR(CONFIGURATION) returns the configuration descriptor followed by all the interface,
+    // endpoint and class descriptors, so we parse them one after the other
+    while( mParseOffset < int( mStageData.size() ) )
     {
-        USBCtrlTransFieldFrame f;
-        f.mFlags = FF_None;
-        f.mStartingSampleInclusive = *( pPacket->mBitBeginSamples.begin() + ( mPacketOffset + 2 ) * 8 );
-        f.mEndingSampleInclusive = *( pPacket->mBitBeginSamples.begin() + ( mPacketOffset + 3 ) * 8 );
+        const U8 interfaceClass = GetParsedInterfaceClass();
+        const int descOffset = mParseOffset - mDescBegin;
 
-        f.PackFrame( pPacket->mData[ mPacketOffset + 2 ], 1, mAddress, Fld_None, "byte" );
+        if( descOffset == 0 ) // are we just starting with this descriptor?
+        {
+            // a descriptor shorter than its header doesn't tell us where the next one begins,
+            // so we show the rest of the data stage as raw bytes
+            const U8 bLength = mStageData[ mParseOffset ];
+            mDescEnd = bLength >= 2 ? mDescBegin + bLength : std::numeric_limits<int>::max();
 
-        pResults->AddFrame( f );
+            AddField( 1, "bLength", Fld_None, FF_DataDescriptor );
+        }
+        else if( descOffset == 1 )
+        {
+            mDescType = mDescEnd != std::numeric_limits<int>::max() ? USBDescriptorType( mStageData[ mParseOffset ] ) : DT_Undefined;
+            mDescSubtype = DST_Undefined;
+            mDescSchema = NULL;
+            mDescFieldCnt = 0;
+
+            if( IsStandardDescriptor( mStageData[ mParseOffset ] ) || interfaceClass == CC_HID ||
+                interfaceClass == CC_CommunicationsAndCDCControl || interfaceClass == CC_CDCData )
+                AddField( 1, "bDescriptorType", Fld_bDescriptorType );
+            else
+                AddField( 1, "bDescriptorType", Fld_bDescriptorType_Other );
+        }
+        else if( descOffset == 2 && ( interfaceClass == CC_CommunicationsAndCDCControl || interfaceClass == CC_CDCData ) &&
+                 ( mDescType == DT_CDC_CS_INTERFACE || mDescType == DT_CDC_CS_ENDPOINT ) )
+        {
+            mDescSubtype = USBCDCDescriptorSubtype( mStageData[ mParseOffset ] );
+            AddField( 1, "bDescriptorSubtype", Fld_CDC_DescriptorSubtype );
+        }
+        else if( mDescType == DT_STRING )
+        {
+            if( !ParseStringDescriptor() )
+                return;
+        }
+        else if( !ParseStandardDescriptor() )
+        {
+            return;
+        }
 
-        ++mPacketOffset;
-        ++mParsedOffset;
-    }
+        // on to the next descriptor if we have completed parsing this one
+        if( mParseOffset == mDescEnd )
+        {
+            mDevice.AddDescriptor( &mStageData[ mDescBegin ], mDescEnd - mDescBegin );
+            if( mpPacketResult != NULL )
+                mpPacketResult->descriptors.push_back( std::make_pair( mDescBegin, mDescEnd ) );
 
-    // reset the parser if we have completeted parsing the descriptor
-    if( mDescBytes == mParsedOffset )
-    {
-        mParsedOffset = 0;
-        mDescType = DT_Undefined;
+            mDescBegin = mDescEnd;
+            mDescType = DT_Undefined;
+        }
     }
 }
 
 void USBControlTransferParser::ParseHIDReportDescriptor()
 {
-    // more bytes in the packet?
-    while( mPacketDataBytes > mPacketOffset )
+    while( mParseOffset < int( mStageData.size() ) )
     {
-        int itemStartOffset = mPacketOffset;
+        // the size of the item is in its first byte
+        const int itemSize = GetNumHIDItemDataBytes( mStageData[ mParseOffset ] ) + 1;
+        const int numBytes = std::min( itemSize, int( mStageData.size() ) - mParseOffset );
 
-        // we need to have at least the first byte of the item to get the item size
-        if( mHidRepDescBytes == 0 )
-            mHidRepDescItem[ mHidRepDescBytes++ ] = pPacket->GetDataPayload( mPacketOffset++, 1 );
+        U8 item[ 5 ] = { 0 };
+        std::copy( mStageData.begin() + mParseOffset, mStageData.begin() + mParseOffset + numBytes, item );
 
-        U8 itemSize = GetNumHIDItemDataBytes( mHidRepDescItem[ 0 ] ) + 1;
-
-        // do we have the entire item in this packet?
-        if( itemSize - mHidRepDescBytes <= mPacketDataBytes - mPacketOffset )
-        {
-            // we have the entire item - copy it to the item buffer
-            while( mHidRepDescBytes < itemSize )
-                mHidRepDescItem[ mHidRepDescBytes++ ] = pPacket->GetDataPayload( mPacketOffset++, 1 );
-
-            // end collection decreases the indent level
-            if( IsHIDItemEndCollection( mHidRepDescItem[ 0 ] ) && mHidIndentLevel > 0 )
-                --mHidIndentLevel;
-            else if( IsHIDItemUsagePage( mHidRepDescItem[ 0 ] ) )
-                SetHIDUsagePage( *( U16* )( mHidRepDescItem + 1 ) );
-            else if( IsHIDItemPush( mHidRepDescItem[ 0 ] ) )
-                PushHIDUsagePage();
-            else if( IsHIDItemPop( mHidRepDescItem[ 0 ] ) )
-                PopHIDUsagePage();
-
-            // make the frame with all the data
-            pResults->AddFrame( pPacket->GetHIDItem( itemStartOffset, mPacketOffset - itemStartOffset, mHidRepDescItem, mHidIndentLevel,
-                                                     GetHIDUsagePage(), mHidItemCnt == 0 ? FF_DataDescriptor : FF_None ) );
-
-            // collection increases the indent level
-            if( IsHIDItemCollection( mHidRepDescItem[ 0 ] ) )
-                ++mHidIndentLevel;
-
-            // start with a new packet
-            mHidRepDescBytes = 0;
-            memset( mHidRepDescItem, 0, sizeof mHidRepDescItem );
-
-            mHidItemCnt++;
-        }
-        else
+        // do we have the entire item?
+        if( numBytes < itemSize )
         {
-            // we don't have the entire item, so just make a frame and store what data we do have
-            pResults->AddFrame( pPacket->GetHIDItem( itemStartOffset, mPacketOffset - itemStartOffset, mHidRepDescItem, mHidIndentLevel,
-                                                     GetHIDUsagePage(), FF_FieldIncomplete ) );
-            while( mPacketDataBytes > mPacketOffset )
-                mHidRepDescItem[ mHidRepDescBytes++ ] = pPacket->GetDataPayload( mPacketOffset++, 1 );
+            // no, so just make a frame with the bytes we have so far
+            if( IsInLastPacket( mParseOffset, numBytes ) )
+            {
+                USBHidRepDescItemFrame f;
+                f.mFlags = FF_FieldIncomplete;
+                f.PackIncompleteFrame( item, numBytes );
+
+                AddStageFrame( f, mParseOffset, numBytes );
+            }
+
+            return;
         }
+
+        // end collection decreases the indent level
+        if( IsHIDItemEndCollection( item[ 0 ] ) && mHidIndentLevel > 0 )
+            --mHidIndentLevel;
+        else if( IsHIDItemUsagePage( item[ 0 ] ) )
+            SetHIDUsagePage( item[ 1 ] | ( item[ 2 ] << 8 ) );
+        else if( IsHIDItemPush( item[ 0 ] ) )
+            PushHIDUsagePage();
+        else if( IsHIDItemPop( item[ 0 ] ) )
+            PopHIDUsagePage();
+
+        // make the frame with all the data
+        USBHidRepDescItemFrame f;
+        f.mFlags = mHidItemCnt == 0 ? FF_DataDescriptor : FF_None;
+        f.PackFrame( item, mHidIndentLevel, GetHIDUsagePage() );
+
+        AddStageFrame( f, mParseOffset, itemSize );
+
+        // collection increases the indent level
+        if( IsHIDItemCollection( item[ 0 ] ) )
+            ++mHidIndentLevel;
+
+        mParseOffset += itemSize;
+        mHidItemCnt++;
     }
 }
 
 void USBControlTransferParser::ParseCDCDataStage()
 {
-    USBCDCRequestCode reqCode = ( USBCDCRequestCode )mRequest.bRequest;
-
-    if( reqCode == GET_COMM_FEATURE || reqCode == SET_COMM_FEATURE )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-
-        if( mRequest.wValue == 1 ) // ABSTRACT_STATE
-            ParseStructure( CDCAbstractStateFields );
-        else if( mRequest.wValue == 2 ) // COUNTRY_SETTING
-            ParseStructure( CDCCountrySettingFields );
-        else
-            ParseUnknownResponse();
-    }
-    else if( reqCode == SET_LINE_CODING || reqCode == GET_LINE_CODING )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCLineCodingFields );
-    }
-    else if( reqCode == SET_RINGER_PARMS || reqCode == GET_RINGER_PARMS )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCRingerConfigFields );
-    }
-    else if( reqCode == GET_OPERATION_PARMS )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCOperationModeFields );
-    }
-    else if( reqCode == SET_LINE_PARMS || reqCode == GET_LINE_PARMS )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCLineParmsFields );
-    }
-    else if( reqCode == SET_UNIT_PARAMETER || reqCode == GET_UNIT_PARAMETER )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCUnitParameterFields );
-    }
-    else if( reqCode == GET_ETHERNET_STATISTIC || reqCode == GET_ATM_DEVICE_STATISTICS || reqCode == GET_ATM_VC_STATISTICS )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCUnsignedIntFields );
-    }
-    else if( reqCode == SET_ATM_DEFAULT_VC )
-    {
-        mDescBytes = mRequest.wLength;
-        mParsedOffset = 0;
-        ParseStructure( CDCATMDefaultVCFields );
-    }
-    else
+    // the whole data stage is one structure of wLength bytes
+    if( mParseOffset == 0 )
     {
-        ParseUnknownResponse();
+        mDescEnd = mRequest.wLength;
+        mDescSchema = FindCDCRequestSchema( mRequest.bRequest, mRequest.wValue );
+        mDescFieldCnt = 0;
     }
+
+    if( mDescSchema != NULL && !ParseStructure() )
+        return;
+
+    ParseBytes( std::numeric_limits<int>::max() );
 }
 
 void USBControlTransferParser::ParseDataPacket( USBPacket& packet )
 {
-    pPacket = &packet;
-    mPacketOffset = 0;
-    mPacketDataBytes = packet.mData.size() - 4;
+    USBPerfTimer timer( pPerf, PS_Descriptors );
+    if( pPerf != NULL )
+        pPerf->Count( PC_DataStagePackets );
 
-    if( mRequest.IsRequestedStandardDescriptor() )
+    // add the packet's data to the data stage
+    const int packetDataBytes = int( packet.mData.size() ) - 4;
+
+    mPacketBegin = int( mStageData.size() );
+    for( int cnt = 0; cnt < packetDataBytes; ++cnt )
     {
-        while( mPacketDataBytes > mPacketOffset )
-        {
-            U8 interfaceClass = mInterfaceClasses[ mInterfaceNumber ];
+        USBStageByteSamples samples = { packet.mBitBeginSamples[ 16 + cnt * 8 ], packet.mBitBeginSamples[ 16 + ( cnt + 1 ) * 8 ] };
 
-            if( mParsedOffset == 0 ) // are we just starting with this descriptor?
-            {
-                // handle the bLength field
-                pResults->AddFrame( packet.GetDataPayloadField( mPacketOffset, 1, mAddress, "bLength", Fld_None, FF_DataDescriptor ) );
-                mDescBytes = packet.GetDataPayload( mPacketOffset, 1 );
-                ++mPacketOffset;
-                ++mParsedOffset;
-            }
-            else if( mParsedOffset == 1 )
-            {
-                mDescType = USBDescriptorType( packet.GetDataPayload( mPacketOffset, 1 ) );
+        mStageData.push_back( packet.mData[ cnt + 2 ] );
+        mStageSamples.push_back( samples );
+    }
 
-                if( IsStandardDescriptor( mDescType ) || interfaceClass == CC_HID || interfaceClass == CC_CommunicationsAndCDCControl ||
-                    interfaceClass == CC_CDCData )
-                    pResults->AddFrame( packet.GetDataPayloadField( mPacketOffset, 1, mAddress, "bDescriptorType", Fld_bDescriptorType ) );
-                else
-                    pResults->AddFrame(
-                        packet.GetDataPayloadField( mPacketOffset, 1, mAddress, "bDescriptorType", Fld_bDescriptorType_Other ) );
+    if( !IsCachedRequest() )
+    {
+        ParseStageData();
+        return;
+    }
 
-                ++mPacketOffset;
-                ++mParsedOffset;
-            }
-            else if( mParsedOffset == 2 && ( interfaceClass == CC_CommunicationsAndCDCControl || interfaceClass == CC_CDCData ) &&
-                     ( mDescType == DT_CDC_CS_INTERFACE || mDescType == DT_CDC_CS_ENDPOINT ) )
-            {
-                mDescSubtype = USBCDCDescriptorSubtype( packet.GetDataPayload( mPacketOffset, 1 ) );
-                pResults->AddFrame(
-                    packet.GetDataPayloadField( mPacketOffset, 1, mAddress, "bDescriptorSubtype", Fld_CDC_DescriptorSubtype ) );
+    // a stage counts as replayed until one of its packets is not in the cache
+    if( !mHasStageHash )
+        mStageReplayed = true;
 
-                ++mPacketOffset;
-                ++mParsedOffset;
-            }
-            else
-            {
-                if( mDescType == DT_STRING )
-                {
-                    bool detected_complete_descriptor = ParseStringDescriptor();
-                    if( detected_complete_descriptor && mPacketDataBytes > mPacketOffset )
-                    {
-                        // we finished parsing the complete string descriptor, according to bLength, however there are still bytes left in
-                        // the packet.
-                        std::cerr << "String descriptor length shorter than packet length. Packet length: " << mPacketDataBytes
-                                  << " processed bytes: " << mPacketOffset << " reported descriptor length: " << mDescBytes << "\n";
-                        break;
-                    }
-                }
-                else
-                {
-                    ParseStandardDescriptor();
-                }
-            }
-        }
+    // the hash covers the packet boundaries too, since they decide where the split fields are
+    const U64 prevHash = mHasStageHash ? mStageHash : GetStageContextHash();
+    const U8 packetSize = U8( packetDataBytes );
+    const U8* pPacketData = packetDataBytes > 0 ? &mStageData[ mPacketBegin ] : NULL;
+    mStageHash = USBStageCache::Hash( USBStageCache::Hash( prevHash, &packetSize, 1 ), pPacketData, packetDataBytes );
+    mHasStageHash = true;
+
+    USBStageCache& cache = *pStageCache;
+    const USBStagePacketResult* pCached = cache.Find( mStageHash, prevHash, pPacketData, packetDataBytes );
+    if( pCached != NULL )
+    {
+        ReplayPacket( *pCached );
+        return;
     }
+
+    mStageReplayed = false;
+
+    USBStagePacketResult result;
+    mpPacketResult = &result;
+    ParseStageData();
+    mpPacketResult = NULL;
+
+    result.prevHash = prevHash;
+    result.data.assign( pPacketData, pPacketData + packetDataBytes );
+    SaveParseState( result.state );
+    cache.Insert( mStageHash, result );
+}
+
+void USBControlTransferParser::ParseStageData()
+{
+    // parse everything we can up to the end of the last packet
+    if( mRequest.IsRequestedStandardDescriptor() )
+        ParseStandardDescriptors();
     else if( mRequest.IsRequestedHIDReportDescriptor() )
-    {
         ParseHIDReportDescriptor();
-    }
     else if( IsCDCClassRequest() )
-    {
         ParseCDCDataStage();
-    }
     else
+        ParseBytes( std::numeric_limits<int>::max() );
+}
+
+U64 USBControlTransferParser::GetStageContextHash() const
+{
+    // the frames have the address, and the class specific descriptors depend on the interface before them
+    const U16 context[] = { U16( mRequest.bmRequestType | ( mRequest.bRequest << 8 ) ), mRequest.wValue, mRequest.wIndex, mRequest.wLength,
+                            U16( mAddress | ( GetParsedInterfaceClass() << 8 ) ) };
+
+    return USBStageCache::Hash( USBStageCache::GetInitialHash(), ( const U8* )context, sizeof( context ) );
+}
+
+void USBControlTransferParser::SaveParseState( USBStageParseState& state ) const
+{
+    state.parseOffset = mParseOffset;
+    state.descBegin = mDescBegin;
+    state.descEnd = mDescEnd;
+    state.descType = mDescType;
+    state.descSubtype = mDescSubtype;
+    state.descSchema = mDescSchema;
+    state.descFieldCnt = mDescFieldCnt;
+
+    state.hidIndentLevel = mHidIndentLevel;
+    state.hidItemCnt = mHidItemCnt;
+    state.hidUsagePageStack = mHidUsagePageStack;
+}
+
+void USBControlTransferParser::RestoreParseState( const USBStageParseState& state )
+{
+    mParseOffset = state.parseOffset;
+    mDescBegin = state.descBegin;
+    mDescEnd = state.descEnd;
+    mDescType = state.descType;
+    mDescSubtype = state.descSubtype;
+    mDescSchema = state.descSchema;
+    mDescFieldCnt = state.descFieldCnt;
+
+    mHidIndentLevel = state.hidIndentLevel;
+    mHidItemCnt = state.hidItemCnt;
+    mHidUsagePageStack = state.hidUsagePageStack;
+}
+
+void USBControlTransferParser::ReplayPacket( const USBStagePacketResult& result )
+{
+    // the same frames at the samples of this packet
+    for( size_t cnt = 0; cnt < result.frames.size(); ++cnt )
+    {
+        const USBStageFrame& stageFrame = result.frames[ cnt ];
+
+        USBFrame f( stageFrame.frame );
+        f.mStartingSampleInclusive = mStageSamples[ stageFrame.firstByte ].begin;
+        f.mEndingSampleInclusive = mStageSamples[ stageFrame.lastByte ].end;
+        pSink->AddFrame( f );
+    }
+
+    // and the same changes to the device
+    for( size_t cnt = 0; cnt < result.descriptors.size(); ++cnt )
     {
-        ParseUnknownResponse();
+        const std::pair<int, int>& descriptor = result.descriptors[ cnt ];
+        mDevice.AddDescriptor( &mStageData[ descriptor.first ], descriptor.second - descriptor.first );
     }
+
+    if( result.hasStringDescriptor )
+        pSink->AddStringDescriptor( mAddress, mRequest.GetRequestedDescriptorIndex(), result.stringDescriptor );
+
+    RestoreParseState( result.state );
+}
+
+void USBControlTransferParser::CompleteRequest()
+{
+    if( mHasStageHash && mStageReplayed )
+        pStageCache->AddDuplicateStage();
+
+    if( !mRequest.IsStandardRequest() )
+        return;
+
+    if( mRequest.bRequest == SET_ADDRESS && mRequest.IsRecipientDevice() )
+        mDevice.SetAddress( mRequest.wValue & 0x7f );
+    else if( mRequest.bRequest == SET_CONFIGURATION && mRequest.IsRecipientDevice() )
+        mDevice.SetConfiguration( mRequest.wValue & 0xff );
+    else if( mRequest.bRequest == SET_INTERFACE && mRequest.IsRecipientInterface() )
+        mDevice.SetInterface( mRequest.wIndex & 0xff, mRequest.wValue & 0xff );
+    else if( mRequest.IsRequestedHIDReportDescriptor() && !mStageData.empty() )
+        mDevice.SetHIDReportDescriptor( mRequest.wIndex & 0xff, &mStageData.front(), int( mStageData.size() ) );
 }
 
-void USBControlTransferPacketHandler::Init( USBAnalyzerResults* pResults, int address )
+void USBControlTransferPacketHandler::Init( USBFrameSink* pSink, USBStageCache* pStageCache, int address, USBPerfCounters* pPerf )
 {
-    mResults = pResults;
+    mSink = pSink;
+    mStageCache = pStageCache;
     mAddress = address;
 
     mCtrlTransLastReceived = CTS_StatusEnd;
-    mCtrlTransParser.SetAnalyzerResults( mResults );
+    mCtrlTransParser.SetFrameSink( mSink );
+    mCtrlTransParser.SetStageCache( mStageCache );
+    mCtrlTransParser.SetPerfCounters( pPerf );
+    mCtrlTransParser.ClearDevice( address );
 }
 
-U64 USBControlTransferPacketHandler::ResetControlTransferParser( USBPacket& pckt, USBFrameFlags flag )
+void USBControlTransferPacketHandler::AbortControlTransfer()
 {
     mCtrlTransLastReceived = CTS_StatusEnd;
     mCtrlTransParser.ResetParser();
-    return pckt.AddPacketFrames( mResults, flag );
+}
+
+U64 USBControlTransferPacketHandler::ResetControlTransferParser( USBPacket& pckt, USBFrameFlags flag )
+{
+    AbortControlTransfer();
+    return pckt.AddPacketFrames( mSink, flag );
 }
 
 U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
@@ -1294,13 +829,13 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
     {
         USBFrameFlags flag = mCtrlTransLastReceived == CTS_StatusEnd ? FF_None : FF_UnexpectedPacket;
         mCtrlTransLastReceived = CTS_SetupToken;
-        return pckt.AddPacketFrames( mResults, flag );
+        return pckt.AddPacketFrames( mSink, flag );
     }
 
     if( mCtrlTransLastReceived == CTS_SetupToken )
     {
-        // we must get a DATA0 after the SETUP pid
-        if( pckt.mPID != PID_DATA0 )
+        // we must get a DATA0 with the 8 bytes of the request after the SETUP pid
+        if( pckt.mPID != PID_DATA0 || pckt.mData.size() != 12 )
             return ResetControlTransferParser( pckt );
 
         // remember the request code and the response direction
@@ -1312,7 +847,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
         mCtrlTransParser.SetAddress( mAddress );
 
         mCtrlTransLastReceived = CTS_SetupData;
-        return pckt.AddSetupPacketFrame( mResults, mCtrlTransParser, mAddress );
+        return pckt.AddSetupPacketFrame( mSink, mCtrlTransParser, mAddress );
     }
     else if( mCtrlTransLastReceived == CTS_SetupData )
     {
@@ -1321,7 +856,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
             return ResetControlTransferParser( pckt );
 
         mCtrlTransLastReceived = CTS_SetupAck;
-        return pckt.AddPacketFrames( mResults );
+        return pckt.AddPacketFrames( mSink );
     }
 
     //
@@ -1343,14 +878,14 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
         if( mCtrlTransLastReceived == CTS_StatusOutToken || mCtrlTransLastReceived == CTS_StatusInToken )
             flag = FF_StatusBegin;
 
-        return pckt.AddPacketFrames( mResults, flag );
+        return pckt.AddPacketFrames( mSink, flag );
     }
     else if( mCtrlTransLastReceived == CTS_DataInToken )
     {
         if( pckt.mPID == PID_NAK )
         {
             mCtrlTransLastReceived = CTS_DataEnd;
-            return pckt.AddPacketFrames( mResults, FF_DataInNAKed );
+            return pckt.AddPacketFrames( mSink, FF_DataInNAKed );
         }
 
         if( pckt.mPID == PID_STALL )
@@ -1361,7 +896,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_DataInData;
 
-        return pckt.AddDataStageFrames( mResults, mCtrlTransParser, mAddress );
+        return pckt.AddDataStageFrames( mSink, mCtrlTransParser, mAddress );
     }
     else if( mCtrlTransLastReceived == CTS_DataOutToken )
     {
@@ -1370,7 +905,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_DataOutData;
 
-        return pckt.AddDataStageFrames( mResults, mCtrlTransParser, mAddress );
+        return pckt.AddDataStageFrames( mSink, mCtrlTransParser, mAddress );
     }
     else if( mCtrlTransLastReceived == CTS_DataInData )
     {
@@ -1380,7 +915,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_DataEnd;
 
-        return pckt.AddPacketFrames( mResults );
+        return pckt.AddPacketFrames( mSink );
     }
     else if( mCtrlTransLastReceived == CTS_DataOutData )
     {
@@ -1392,7 +927,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_DataEnd;
 
-        return pckt.AddPacketFrames( mResults, pckt.mPID == PID_NAK ? FF_DataOutNAKed : FF_None );
+        return pckt.AddPacketFrames( mSink, pckt.mPID == PID_NAK ? FF_DataOutNAKed : FF_None );
     }
 
     //
@@ -1421,7 +956,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
             flag = FF_None;
         }
 
-        return pckt.AddPacketFrames( mResults, flag );
+        return pckt.AddPacketFrames( mSink, flag );
     }
     else if( mCtrlTransLastReceived == CTS_StatusOutToken )
     {
@@ -1430,7 +965,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_StatusOutDataEmpty;
 
-        return pckt.AddPacketFrames( mResults );
+        return pckt.AddPacketFrames( mSink );
     }
     else if( mCtrlTransLastReceived == CTS_StatusInDataEmpty )
     {
@@ -1438,8 +973,9 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
             return ResetControlTransferParser( pckt );
 
         mCtrlTransLastReceived = CTS_StatusEnd;
+        mCtrlTransParser.CompleteRequest();
 
-        return pckt.AddPacketFrames( mResults, FF_StatusEnd );
+        return pckt.AddPacketFrames( mSink, FF_StatusEnd );
     }
     else if( mCtrlTransLastReceived == CTS_StatusOutDataEmpty )
     {
@@ -1451,6 +987,9 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
         {
             mCtrlTransLastReceived = CTS_StatusEnd;
             flag = FF_StatusEnd;
+
+            if( pckt.mPID == PID_ACK )
+                mCtrlTransParser.CompleteRequest();
         }
         else
         {
@@ -1458,7 +997,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
             flag = FF_StatusOutNAKed;
         }
 
-        return pckt.AddPacketFrames( mResults, flag );
+        return pckt.AddPacketFrames( mSink, flag );
     }
     else if( mCtrlTransLastReceived == CTS_StatusOutDataNAKed )
     {
@@ -1467,7 +1006,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_StatusOutToken;
 
-        return pckt.AddPacketFrames( mResults );
+        return pckt.AddPacketFrames( mSink );
     }
     else if( mCtrlTransLastReceived == CTS_StatusInNAKed )
     {
@@ -1476,7 +1015,7 @@ U64 USBControlTransferPacketHandler::HandleControlTransfer( USBPacket& pckt )
 
         mCtrlTransLastReceived = CTS_StatusInToken;
 
-        return pckt.AddPacketFrames( mResults );
+        return pckt.AddPacketFrames( mSink );
     }
 
     assert( mCtrlTransLastReceived == CTS_StatusEnd );
@@ -1,12 +1,14 @@
 #ifndef USB_CONTROL_TRANSFERS_H
 #define USB_CONTROL_TRANSFERS_H
 
-#include <map>
-
-#include <LogicPublicTypes.h>
-#include <AnalyzerResults.h>
+#include <vector>
 
+#include "USBCoreTypes.h"
 #include "USBEnums.h"
+#include "USBDescriptorSchemas.h"
+#include "USBDeviceModel.h"
+#include "USBPerfCounters.h"
+#include "USBStageCache.h"
 
 struct USBRequest
 {
@@ -146,7 +148,7 @@ struct USBEndpointDescriptor
 };
 */
 
-class USBCtrlTransFieldFrame : public Frame
+class USBCtrlTransFieldFrame : public USBFrame
 {
   public:
     USBCtrlTransFieldFrame()
@@ -183,7 +185,7 @@ class USBCtrlTransFieldFrame : public Frame
     }
 };
 
-class USBHidRepDescItemFrame : public Frame
+class USBHidRepDescItemFrame : public USBFrame
 {
   public:
     USBHidRepDescItemFrame()
@@ -195,11 +197,20 @@ class USBHidRepDescItemFrame : public Frame
 
     void PackFrame( const U8* pItem, U16 indentLevel, U16 usagePage );
 
+    // for an item which continues in the next packet: the bytes of the item so far
+    void PackIncompleteFrame( const U8* pItem, U8 numBytes );
+
     const U8* GetItem() const
     {
         return ( const U8* )&mData1;
     }
 
+    // only valid for FF_FieldIncomplete frames
+    U8 GetNumIncompleteBytes() const
+    {
+        return mData2 & 0xff;
+    }
+
     U16 GetIndentLevel() const
     {
         return mData2 & 0xffff;
@@ -212,55 +223,77 @@ class USBHidRepDescItemFrame : public Frame
 };
 
 // describes data structures
-struct USBStructField
-{
-    const char* name;
-    int numBytes;
-    USBCtrlTransFieldType formatter;
-};
-
 class USBControlTransferParser
 {
   private:
-    int mDescBytes; // size of this descriptor in bytes; equal to Descriptor.bLength
+    // the data stage is reassembled from its data packets, and we keep the sample range of each byte
+    // so that fields which span two packets can be parsed in one piece
+    struct USBStageByteSamples
+    {
+        U64 begin; // first bit of the byte
+        U64 end;   // first bit after the byte
+    };
+
+    std::vector<U8> mStageData;
+    std::vector<USBStageByteSamples> mStageSamples;
+    int mPacketBegin; // offset of the last data packet in mStageData
+    int mParseOffset; // offset of the first byte in mStageData which is not parsed yet
+
+    // the descriptor or structure we are parsing
+    int mDescBegin; // offset of bLength
+    int mDescEnd;   // mDescBegin + bLength
     USBDescriptorType mDescType;
     USBCDCDescriptorSubtype mDescSubtype;
-    int mParsedOffset; // number of bytes we have already parsed from the current descriptor
-    U32 mLeftover;     // the LS byte of the previous packet in case a field spans two packets
+    const USBDescriptorSchema* mDescSchema; // NULL if we don't know its fields
+    int mDescFieldCnt;                      // index of the next field in mDescSchema
 
-    USBAnalyzerResults* pResults;
+    USBFrameSink* pSink;
+    USBStageCache* pStageCache;
+    USBPerfCounters* pPerf; // NULL unless the decoder keeps the counters
     U8 mAddress;
 
     USBRequest mRequest;
 
-    std::u16string utf16StringDescriptor;
-
-
-    // these are only valid during a ParsePacket call, and invalid before and after
-    USBPacket* pPacket;
-    int mPacketOffset;    // index of the data byte of the current packet
-    int mPacketDataBytes; // number of bytes in the current packet
-
-    // we store the class IDs for the device and the interfaces
-    U8 mInterfaceNumber; // the last parsed interface number
-    typedef std::map<U8, USBClassCodes> USBInterfaceClassesContainer;
-
-    USBInterfaceClassesContainer mInterfaceClasses;
+    // the descriptors and state of the device
+    USBDeviceModel mDevice;
 
     // used for the HID report descriptor parser
-    U8 mHidRepDescItem[ 5 ];
-    U8 mHidRepDescBytes;
     int mHidIndentLevel;
     int mHidItemCnt;
     std::vector<U16> mHidUsagePageStack;
 
-    USBClassCodes GetClassCodeForInterface( U8 iface ) const;
+    // the descriptor data stages are cached by the hash of the request and the data so far
+    U64 mStageHash;
+    bool mHasStageHash;
+    bool mStageReplayed;                  // true if all the packets of the stage were replayed from the cache
+    USBStagePacketResult* mpPacketResult; // where the parse of the current packet goes, NULL if it is not cached
+
+    // the class of the last parsed interface descriptor, which the class specific descriptors belong to
+    U8 GetParsedInterfaceClass() const
+    {
+        const USBInterfaceInfo* pInterface = mDevice.GetParsedInterface();
+
+        return pInterface != NULL ? pInterface->bInterfaceClass : 0;
+    }
 
     bool IsCDCClassRequest() const;
 
+    U32 GetStageData( int offset, int numBytes ) const;
+    bool IsInLastPacket( int offset, int numBytes ) const
+    {
+        return numBytes > 0 && offset + numBytes > mPacketBegin;
+    }
+    void SetFrameSamples( USBFrame& f, int offset, int numBytes ) const;
+    void AddStageFrame( USBFrame& f, int offset, int numBytes );
+
+    // the parse functions return false if they need the data of the next packet to continue
+    bool AddField( int numBytes, const char* name, USBCtrlTransFieldType formatter = Fld_None, U8 flags = FF_None );
+    bool ParseBytes( int end );
+    bool ParseStructure();
+
     bool ParseStringDescriptor();
-    void ParseStructure( USBStructField* descFields );
-    void ParseStandardDescriptor();
+    bool ParseStandardDescriptor();
+    void ParseStandardDescriptors();
 
     void SetHIDUsagePage( U16 usagePage )
     {
@@ -291,17 +324,37 @@ class USBControlTransferParser
 
     void ParseCDCDataStage();
     void ParseHIDReportDescriptor();
-    void ParseUnknownResponse();
+    void ParseStageData();
+
+    bool IsCachedRequest() const
+    {
+        return mRequest.IsRequestedStandardDescriptor() || mRequest.IsRequestedHIDReportDescriptor();
+    }
+
+    U64 GetStageContextHash() const;
+    void SaveParseState( USBStageParseState& state ) const;
+    void RestoreParseState( const USBStageParseState& state );
+    void ReplayPacket( const USBStagePacketResult& result );
 
   public:
-    USBControlTransferParser()
+    USBControlTransferParser() : pPerf( NULL )
     {
         ResetParser();
     }
 
-    void SetAnalyzerResults( USBAnalyzerResults* pres )
+    void SetFrameSink( USBFrameSink* psink )
+    {
+        pSink = psink;
+    }
+
+    void SetStageCache( USBStageCache* pcache )
+    {
+        pStageCache = pcache;
+    }
+
+    void SetPerfCounters( USBPerfCounters* pperf )
     {
-        pResults = pres;
+        pPerf = pperf;
     }
 
     void ResetParser();
@@ -314,16 +367,32 @@ class USBControlTransferParser
     void SetRequest( USBPacket& packet )
     {
         mRequest.SetFromPacket( packet );
+        mStageData.reserve( mRequest.wLength );
+        mStageSamples.reserve( mRequest.wLength );
     }
 
     void ParseDataPacket( USBPacket& packet );
 
+    // applies the standard requests which change the state of the device, once their status stage completes
+    void CompleteRequest();
+
+    // starts over with a device we know nothing about
+    void ClearDevice( U8 address )
+    {
+        mDevice.Clear( address );
+    }
+
+    const USBDeviceModel& GetDeviceModel() const
+    {
+        return mDevice;
+    }
+
     U8 GetClassForInterface( U8 iface ) const
     {
         // get the interface class
-        USBInterfaceClassesContainer::const_iterator srch( mInterfaceClasses.find( iface ) );
-        if( srch != mInterfaceClasses.end() )
-            return srch->second;
+        const USBInterfaceInfo* pInterface = mDevice.GetInterface( iface );
+        if( pInterface != NULL )
+            return pInterface->bInterfaceClass;
 
         return 0;
     }
@@ -364,13 +433,28 @@ class USBControlTransferPacketHandler
     USBControlTransferParser mCtrlTransParser;
     int mAddress;
 
-    USBAnalyzerResults* mResults;
+    USBFrameSink* mSink;
+    USBStageCache* mStageCache;
 
   public:
-    void Init( USBAnalyzerResults* pResults, int addr );
+    void Init( USBFrameSink* pSink, USBStageCache* pStageCache, int addr, USBPerfCounters* pPerf = NULL );
+
+    // the device state moved to the pipe of this address
+    void SetAddress( int addr )
+    {
+        mAddress = addr;
+    }
+
+    // drops the control transfer in progress, but keeps the device state
+    void AbortControlTransfer();
 
     U64 ResetControlTransferParser( USBPacket& pckt, USBFrameFlags flag = FF_UnexpectedPacket );
     U64 HandleControlTransfer( USBPacket& pckt );
+
+    const USBDeviceModel& GetDeviceModel() const
+    {
+        return mCtrlTransParser.GetDeviceModel();
+    }
 };
 
 inline int GetNumHIDItemDataBytes( U8 firstByte )
@@ -0,0 +1,66 @@
+#ifndef USB_CORE_TYPES_H
+#define USB_CORE_TYPES_H
+
+// The types of the decoder core. The core doesn't use the AnalyzerSDK, so it builds into programs without the
+// Logic app or the SDK; the plugin converts between these and the SDK types in USBAnalyzer.cpp and
+// USBAnalyzerResults.cpp. The integers are the same types as those of LogicPublicTypes.h, so a file can
+// include both.
+
+#include <stddef.h>
+
+typedef signed char S8;
+typedef short S16;
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+// how the numbers of the bubbles and the exports are shown
+enum USBDisplayBase
+{
+    DB_Binary,
+    DB_Decimal,
+    DB_Hexadecimal,
+    DB_ASCII,
+    DB_AsciiHex,
+};
+
+// the level of a bus line
+enum USBBitState
+{
+    BS_Low,
+    BS_High,
+};
+
+inline USBBitState InvertBitState( USBBitState state )
+{
+    return state == BS_Low ? BS_High : BS_Low;
+}
+
+// the marker on a bit of a packet
+enum USBBitMarker
+{
+    BM_Zero,
+    BM_One,
+    BM_StuffBit,
+};
+
+// a decoded frame; mType is a USBFrameTypes and mFlags a USBFrameFlags
+struct USBFrame
+{
+    USBFrame() : mStartingSampleInclusive( 0 ), mEndingSampleInclusive( 0 ), mData1( 0 ), mData2( 0 ), mType( 0 ), mFlags( 0 )
+    {
+    }
+
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U64 mData1;
+    U64 mData2;
+    U8 mType;
+    U8 mFlags;
+};
+
+#endif // USB_CORE_TYPES_H
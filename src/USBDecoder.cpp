@@ -0,0 +1,281 @@
+#include "USBDecoder.h"
+#include "USBEdgeSource.h"
+#include "USBFrameSink.h"
+
+USBDecoder::USBDecoder( USBFrameSink* pSink, U32 sampleRate, USBSpeed speed, USBDecodeLevel decodeLevel )
+    : mSink( pSink ), mSampleRate( sampleRate ), mSpeed( speed ), mDecodeLevel( decodeLevel ), mLastTokenPID( PID_SETUP ), mpPerf( NULL )
+{
+}
+
+void USBDecoder::SetPerfCounters( USBPerfCounters* pPerf )
+{
+    // the frames go through a sink which counts and times them
+    if( mpPerf == NULL && pPerf != NULL )
+    {
+        mPerfSink.SetSink( mSink, pPerf );
+        mSink = &mPerfSink;
+    }
+    else if( mpPerf != NULL && pPerf == NULL )
+    {
+        mSink = mPerfSink.GetSink();
+    }
+    else if( pPerf != NULL )
+    {
+        mPerfSink.SetSink( mPerfSink.GetSink(), pPerf );
+    }
+
+    mpPerf = pPerf;
+}
+
+void USBDecoder::Reset()
+{
+    mCtrlTransPacketHandlers.clear();
+    mResetDevices.clear();
+    mCtrlTransLastPipe.Clear();
+    mLastTokenPID = PID_SETUP;
+    mHidReportStates.clear();
+}
+
+U64 USBDecoder::SendPacketToHandler( USBPacket& pckt )
+{
+    if( pckt.IsTokenPacket() )
+    {
+        mCtrlTransLastPipe.addr = pckt.GetAddress();
+        mCtrlTransLastPipe.endp = pckt.GetEndpoint();
+        mLastTokenPID = pckt.mPID;
+    }
+
+    // only control transfers and no SOF or PRE packets
+    if( mCtrlTransLastPipe.endp == 0 && pckt.mPID != PID_SOF && pckt.mPID != PID_PRE )
+    {
+        USBPipeHandler::iterator srch( GetPipeHandler( mCtrlTransLastPipe ) );
+
+        U64 ret_val = srch->second.HandleControlTransfer( pckt );
+
+        // did the status stage of a SET_ADDRESS just complete?
+        if( srch->second.GetDeviceModel().GetAddress() != srch->first.addr )
+            MoveDevice( srch );
+
+        return ret_val;
+    }
+
+    if( pckt.IsDataPacket() )
+        return HandleInterruptPacket( pckt );
+
+    return pckt.AddPacketFrames( mSink );
+}
+
+U64 USBDecoder::HandleInterruptPacket( USBPacket& pckt )
+{
+    // the device state is kept by the handler of its default control pipe
+    USBPipe control( mCtrlTransLastPipe );
+    control.endp = 0;
+
+    USBPipeHandler::const_iterator srch( mCtrlTransPacketHandlers.find( control ) );
+    if( srch == mCtrlTransPacketHandlers.end() || ( mLastTokenPID != PID_IN && mLastTokenPID != PID_OUT ) )
+        return pckt.AddPacketFrames( mSink );
+
+    USBPipe pipe( mCtrlTransLastPipe );
+    if( mLastTokenPID == PID_IN )
+        pipe.endp |= 0x80;
+
+    // decode the reports if the endpoint is an interrupt endpoint of an interface we have the report descriptor of
+    const USBDeviceModel& device = srch->second.GetDeviceModel();
+    const USBEndpointInfo* pEndpoint = device.GetEndpoint( U8( pipe.endp ) );
+    if( pEndpoint == NULL || pEndpoint->GetType() != EPT_Interrupt )
+        return pckt.AddPacketFrames( mSink );
+
+    const USBHidReportLayout* pLayout = device.GetHIDReportLayout( pEndpoint->bInterfaceNumber );
+    if( pLayout == NULL )
+        return pckt.AddPacketFrames( mSink );
+
+    return pckt.AddHIDReportFrames( mSink, *pLayout, mLastTokenPID == PID_IN ? HRT_Input : HRT_Output,
+                                    pEndpoint->wMaxPacketSize & 0x7ff, mHidReportStates[ pipe ] );
+}
+
+USBDecoder::USBPipeHandler::iterator USBDecoder::GetPipeHandler( const USBPipe& pipe )
+{
+    // do we have this address/enpoint already?
+    USBPipeHandler::iterator srch( mCtrlTransPacketHandlers.find( pipe ) );
+    if( srch != mCtrlTransPacketHandlers.end() )
+        return srch;
+
+    // Nobody got this address since the bus reset, so the device didn't go through the reset (or the SE0 was
+    // not a reset at all) and it keeps its state.
+    USBPipeHandler::iterator reset( mResetDevices.find( pipe ) );
+    if( reset != mResetDevices.end() )
+    {
+        srch = mCtrlTransPacketHandlers.insert( *reset ).first;
+        mResetDevices.erase( reset );
+        return srch;
+    }
+
+    // this is a new address
+    srch = mCtrlTransPacketHandlers.insert( std::make_pair( pipe, USBControlTransferPacketHandler() ) ).first;
+    srch->second.Init( mSink, &mStageCache, pipe.addr, mpPerf );
+
+    return srch;
+}
+
+void USBDecoder::MoveDevice( USBPipeHandler::iterator srch )
+{
+    const USBDeviceModel& device = srch->second.GetDeviceModel();
+
+    USBPipe pipe( srch->first );
+    pipe.addr = device.GetAddress();
+
+    // the device that had this address before the bus reset is gone
+    mResetDevices.erase( pipe );
+
+    // If this device was here before the bus reset, the host might not read all of its string descriptors
+    // again. We only find it if we got the device descriptor before the SET_ADDRESS.
+    for( USBPipeHandler::iterator reset = mResetDevices.begin(); reset != mResetDevices.end(); ++reset )
+    {
+        if( reset->second.GetDeviceModel().IsSameDevice( device ) )
+        {
+            mSink->CopyStringDescriptors( reset->first.addr, pipe.addr );
+            mResetDevices.erase( reset );
+            break;
+        }
+    }
+
+    // the string descriptors read at the old address are newer
+    mSink->CopyStringDescriptors( srch->first.addr, pipe.addr );
+
+    USBControlTransferPacketHandler& handler = mCtrlTransPacketHandlers[ pipe ];
+    handler = srch->second;
+    handler.SetAddress( pipe.addr );
+
+    mCtrlTransPacketHandlers.erase( srch );
+}
+
+void USBDecoder::ResetBus()
+{
+    // All the devices are back at address 0, where they are enumerated again. Keep what we know about them
+    // until then, but only since the last reset, so repeated re-enumerations don't pile up devices.
+    mResetDevices.clear();
+    mResetDevices.swap( mCtrlTransPacketHandlers );
+
+    for( USBPipeHandler::iterator srch = mResetDevices.begin(); srch != mResetDevices.end(); )
+    {
+        if( srch->first.addr == 0 )
+        {
+            mResetDevices.erase( srch++ );
+        }
+        else
+        {
+            srch->second.AbortControlTransfer();
+            ++srch;
+        }
+    }
+
+    mCtrlTransLastPipe.Clear();
+    mHidReportStates.clear();
+}
+
+void USBDecoder::Decode( USBEdgeSource* pDP, USBEdgeSource* pDM )
+{
+    // the edges are read through sources which time them
+    USBPerfEdgeSource perfDP( pDP, mpPerf );
+    USBPerfEdgeSource perfDM( pDM, mpPerf );
+    if( mpPerf != NULL )
+        pDP = &perfDP, pDM = &perfDM;
+
+    USBPerfTimer timer( mpPerf, PS_Decode );
+
+    USBSignalFilter sf( mSink, pDP, pDM, mSampleRate, mSpeed, mpPerf );
+
+    Reset();
+
+    USBSignalState s;
+    USBPacket pckt;
+    U64 lastFrameEnd = 0;
+    while( sf.HasMoreData() )
+    {
+        s = sf.GetState();
+
+        if( mDecodeLevel == OUT_SIGNALS )
+        {
+            s.AddFrame( mSink );
+        }
+        else
+        {
+            if( lastFrameEnd == 0 )
+                lastFrameEnd = s.mSampleBegin;
+
+            // if this is a data signal
+            if( sf.IsDataSignal( s ) )
+            {
+                // try reading an entire USB packet by parsing subsequent data signals
+                bool isPacket;
+                {
+                    USBPerfTimer packetTimer( mpPerf, PS_GetPacket );
+                    isPacket = sf.GetPacket( pckt, s );
+                }
+
+                if( mpPerf != NULL )
+                    mpPerf->Count( isPacket ? PC_Packets : PC_BadPackets );
+
+                USBPerfTimer handlerTimer( mpPerf, PS_Handler );
+                if( isPacket )
+                {
+                    if( mDecodeLevel == OUT_CONTROL_TRANSFERS )
+                        lastFrameEnd = SendPacketToHandler( pckt );
+                    else if( mDecodeLevel == OUT_PACKETS )
+                        lastFrameEnd = pckt.AddPacketFrames( mSink );
+                    else if( mDecodeLevel == OUT_BYTES )
+                        lastFrameEnd = pckt.AddRawByteFrames( mSink );
+                }
+                else
+                {
+                    lastFrameEnd = pckt.AddErrorFrame( mSink );
+                }
+            }
+            else if( mSpeed == LOW_SPEED // is this a LS Keep-alive?
+                     && s.mState == S_SE0 && s.GetNumBits( LOW_SPEED ) == 2 )
+            {
+                USBFrame f;
+                f.mStartingSampleInclusive = lastFrameEnd;
+                f.mEndingSampleInclusive = s.mSampleEnd;
+                f.mType = FT_KeepAlive;
+                f.mFlags = FF_None;
+                f.mData1 = f.mData2 = 0;
+
+                mSink->AddFrame( f );
+                mSink->CommitFrames();
+
+                lastFrameEnd = s.mSampleEnd;
+            }
+            else if( s.mState == S_SE0 && s.mDur > 1e7 )
+            { // Reset?   dur > 10 ms
+
+                USBFrame f;
+                f.mStartingSampleInclusive = lastFrameEnd;
+                f.mEndingSampleInclusive = s.mSampleEnd;
+                f.mType = FT_Reset;
+                f.mFlags = FF_None;
+                f.mData1 = f.mData2 = 0;
+
+                mSink->AddFrame( f );
+                mSink->CommitFrames();
+
+                lastFrameEnd = s.mSampleEnd;
+
+                ResetBus();
+            }
+            else if( s.mState == S_J )
+            { // Idle
+
+                lastFrameEnd = s.mSampleEnd;
+            }
+        }
+
+        mSink->ReportProgress( s.mSampleEnd );
+    }
+
+    if( mpPerf != NULL )
+    {
+        mpPerf->SetCount( PC_ReplayedPackets, mStageCache.GetNumReplayedPackets() );
+        mpPerf->SetCount( PC_ParsedPackets, mStageCache.GetNumParsedPackets() );
+    }
+}
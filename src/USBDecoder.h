@@ -0,0 +1,95 @@
+#ifndef USB_DECODER_H
+#define USB_DECODER_H
+
+#include <map>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+#include "USBTypes.h"
+#include "USBControlTransfers.h"
+#include "USBHidReports.h"
+#include "USBPerfCounters.h"
+#include "USBStageCache.h"
+
+class USBEdgeSource;
+class USBFrameSink;
+
+// Decodes the D+ and D- lines into frames, at the level of the settings. This is everything the analyzer does
+// with a capture, without the Logic app: the plugin passes it the channels and the results, and the offline
+// tools pass it their own edge sources and frame sinks.
+class USBDecoder
+{
+  public:
+    USBDecoder( USBFrameSink* pSink, U32 sampleRate, USBSpeed speed, USBDecodeLevel decodeLevel );
+
+    // decodes until there are no more edges on either line
+    void Decode( USBEdgeSource* pDP, USBEdgeSource* pDM );
+
+    // forgets all the devices and transfers
+    void Reset();
+
+    // times the stages and counts what goes through them, from the next Decode on; NULL turns them off
+    void SetPerfCounters( USBPerfCounters* pPerf );
+
+    USBStageCache& GetStageCache()
+    {
+        return mStageCache;
+    }
+
+  protected: // functions
+    struct USBPipe
+    {
+        int addr;
+        int endp;
+
+        USBPipe()
+        {
+            Clear();
+        }
+
+        void Clear()
+        {
+            addr = endp = 0;
+        }
+
+        bool operator<( const USBPipe& rhs ) const
+        {
+            if( addr == rhs.addr )
+                return endp < rhs.endp;
+
+            return addr < rhs.addr;
+        }
+    };
+
+    // address to packet handler; the handler keeps the state of the device at that address
+    typedef std::map<USBPipe, USBControlTransferPacketHandler> USBPipeHandler;
+
+    U64 SendPacketToHandler( USBPacket& pckt );
+    USBPipeHandler::iterator GetPipeHandler( const USBPipe& pipe );
+    void MoveDevice( USBPipeHandler::iterator srch );
+    U64 HandleInterruptPacket( USBPacket& pckt );
+
+    void ResetBus();
+
+  protected: // vars
+    USBFrameSink* mSink;
+
+    U32 mSampleRate;
+    USBSpeed mSpeed;
+    USBDecodeLevel mDecodeLevel;
+
+    USBPipeHandler mCtrlTransPacketHandlers;
+    USBPipeHandler mResetDevices; // the devices from before the last bus reset which didn't show up again yet
+    USBPipe mCtrlTransLastPipe;
+    USB_PID mLastTokenPID;
+
+    // where we are in the reports of the HID interrupt endpoints; endp has the direction bit
+    std::map<USBPipe, USBHidReportState> mHidReportStates;
+
+    USBStageCache mStageCache; // parse results of the descriptor data stages, which hosts read again and again
+
+    USBPerfCounters* mpPerf;    // NULL unless the counters are on
+    USBPerfFrameSink mPerfSink; // between the decoder and the sink while they are on
+};
+
+#endif // USB_DECODER_H
@@ -0,0 +1,621 @@
+#include <stddef.h>
+#include <algorithm>
+
+#include "USBDescriptorSchemas.h"
+#include "USBSortedTables.h"
+
+//
+// standard and HID descriptors
+//
+
+constexpr USBStructField DeviceDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bcdUSB", 2, Fld_BCD },
+    { "bDeviceClass", 1, Fld_ClassCode },
+    { "bDeviceSubClass", 1, Fld_None },
+    { "bDeviceProtocol", 1, Fld_None },
+    { "bMaxPacketSize0", 1, Fld_None },
+    { "idVendor", 2, Fld_wVendorId },
+    { "idProduct", 2, Fld_None },
+    { "bcdDevice", 2, Fld_BCD },
+    { "iManufacturer", 1, Fld_String },
+    { "iProduct", 1, Fld_String },
+    { "iSerialNumber", 1, Fld_String },
+    { "bNumConfigurations", 1, Fld_None },
+};
+
+constexpr USBStructField DeviceQualifierDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bcdUSB", 2, Fld_BCD },
+    { "bDeviceClass", 1, Fld_ClassCode },
+    { "bDeviceSubClass", 1, Fld_None },
+    { "bDeviceProtocol", 1, Fld_None },
+    { "bMaxPacketSize0", 1, Fld_None },
+    { "bNumConfigurations", 1, Fld_None },
+    { "bReserved", 1, Fld_None },
+};
+
+constexpr USBStructField ConfigurationDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "wTotalLength", 2, Fld_None },
+    { "bNumInterfaces", 1, Fld_None },
+    { "bConfigurationValue", 1, Fld_None },
+    { "iConfiguration", 1, Fld_String },
+    { "bmAttributes", 1, Fld_bmAttributes_Config },
+    { "bMaxPower", 1, Fld_bMaxPower },
+};
+
+constexpr USBStructField InterfaceDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bInterfaceNumber", 1, Fld_None },
+    { "bAlternateSetting", 1, Fld_None },
+    { "bNumEndpoints", 1, Fld_None },
+    { "bInterfaceClass", 1, Fld_ClassCode },
+    { "bInterfaceSubClass", 1, Fld_None },
+    { "bInterfaceProtocol", 1, Fld_None },
+    { "iInterface", 1, Fld_String },
+};
+
+constexpr USBStructField EndpointDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bEndpointAddress", 1, Fld_bEndpointAddress },
+    { "bmAttributes", 1, Fld_bmAttributes_Endpoint },
+    { "wMaxPacketSize", 2, Fld_None },
+    { "bInterval", 1, Fld_None },
+};
+
+constexpr USBStructField HIDDescriptorFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bcdHID", 2, Fld_BCD },
+    { "bCountryCode", 1, Fld_HID_bCountryCode },
+    { "bNumDescriptors", 1, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+
+    // these are optional and depend of the number of HID class descriptors for this interface
+    // we have enough for 16
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+    { "bDescriptorType", 1, Fld_bDescriptorType },
+    { "wDescriptorLength", 2, Fld_None },
+};
+
+//
+// CDC descriptors
+//
+
+constexpr USBStructField CDCHeaderFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bcdCDC", 2, Fld_BCD },
+};
+
+constexpr USBStructField CDCCallManagementFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_Call },
+    { "bDataInterface", 1, Fld_None },
+};
+
+constexpr USBStructField CDCAbstractControlManagementFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_AbstractCtrl },
+};
+
+constexpr USBStructField CDCDirectLineManagementFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_DataLine },
+};
+
+constexpr USBStructField CDCTelephoneRingerFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bRingerVolSteps", 1, Fld_CDC_bRingerVolSteps },
+    { "bNumRingerPatterns", 1, Fld_None },
+};
+
+constexpr USBStructField CDCTelephoneOperationalModesFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_TelOpModes },
+};
+
+constexpr USBStructField CDCTelephoneCallStateReportingFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_TelCallStateRep },
+};
+
+constexpr USBStructField CDCUnionFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bMasterInterface", 1, Fld_None },
+    { "bSlaveInterface0", 1, Fld_None },
+    { "bSlaveInterface1", 1, Fld_None },
+    { "bSlaveInterface2", 1, Fld_None },
+    { "bSlaveInterface3", 1, Fld_None },
+    { "bSlaveInterface4", 1, Fld_None },
+    { "bSlaveInterface5", 1, Fld_None },
+    { "bSlaveInterface6", 1, Fld_None },
+    { "bSlaveInterface7", 1, Fld_None },
+    { "bSlaveInterface8", 1, Fld_None },
+    { "bSlaveInterface9", 1, Fld_None },
+    { "bSlaveInterface10", 1, Fld_None },
+    { "bSlaveInterface11", 1, Fld_None },
+    { "bSlaveInterface12", 1, Fld_None },
+    { "bSlaveInterface13", 1, Fld_None },
+    { "bSlaveInterface14", 1, Fld_None },
+    { "bSlaveInterface15", 1, Fld_None },
+    { "bSlaveInterface16", 1, Fld_None },
+    { "bSlaveInterface17", 1, Fld_None },
+};
+
+constexpr USBStructField CDCCountrySelectionFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "iCountryCodeRelDate", 1, Fld_String },
+    { "wCountryCode0", 2, Fld_None },
+    { "wCountryCode1", 2, Fld_None },
+    { "wCountryCode2", 2, Fld_None },
+    { "wCountryCode3", 2, Fld_None },
+    { "wCountryCode4", 2, Fld_None },
+    { "wCountryCode5", 2, Fld_None },
+    { "wCountryCode6", 2, Fld_None },
+    { "wCountryCode7", 2, Fld_None },
+    { "wCountryCode8", 2, Fld_None },
+    { "wCountryCode9", 2, Fld_None },
+    { "wCountryCode10", 2, Fld_None },
+    { "wCountryCode11", 2, Fld_None },
+    { "wCountryCode12", 2, Fld_None },
+    { "wCountryCode13", 2, Fld_None },
+    { "wCountryCode14", 2, Fld_None },
+    { "wCountryCode15", 2, Fld_None },
+    { "wCountryCode16", 2, Fld_None },
+    { "wCountryCode17", 2, Fld_None },
+};
+
+constexpr USBStructField CDCUSBTerminalFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bEntityId", 1, Fld_None },
+    { "bInInterfaceNo", 1, Fld_None },
+    { "bOutInterfaceNo", 1, Fld_None },
+    { "bmOptions", 1, Fld_CDC_bmOptions },
+    { "bChildId0", 1, Fld_None },
+    { "bChildId1", 1, Fld_None },
+    { "bChildId2", 1, Fld_None },
+    { "bChildId3", 1, Fld_None },
+    { "bChildId4", 1, Fld_None },
+    { "bChildId5", 1, Fld_None },
+    { "bChildId6", 1, Fld_None },
+    { "bChildId7", 1, Fld_None },
+    { "bChildId8", 1, Fld_None },
+    { "bChildId9", 1, Fld_None },
+    { "bChildId10", 1, Fld_None },
+    { "bChildId11", 1, Fld_None },
+    { "bChildId12", 1, Fld_None },
+    { "bChildId13", 1, Fld_None },
+    { "bChildId14", 1, Fld_None },
+    { "bChildId15", 1, Fld_None },
+    { "bChildId16", 1, Fld_None },
+    { "bChildId17", 1, Fld_None },
+};
+
+constexpr USBStructField CDCNetworkChannelTerminalFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bEntityId", 1, Fld_None },
+    { "iName", 1, Fld_String },
+    { "bChannelIndex", 1, Fld_None },
+    { "bPhysicalInterface", 1, Fld_CDC_bPhysicalInterface },
+};
+
+constexpr USBStructField CDCProtocolUnitFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bEntityId", 1, Fld_None },
+    { "bProtocol", 1, Fld_CDC_bProtocol },
+    { "bOutInterfaceNo", 1, Fld_None },
+    { "bmOptions", 1, Fld_CDC_bmOptions },
+    { "bChildId0", 1, Fld_None },
+    { "bChildId1", 1, Fld_None },
+    { "bChildId2", 1, Fld_None },
+    { "bChildId3", 1, Fld_None },
+    { "bChildId4", 1, Fld_None },
+    { "bChildId5", 1, Fld_None },
+    { "bChildId6", 1, Fld_None },
+    { "bChildId7", 1, Fld_None },
+    { "bChildId8", 1, Fld_None },
+    { "bChildId9", 1, Fld_None },
+    { "bChildId10", 1, Fld_None },
+    { "bChildId11", 1, Fld_None },
+    { "bChildId12", 1, Fld_None },
+    { "bChildId13", 1, Fld_None },
+    { "bChildId14", 1, Fld_None },
+    { "bChildId15", 1, Fld_None },
+    { "bChildId16", 1, Fld_None },
+    { "bChildId17", 1, Fld_None },
+};
+
+constexpr USBStructField CDCExtensionUnitFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bEntityId", 1, Fld_None },
+    { "bExtensionCode", 1, Fld_None },
+    { "iName", 1, Fld_String },
+    { "bChildId0", 1, Fld_None },
+    { "bChildId1", 1, Fld_None },
+    { "bChildId2", 1, Fld_None },
+    { "bChildId3", 1, Fld_None },
+    { "bChildId4", 1, Fld_None },
+    { "bChildId5", 1, Fld_None },
+    { "bChildId6", 1, Fld_None },
+    { "bChildId7", 1, Fld_None },
+    { "bChildId8", 1, Fld_None },
+    { "bChildId9", 1, Fld_None },
+    { "bChildId10", 1, Fld_None },
+    { "bChildId11", 1, Fld_None },
+    { "bChildId12", 1, Fld_None },
+    { "bChildId13", 1, Fld_None },
+    { "bChildId14", 1, Fld_None },
+    { "bChildId15", 1, Fld_None },
+    { "bChildId16", 1, Fld_None },
+    { "bChildId17", 1, Fld_None },
+};
+
+constexpr USBStructField CDCMultiChannelFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_MultiChannel },
+};
+
+constexpr USBStructField CDCCAPIControlFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "bmCapabilities", 1, Fld_CDC_bmCapabilities_CAPIControl },
+};
+
+constexpr USBStructField CDCEthernetNetworkingFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "iMACAddress", 1, Fld_String },
+    { "bmEthernetStatistics", 4, Fld_CDC_bmEthernetStatistics },
+    { "wMaxSegmentSize", 2, Fld_None },
+    { "wNumberMCFilters", 2, Fld_CDC_wNumberMCFilters },
+    { "bNumberPowerFilters", 2, Fld_None },
+};
+
+constexpr USBStructField CDCATMNetworkingFields[] = {
+    //{"bLength",				1, Fld_None},
+    //{"bDescriptorType",		1, Fld_None},
+    { "bDescriptorSubtype", 1, Fld_CDC_DescriptorSubtype },
+
+    { "iEndSystemIdentifier", 1, Fld_String },
+    { "bmDataCapabilities", 1, Fld_CDC_bmDataCapabilities },
+    { "bmATMDeviceStatistics", 1, Fld_CDC_bmATMDeviceStatistics },
+    { "wType2MaxSegmentSize", 2, Fld_None },
+    { "wType3MaxSegmentSize", 2, Fld_None },
+    { "wMaxVC", 2, Fld_None },
+};
+
+//
+// CDC data payloads
+//
+
+constexpr USBStructField CDCLineCodingFields[] = {
+    { "dwDTERate", 4, Fld_CDC_dwDTERate },
+    { "bCharFormat", 1, Fld_CDC_bCharFormat },
+    { "bParityType", 1, Fld_CDC_bParityType },
+    { "bDataBits", 1, Fld_CDC_bDataBits },
+};
+
+constexpr USBStructField CDCAbstractStateFields[] = {
+    { "ABSTRACT_STATE", 2, Fld_CDC_Data_AbstractState },
+};
+
+constexpr USBStructField CDCCountrySettingFields[] = {
+    { "COUNTRY_SETTING", 2, Fld_CDC_Data_CountrySetting },
+};
+
+constexpr USBStructField CDCRingerConfigFields[] = {
+    { "dwRingerBitmap", 4, Fld_CDC_dwRingerBitmap },
+};
+
+constexpr USBStructField CDCOperationModeFields[] = {
+    { "Operation mode", 4, Fld_CDC_OperationMode },
+};
+
+constexpr USBStructField CDCLineParmsFields[] = {
+    { "wLength", 2, Fld_None },
+    { "dwRingerBitmap", 4, Fld_CDC_dwRingerBitmap },
+    { "dwLineState", 4, Fld_CDC_dwLineState },
+    { "dwCallState0", 4, Fld_CDC_dwCallState },
+    { "dwCallState1", 4, Fld_CDC_dwCallState },
+    { "dwCallState2", 4, Fld_CDC_dwCallState },
+    { "dwCallState3", 4, Fld_CDC_dwCallState },
+    { "dwCallState4", 4, Fld_CDC_dwCallState },
+    { "dwCallState5", 4, Fld_CDC_dwCallState },
+    { "dwCallState6", 4, Fld_CDC_dwCallState },
+    { "dwCallState7", 4, Fld_CDC_dwCallState },
+    { "dwCallState8", 4, Fld_CDC_dwCallState },
+    { "dwCallState9", 4, Fld_CDC_dwCallState },
+    { "dwCallState10", 4, Fld_CDC_dwCallState },
+    { "dwCallState11", 4, Fld_CDC_dwCallState },
+    { "dwCallState12", 4, Fld_CDC_dwCallState },
+    { "dwCallState13", 4, Fld_CDC_dwCallState },
+    { "dwCallState14", 4, Fld_CDC_dwCallState },
+    { "dwCallState15", 4, Fld_CDC_dwCallState },
+    { "dwCallState16", 4, Fld_CDC_dwCallState },
+    { "dwCallState17", 4, Fld_CDC_dwCallState },
+    { "dwCallState18", 4, Fld_CDC_dwCallState },
+    { "dwCallState19", 4, Fld_CDC_dwCallState },
+};
+
+constexpr USBStructField CDCUnitParameterFields[] = {
+    { "bEntityId", 1, Fld_None },
+    { "bParameterIndex", 1, Fld_None },
+};
+
+constexpr USBStructField CDCUnsignedIntFields[] = {
+    { "uint32", 4, Fld_None },
+};
+
+constexpr USBStructField CDCATMDefaultVCFields[] = {
+    { "VPI", 1, Fld_None },
+    { "VCI", 2, Fld_None },
+};
+
+//
+// the schemas
+//
+
+// C++11 has no std::index_sequence, so this makes the 0..N-1 list the schema fields are expanded from
+template <size_t... I>
+struct USBIndexList
+{
+};
+
+template <size_t N, size_t... I>
+struct USBMakeIndexList : USBMakeIndexList<N - 1, N - 1, I...>
+{
+};
+
+template <size_t... I>
+struct USBMakeIndexList<0, I...>
+{
+    typedef USBIndexList<I...> Type;
+};
+
+// the offset of a field is the sum of the sizes of the fields before it
+constexpr int GetFieldOffset( const USBStructField* layout, size_t field, int begin )
+{
+    return field == 0 ? begin : GetFieldOffset( layout, field - 1, begin ) + layout[ field - 1 ].numBytes;
+}
+
+template <const USBStructField* Layout, size_t N, int Begin, typename Indices = typename USBMakeIndexList<N>::Type>
+struct USBSchemaBuilder;
+
+template <const USBStructField* Layout, size_t N, int Begin, size_t... I>
+struct USBSchemaBuilder<Layout, N, Begin, USBIndexList<I...>>
+{
+    static_assert( GetFieldOffset( Layout, N, Begin ) <= 0xff, "the fields must fit in a descriptor" );
+
+    static constexpr USBSchemaField fields[ N ] = {
+        { Layout[ I ].name, Layout[ I ].formatter, U8( GetFieldOffset( Layout, I, Begin ) ),
+          U8( GetFieldOffset( Layout, I + 1, Begin ) ) }...
+    };
+
+    static constexpr USBDescriptorSchema schema = { fields, int( N ) };
+};
+
+template <const USBStructField* Layout, size_t N, int Begin, size_t... I>
+constexpr USBSchemaField USBSchemaBuilder<Layout, N, Begin, USBIndexList<I...>>::fields[ N ];
+
+template <const USBStructField* Layout, size_t N, int Begin, size_t... I>
+constexpr USBDescriptorSchema USBSchemaBuilder<Layout, N, Begin, USBIndexList<I...>>::schema;
+
+// the fields of descriptors begin after bLength and bDescriptorType, the data stage structures at 0
+#define DESCRIPTOR_SCHEMA( layout ) ( &USBSchemaBuilder<layout, sizeof( layout ) / sizeof( layout[ 0 ] ), 2>::schema )
+#define DATA_STAGE_SCHEMA( layout ) ( &USBSchemaBuilder<layout, sizeof( layout ) / sizeof( layout[ 0 ] ), 0>::schema )
+
+//
+// the descriptor dispatch table
+//
+
+struct USBSchemaTableEntry
+{
+    U32 key; // from GetSchemaKey
+    const USBDescriptorSchema* schema;
+
+    constexpr bool operator<( const USBSchemaTableEntry& rhs ) const
+    {
+        return key < rhs.key;
+    }
+};
+
+constexpr U32 GetSchemaKey( U32 descType, U32 interfaceClass, U32 descSubtype )
+{
+    return ( descType << 16 ) | ( interfaceClass << 8 ) | descSubtype;
+}
+
+#define STANDARD_SCHEMA( descType, layout ) { GetSchemaKey( descType, 0, DST_Undefined ), DESCRIPTOR_SCHEMA( layout ) }
+#define CLASS_SCHEMA( descType, interfaceClass, layout )                                                                                   \
+    { GetSchemaKey( descType, interfaceClass, DST_Undefined ), DESCRIPTOR_SCHEMA( layout ) }
+#define CDC_SCHEMA( descType, descSubtype, layout )                                                                                        \
+    { GetSchemaKey( descType, CC_CommunicationsAndCDCControl, descSubtype ), DESCRIPTOR_SCHEMA( layout ) }
+
+#define CDC_FUNCTIONAL_SCHEMAS( descType )                                                                                                 \
+    CDC_SCHEMA( descType, DST_HEADER, CDCHeaderFields ),                                                                                   \
+    CDC_SCHEMA( descType, DST_CALL_MANAGEMENT, CDCCallManagementFields ),                                                                  \
+    CDC_SCHEMA( descType, DST_ABSTRACT_CONTROL_MANAGEMENT, CDCAbstractControlManagementFields ),                                           \
+    CDC_SCHEMA( descType, DST_DIRECT_LINE_MANAGEMENT, CDCDirectLineManagementFields ),                                                     \
+    CDC_SCHEMA( descType, DST_TELEPHONE_RINGER, CDCTelephoneRingerFields ),                                                                \
+    CDC_SCHEMA( descType, DST_TELEPHONE_CALL_AND_LINE_STATE, CDCTelephoneCallStateReportingFields ),                                       \
+    CDC_SCHEMA( descType, DST_UNION, CDCUnionFields ),                                                                                     \
+    CDC_SCHEMA( descType, DST_COUNTRY_SELECTION, CDCCountrySelectionFields ),                                                              \
+    CDC_SCHEMA( descType, DST_TELEPHONE_OPERATIONAL_MODES, CDCTelephoneOperationalModesFields ),                                           \
+    CDC_SCHEMA( descType, DST_USB_TERMINAL, CDCUSBTerminalFields ),                                                                        \
+    CDC_SCHEMA( descType, DST_NETWORK_CHANNEL_TERMINAL, CDCNetworkChannelTerminalFields ),                                                 \
+    CDC_SCHEMA( descType, DST_PROTOCOL_UNIT, CDCProtocolUnitFields ),                                                                      \
+    CDC_SCHEMA( descType, DST_EXTENSION_UNIT, CDCExtensionUnitFields ),                                                                    \
+    CDC_SCHEMA( descType, DST_MULTI_CHANNEL_MANAGEMENT, CDCMultiChannelFields ),                                                           \
+    CDC_SCHEMA( descType, DST_CAPI_CONTROL_MANAGEMENT, CDCCAPIControlFields ),                                                             \
+    CDC_SCHEMA( descType, DST_ETHERNET_NETWORKING, CDCEthernetNetworkingFields ),                                                          \
+    CDC_SCHEMA( descType, DST_ATM_NETWORKING, CDCATMNetworkingFields )
+
+// Sorted by key. A new class only adds its rows here, and the lookup is a binary search, so it doesn't slow
+// down finding the others.
+constexpr USBSchemaTableEntry DescriptorSchemas[] = {
+    STANDARD_SCHEMA( DT_DEVICE, DeviceDescriptorFields ),
+    STANDARD_SCHEMA( DT_CONFIGURATION, ConfigurationDescriptorFields ),
+    STANDARD_SCHEMA( DT_INTERFACE, InterfaceDescriptorFields ),
+    STANDARD_SCHEMA( DT_ENDPOINT, EndpointDescriptorFields ),
+    STANDARD_SCHEMA( DT_DEVICE_QUALIFIER, DeviceQualifierDescriptorFields ),
+    STANDARD_SCHEMA( DT_OTHER_SPEED_CONFIGURATION, ConfigurationDescriptorFields ),
+
+    CLASS_SCHEMA( DT_HID, CC_HID, HIDDescriptorFields ),
+
+    CDC_FUNCTIONAL_SCHEMAS( DT_CDC_CS_INTERFACE ),
+    CDC_FUNCTIONAL_SCHEMAS( DT_CDC_CS_ENDPOINT ),
+};
+
+const size_t NUM_DESCRIPTOR_SCHEMAS = sizeof( DescriptorSchemas ) / sizeof( DescriptorSchemas[ 0 ] );
+
+static_assert( IsSortedRange( DescriptorSchemas, 0, NUM_DESCRIPTOR_SCHEMAS ),
+               "DescriptorSchemas must be sorted by key, without duplicates" );
+
+static bool operator<( const USBSchemaTableEntry& lhs, U32 key )
+{
+    return lhs.key < key;
+}
+
+const USBDescriptorSchema* FindDescriptorSchema( U8 descType, U8 interfaceClass, U8 descSubtype )
+{
+    if( descType >= DT_DEVICE && descType <= DT_INTERFACE_POWER )
+    {
+        // the standard descriptors are the same for all the classes
+        interfaceClass = 0;
+        descSubtype = DST_Undefined;
+    }
+    else if( interfaceClass == CC_CDCData )
+    {
+        // the data class interfaces use the communications class descriptors
+        interfaceClass = CC_CommunicationsAndCDCControl;
+    }
+
+    const U32 key = GetSchemaKey( descType, interfaceClass, descSubtype );
+    const USBSchemaTableEntry* pEntry = std::lower_bound( DescriptorSchemas, DescriptorSchemas + NUM_DESCRIPTOR_SCHEMAS, key );
+
+    return pEntry != DescriptorSchemas + NUM_DESCRIPTOR_SCHEMAS && pEntry->key == key ? pEntry->schema : NULL;
+}
+
+const USBDescriptorSchema* FindCDCRequestSchema( U8 bRequest, U16 wValue )
+{
+    USBCDCRequestCode reqCode = ( USBCDCRequestCode )bRequest;
+
+    if( reqCode == GET_COMM_FEATURE || reqCode == SET_COMM_FEATURE )
+    {
+        if( wValue == 1 ) // ABSTRACT_STATE
+            return DATA_STAGE_SCHEMA( CDCAbstractStateFields );
+        else if( wValue == 2 ) // COUNTRY_SETTING
+            return DATA_STAGE_SCHEMA( CDCCountrySettingFields );
+    }
+    else if( reqCode == SET_LINE_CODING || reqCode == GET_LINE_CODING )
+    {
+        return DATA_STAGE_SCHEMA( CDCLineCodingFields );
+    }
+    else if( reqCode == SET_RINGER_PARMS || reqCode == GET_RINGER_PARMS )
+    {
+        return DATA_STAGE_SCHEMA( CDCRingerConfigFields );
+    }
+    else if( reqCode == GET_OPERATION_PARMS )
+    {
+        return DATA_STAGE_SCHEMA( CDCOperationModeFields );
+    }
+    else if( reqCode == SET_LINE_PARMS || reqCode == GET_LINE_PARMS )
+    {
+        return DATA_STAGE_SCHEMA( CDCLineParmsFields );
+    }
+    else if( reqCode == SET_UNIT_PARAMETER || reqCode == GET_UNIT_PARAMETER )
+    {
+        return DATA_STAGE_SCHEMA( CDCUnitParameterFields );
+    }
+    else if( reqCode == GET_ETHERNET_STATISTIC || reqCode == GET_ATM_DEVICE_STATISTICS || reqCode == GET_ATM_VC_STATISTICS )
+    {
+        return DATA_STAGE_SCHEMA( CDCUnsignedIntFields );
+    }
+    else if( reqCode == SET_ATM_DEFAULT_VC )
+    {
+        return DATA_STAGE_SCHEMA( CDCATMDefaultVCFields );
+    }
+
+    return NULL;
+}
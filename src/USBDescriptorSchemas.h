@@ -0,0 +1,50 @@
+#ifndef USB_DESCRIPTOR_SCHEMAS_H
+#define USB_DESCRIPTOR_SCHEMAS_H
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+
+// a field of a descriptor or of a data stage structure, as it is listed in the spec
+struct USBStructField
+{
+    const char* name;
+    int numBytes;
+    USBCtrlTransFieldType formatter;
+};
+
+// a field with its position in the descriptor
+struct USBSchemaField
+{
+    const char* name;
+    USBCtrlTransFieldType formatter;
+    U8 offset; // from bLength, or from the beginning of the data stage
+    U8 end;    // offset + the size of the field
+};
+
+// The fields of a descriptor or a data stage structure with their offsets, which are worked out from the
+// USBStructField lists at compile time.
+struct USBDescriptorSchema
+{
+    const USBSchemaField* fields;
+    int numFields;
+
+    // index of the first field which begins at or after the offset, to skip the fields of the descriptor
+    // header which are parsed before we know the schema
+    int FindField( int offset ) const
+    {
+        int field = 0;
+        while( field < numFields && fields[ field ].offset < offset )
+            ++field;
+
+        return field;
+    }
+};
+
+// NULL if we don't know the descriptor. interfaceClass is the class of the interface that the class specific
+// descriptors belong to, and descSubtype is DST_Undefined for the descriptors which don't have a subtype.
+const USBDescriptorSchema* FindDescriptorSchema( U8 descType, U8 interfaceClass, U8 descSubtype );
+
+// the structure in the data stage of a CDC class request, NULL if it doesn't have one we know
+const USBDescriptorSchema* FindCDCRequestSchema( U8 bRequest, U16 wValue );
+
+#endif // USB_DESCRIPTOR_SCHEMAS_H
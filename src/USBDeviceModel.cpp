@@ -0,0 +1,229 @@
+#include "USBDeviceModel.h"
+
+static U16 GetWord( const U8* pData )
+{
+    return pData[ 0 ] | ( pData[ 1 ] << 8 );
+}
+
+USBDeviceModel::USBDeviceModel()
+{
+    Clear();
+}
+
+void USBDeviceModel::Clear( U8 address )
+{
+    mAddress = address;
+    mHasDeviceInfo = false;
+
+    mConfigurations.clear();
+    mParsedConfiguration = -1;
+
+    mHasConfigurationValue = false;
+    mConfigurationValue = 0;
+    mAlternateSettings.clear();
+
+    mHidReportLayouts.clear();
+
+    UpdateActiveEndpoints();
+}
+
+int USBDeviceModel::FindConfiguration( U8 configurationValue ) const
+{
+    for( size_t cnt = 0; cnt < mConfigurations.size(); ++cnt )
+    {
+        if( mConfigurations[ cnt ].bConfigurationValue == configurationValue )
+            return int( cnt );
+    }
+
+    return -1;
+}
+
+void USBDeviceModel::AddDescriptor( const U8* pDesc, int descBytes )
+{
+    if( descBytes < 2 )
+        return;
+
+    const U8 descType = pDesc[ 1 ];
+    if( descType == DT_DEVICE && descBytes >= 18 )
+    {
+        mHasDeviceInfo = true;
+        mDeviceInfo.bcdUSB = GetWord( pDesc + 2 );
+        mDeviceInfo.bDeviceClass = pDesc[ 4 ];
+        mDeviceInfo.bDeviceSubClass = pDesc[ 5 ];
+        mDeviceInfo.bDeviceProtocol = pDesc[ 6 ];
+        mDeviceInfo.bMaxPacketSize0 = pDesc[ 7 ];
+        mDeviceInfo.idVendor = GetWord( pDesc + 8 );
+        mDeviceInfo.idProduct = GetWord( pDesc + 10 );
+        mDeviceInfo.bcdDevice = GetWord( pDesc + 12 );
+        mDeviceInfo.iManufacturer = pDesc[ 14 ];
+        mDeviceInfo.iProduct = pDesc[ 15 ];
+        mDeviceInfo.iSerialNumber = pDesc[ 16 ];
+        mDeviceInfo.bNumConfigurations = pDesc[ 17 ];
+    }
+    else if( descType == DT_CONFIGURATION && descBytes >= 9 )
+    {
+        // the host usually reads the configuration descriptor alone first, and then with all the descriptors after it
+        mParsedConfiguration = FindConfiguration( pDesc[ 5 ] );
+        if( mParsedConfiguration < 0 )
+        {
+            mParsedConfiguration = int( mConfigurations.size() );
+            mConfigurations.push_back( USBConfigurationInfo() );
+        }
+
+        USBConfigurationInfo& configuration = mConfigurations[ mParsedConfiguration ];
+        configuration.bConfigurationValue = pDesc[ 5 ];
+        configuration.bmAttributes = pDesc[ 7 ];
+        configuration.bMaxPower = pDesc[ 8 ];
+        configuration.interfaces.clear();
+    }
+    else if( descType == DT_OTHER_SPEED_CONFIGURATION )
+    {
+        // the interfaces after it are not used at this speed
+        mParsedConfiguration = -1;
+    }
+    else if( descType == DT_INTERFACE && descBytes >= 9 && mParsedConfiguration >= 0 )
+    {
+        USBInterfaceInfo iface;
+        iface.bInterfaceNumber = pDesc[ 2 ];
+        iface.bAlternateSetting = pDesc[ 3 ];
+        iface.bInterfaceClass = pDesc[ 5 ];
+        iface.bInterfaceSubClass = pDesc[ 6 ];
+        iface.bInterfaceProtocol = pDesc[ 7 ];
+
+        mConfigurations[ mParsedConfiguration ].interfaces.push_back( iface );
+    }
+    else if( descType == DT_ENDPOINT && descBytes >= 7 && mParsedConfiguration >= 0 &&
+             !mConfigurations[ mParsedConfiguration ].interfaces.empty() )
+    {
+        USBEndpointInfo endpoint;
+        endpoint.bEndpointAddress = pDesc[ 2 ];
+        endpoint.bmAttributes = pDesc[ 3 ];
+        endpoint.wMaxPacketSize = GetWord( pDesc + 4 );
+        endpoint.bInterval = pDesc[ 6 ];
+
+        USBInterfaceInfo& iface = mConfigurations[ mParsedConfiguration ].interfaces.back();
+        endpoint.bInterfaceNumber = iface.bInterfaceNumber;
+        iface.endpoints.push_back( endpoint );
+    }
+    else
+    {
+        return;
+    }
+
+    UpdateActiveEndpoints();
+}
+
+void USBDeviceModel::SetAddress( U8 address )
+{
+    mAddress = address;
+
+    // address 0 puts the device back into the default state
+    if( address == 0 )
+        SetConfiguration( 0 );
+}
+
+void USBDeviceModel::SetConfiguration( U8 configurationValue )
+{
+    mHasConfigurationValue = true;
+    mConfigurationValue = configurationValue;
+
+    // all the interfaces start with alternate setting 0
+    mAlternateSettings.clear();
+
+    UpdateActiveEndpoints();
+}
+
+void USBDeviceModel::SetInterface( U8 interfaceNumber, U8 alternateSetting )
+{
+    mAlternateSettings[ interfaceNumber ] = alternateSetting;
+
+    UpdateActiveEndpoints();
+}
+
+void USBDeviceModel::SetHIDReportDescriptor( U8 interfaceNumber, const U8* pDesc, int descBytes )
+{
+    mHidReportLayouts[ interfaceNumber ].Compile( pDesc, descBytes );
+}
+
+U8 USBDeviceModel::GetAlternateSetting( U8 interfaceNumber ) const
+{
+    std::map<U8, U8>::const_iterator srch = mAlternateSettings.find( interfaceNumber );
+
+    return srch != mAlternateSettings.end() ? srch->second : 0;
+}
+
+bool USBDeviceModel::IsSameDevice( const USBDeviceModel& other ) const
+{
+    if( !mHasDeviceInfo || !other.mHasDeviceInfo )
+        return false;
+
+    const USBDeviceInfo& lhs = mDeviceInfo;
+    const USBDeviceInfo& rhs = other.mDeviceInfo;
+
+    return lhs.idVendor == rhs.idVendor && lhs.idProduct == rhs.idProduct && lhs.bcdDevice == rhs.bcdDevice && lhs.bcdUSB == rhs.bcdUSB &&
+           lhs.bDeviceClass == rhs.bDeviceClass && lhs.bDeviceSubClass == rhs.bDeviceSubClass &&
+           lhs.bDeviceProtocol == rhs.bDeviceProtocol && lhs.iSerialNumber == rhs.iSerialNumber;
+}
+
+const USBConfigurationInfo* USBDeviceModel::GetActiveConfiguration() const
+{
+    if( !mHasConfigurationValue )
+        return mParsedConfiguration >= 0 ? &mConfigurations[ mParsedConfiguration ] : NULL;
+
+    const int configuration = mConfigurationValue != 0 ? FindConfiguration( mConfigurationValue ) : -1;
+
+    return configuration >= 0 ? &mConfigurations[ configuration ] : NULL;
+}
+
+const USBInterfaceInfo* USBDeviceModel::GetInterface( U8 interfaceNumber ) const
+{
+    const USBConfigurationInfo* pConfiguration = GetActiveConfiguration();
+    if( pConfiguration == NULL )
+        return NULL;
+
+    const U8 alternateSetting = GetAlternateSetting( interfaceNumber );
+    for( size_t cnt = 0; cnt < pConfiguration->interfaces.size(); ++cnt )
+    {
+        const USBInterfaceInfo& iface = pConfiguration->interfaces[ cnt ];
+        if( iface.bInterfaceNumber == interfaceNumber && iface.bAlternateSetting == alternateSetting )
+            return &iface;
+    }
+
+    return NULL;
+}
+
+const USBInterfaceInfo* USBDeviceModel::GetParsedInterface() const
+{
+    if( mParsedConfiguration < 0 || mConfigurations[ mParsedConfiguration ].interfaces.empty() )
+        return NULL;
+
+    return &mConfigurations[ mParsedConfiguration ].interfaces.back();
+}
+
+void USBDeviceModel::UpdateActiveEndpoints()
+{
+    // the default control pipe is always there
+    USBEndpointInfo control = { 0, EPT_Control, U16( mHasDeviceInfo ? mDeviceInfo.bMaxPacketSize0 : 0 ), 0, 0 };
+    mActiveEndpoints[ GetEndpointSlot( 0x00 ) ] = control;
+    mActiveEndpoints[ GetEndpointSlot( 0x80 ) ] = control;
+    mActiveEndpointsMask = ( 1u << GetEndpointSlot( 0x00 ) ) | ( 1u << GetEndpointSlot( 0x80 ) );
+
+    const USBConfigurationInfo* pConfiguration = GetActiveConfiguration();
+    if( pConfiguration == NULL )
+        return;
+
+    for( size_t ifc = 0; ifc < pConfiguration->interfaces.size(); ++ifc )
+    {
+        const USBInterfaceInfo& iface = pConfiguration->interfaces[ ifc ];
+        if( iface.bAlternateSetting != GetAlternateSetting( iface.bInterfaceNumber ) )
+            continue;
+
+        for( size_t epc = 0; epc < iface.endpoints.size(); ++epc )
+        {
+            const int slot = GetEndpointSlot( iface.endpoints[ epc ].bEndpointAddress );
+
+            mActiveEndpoints[ slot ] = iface.endpoints[ epc ];
+            mActiveEndpointsMask |= 1u << slot;
+        }
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef USB_DEVICE_MODEL_H
+#define USB_DEVICE_MODEL_H
+
+#include <map>
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+#include "USBHidReports.h"
+
+struct USBEndpointInfo
+{
+    U8 bEndpointAddress;
+    U8 bmAttributes;
+    U16 wMaxPacketSize;
+    U8 bInterval;
+
+    U8 bInterfaceNumber; // of the interface descriptor it came after
+
+    USBEndpointType GetType() const
+    {
+        return USBEndpointType( bmAttributes & 0x03 );
+    }
+};
+
+struct USBInterfaceInfo
+{
+    U8 bInterfaceNumber;
+    U8 bAlternateSetting;
+    U8 bInterfaceClass;
+    U8 bInterfaceSubClass;
+    U8 bInterfaceProtocol;
+
+    std::vector<USBEndpointInfo> endpoints;
+};
+
+struct USBConfigurationInfo
+{
+    U8 bConfigurationValue;
+    U8 bmAttributes;
+    U8 bMaxPower;
+
+    std::vector<USBInterfaceInfo> interfaces; // all the alternate settings, in descriptor order
+};
+
+struct USBDeviceInfo
+{
+    U16 bcdUSB;
+    U8 bDeviceClass;
+    U8 bDeviceSubClass;
+    U8 bDeviceProtocol;
+    U8 bMaxPacketSize0;
+    U16 idVendor;
+    U16 idProduct;
+    U16 bcdDevice;
+    U8 iManufacturer;
+    U8 iProduct;
+    U8 iSerialNumber;
+    U8 bNumConfigurations;
+};
+
+// What we know about a device from the descriptors it returned and the standard requests that changed its
+// state. The endpoints of the active configuration and alternate settings are kept in a table, so the
+// type of an endpoint is found without going through the descriptors.
+class USBDeviceModel
+{
+  public:
+    USBDeviceModel();
+
+    // forgets everything about the device, which is at the address
+    void Clear( U8 address = 0 );
+
+    // a complete descriptor of a GET_DESCRIPTOR data stage; the interface and endpoint descriptors that
+    // follow a configuration descriptor are added to that configuration
+    void AddDescriptor( const U8* pDesc, int descBytes );
+
+    // the standard requests that change the state of the device, once their status stage completes
+    void SetAddress( U8 address );
+    void SetConfiguration( U8 configurationValue );
+    void SetInterface( U8 interfaceNumber, U8 alternateSetting );
+
+    U8 GetAddress() const
+    {
+        return mAddress;
+    }
+
+    // NULL if we didn't get the device descriptor
+    const USBDeviceInfo* GetDeviceInfo() const
+    {
+        return mHasDeviceInfo ? &mDeviceInfo : NULL;
+    }
+
+    // true if both device descriptors say this is the same kind of device, with the same serial number index
+    bool IsSameDevice( const USBDeviceModel& other ) const;
+
+    // the configuration set with SET_CONFIGURATION, or the last one we got the descriptors of if the
+    // capture doesn't have the SET_CONFIGURATION; NULL if the device is not configured
+    const USBConfigurationInfo* GetActiveConfiguration() const;
+
+    // the active alternate setting of the interface, NULL if we don't have its descriptor
+    const USBInterfaceInfo* GetInterface( U8 interfaceNumber ) const;
+
+    // the last interface descriptor we got, which the class specific descriptors after it belong to
+    const USBInterfaceInfo* GetParsedInterface() const;
+
+    // NULL if the endpoint is not in the active configuration or alternate settings
+    const USBEndpointInfo* GetEndpoint( U8 endpointAddress ) const
+    {
+        const int slot = GetEndpointSlot( endpointAddress );
+
+        return ( mActiveEndpointsMask & ( 1u << slot ) ) != 0 ? &mActiveEndpoints[ slot ] : NULL;
+    }
+
+    USBEndpointType GetEndpointType( U8 endpointAddress ) const
+    {
+        const USBEndpointInfo* pEndpoint = GetEndpoint( endpointAddress );
+
+        return pEndpoint != NULL ? pEndpoint->GetType() : EPT_Unknown;
+    }
+
+    // the report descriptor of a HID interface, compiled once when we get it
+    void SetHIDReportDescriptor( U8 interfaceNumber, const U8* pDesc, int descBytes );
+
+    // NULL if we didn't get the report descriptor of the interface
+    const USBHidReportLayout* GetHIDReportLayout( U8 interfaceNumber ) const
+    {
+        std::map<U8, USBHidReportLayout>::const_iterator srch = mHidReportLayouts.find( interfaceNumber );
+
+        return srch != mHidReportLayouts.end() ? &srch->second : NULL;
+    }
+
+  private:
+    U8 mAddress;
+
+    bool mHasDeviceInfo;
+    USBDeviceInfo mDeviceInfo;
+
+    std::vector<USBConfigurationInfo> mConfigurations;
+    int mParsedConfiguration; // index of the configuration the next interface descriptors belong to, or -1
+
+    bool mHasConfigurationValue;         // false until we see a SET_CONFIGURATION
+    U8 mConfigurationValue;              // 0 if the device is not configured
+    std::map<U8, U8> mAlternateSettings; // interface number to alternate setting; 0 if not in the map
+
+    // the endpoints of the active configuration and alternate settings, indexed by GetEndpointSlot
+    USBEndpointInfo mActiveEndpoints[ 32 ];
+    U32 mActiveEndpointsMask; // bit n is set if mActiveEndpoints[ n ] is valid
+
+    std::map<U8, USBHidReportLayout> mHidReportLayouts; // by interface number
+
+    static int GetEndpointSlot( U8 endpointAddress )
+    {
+        return ( endpointAddress & 0x0f ) | ( ( endpointAddress & 0x80 ) >> 3 );
+    }
+
+    int FindConfiguration( U8 configurationValue ) const; // index in mConfigurations, or -1
+    U8 GetAlternateSetting( U8 interfaceNumber ) const;
+    void UpdateActiveEndpoints();
+};
+
+#endif // USB_DEVICE_MODEL_H
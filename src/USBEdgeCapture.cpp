@@ -0,0 +1,466 @@
+#include <string.h>
+
+#include "USBEdgeCapture.h"
+
+using namespace USBEdgeCaptureFormat;
+
+static const char Magic[ 8 ] = { 'U', 'S', 'B', 'E', 'D', 'G', 'E', '1' };
+
+static void PutU32( U8* pDest, U32 value )
+{
+    for( int bc = 0; bc < 4; ++bc )
+        pDest[ bc ] = U8( value >> ( bc * 8 ) );
+}
+
+static void PutU64( U8* pDest, U64 value )
+{
+    for( int bc = 0; bc < 8; ++bc )
+        pDest[ bc ] = U8( value >> ( bc * 8 ) );
+}
+
+static U32 GetU32( const U8* pSrc )
+{
+    U32 value = 0;
+    for( int bc = 3; bc >= 0; --bc )
+        value = ( value << 8 ) | pSrc[ bc ];
+
+    return value;
+}
+
+static U64 GetU64( const U8* pSrc )
+{
+    U64 value = 0;
+    for( int bc = 7; bc >= 0; --bc )
+        value = ( value << 8 ) | pSrc[ bc ];
+
+    return value;
+}
+
+USBEdgeCaptureWriter::USBEdgeCaptureWriter() : mpFile( NULL ), mSampleRate( 0 ), mBlockEdges( DEFAULT_BLOCK_EDGES ), mFirstSample( 0 )
+{
+}
+
+USBEdgeCaptureWriter::~USBEdgeCaptureWriter()
+{
+    if( mpFile != NULL )
+        fclose( mpFile );
+}
+
+bool USBEdgeCaptureWriter::Open( const char* path, U32 sampleRate, U64 firstSample, USBBitState initialDP, USBBitState initialDM,
+                                 U32 blockEdges )
+{
+    mpFile = fopen( path, "wb" );
+    if( mpFile == NULL )
+        return false;
+
+    mSampleRate = sampleRate;
+    mBlockEdges = blockEdges > 0 ? blockEdges : DEFAULT_BLOCK_EDGES;
+    mFirstSample = firstSample;
+
+    for( int lc = 0; lc < ECL_Count; ++lc )
+    {
+        Line& line = mLines[ lc ];
+        line.initialState = lc == ECL_DP ? initialDP : initialDM;
+        line.numEdges = 0;
+        line.lastEdge = firstSample;
+        line.stream.clear();
+        line.index.clear();
+    }
+
+    return true;
+}
+
+bool USBEdgeCaptureWriter::AddEdge( USBEdgeCaptureLine ln, U64 sample )
+{
+    Line& line = mLines[ ln ];
+    if( sample < line.lastEdge )
+        return false;
+
+    if( line.numEdges % mBlockEdges == 0 )
+    {
+        line.index.push_back( line.lastEdge );
+        line.index.push_back( line.stream.size() );
+    }
+
+    for( U64 delta = sample - line.lastEdge;; delta >>= 7 )
+    {
+        if( delta < 0x80 )
+        {
+            line.stream.push_back( U8( delta ) );
+            break;
+        }
+
+        line.stream.push_back( U8( delta | 0x80 ) );
+    }
+
+    line.lastEdge = sample;
+    ++line.numEdges;
+
+    return true;
+}
+
+bool USBEdgeCaptureWriter::Close( U64 lastSample )
+{
+    if( mpFile == NULL )
+        return false;
+
+    U8 header[ HEADER_SIZE ];
+    memcpy( header, Magic, sizeof( Magic ) );
+    PutU32( header + 8, mSampleRate );
+    PutU32( header + 12, mBlockEdges );
+    PutU64( header + 16, mFirstSample );
+    PutU64( header + 24, lastSample );
+
+    // the streams come right after the header, and the indexes after the streams
+    U64 offset = HEADER_SIZE;
+    U64 streamOffsets[ ECL_Count ];
+    for( int lc = 0; lc < ECL_Count; ++lc )
+    {
+        streamOffsets[ lc ] = offset;
+        offset += mLines[ lc ].stream.size();
+    }
+
+    for( int lc = 0; lc < ECL_Count; ++lc )
+    {
+        const Line& line = mLines[ lc ];
+        U8* pLine = header + 32 + lc * LINE_HEADER_SIZE;
+        PutU64( pLine, line.initialState == BS_High );
+        PutU64( pLine + 8, line.numEdges );
+        PutU64( pLine + 16, streamOffsets[ lc ] );
+        PutU64( pLine + 24, line.stream.size() );
+        PutU64( pLine + 32, offset );
+        offset += line.index.size() * 8;
+    }
+
+    bool ok = fwrite( header, 1, sizeof( header ), mpFile ) == sizeof( header );
+
+    for( int lc = 0; lc < ECL_Count && ok; ++lc )
+    {
+        const std::vector<U8>& stream = mLines[ lc ].stream;
+        ok = stream.empty() || fwrite( &stream.front(), 1, stream.size(), mpFile ) == stream.size();
+    }
+
+    for( int lc = 0; lc < ECL_Count && ok; ++lc )
+    {
+        const std::vector<U64>& index = mLines[ lc ].index;
+        std::vector<U8> bytes( index.size() * 8 );
+        for( size_t ic = 0; ic < index.size(); ++ic )
+            PutU64( &bytes[ ic * 8 ], index[ ic ] );
+
+        ok = bytes.empty() || fwrite( &bytes.front(), 1, bytes.size(), mpFile ) == bytes.size();
+    }
+
+    ok = fclose( mpFile ) == 0 && ok;
+    mpFile = NULL;
+
+    return ok;
+}
+
+USBEdgeCaptureFile::USBEdgeCaptureFile() : mSampleRate( 0 ), mBlockEdges( 0 ), mFirstSample( 0 ), mLastSample( 0 )
+{
+    memset( mLines, 0, sizeof( mLines ) );
+}
+
+bool USBEdgeCaptureFile::IsCaptureFile( const char* pData, size_t size )
+{
+    return size >= sizeof( Magic ) && memcmp( pData, Magic, sizeof( Magic ) ) == 0;
+}
+
+bool USBEdgeCaptureFile::Open( const char* path )
+{
+    if( !mFile.Open( path ) )
+    {
+        mError = std::string( "can't open " ) + path;
+        return false;
+    }
+
+    const U8* pData = reinterpret_cast<const U8*>( mFile.GetData() );
+    const U64 size = mFile.GetSize();
+    if( size < U64( HEADER_SIZE ) || !IsCaptureFile( mFile.GetData(), size ) )
+    {
+        mError = "not an edge capture file";
+        return false;
+    }
+
+    mSampleRate = GetU32( pData + 8 );
+    mBlockEdges = GetU32( pData + 12 );
+    mFirstSample = GetU64( pData + 16 );
+    mLastSample = GetU64( pData + 24 );
+    if( mSampleRate == 0 || mBlockEdges == 0 || mLastSample < mFirstSample )
+    {
+        mError = "bad header";
+        return false;
+    }
+
+    for( int lc = 0; lc < ECL_Count; ++lc )
+    {
+        const U8* pLine = pData + 32 + lc * LINE_HEADER_SIZE;
+        const U64 initialState = GetU64( pLine );
+        const U64 numEdges = GetU64( pLine + 8 );
+        const U64 streamOffset = GetU64( pLine + 16 );
+        const U64 streamSize = GetU64( pLine + 24 );
+        const U64 indexOffset = GetU64( pLine + 32 );
+        const U64 numBlocks = numEdges / mBlockEdges + ( numEdges % mBlockEdges != 0 );
+
+        // every edge takes at least one byte of the stream
+        if( initialState > 1 || streamOffset > size || streamSize > size - streamOffset || numEdges > streamSize || indexOffset > size ||
+            numBlocks > ( size - indexOffset ) / INDEX_ENTRY_SIZE )
+        {
+            mError = "bad header";
+            return false;
+        }
+
+        Line& line = mLines[ lc ];
+        line.initialState = initialState != 0 ? BS_High : BS_Low;
+        line.numEdges = numEdges;
+        line.numBlocks = numBlocks;
+        line.pStream = pData + streamOffset;
+        line.streamSize = streamSize;
+        line.pIndex = pData + indexOffset;
+
+        // the cursors trust the index
+        for( U64 bc = 0; bc < numBlocks; ++bc )
+        {
+            if( GetBlockOffset( USBEdgeCaptureLine( lc ), bc ) >= streamSize ||
+                ( bc > 0 && ( GetBlockOffset( USBEdgeCaptureLine( lc ), bc ) <= GetBlockOffset( USBEdgeCaptureLine( lc ), bc - 1 ) ||
+                              GetBlockSample( USBEdgeCaptureLine( lc ), bc ) < GetBlockSample( USBEdgeCaptureLine( lc ), bc - 1 ) ) ) )
+            {
+                mError = "bad index";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+U64 USBEdgeCaptureFile::GetBlockSample( USBEdgeCaptureLine line, U64 block ) const
+{
+    return GetU64( mLines[ line ].pIndex + block * INDEX_ENTRY_SIZE );
+}
+
+U64 USBEdgeCaptureFile::GetBlockOffset( USBEdgeCaptureLine line, U64 block ) const
+{
+    return GetU64( mLines[ line ].pIndex + block * INDEX_ENTRY_SIZE + 8 );
+}
+
+U64 USBEdgeCaptureFile::FindBlock( USBEdgeCaptureLine line, U64 sample ) const
+{
+    // binary search for the last block with its sample at or before sample
+    U64 lo = 0;
+    U64 hi = mLines[ line ].numBlocks;
+    while( hi - lo > 1 )
+    {
+        const U64 mid = lo + ( hi - lo ) / 2;
+        if( GetBlockSample( line, mid ) <= sample )
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// a split is in the J after an EOP which lasts this many full speed bits, and this far into it
+static const U64 SPLIT_IDLE_BITS = 8;
+static const U64 SPLIT_OFFSET_BITS = 4;
+
+bool USBEdgeCaptureFile::FindIdle( U64 begin, U64 end, U64& sample ) const
+{
+    const U64 bitSamples = mSampleRate >= 12000000 ? mSampleRate / 12000000 : 1;
+
+    USBEdgeCaptureCursor cursors[ ECL_Count ];
+    USBBitState states[ ECL_Count ];
+    U64 next[ ECL_Count ];
+    bool more[ ECL_Count ];
+    for( int lc = 0; lc < ECL_Count; ++lc )
+    {
+        cursors[ lc ].Init( this, USBEdgeCaptureLine( lc ) );
+        cursors[ lc ].Seek( begin );
+        states[ lc ] = cursors[ lc ].GetState();
+        more[ lc ] = cursors[ lc ].GetNextEdge( next[ lc ] );
+    }
+
+    // walk the states of the bus; an SE0 of a bit or longer is an EOP, not the skew of a J/K change
+    U64 stateBegin = begin;
+    U64 se0Length = 0; // of the SE0 before the current state, 0 if there was none
+    while( stateBegin < end )
+    {
+        U64 stateEnd = mLastSample;
+        for( int lc = 0; lc < ECL_Count; ++lc )
+        {
+            if( more[ lc ] && next[ lc ] < stateEnd )
+                stateEnd = next[ lc ];
+        }
+
+        const bool isSE0 = states[ ECL_DP ] == BS_Low && states[ ECL_DM ] == BS_Low;
+        const bool isJK = states[ ECL_DP ] != states[ ECL_DM ];
+        if( isJK && se0Length >= bitSamples && stateEnd - stateBegin >= SPLIT_IDLE_BITS * bitSamples )
+        {
+            sample = stateBegin + SPLIT_OFFSET_BITS * bitSamples;
+            return true;
+        }
+
+        if( !more[ ECL_DP ] && !more[ ECL_DM ] )
+            break;
+
+        se0Length = isSE0 ? stateEnd - stateBegin : 0;
+
+        // the lines can change at the same sample
+        for( int lc = 0; lc < ECL_Count; ++lc )
+        {
+            while( more[ lc ] && next[ lc ] == stateEnd )
+            {
+                states[ lc ] = InvertBitState( states[ lc ] );
+                more[ lc ] = cursors[ lc ].GetNextEdge( next[ lc ] );
+            }
+        }
+
+        stateBegin = stateEnd;
+    }
+
+    return false;
+}
+
+void USBEdgeCaptureFile::GetSplitSamples( int numSegments, std::vector<U64>& samples ) const
+{
+    samples.clear();
+
+    const U64 numBlocks = mLines[ ECL_DP ].numBlocks;
+    for( int sc = 1; sc < numSegments; ++sc )
+    {
+        const U64 block = numBlocks * sc / numSegments;
+        if( block == 0 || block >= numBlocks )
+            continue;
+
+        // the index gives the block, which most likely starts in a packet, so move on to the first idle in it
+        const U64 blockEnd = block + 1 < numBlocks ? GetBlockSample( ECL_DP, block + 1 ) : mLastSample;
+        U64 sample;
+        if( !FindIdle( GetBlockSample( ECL_DP, block ), blockEnd, sample ) )
+            continue;
+
+        if( samples.empty() || sample > samples.back() )
+            samples.push_back( sample );
+    }
+}
+
+USBEdgeCaptureCursor::USBEdgeCaptureCursor()
+    : mpFile( NULL ), mLine( ECL_DP ), mpPos( NULL ), mpEnd( NULL ), mEdgesLeft( 0 ), mLastEdge( 0 ), mState( BS_Low )
+{
+}
+
+void USBEdgeCaptureCursor::Init( const USBEdgeCaptureFile* pFile, USBEdgeCaptureLine line )
+{
+    mpFile = pFile;
+    mLine = line;
+    mpEnd = pFile->GetStream( line ) + pFile->GetStreamSize( line );
+    SeekBlock( 0 );
+}
+
+void USBEdgeCaptureCursor::SeekBlock( U64 block )
+{
+    const U64 firstEdge = block * mpFile->GetBlockEdges();
+
+    mpPos = mpFile->GetStream( mLine );
+    mEdgesLeft = mpFile->GetNumEdges( mLine );
+    mLastEdge = mpFile->GetFirstSample();
+    mState = mpFile->GetInitialState( mLine );
+
+    if( block < mpFile->GetNumBlocks( mLine ) )
+    {
+        mpPos += mpFile->GetBlockOffset( mLine, block );
+        mEdgesLeft -= firstEdge;
+        mLastEdge = mpFile->GetBlockSample( mLine, block );
+        if( firstEdge & 1 )
+            mState = InvertBitState( mState );
+    }
+}
+
+void USBEdgeCaptureCursor::Seek( U64 sample )
+{
+    SeekBlock( mpFile->FindBlock( mLine, sample ) );
+
+    for( ;; )
+    {
+        const U8* pPos = mpPos;
+        const U64 edgesLeft = mEdgesLeft;
+        const U64 lastEdge = mLastEdge;
+        const USBBitState state = mState;
+
+        U64 edge;
+        if( !GetNextEdge( edge ) )
+            return;
+
+        if( edge > sample )
+        {
+            // leave it for the next call
+            mpPos = pPos;
+            mEdgesLeft = edgesLeft;
+            mLastEdge = lastEdge;
+            mState = state;
+            return;
+        }
+    }
+}
+
+bool USBEdgeCaptureCursor::GetNextEdge( U64& sample )
+{
+    if( mEdgesLeft == 0 )
+        return false;
+
+    U64 delta = 0;
+    for( int shift = 0;; shift += 7 )
+    {
+        if( mpPos == mpEnd || shift >= MAX_VARINT_BYTES * 7 )
+        {
+            mEdgesLeft = 0;
+            return false;
+        }
+
+        const U8 byte = *mpPos++;
+        delta |= U64( byte & 0x7f ) << shift;
+        if( ( byte & 0x80 ) == 0 )
+            break;
+    }
+
+    mLastEdge += delta;
+    mState = InvertBitState( mState );
+    --mEdgesLeft;
+
+    sample = mLastEdge;
+    return true;
+}
+
+USBEdgeCaptureSource::USBEdgeCaptureSource( const USBEdgeCaptureFile* pFile, USBEdgeCaptureLine line, U64 startSample )
+    : mSample( startSample ), mEndSample( pFile->GetLastSample() )
+{
+    mCursor.Init( pFile, line );
+    mCursor.Seek( startSample );
+    mState = mCursor.GetState();
+    mHasNextEdge = mCursor.GetNextEdge( mNextEdge );
+}
+
+void USBEdgeCaptureSource::AdvanceToNextEdge()
+{
+    if( !mHasNextEdge )
+    {
+        mSample = mEndSample;
+        return;
+    }
+
+    mSample = mNextEdge;
+    mState = InvertBitState( mState );
+    mHasNextEdge = mCursor.GetNextEdge( mNextEdge );
+}
+
+void USBEdgeCaptureSource::AdvanceToAbsPosition( U64 sample )
+{
+    while( mHasNextEdge && mNextEdge <= sample )
+    {
+        mState = InvertBitState( mState );
+        mHasNextEdge = mCursor.GetNextEdge( mNextEdge );
+    }
+
+    if( sample > mSample )
+        mSample = sample;
+}
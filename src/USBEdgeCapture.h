@@ -0,0 +1,255 @@
+#ifndef USB_EDGE_CAPTURE_H
+#define USB_EDGE_CAPTURE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBMappedFile.h"
+#include "USBEdgeSource.h"
+
+// A binary capture of the D+ and D- edges, which is mapped instead of parsed:
+//
+//   header     magic "USBEDGE1", sample rate, edges per block, first and last sample of the capture,
+//              and for each line its initial state, number of edges, and where its stream and index are
+//   streams    for each line, the samples of its edges as varints (LEB128) of the distance to the edge before,
+//              or to the first sample for the first edge
+//   indexes    for each line, a { sample before, stream offset } entry for every block of edges
+//
+// All the numbers of the header and the indexes are little endian U64s, but the rate and the block size
+// which are U32s. With the index a reader can start at any sample after reading only one block of edges,
+// and the blocks give evenly spread split points for decoding the capture in parallel.
+namespace USBEdgeCaptureFormat
+{
+    const int HEADER_SIZE = 112;
+    const int LINE_HEADER_SIZE = 40;
+    const int INDEX_ENTRY_SIZE = 16;
+    const U32 DEFAULT_BLOCK_EDGES = 4096;
+    const int MAX_VARINT_BYTES = 10;
+}
+
+enum USBEdgeCaptureLine
+{
+    ECL_DP,
+    ECL_DM,
+    ECL_Count
+};
+
+// Writes a capture. The edges of each line must not go back; the two lines can be added in any order.
+class USBEdgeCaptureWriter
+{
+  public:
+    USBEdgeCaptureWriter();
+    ~USBEdgeCaptureWriter();
+
+    bool Open( const char* path, U32 sampleRate, U64 firstSample, USBBitState initialDP, USBBitState initialDM,
+               U32 blockEdges = USBEdgeCaptureFormat::DEFAULT_BLOCK_EDGES );
+
+    // false for an edge before the last one of the line or before the first sample
+    bool AddEdge( USBEdgeCaptureLine line, U64 sample );
+
+    // writes the index and the header; the capture ends at lastSample
+    bool Close( U64 lastSample );
+
+  private:
+    struct Line
+    {
+        USBBitState initialState;
+        U64 numEdges;
+        U64 lastEdge;
+        std::vector<U8> stream;
+        std::vector<U64> index; // sample before and stream offset of each block
+    };
+
+    FILE* mpFile;
+    U32 mSampleRate;
+    U32 mBlockEdges;
+    U64 mFirstSample;
+    Line mLines[ ECL_Count ];
+};
+
+// A mapped capture.
+class USBEdgeCaptureFile
+{
+  public:
+    USBEdgeCaptureFile();
+
+    // checks the header and the index, but doesn't read the edges
+    bool Open( const char* path );
+
+    // the start of a file is enough to tell its format
+    static bool IsCaptureFile( const char* pData, size_t size );
+
+    const std::string& GetError() const
+    {
+        return mError;
+    }
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    U32 GetBlockEdges() const
+    {
+        return mBlockEdges;
+    }
+
+    U64 GetFirstSample() const
+    {
+        return mFirstSample;
+    }
+
+    U64 GetLastSample() const
+    {
+        return mLastSample;
+    }
+
+    USBBitState GetInitialState( USBEdgeCaptureLine line ) const
+    {
+        return mLines[ line ].initialState;
+    }
+
+    U64 GetNumEdges( USBEdgeCaptureLine line ) const
+    {
+        return mLines[ line ].numEdges;
+    }
+
+    U64 GetNumBlocks( USBEdgeCaptureLine line ) const
+    {
+        return mLines[ line ].numBlocks;
+    }
+
+    // the sample of the edge before the block, or the first sample for the first block
+    U64 GetBlockSample( USBEdgeCaptureLine line, U64 block ) const;
+    U64 GetBlockOffset( USBEdgeCaptureLine line, U64 block ) const;
+
+    // the last block which starts after an edge at or before sample
+    U64 FindBlock( USBEdgeCaptureLine line, U64 sample ) const;
+
+    // Samples at which the capture can be split into numSegments pieces of about the same number of edges.
+    // The index of D+ gives the blocks to split at, and each split is moved on to the first bus idle in its
+    // block, so every segment starts at idle and not in a packet. A block without an idle gives no split,
+    // so there can be fewer segments.
+    void GetSplitSamples( int numSegments, std::vector<U64>& samples ) const;
+
+    const U8* GetStream( USBEdgeCaptureLine line ) const
+    {
+        return mLines[ line ].pStream;
+    }
+
+    U64 GetStreamSize( USBEdgeCaptureLine line ) const
+    {
+        return mLines[ line ].streamSize;
+    }
+
+  private:
+    // a sample in the first bus idle which begins from begin up to end: the J after an EOP, without an edge
+    // for a few bits; false if there is none
+    bool FindIdle( U64 begin, U64 end, U64& sample ) const;
+
+    struct Line
+    {
+        USBBitState initialState;
+        U64 numEdges;
+        U64 numBlocks;
+        const U8* pStream;
+        U64 streamSize;
+        const U8* pIndex;
+    };
+
+    USBMappedFile mFile;
+    std::string mError;
+
+    U32 mSampleRate;
+    U32 mBlockEdges;
+    U64 mFirstSample;
+    U64 mLastSample;
+    Line mLines[ ECL_Count ];
+};
+
+// Reads the edges of one line of a capture.
+class USBEdgeCaptureCursor
+{
+  public:
+    USBEdgeCaptureCursor();
+
+    void Init( const USBEdgeCaptureFile* pFile, USBEdgeCaptureLine line );
+
+    // the next edge is the first one after sample
+    void Seek( U64 sample );
+
+    // the state of the line after the last edge read
+    USBBitState GetState() const
+    {
+        return mState;
+    }
+
+    // false at the end of the line, and for a broken stream
+    bool GetNextEdge( U64& sample );
+
+  private:
+    // to the start of a block, without reading its edges
+    void SeekBlock( U64 block );
+
+    const USBEdgeCaptureFile* mpFile;
+    USBEdgeCaptureLine mLine;
+
+    const U8* mpPos;
+    const U8* mpEnd;
+    U64 mEdgesLeft;
+    U64 mLastEdge;
+    USBBitState mState;
+};
+
+// One line of a capture, for the decoder. Past the last edge the line stays in its state up to the end
+// of the capture.
+class USBEdgeCaptureSource : public USBEdgeSource
+{
+  public:
+    USBEdgeCaptureSource( const USBEdgeCaptureFile* pFile, USBEdgeCaptureLine line, U64 startSample = 0 );
+
+    virtual U64 GetSampleNumber()
+    {
+        return mSample;
+    }
+
+    virtual USBBitState GetBitState()
+    {
+        return mState;
+    }
+
+    virtual U64 GetSampleOfNextEdge()
+    {
+        return mHasNextEdge ? mNextEdge : mEndSample;
+    }
+
+    virtual void AdvanceToNextEdge();
+    virtual void AdvanceToAbsPosition( U64 sample );
+
+    virtual bool WouldAdvancingCauseTransition( U32 numSamples )
+    {
+        return mHasNextEdge && mNextEdge <= mSample + numSamples;
+    }
+
+    virtual bool WouldAdvancingToAbsPositionCauseTransition( U64 sample )
+    {
+        return mHasNextEdge && mNextEdge <= sample;
+    }
+
+    virtual bool DoMoreTransitionsExistInCurrentData()
+    {
+        return mHasNextEdge;
+    }
+
+  private:
+    USBEdgeCaptureCursor mCursor;
+    U64 mSample;
+    USBBitState mState;
+    bool mHasNextEdge;
+    U64 mNextEdge;
+    U64 mEndSample;
+};
+
+#endif // USB_EDGE_CAPTURE_H
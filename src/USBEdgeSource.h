@@ -0,0 +1,30 @@
+#ifndef USB_EDGE_SOURCE_H
+#define USB_EDGE_SOURCE_H
+
+#include "USBCoreTypes.h"
+
+// The samples of one bus line, as the decoder reads them. It has the calls of the AnalyzerChannelData that
+// the signal filter uses, so the plugin wraps the channels it gets from the Logic app, and anything else that
+// has the edges of D+ and D- (capture files, generated signals) can be decoded without the app.
+class USBEdgeSource
+{
+  public:
+    virtual ~USBEdgeSource()
+    {
+    }
+
+    virtual U64 GetSampleNumber() = 0;
+    virtual USBBitState GetBitState() = 0;
+    virtual U64 GetSampleOfNextEdge() = 0;
+
+    virtual void AdvanceToNextEdge() = 0;
+    virtual void AdvanceToAbsPosition( U64 sample ) = 0;
+
+    virtual bool WouldAdvancingCauseTransition( U32 numSamples ) = 0;
+    virtual bool WouldAdvancingToAbsPositionCauseTransition( U64 sample ) = 0;
+
+    // false when there are no more edges to decode
+    virtual bool DoMoreTransitionsExistInCurrentData() = 0;
+};
+
+#endif // USB_EDGE_SOURCE_H
@@ -22,6 +22,9 @@ enum USBFrameTypes // analyzer frames, NOT USB 1ms frame
 
     FT_ControlTransferField,
     FT_HIDReportDescriptorItem,
+    FT_HIDReportField, // a field of a HID report on an interrupt endpoint
+
+    FT_Count
 };
 
 // these are used by the exporter to help with formatting
@@ -87,8 +90,8 @@ enum USBRequestCode
     GET_CONFIGURATION = 0x08,
     SET_CONFIGURATION = 0x09,
     GET_INTERFACE = 0x0A,
-    SET_INTERFACE = 0x11,
-    SYNCH_FRAME = 0x12,
+    SET_INTERFACE = 0x0B,
+    SYNCH_FRAME = 0x0C,
 };
 
 enum USBHIDRequestCode
@@ -138,6 +141,9 @@ enum USBCDCRequestCode
     GET_ATM_DEVICE_STATISTICS = 0x51,
     SET_ATM_DEFAULT_VC = 0x52,
     GET_ATM_VC_STATISTICS = 0x53,
+
+    // bRequest is kept as it is, so every byte has to be a value of the enum
+    LAST_REQUEST_CODE = 0xff,
 };
 
 enum USBDescriptorType
@@ -162,6 +168,9 @@ enum USBDescriptorType
     // CDC
     DT_CDC_CS_INTERFACE = 0x24,
     DT_CDC_CS_ENDPOINT = 0x25,
+
+    // bDescriptorType is kept as it is, so every byte has to be a value of the enum
+    DT_Last = 0xff,
 };
 
 enum USBCDCDescriptorSubtype
@@ -271,6 +280,8 @@ enum USBCtrlTransFieldType
     Fld_CDC_wValue_ATMDataFormat,
     Fld_CDC_wValue_ATMFeatureSelector,
     Fld_CDC_wValue_ATMVCFeatureSelector,
+
+    Fld_Count
 };
 
 enum USBState
@@ -295,6 +306,23 @@ enum USBDecodeLevel
     OUT_CONTROL_TRANSFERS,
 };
 
+// the export_type_user_id values of the export options
+enum USBExportType
+{
+    EXP_TEXT,          // text file matching the decode level
+    EXP_USBMON_TEXT,   // Linux usbmon text format
+    EXP_USBMON_BINARY, // Linux usbmon binary (mon_bin) records
+    EXP_COLUMNS,       // binary packet columns, see USBColumnarExport.h
+    EXP_PERF_COUNTERS, // debug: where the time of the last decode went, see USBPerfCounters.h
+};
+
+enum USBCRCStatus
+{
+    CRCS_None, // packet has no CRC
+    CRCS_OK,
+    CRCS_Bad,
+};
+
 enum USBClassCodes
 {
     CC_DeferredToInterface = 0x00,
@@ -319,4 +347,33 @@ enum USBClassCodes
     CC_VendorSpecific = 0xFF,
 };
 
+// the transfer type in bits 0..1 of the endpoint descriptor's bmAttributes
+enum USBEndpointType
+{
+    EPT_Control = 0,
+    EPT_Isochronous = 1,
+    EPT_Bulk = 2,
+    EPT_Interrupt = 3,
+
+    EPT_Unknown, // we don't have the endpoint's descriptor
+};
+
+// the HID reports that go over the interrupt endpoints
+enum USBHidReportType
+{
+    HRT_Input,  // interrupt IN
+    HRT_Output, // interrupt OUT
+
+    HRT_Count
+};
+
+enum USBHidReportFieldKind
+{
+    HRF_ReportID,
+    HRF_Variable, // the value of the usage
+    HRF_Array,    // the index of the usage that is on, like the keys pressed on a keyboard
+    HRF_Constant, // padding
+    HRF_Data,     // bits which are not in the report descriptor
+};
+
 #endif // USB_ENUMS_H
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "USBFormat.h"
+
+static const char HexDigits[] = "0123456789ABCDEF";
+
+static USBHostNumberFormatter HostNumberFormatter = NULL;
+static USBHostTimeFormatter HostTimeFormatter = NULL;
+static bool HostFormatsBase[ DB_AsciiHex + 1 ]; // the bases where the host formats the numbers
+
+static size_t FormatNumberHere( char* buff, size_t size, U64 val, USBDisplayBase base, int num_bits )
+{
+    if( size == 0 )
+        return 0;
+
+    if( num_bits < 64 )
+        val &= ( 1ull << num_bits ) - 1;
+
+    if( base == DB_ASCII || base == DB_AsciiHex )
+    {
+        // a printable character, or its value in quotes, and the hex after it for DB_AsciiHex
+        char ascii[ 24 ];
+        if( val >= 0x20 && val < 0x7f )
+            snprintf( ascii, sizeof( ascii ), "%c", char( val ) );
+        else
+            snprintf( ascii, sizeof( ascii ), "'%llu'", val );
+
+        if( base == DB_ASCII )
+        {
+            snprintf( buff, size, "%s", ascii );
+        }
+        else
+        {
+            char hex[ 24 ];
+            FormatNumberHere( hex, sizeof( hex ), val, DB_Hexadecimal, num_bits );
+            snprintf( buff, size, "%s (%s)", ascii, hex );
+        }
+
+        return strlen( buff );
+    }
+
+    // the digits are made from the right
+    char tmp[ 72 ];
+    char* p = tmp + sizeof( tmp );
+    if( base == DB_Hexadecimal )
+    {
+        const int num_digits = num_bits <= 0 ? 1 : num_bits < 64 ? ( num_bits + 3 ) / 4 : 16;
+        for( int dc = 0; dc < num_digits; ++dc )
+        {
+            *--p = HexDigits[ val & 0xf ];
+            val >>= 4;
+        }
+
+        *--p = 'x';
+        *--p = '0';
+    }
+    else if( base == DB_Binary )
+    {
+        for( int bc = 0; bc < num_bits && bc < 64; ++bc )
+        {
+            *--p = char( '0' + ( val & 1 ) );
+            val >>= 1;
+        }
+
+        *--p = 'b';
+        *--p = '0';
+    }
+    else
+    {
+        do
+        {
+            *--p = char( '0' + val % 10 );
+            val /= 10;
+        } while( val != 0 );
+    }
+
+    size_t len = tmp + sizeof( tmp ) - p;
+    if( len >= size )
+        len = size - 1;
+
+    memcpy( buff, p, len );
+    buff[ len ] = '\0';
+
+    return len;
+}
+
+void SetHostFormatters( USBHostNumberFormatter pNumberFormatter, USBHostTimeFormatter pTimeFormatter )
+{
+    HostNumberFormatter = pNumberFormatter;
+    HostTimeFormatter = pTimeFormatter;
+
+    // every width, with the edges of the printable characters for the ASCII bases
+    static const U64 values[] = { 0, 1, 9, 10, 0x1f, 0x20, 0x41, 0x7e, 0x7f, 0x80, 0xff, 0x0123456789abcdefull, ~0ull };
+    for( int base = DB_Binary; base <= DB_AsciiHex; ++base )
+    {
+        HostFormatsBase[ base ] = false;
+        for( int bits = 1; bits <= 64 && pNumberFormatter != NULL && !HostFormatsBase[ base ]; ++bits )
+        {
+            for( size_t vc = 0; vc < sizeof( values ) / sizeof( values[ 0 ] ); ++vc )
+            {
+                const U64 val = bits < 64 ? values[ vc ] & ( ( 1ull << bits ) - 1 ) : values[ vc ];
+
+                char host_str[ 128 ];
+                char here_str[ 128 ];
+                pNumberFormatter( val, USBDisplayBase( base ), bits, host_str, sizeof( host_str ) );
+                FormatNumberHere( here_str, sizeof( here_str ), val, USBDisplayBase( base ), bits );
+                if( strcmp( host_str, here_str ) != 0 )
+                {
+                    HostFormatsBase[ base ] = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+size_t FormatNumber( char* buff, size_t size, U64 val, USBDisplayBase base, int num_bits )
+{
+    if( size == 0 )
+        return 0;
+
+    if( HostFormatsBase[ base ] )
+    {
+        HostNumberFormatter( val, base, num_bits, buff, size );
+        return strlen( buff );
+    }
+
+    return FormatNumberHere( buff, size, val, base, num_bits );
+}
+
+USBTimeFormatter::USBTimeFormatter( U64 trigger_sample, U32 sample_rate, bool trim_zeros )
+    : mTriggerSample( S64( trigger_sample ) ),
+      mSampleRate( sample_rate > 0 ? sample_rate : 1 ),
+      mScale( 1 ),
+      mScaleHigh( 1 ),
+      mScaleLow( 1 ),
+      mDecimals( 0 ),
+      mTrimZeros( trim_zeros ),
+      mpBegin( NULL ),
+      mWhole( 0 ),
+      mFrac( 0 ),
+      mWholeDigits( 0 ),
+      mWholeMin( 0 ),
+      mWholeLimit( 0 ),
+      mValid( false ),
+      mpTrimmed( NULL ),
+      mTrimmedChar( 0 ),
+      mUseHost( false )
+{
+    // enough decimals to resolve a single sample
+    while( mScale < mSampleRate )
+    {
+        mScale *= 10;
+        ++mDecimals;
+    }
+
+    // the decimals are worked out in two steps if a remainder times mScale can overflow
+    mScaleLow = mScale;
+    while( mScaleLow > ~0ull / mSampleRate )
+    {
+        mScaleLow /= 10;
+        mScaleHigh *= 10;
+    }
+
+    memset( mBuff, 0, sizeof( mBuff ) );
+    if( mDecimals > 0 )
+        *( mBuff + BUFF_SIZE - 2 - mDecimals ) = '.';
+
+    // compare with the host around the trigger, a second away, and where the whole seconds have more digits
+    if( HostTimeFormatter != NULL )
+    {
+        const U64 steps[] = { 0, 1, mSampleRate - 1, mSampleRate, mSampleRate * 10 + 1, mSampleRate * 90000 + 7 };
+        for( size_t sc = 0; sc < sizeof( steps ) / sizeof( steps[ 0 ] ) && !mUseHost; ++sc )
+        {
+            if( !MatchesHost( trigger_sample + steps[ sc ] ) )
+                mUseHost = true;
+            else if( steps[ sc ] <= trigger_sample && !MatchesHost( trigger_sample - steps[ sc ] ) )
+                mUseHost = true;
+        }
+
+        mValid = false;
+    }
+}
+
+bool USBTimeFormatter::MatchesHost( U64 sample )
+{
+    const char* pHere = Format( sample );
+    return strcmp( pHere, FormatHost( sample ) ) == 0;
+}
+
+const char* USBTimeFormatter::FormatHost( U64 sample )
+{
+    HostTimeFormatter( sample, U64( mTriggerSample ), U32( mSampleRate ), mHostBuff, sizeof( mHostBuff ) );
+
+    // the same trimming as Format
+    if( mTrimZeros && strchr( mHostBuff, '.' ) != NULL )
+    {
+        char* pEnd = strchr( mHostBuff, '\0' );
+        while( pEnd - 1 > mHostBuff && *( pEnd - 1 ) == '0' )
+            *--pEnd = '\0';
+    }
+
+    return mHostBuff;
+}
+
+char* USBTimeFormatter::GetDigitPos( int digit )
+{
+    // skip the decimal point
+    if( mDecimals > 0 && digit >= mDecimals )
+        ++digit;
+
+    return mBuff + BUFF_SIZE - 2 - digit;
+}
+
+void USBTimeFormatter::FormatWhole( U64 whole )
+{
+    mWholeDigits = 0;
+    do
+    {
+        *GetDigitPos( mDecimals + mWholeDigits++ ) = char( '0' + whole % 10 );
+        whole /= 10;
+    } while( whole != 0 );
+
+    mpBegin = GetDigitPos( mDecimals + mWholeDigits - 1 );
+
+    // the range of values with the same number of digits
+    mWholeMin = 0;
+    mWholeLimit = 1;
+    for( int dc = 0; dc < mWholeDigits && mWholeLimit != 0; ++dc )
+    {
+        if( dc == mWholeDigits - 1 && dc > 0 )
+            mWholeMin = mWholeLimit;
+        mWholeLimit = mWholeLimit <= ~0ull / 10 ? mWholeLimit * 10 : 0;
+    }
+}
+
+void USBTimeFormatter::UpdateDigits( int first_digit, U64 curr, U64 prev )
+{
+    // rewrite the low digits until the rest is the same as before
+    for( int digit = first_digit; curr != prev; ++digit )
+    {
+        *GetDigitPos( digit ) = char( '0' + curr % 10 );
+        curr /= 10;
+        prev /= 10;
+    }
+}
+
+const char* USBTimeFormatter::Format( U64 sample )
+{
+    if( mUseHost )
+        return FormatHost( sample );
+
+    // undo the trimming of the previous string
+    if( mpTrimmed != NULL )
+    {
+        *mpTrimmed = mTrimmedChar;
+        mpTrimmed = NULL;
+    }
+
+    const S64 rel = S64( sample ) - mTriggerSample;
+    const bool negative = rel < 0;
+    const U64 mag = negative ? 0 - U64( rel ) : U64( rel );
+    const U64 whole = mag / mSampleRate;
+    U64 frac;
+    if( mScaleHigh == 1 )
+    {
+        frac = mag % mSampleRate * mScale / mSampleRate;
+    }
+    else
+    {
+        // rem * mScaleHigh is split into whole samples and a remainder again, like mag is
+        const U64 high = mag % mSampleRate * mScaleHigh;
+        frac = high / mSampleRate * mScaleLow + high % mSampleRate * mScaleLow / mSampleRate;
+    }
+
+    if( !mValid )
+    {
+        // the decimals are zero padded
+        for( int digit = 0; digit < mDecimals; ++digit )
+            *GetDigitPos( digit ) = '0';
+        UpdateDigits( 0, frac, 0 );
+        FormatWhole( whole );
+    }
+    else
+    {
+        UpdateDigits( 0, frac, mFrac );
+
+        // the whole seconds are updated in place if the number of digits stays the same
+        if( whole < mWholeMin || ( mWholeLimit != 0 && whole >= mWholeLimit ) )
+            FormatWhole( whole );
+        else
+            UpdateDigits( mDecimals, whole, mWhole );
+    }
+
+    mWhole = whole;
+    mFrac = frac;
+    mValid = true;
+
+    char* pResult = mpBegin;
+    if( negative )
+        *--pResult = '-';
+
+    if( mTrimZeros && mDecimals > 0 )
+    {
+        char* pEnd = mBuff + BUFF_SIZE - 1;
+        while( pEnd - 1 > pResult && *( pEnd - 1 ) == '0' )
+            --pEnd;
+
+        if( *pEnd != '\0' )
+        {
+            mpTrimmed = pEnd;
+            mTrimmedChar = *pEnd;
+            *pEnd = '\0';
+        }
+    }
+
+    return pResult;
+}
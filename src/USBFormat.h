@@ -0,0 +1,80 @@
+#ifndef USB_FORMAT_H
+#define USB_FORMAT_H
+
+#include <stddef.h>
+
+#include "USBCoreTypes.h"
+
+// Number and time formatting into caller supplied buffers. These are used for every number in
+// the bubbles, tabular text and exports, so they don't allocate.
+
+// The number and time formatting of the host, e.g. AnalyzerHelpers::GetNumberString and GetTimeString in
+// the plugin, so the strings are the same as everywhere else in the host.
+typedef void ( *USBHostNumberFormatter )( U64 val, USBDisplayBase base, int num_bits, char* buff, size_t size );
+typedef void ( *USBHostTimeFormatter )( U64 sample, U64 trigger_sample, U32 sample_rate, char* buff, size_t size );
+
+// Sets the formatting of the host; call it once, before anything is formatted. The formatting here is
+// compared with the host's for a set of values of each base, and for some samples around the trigger of
+// each USBTimeFormatter. Where any of them differ the host formats all the strings, so only the strings
+// shown to be the same are made here.
+void SetHostFormatters( USBHostNumberFormatter pNumberFormatter, USBHostTimeFormatter pTimeFormatter );
+
+// Writes the low num_bits of val like AnalyzerHelpers::GetNumberString and returns the length
+// of the string. The result is always terminated, and truncated if it does not fit.
+size_t FormatNumber( char* buff, size_t size, U64 val, USBDisplayBase base, int num_bits );
+
+// Formats sample numbers as seconds relative to the trigger, with enough decimals to resolve one
+// sample. The samples of consecutive export lines are close together, so only the digits that
+// changed since the previous call are rewritten.
+class USBTimeFormatter
+{
+  public:
+    // trim_zeros removes the trailing zeros of the decimals
+    USBTimeFormatter( U64 trigger_sample, U32 sample_rate, bool trim_zeros = false );
+
+    // the string is valid until the next call
+    const char* Format( U64 sample );
+
+  private:
+    enum
+    {
+        BUFF_SIZE = 48,
+        HOST_BUFF_SIZE = 128
+    };
+
+    S64 mTriggerSample;
+    U64 mSampleRate;
+    U64 mScale; // 10 ^ mDecimals
+
+    // mScale = mScaleHigh * mScaleLow, with mSampleRate * mScaleLow in 64 bits; mScaleHigh is 1 unless the sample
+    // rate is above about 1.8 GHz
+    U64 mScaleHigh;
+    U64 mScaleLow;
+    int mDecimals;
+    bool mTrimZeros;
+
+    // the digits are right aligned in mBuff, the terminator is at mBuff[ BUFF_SIZE - 1 ]
+    char mBuff[ BUFF_SIZE ];
+    char* mpBegin;    // first digit
+    U64 mWhole;       // the whole seconds in mBuff
+    U64 mFrac;        // the decimals in mBuff, in units of 1 / mScale seconds
+    int mWholeDigits; // the number of digits of mWhole
+    U64 mWholeMin;    // the values from mWholeMin up to mWholeLimit have mWholeDigits digits
+    U64 mWholeLimit;  // 0 if there are no values with more digits
+    bool mValid;
+
+    char* mpTrimmed; // where the terminator of the trimmed string was put, NULL if nowhere
+    char mTrimmedChar;
+
+    // the host formats the strings, because they differ from the ones made here
+    bool mUseHost;
+    char mHostBuff[ HOST_BUFF_SIZE ];
+
+    bool MatchesHost( U64 sample );
+    const char* FormatHost( U64 sample );
+    char* GetDigitPos( int digit );
+    void FormatWhole( U64 whole );
+    void UpdateDigits( int first_digit, U64 curr, U64 prev );
+};
+
+#endif // USB_FORMAT_H
@@ -0,0 +1,1598 @@
+#include <stdio.h>
+#include <string.h>
+#include <locale>
+#include <codecvt>
+
+#include "USBFrameFormatters.h"
+#include "USBTypes.h"
+#include "USBControlTransfers.h"
+#include "USBHidReports.h"
+#include "USBLookupTables.h"
+
+static std::string GetCollectionData( U8 data )
+{
+    switch( data )
+    {
+    case 0x00:
+        return "Physical";
+    case 0x01:
+        return "Application";
+    case 0x02:
+        return "Logical";
+    case 0x03:
+        return "Report";
+    case 0x04:
+        return "Named Array";
+    case 0x05:
+        return "Usage Switch";
+    case 0x06:
+        return "Usage Modifier";
+    }
+
+    if( data >= 0x07 && data <= 0x7F )
+        return "Reserved";
+
+    return "Vendor-defined";
+}
+
+static std::string GetInputData( U8 data1, U8 data2 )
+{
+    std::string retVal;
+
+    retVal += data1 & 0x01 ? "Constant" : "Data";
+    retVal += ',';
+    retVal += data1 & 0x02 ? "Variable" : "Array";
+    retVal += ',';
+    retVal += data1 & 0x04 ? "Relative" : "Absolute";
+    retVal += ',';
+    retVal += data1 & 0x08 ? "Wrap" : "No wrap";
+    retVal += ',';
+    retVal += data1 & 0x10 ? "Non Linear" : "Linear";
+    retVal += ',';
+    retVal += data1 & 0x20 ? "No Preferred" : "Preferred State";
+    retVal += ',';
+    retVal += data1 & 0x40 ? "Null State" : "No Null position";
+    retVal += ',';
+
+    retVal += data2 & 0x01 ? "Buffered Bytes" : "Bit Field";
+
+    return retVal;
+}
+
+static std::string GetOutputAndFeatureData( U8 data1, U8 data2 )
+{
+    std::string retVal;
+
+    retVal += data1 & 0x01 ? "Constant" : "Data";
+    retVal += ',';
+    retVal += data1 & 0x02 ? "Variable" : "Array";
+    retVal += ',';
+    retVal += data1 & 0x04 ? "Relative" : "Absolute";
+    retVal += ',';
+    retVal += data1 & 0x08 ? "Wrap" : "No wrap";
+    retVal += ',';
+    retVal += data1 & 0x10 ? "Non Linear" : "Linear";
+    retVal += ',';
+    retVal += data1 & 0x20 ? "No Preferred" : "Preferred State";
+    retVal += ',';
+    retVal += data1 & 0x40 ? "Null State" : "No Null position";
+    retVal += ',';
+    retVal += data1 & 0x80 ? "Volatile" : "Non Volatile";
+    retVal += ',';
+
+    retVal += data2 & 0x01 ? "Buffered Bytes" : "Bit Field";
+
+    return retVal;
+}
+
+static const char* GetHIDItemUsage( U16 usagePage, const U8* pItem, USBIdsDatabase* pUsbIds, char* buff, size_t size )
+{
+    // do we have an extended usage?
+    if( GetNumHIDItemDataBytes( *pItem ) == 4 )
+    {
+        U16 usagePage = *( U16* )( pItem + 3 );
+        U16 usageID = *( U16* )( pItem + 1 );
+        return GetHIDUsageName( usagePage, usageID, pUsbIds, buff, size );
+    }
+
+    return GetHIDUsageName( usagePage, *( U16* )( pItem + 1 ), pUsbIds, buff, size );
+}
+
+static std::string GetSignedDataValue( const U8* pItem, USBDisplayBase display_base )
+{
+    int numBytes = GetNumHIDItemDataBytes( pItem[ 0 ] ); // number of data bytes
+
+    if( numBytes == 0 )
+        return "0";
+
+    int sVal;
+    U64 uVal;
+
+    if( numBytes == 1 )
+    {
+        sVal = S8( pItem[ 1 ] );
+        uVal = pItem[ 1 ];
+    }
+    else if( numBytes == 2 )
+    {
+        sVal = *( S16* )( pItem + 1 );
+        uVal = *( U16* )( pItem + 1 );
+    }
+    else
+    {
+        sVal = *( S32* )( pItem + 1 );
+        uVal = *( U32* )( pItem + 1 );
+    }
+
+    std::string retVal;
+
+    if( display_base == DB_Decimal )
+    {
+        // we can't use AnalyzerHelpers::GetNumberString because we need signed values
+        char buff[ 32 ];
+        sprintf( buff, "%i", sVal );
+        retVal = buff;
+    }
+    else
+    {
+        retVal = int2str_sal( uVal, display_base, numBytes * 8 );
+    }
+
+    return retVal;
+}
+
+static std::string GetUnitExponent( U8 data )
+{
+    if( data > 0xF0 )
+        return "undefined";
+
+    const char* results[] = { "0", "1", "2", "3", "4", "5", "6", "7", "-8", "-7", "-6", "-5", "-4", "-3", "-2", "-1" };
+
+    return results[ data ];
+}
+
+static std::string GetUnit( const U8* pItem )
+{
+    U32 val = *( U32* )( pItem + 1 );
+
+    U8 firstNibble = val & 0x0f;
+
+    // branch by quality measures
+    if( val & 0x000000f0 ) // Length
+    {
+        switch( firstNibble )
+        {
+        case 1:
+            return "Centimeter";
+        case 2:
+            return "Radian";
+        case 3:
+            return "Inch";
+        case 4:
+            return "Degree";
+        }
+    }
+    else if( val & 0x00000f00 )
+    { // Mass
+
+        if( firstNibble == 1 || firstNibble == 2 )
+            return "Gram";
+        else if( firstNibble == 3 || firstNibble == 4 )
+            return "Slug";
+    }
+    else if( val & 0x0000f000 )
+    { // Time
+
+        if( firstNibble >= 1 || firstNibble <= 4 )
+            return "Second";
+    }
+    else if( val & 0x000f0000 )
+    { // Temperature
+
+        if( firstNibble == 1 || firstNibble == 2 )
+            return "Kelvin";
+        else if( firstNibble == 3 || firstNibble == 4 )
+            return "Fahrenheit";
+    }
+    else if( val & 0x00f00000 )
+    { // Current
+
+        if( firstNibble >= 1 || firstNibble <= 4 )
+            return "Ampere";
+    }
+    else if( val & 0x0f000000 )
+    { // Luminosity
+
+        if( firstNibble >= 1 || firstNibble <= 4 )
+            return "Candela";
+    }
+
+    return "Undefined Unit";
+}
+
+static void GetHIDReportDescriptorItemFrameDesc( const USBFrame& frm, USBDisplayBase display_base, std::vector<std::string>& results,
+                                                 USBIdsDatabase* pUsbIds )
+{
+    if( ( frm.mFlags & 0x3F ) == FF_FieldIncomplete )
+    {
+        results.push_back( "<item incomplete - see next packet>" );
+        results.push_back( "<item incomplete>" );
+        results.push_back( "<incomplete>" );
+        return;
+    }
+
+    const USBHidRepDescItemFrame& f( static_cast<const USBHidRepDescItemFrame&>( frm ) );
+
+    std::string indent( f.GetIndentLevel() * 4, ' ' );
+
+    const U8* pItem = f.GetItem();
+    U8 itemSize = GetNumHIDItemDataBytes( pItem[ 0 ] ) + 1;
+
+    // make the raw values (always HEX)
+    std::string rawVal;
+    for( int cnt = 0; cnt < itemSize; cnt++ )
+    {
+        if( cnt )
+            rawVal += ' ';
+
+        rawVal += int2str_sal( pItem[ cnt ], DB_Hexadecimal, 8 );
+    }
+
+    size_t padding_chars;
+    if( rawVal.size() >= 15 )
+        padding_chars = 1;
+    else
+        padding_chars = 16 - rawVal.size();
+
+    std::string padding( padding_chars, ' ' );
+    std::string desc;
+    char name_str[ 128 ];
+
+    const U8 firstByte = *pItem;
+    const U8 tagType = ( firstByte & 0xfc );
+    const U8 bType = ( firstByte >> 2 ) & 0x03;
+    const U8 bTag = firstByte >> 4;
+
+    if( bType == 0 ) // Main items
+    {
+        if( bTag == 0x0A )
+            desc = "Collection (" + GetCollectionData( pItem[ 1 ] ) + ")";
+        else if( bTag == 0x0C )
+            desc = "End Collection";
+        else if( bTag == 0x08 )
+            desc = "Input (" + GetInputData( pItem[ 1 ], pItem[ 2 ] ) + ")";
+        else if( bTag == 0x09 )
+            desc = "Output (" + GetOutputAndFeatureData( pItem[ 1 ], pItem[ 2 ] ) + ")";
+        else if( bTag == 0x0B )
+            desc = "Feature (" + GetOutputAndFeatureData( pItem[ 1 ], pItem[ 2 ] ) + ")";
+        else
+            desc = "Unknown Main item. bTag=" + int2str_sal( bTag, display_base, 4 );
+    }
+    else if( bType == 1 )
+    { // Global
+
+        if( bTag == 0x00 )
+        {
+            desc = "Usage Page (";
+            desc += GetHIDUsagePageName( ( pItem[ 2 ] << 8 ) | pItem[ 1 ], pUsbIds, name_str, sizeof( name_str ) );
+            desc += ')';
+        }
+        else if( bTag == 0x01 )
+            desc = "Logical Minimum (" + GetSignedDataValue( pItem, display_base ) + ")";
+        else if( bTag == 0x02 )
+            desc = "Logical Maximum (" + GetSignedDataValue( pItem, display_base ) + ")";
+        else if( bTag == 0x03 )
+            desc = "Physical Minimum (" + GetSignedDataValue( pItem, display_base ) + ")";
+        else if( bTag == 0x04 )
+            desc = "Physical Maximum (" + GetSignedDataValue( pItem, display_base ) + ")";
+        else if( bTag == 0x05 )
+            desc = "Unit Exponent (" + GetUnitExponent( pItem[ 1 ] ) + ")";
+        else if( bTag == 0x06 )
+            desc = "Unit (" + GetUnit( pItem ) + ")";
+        else if( bTag == 0x07 )
+            desc = "Report Size (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 0x08 )
+            desc = "Report ID (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 0x09 )
+            desc = "Report Count (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 0x0A )
+            desc = "Push";
+        else if( bTag == 0x0B )
+            desc = "Pop";
+        else
+            desc = "Unknown Global item bTag=" + int2str_sal( bTag, display_base, 4 );
+    }
+    else if( bType == 2 )
+    { // Local
+
+        if( bTag == 0 )
+        {
+            desc = "Usage (";
+            desc += GetHIDItemUsage( f.GetUsagePage(), pItem, pUsbIds, name_str, sizeof( name_str ) );
+            desc += ')';
+        }
+        else if( bTag == 1 )
+        {
+            desc = "Usage Minimum (";
+            desc += GetHIDItemUsage( f.GetUsagePage(), pItem, pUsbIds, name_str, sizeof( name_str ) );
+            desc += ')';
+        }
+        else if( bTag == 2 )
+        {
+            desc = "Usage Maximum (";
+            desc += GetHIDItemUsage( f.GetUsagePage(), pItem, pUsbIds, name_str, sizeof( name_str ) );
+            desc += ')';
+        }
+        else if( bTag == 3 )
+            desc = "Designator Index (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 4 )
+            desc = "Designator Minimum (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 5 )
+            desc = "Designator Maximum (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 7 )
+            desc = "String Index (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 8 )
+            desc = "String Minimum (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 9 )
+            desc = "String Maximum (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else if( bTag == 10 )
+            desc = "Delimiter (" + int2str_sal( pItem[ 1 ], display_base, 8 ) + ")";
+        else
+            desc = "Unknown Local item bTag=" + int2str_sal( bTag, display_base, 4 );
+    }
+    else
+    {
+        desc = "Unknown item type (" + int2str_sal( tagType, DB_Hexadecimal, 8 ) + ")";
+    }
+
+    results.push_back( rawVal + padding + indent + desc );
+    results.push_back( desc );
+    results.push_back( rawVal + desc );
+    results.push_back( rawVal );
+}
+
+// control transfer field formatters: they make the description that follows the field value
+
+static void FormatField_bRequest_Standard( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    desc += GetRequestName( val );
+}
+
+static void FormatField_bRequest_Class( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                        std::string& desc )
+{
+    desc = " (Class request)";
+}
+
+static void FormatField_bRequest_HID( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                      std::string& desc )
+{
+    desc = " ";
+    desc += GetHIDRequestName( val );
+    desc += " (HID class)";
+}
+
+static void FormatField_bRequest_CDC( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                      std::string& desc )
+{
+    desc = " ";
+    desc += GetCDCRequestName( val );
+    desc += " (CDC class)";
+}
+
+static void FormatField_bRequest_Vendor( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    desc = " (Vendor request)";
+}
+
+static void FormatField_bmRequestType( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                       std::string& desc )
+{
+    desc = " Data direction=";
+    if( f.GetFormatter() == Fld_bmRequestType_NoData )
+        desc += "No data";
+    else
+        desc += ( val & 0x80 ) ? "Device to host" : "Host to device";
+
+    desc += ", Type=";
+    switch( ( val & 0x60 ) >> 5 )
+    {
+    case 0:
+        desc += "Standard";
+        break;
+    case 1:
+        desc += "Class";
+        break;
+    case 2:
+        desc += "Vendor";
+        break;
+    case 3:
+        desc += "Reserved";
+        break;
+    }
+
+    desc += ", Recipient=";
+    switch( val & 0x1f )
+    {
+    case 0:
+        desc += "Device";
+        break;
+    case 1:
+        desc += "Interface";
+        break;
+    case 2:
+        desc += "Endpoint";
+        break;
+    case 3:
+        desc += "Other";
+        break;
+    default:
+        desc += "Reserved";
+        break;
+    }
+}
+
+static void FormatField_wValue_Address( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                        std::string& desc )
+{
+    desc += " Address=" + int2str_sal( val, display_base, 8 );
+}
+
+static void FormatField_wValue_Descriptor( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    U8 descriptor = ( val >> 8 ) & 0xff;
+    U8 index = val & 0xff;
+
+    desc = " Descriptor=";
+    desc += GetDescriptorName( descriptor );
+    desc += ", Index=" + int2str_sal( index, display_base, 8 );
+}
+
+static void FormatField_wValue_HIDSetIdle( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    U8 duration = ( val >> 8 ) & 0xff;
+    U8 reportID = val & 0xff;
+
+    desc = " Duration=";
+    if( duration == 0 )
+        desc += "Indefinite";
+    else
+        desc += int2str( duration ) + "ms";
+
+    desc += ", Report ID=" + int2str_sal( reportID, display_base, 8 );
+}
+
+static void FormatField_wValue_HIDGetIdle( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    desc = " Report ID=" + int2str_sal( val & 0xff, display_base, 8 );
+}
+
+static void FormatField_wValue_HIDSetProtocol( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                               const USBFormatNames& names, std::string& desc )
+{
+    desc = " Protocol=";
+    if( val == 0 )
+        desc += "Boot protocol";
+    else if( val == 1 )
+        desc += "Report protocol";
+    else
+        desc += "<unknown>";
+}
+
+static void FormatField_wValue_HIDGetSetReport( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                const USBFormatNames& names, std::string& desc )
+{
+    U8 reportType = ( val >> 8 ) & 0xff;
+    U8 reportID = val & 0xff;
+
+    desc = " Report type=";
+    if( reportType == 1 )
+        desc += "Input";
+    else if( reportType == 2 )
+        desc += "Output";
+    else if( reportType == 3 )
+        desc += "Feature";
+    else
+        desc += "Reserved";
+
+    desc += ", Report ID=" + int2str_sal( reportID, display_base, 8 );
+}
+
+static void FormatField_bDescriptorType( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    desc = " ";
+    desc += GetDescriptorName( val & 0xff );
+}
+
+static void FormatField_bDescriptorType_Other( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                               const USBFormatNames& names, std::string& desc )
+{
+    desc = " <unknown>";
+}
+
+static void FormatField_Wchar( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                               std::string& desc )
+{
+    // utf-8 encode the utf-16 character.
+    std::u16string utf_16_str;
+    char16_t u16_char = static_cast<char16_t>( val );
+    utf_16_str.push_back( u16_char );
+
+    // half of a surrogate pair can't be converted on its own, so it shows as U+FFFD instead of throwing
+    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert( "\xEF\xBF\xBD" );
+    std::string utf8_str = convert.to_bytes( utf_16_str );
+    desc = std::string( " char='" ) + utf8_str + '\'';
+}
+
+static void FormatField_wLANGID( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                 std::string& desc )
+{
+    desc = " Language=" + std::string( GetLangName( val ) );
+}
+
+static void FormatField_wVendorId( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                   std::string& desc )
+{
+    desc = " Vendor=" + std::string( GetVendorName( val, names.mpUsbIds ) );
+}
+
+static void FormatField_bMaxPower( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                   std::string& desc )
+{
+    desc += " " + int2str( val * 2 ) + "mA";
+}
+
+static void FormatField_bmAttributes_Endpoint( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                               const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    switch( val & 0x03 )
+    {
+    case 0:
+        desc += "Control";
+        break;
+    case 1:
+        desc += "Isochronous";
+        break;
+    case 2:
+        desc += "Bulk";
+        break;
+    case 3:
+        desc += "Interrupt";
+        break;
+    }
+
+    if( ( val & 0x03 ) == 1 ) // if isochronous
+    {
+        desc += ", ";
+        switch( ( val >> 2 ) & 0x03 )
+        {
+        case 0:
+            desc += "No Synchronization";
+            break;
+        case 1:
+            desc += "Asynchronous";
+            break;
+        case 2:
+            desc += "Adaptive";
+            break;
+        case 3:
+            desc += "Synchronous";
+            break;
+        }
+
+        desc += ", ";
+        switch( ( val >> 4 ) & 0x03 )
+        {
+        case 0:
+            desc += "Data endpoint";
+            break;
+        case 1:
+            desc += "Feedback endpoint";
+            break;
+        case 2:
+            desc += "Implicit feedback Data endpoint";
+            break;
+        case 3:
+            desc += "Reserved";
+            break;
+        }
+    }
+}
+
+static void FormatField_bmAttributes_Config( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                             const USBFormatNames& names, std::string& desc )
+{
+    desc = ( val & 0x40 ) ? " Self powered" : " Bus powered";
+    desc += ", Remote wakeup ";
+    desc += ( val & 0x20 ) ? "supported" : "unsupported";
+}
+
+static void FormatField_bEndpointAddress( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                          const USBFormatNames& names, std::string& desc )
+{
+    desc = " Endpoint=" + int2str( val & 0x0F );
+    desc += ", Direction=";
+    desc += ( val & 0x80 ) == 0 ? "OUT" : "IN";
+}
+
+static void FormatField_BCD( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                             std::string& desc )
+{
+    desc = " ";
+    if( val & 0xf000 )
+        desc += int2str( val >> 12 );
+
+    desc += int2str( ( val >> 8 ) & 0x0f );
+    desc += ".";
+    desc += int2str( ( val >> 4 ) & 0x0f );
+    desc += int2str( val & 0x0f );
+}
+
+static void FormatField_ClassCode( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                   std::string& desc )
+{
+    desc = " ";
+    desc += GetUSBClassName( ( U8 )val );
+}
+
+static void FormatField_HIDSubClass( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                     std::string& desc )
+{
+    if( val == 0 )
+        desc = " None";
+    else if( val == 1 )
+        desc = " Boot Interface";
+    else
+        desc = " Reserved";
+}
+
+static void FormatField_HIDProtocol( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                     std::string& desc )
+{
+    if( val == 0 )
+        desc = " None";
+    else if( val == 1 )
+        desc = " Keyboard";
+    else if( val == 2 )
+        desc = " Mouse";
+    else
+        desc = " Reserved";
+}
+
+static void FormatField_wIndex_InterfaceNum( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                             const USBFormatNames& names, std::string& desc )
+{
+    desc = " Interface=" + int2str_sal( val & 0xff, display_base, 8 );
+}
+
+static void FormatField_HID_bCountryCode( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                          const USBFormatNames& names, std::string& desc )
+{
+    desc = " Country=";
+    desc += GetHIDCountryName( ( U8 )val );
+}
+
+static void FormatField_String( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                std::string& desc )
+{
+    if( val != 0 )
+    {
+        USBStringDescriptorMap::const_iterator srch( names.mStringDescriptors.find( std::make_pair( f.GetAddress(), ( int )val ) ) );
+        if( srch != names.mStringDescriptors.end() )
+            desc = " " + srch->second;
+    }
+}
+
+static void FormatField_CDC_wValue_CommFeatureSelector( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                        const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " RESERVED";
+    else if( val == 1 )
+        desc = " ABSTRACT_STATE";
+    else if( val == 2 )
+        desc = " COUNTRY_SETTING";
+}
+
+static void FormatField_CDC_wValue_DisconnectConnect( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                      const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " Disconnect";
+    else if( val == 1 )
+        desc = " Connect";
+}
+
+static void FormatField_CDC_wValue_RelayConfig( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " ON_HOOK";
+    else if( val == 1 )
+        desc = " OFF_HOOK";
+    else if( val == 2 )
+        desc = " SNOOPING";
+}
+
+static void FormatField_CDC_wValue_EnableDisable( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                  const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0xffff )
+        desc = " Disengage the holding circuit";
+    else
+        desc = " Prepare for a pulse-dialing cycle";
+}
+
+static void FormatField_CDC_wValue_Cycles( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    desc = " Number of cycles";
+}
+
+static void FormatField_CDC_wValue_Timing( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                           const USBFormatNames& names, std::string& desc )
+{
+    U8 hi = ( val >> 8 ) & 0xff;
+    U8 lo = val & 0xff;
+
+    desc = " Break time=" + int2str( hi ) + "ms, make time=" + int2str( lo );
+}
+
+static void FormatField_CDC_wValue_NumberOfRings( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                  const USBFormatNames& names, std::string& desc )
+{
+    desc = " Number of rings";
+}
+
+static void FormatField_CDC_wValue_ControlSignalBitmap( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                        const USBFormatNames& names, std::string& desc )
+{
+    desc = ( val & 2 ) ? " Activate carrier" : " Deactivate carrier";
+    desc += ( val & 1 ) ? ", DTE Present" : ", DTE Not Present";
+}
+
+static void FormatField_CDC_wValue_DurationOfBreak( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                    const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0xffff )
+        desc = " Break until receive SEND_BREAK with wValue of 0";
+    else
+        desc = " Duration of break " + int2str( val ) + "ms";
+}
+
+static void FormatField_CDC_wValue_OperationParms( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                   const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " Simple Mode";
+    else if( val == 1 )
+        desc = " Standalone Mode";
+    else if( val == 2 )
+        desc = " Host Centric Mode";
+}
+
+static void FormatField_CDC_wValue_LineStateChange( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                    const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " Drop the active call on the line.";
+    else if( val == 1 )
+        desc = " Start a new call on the line.";
+    else if( val == 2 )
+        desc = " Apply ringing to the line.";
+    else if( val == 3 )
+        desc = " Remove ringing from the line.";
+    else if( val == 4 )
+        desc = " Switch to a specific call on the line.";
+}
+
+static void FormatField_CDC_wValue_UnitParameterStructure( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                           const USBFormatNames& names, std::string& desc )
+{
+    desc = " bEntityId=" + int2str_sal( val & 0xff, display_base, 8 );
+    desc += ", bParameterIndex=" + int2str_sal( val >> 8, display_base, 8 );
+}
+
+static void FormatField_CDC_wValue_NumberOfFilters( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                    const USBFormatNames& names, std::string& desc )
+{
+    desc = " Number of filters";
+}
+
+static void FormatField_CDC_wValue_FilterNumber( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                 const USBFormatNames& names, std::string& desc )
+{
+    desc = " Filter number";
+}
+
+static void FormatField_CDC_wValue_PacketFilterBitmap( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                       const USBFormatNames& names, std::string& desc )
+{
+    desc = " PACKET_TYPE_MULTICAST=";
+    desc += ( ( val & 0x10 ) ? "1" : "0" );
+    desc += ", PACKET_TYPE_BROADCAST=";
+    desc += ( ( val & 0x08 ) ? "1" : "0" );
+    desc += ", PACKET_TYPE_DIRECTED=";
+    desc += ( ( val & 0x04 ) ? "1" : "0" );
+    desc += ", PACKET_TYPE_ALL_MULTICAST=";
+    desc += ( ( val & 0x02 ) ? "1" : "0" );
+    desc += ", PACKET_TYPE_PROMISCUOUS=";
+    desc += ( ( val & 0x01 ) ? "1" : "0" );
+}
+
+static void FormatField_CDC_wValue_EthFeatureSelector( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                       const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    desc += GetCDCEthFeatureSelectorName( val );
+}
+
+static void FormatField_CDC_wValue_ATMDataFormat( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                  const USBFormatNames& names, std::string& desc )
+{
+    if( val == 1 )
+        desc = " Concatenated ATM cells";
+    else if( val == 2 )
+        desc = " ATM header template + concatenated ATM cell payloads";
+    else if( val == 3 )
+        desc = " AAL 5 SDU";
+}
+
+static void FormatField_CDC_wValue_ATMFeatureSelector( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                       const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    desc += GetCDCATMFeatureSelectorName( val );
+}
+
+static void FormatField_CDC_wValue_ATMVCFeatureSelector( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                         const USBFormatNames& names, std::string& desc )
+{
+    if( val == 1 )
+        desc = " VC_US_CELLS_SENT";
+    else if( val == 2 )
+        desc = " VC_DS_CELLS_RECEIVED";
+}
+
+static void FormatField_CDC_DescriptorSubtype( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                               const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    desc += GetCDCDescriptorSubtypeName( val );
+}
+
+static void FormatField_CDC_bmCapabilities_Call( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                 const USBFormatNames& names, std::string& desc )
+{
+    desc = ( val & 0x02 ) ? " Call management over a Data Class interface" : " Call management only over the Comm Class interface";
+    desc += ", ";
+    desc += ( val & 0x01 ) ? "Device handles call management itself" : "Device doesn't handle call management itself";
+}
+
+static void FormatField_CDC_bmCapabilities_AbstractCtrl( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                         const USBFormatNames& names, std::string& desc )
+{
+    desc = " Network_Connection notification ";
+    desc += ( val & 0x08 ) ? "supported" : "not supported";
+    desc += "; Send_Break request ";
+    desc += ( val & 0x04 ) ? "supported" : "not supported";
+    desc += "; Set_Line_Coding, Set_Control_Line_State, Get_Line_Coding and the notification Serial_State ";
+    desc += ( val & 0x02 ) ? "supported" : "not supported";
+    desc += "; Set_Comm_Feature, Clear_Comm_Feature and Get_Comm_Feature ";
+    desc += ( val & 0x01 ) ? "supported" : "not supported";
+}
+
+static void FormatField_CDC_bmCapabilities_DataLine( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                     const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x04 )
+        desc = "Device requires extra Pulse_Setup request during pulse dialing sequence to disengage holding circuit";
+    if( val & 0x02 )
+        desc +=
+            ( desc.empty() ? "" : "; " ) +
+            std::string(
+                "Device supports the request combination of Set_Aux_Line_State, Ring_Aux_Jack, and notification Aux_Jack_Hook_State" );
+    if( val & 0x01 )
+        desc += ( desc.empty() ? "" : "; " ) +
+                std::string( "Device supports the request combination of Pulse_Setup, Send_Pulse, and Set_Pulse_Time" );
+    if( !desc.empty() )
+        desc = " " + desc;
+}
+
+static void FormatField_CDC_bRingerVolSteps( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                             const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    if( val == 0 )
+        desc += "256 discrete volume steps";
+    else
+        desc = int2str( val ) + " discrete volume steps";
+}
+
+static void FormatField_CDC_bmCapabilities_TelOpModes( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                       const USBFormatNames& names, std::string& desc )
+{
+    desc = ( val & 0x04 ) ? " Supports Computer Centric mode" : " Does not support Computer Centric mode";
+    desc += "; ";
+    desc += ( val & 0x02 ) ? "Supports Standalone mode" : "Does not support Standalone mode";
+    desc += "; ";
+    desc += ( val & 0x01 ) ? "Supports Simple mode" : "Does not support Simple mode";
+}
+
+static void FormatField_CDC_bmCapabilities_TelCallStateRep( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                            const USBFormatNames& names, std::string& desc )
+{
+    desc = ( val & 0x20 ) ? " Supports line state change notification." : " Does not support line state change notification";
+    desc += "; ";
+    desc = ( val & 0x10 ) ? "Can report DTMF digits input remotely over the telephone line"
+                          : "Cannot report DTMF digits input remotely over the telephone line";
+    desc += "; ";
+    desc = ( val & 0x08 ) ? "Reports only incoming ringing" : "Reports incoming distinctive ringing patterns";
+    desc += "; ";
+    desc += ( val & 0x04 ) ? "Reports caller ID information" : "Does not report caller ID";
+    desc += "; ";
+    desc += ( val & 0x02 ) ? "Reports ringback, busy, and fast busy states." : "Reports only dialing state";
+    desc += "; ";
+    desc += ( val & 0x01 ) ? "Reports interrupted dialtone in addition to normal dialtone" : "Reports only dialtone";
+}
+
+static void FormatField_CDC_bmOptions( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                       std::string& desc )
+{
+    desc = ( val & 0x01 ) ? " Wrapper used" : " No wrapper used";
+}
+
+static void FormatField_CDC_bPhysicalInterface( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                const USBFormatNames& names, std::string& desc )
+{
+    if( val == 0 )
+        desc = " None";
+    else if( val == 1 )
+        desc = " ISDN";
+    else if( val >= 2 && val <= 200 )
+        desc = " RESERVED";
+    else
+        desc = " Vendor specific";
+}
+
+static void FormatField_CDC_bProtocol( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                       std::string& desc )
+{
+    if( val == 0x00 )
+        desc = " No class specific protocol required";
+    else if( val == 0x30 )
+        desc = " Physical interface protocol for ISDN BRI";
+    else if( val == 0x31 )
+        desc = " HDLC";
+    else if( val == 0x32 )
+        desc = " Transparent";
+    else if( val == 0x50 )
+        desc = " Management protocol for Q.921 data link protocol";
+    else if( val == 0x51 )
+        desc = " Data link protocol for Q.931";
+    else if( val == 0x52 )
+        desc = " TEI-multiplexor for Q.921 data link protocol";
+    else if( val == 0x90 )
+        desc = " Data compression procedures";
+    else if( val == 0x91 )
+        desc = " Euro-ISDN protocol control";
+    else if( val == 0x92 )
+        desc = " V.24 rate adaptation to ISDN";
+    else if( val == 0x93 )
+        desc = " CAPI Commands";
+    else if( val == 0xfd )
+        desc = " Host based driver";
+    else if( val == 0xfe )
+        desc = " The protocol(s) are described using a Protocol Unit Functional Descriptors on Communication Class Interface.";
+    else if( val == 0xff )
+        desc = " Vendor-specific";
+    else
+        desc = " RESERVED";
+}
+
+static void FormatField_CDC_bmCapabilities_MultiChannel( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                         const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x04 )
+        desc = "Device supports the request Set_Unit_Parameter";
+    if( val & 0x02 )
+        desc += ( desc.empty() ? "" : "; " ) + std::string( "Device supports the request Clear_Unit_Parameter" );
+    if( val & 0x01 )
+        desc += ( desc.empty() ? "" : "; " ) + std::string( "Device stores Unit parameters in non-volatile memory" );
+    if( !desc.empty() )
+        desc = " " + desc;
+}
+
+static void FormatField_CDC_bmCapabilities_CAPIControl( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                        const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x01 )
+        desc = " Device is an Intelligent CAPI device";
+    else
+        desc = " Device is an Simple CAPI device";
+}
+
+static void FormatField_CDC_bmEthernetStatistics( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                  const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x00000001 )
+        desc = "XMIT_OK";
+    if( val & 0x00000002 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RVC_OK" );
+    if( val & 0x00000004 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_ERROR" );
+    if( val & 0x00000008 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RCV_ERROR" );
+    if( val & 0x00000010 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RCV_NO_BUFFER" );
+    if( val & 0x00000020 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "DIRECTED_BYTES_XMIT" );
+    if( val & 0x00000040 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "DIRECTED_FRAMES_XMIT" );
+    if( val & 0x00000080 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "MULTICAST_BYTES_XMIT" );
+    if( val & 0x00000100 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "MULTICAST_FRAMES_XMIT" );
+    if( val & 0x00000200 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "BROADCAST_BYTES_XMIT" );
+    if( val & 0x00000400 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "BROADCAST_FRAMES_XMIT" );
+    if( val & 0x00000800 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "DIRECTED_BYTES_RCV" );
+    if( val & 0x00001000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "DIRECTED_FRAMES_RCV" );
+    if( val & 0x00002000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "MULTICAST_BYTES_RCV" );
+    if( val & 0x00004000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "MULTICAST_FRAMES_RCV" );
+    if( val & 0x00008000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "BROADCAST_BYTES_RCV" );
+    if( val & 0x00010000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "BROADCAST_FRAMES_RCV" );
+    if( val & 0x00020000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RCV_CRC_ERROR" );
+    if( val & 0x00040000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "TRANSMIT_QUEUE_LENGTH" );
+    if( val & 0x00080000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RCV_ERROR_ALIGNMENT" );
+    if( val & 0x00100000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_ONE_COLLISION" );
+    if( val & 0x00200000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_MORE_COLLISIONS" );
+    if( val & 0x00400000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_DEFERRED" );
+    if( val & 0x00800000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_MAX_COLLISIONS" );
+    if( val & 0x01000000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "RCV_OVERRUN" );
+    if( val & 0x02000000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_UNDERRUN" );
+    if( val & 0x04000000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_HEARTBEAT_FAILURE" );
+    if( val & 0x08000000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_TIMES_CRS_LOST" );
+    if( val & 0x10000000 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "XMIT_LATE_COLLISIONS" );
+
+    if( !desc.empty() )
+        desc = " " + desc;
+}
+
+static void FormatField_CDC_wNumberMCFilters( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                              const USBFormatNames& names, std::string& desc )
+{
+    desc = " Number of multicase filters=" + int2str( val & 0x7fff ) + "; ";
+    if( val & 0x8000 )
+        desc += "The device uses imperfect multicast address filtering (hashing)";
+    else
+        desc += "The device performs perfect multicast address filtering (no hashing)";
+}
+
+static void FormatField_CDC_bmDataCapabilities( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x08 )
+        desc = "Type 3 - AAL5 SDU";
+    if( val & 0x04 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "Type 2 - ATM header template + concatenated ATM cell payloads" );
+    if( val & 0x02 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "Type 1 - Concatenated ATM cells" );
+
+    if( !desc.empty() )
+        desc = " " + desc;
+}
+
+static void FormatField_CDC_bmATMDeviceStatistics( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                   const USBFormatNames& names, std::string& desc )
+{
+    if( val & 0x10 )
+        desc = "Device counts upstream cells sent on a per VC basis (VC_US_CELLS_SENT)";
+    if( val & 0x08 )
+        desc += ( desc.empty() ? "" : ", " ) +
+                std::string( "Device counts downstream cells received on a per VC basis (VC_DS_CELLS_RECEIVED)" );
+    if( val & 0x04 )
+        desc += ( desc.empty() ? "" : ", " ) +
+                std::string( "Device counts cells with HEC error detected and corrected (DS_CELLS_HEC_ERROR_CORRECTED)" );
+    if( val & 0x02 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "Device counts upstream cells sent (US_CELLS_SENT)" );
+    if( val & 0x01 )
+        desc += ( desc.empty() ? "" : ", " ) + std::string( "Device counts downstream cells received (DS_CELLS_RECEIVED)" );
+
+    if( !desc.empty() )
+        desc = " " + desc;
+}
+
+static void FormatField_CDC_Data_AbstractState( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    desc += ( val & 0x02 ) ? "Enables multiplexing" : "Disables multiplexing";
+    desc += "; ";
+    desc += ( val & 0x01 ) ? "All of the endpoints in this interface will not accept data from the host or offer data to the host"
+                           : "The endpoints in this interface will continue to accept/offer data";
+}
+
+static void FormatField_CDC_Data_CountrySetting( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                                 const USBFormatNames& names, std::string& desc )
+{
+    desc = " Country code";
+}
+
+static void FormatField_CDC_dwDTERate( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                       std::string& desc )
+{
+    desc = " " + int2str( val ) + " bps";
+}
+
+static void FormatField_CDC_bCharFormat( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    if( val == 0 )
+        desc = " 1 Stop Bit";
+    else if( val == 1 )
+        desc = " 1.5 Stop Bits";
+    else if( val == 2 )
+        desc = " 2 Stop Bits";
+}
+
+static void FormatField_CDC_bParityType( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    if( val == 0 )
+        desc = " None";
+    else if( val == 1 )
+        desc = " Odd";
+    else if( val == 2 )
+        desc = " Even";
+    else if( val == 3 )
+        desc = " Mark";
+    else if( val == 4 )
+        desc = " Space";
+}
+
+static void FormatField_CDC_bDataBits( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                       std::string& desc )
+{
+    desc = " " + int2str( val ) + " bits";
+}
+
+static void FormatField_CDC_dwRingerBitmap( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base,
+                                            const USBFormatNames& names, std::string& desc )
+{
+    desc = " ";
+    if( val & 0x80000000UL )
+    {
+        desc += int2str_sal( ( val >> 8 ) & 0xff, display_base, 8 ) + " ringer volume; ";
+        desc += int2str_sal( val & 0xff, display_base, 8 ) + " ringer pattern";
+    }
+    else
+    {
+        desc += "A ringer does not exist";
+    }
+}
+
+static void FormatField_CDC_dwLineState( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    desc = " ";
+    if( val & 0x80000000UL )
+        desc += "Line is active";
+    else
+        desc += "No activity on the line";
+
+    if( ( val & 0xff ) == 0xff )
+        desc += "; No call exists on the line";
+    else
+        desc += "; Active call is " + int2str_sal( val & 0xff, display_base, 8 );
+}
+
+static void FormatField_CDC_dwCallState( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                         std::string& desc )
+{
+    desc = " ";
+    if( val & 0x80000000UL )
+        desc += "No active call";
+    else
+        desc += "Call is active";
+
+    desc += "; ";
+
+    U8 callStateValue = val & 0xff;
+    if( callStateValue == 0 )
+        desc += "Call is idle";
+    else if( callStateValue == 1 )
+        desc += "Typical dial tone";
+    else if( callStateValue == 2 )
+        desc += "Interrupted dial tone";
+    else if( callStateValue == 3 )
+        desc += "Dialing is in progress";
+    else if( callStateValue == 4 )
+        desc += "Ringback";
+    else if( callStateValue == 5 )
+        desc += "Connected";
+    else if( callStateValue == 6 )
+        desc += "Incoming call";
+
+    desc += "; ";
+
+    U8 callStateChange = ( val >> 8 ) & 0xff;
+    if( callStateChange == 1 )
+        desc += "Call has become idle";
+    else if( callStateChange == 2 )
+        desc += "Dialing";
+    else if( callStateChange == 3 )
+        desc += "Ringback";
+    else if( callStateChange == 4 )
+        desc += "Connected";
+    else if( callStateChange == 5 )
+        desc += "Incomming call";
+}
+
+static void GetCtrlTransFrameDesc( const USBFrame& frm, USBDisplayBase display_base, std::vector<std::string>& results,
+                                   const USBFormatNames& names )
+{
+    const USBCtrlTransFieldFrame& f( static_cast<const USBCtrlTransFieldFrame&>( frm ) );
+
+    // create value string for the general case
+    U16 bcnt = f.GetNumBytes();
+    U32 val = f.GetData();
+    std::string val_str = int2str_sal( val, display_base, bcnt * 8 );
+
+    // handle details for specific fields
+    std::string desc;
+    USBFieldFormatter formatter = GetFieldFormatter( f.GetFormatter() );
+    if( formatter != NULL )
+        formatter( f, val, display_base, names, desc );
+
+    const char* fieldName = f.GetFieldName();
+    const char* isIncomplete = ( f.mFlags & 0x3F ) == FF_FieldIncomplete ? " (incomplete)" : "";
+
+    results.push_back( fieldName + std::string( "=" ) + val_str + desc + isIncomplete );
+    results.push_back( fieldName + std::string( "=" ) + val_str );
+    results.push_back( fieldName + desc );
+    results.push_back( fieldName );
+    results.push_back( val_str );
+    results.push_back( desc );
+}
+
+// frame formatters: they make the bubble text strings for each type of analyzer frame, longest first
+
+static void FormatFrame_Signal( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                const USBFormatNames& names )
+{
+    std::string result;
+    if( f.mData1 == S_J )
+        result = "J";
+    else if( f.mData1 == S_K )
+        result = "K";
+    else if( f.mData1 == S_SE0 )
+        result = "SE0";
+    else if( f.mData1 == S_SE1 )
+        result = "SE1";
+
+    results.push_back( result );
+}
+
+static void FormatFrame_EOP( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                             const USBFormatNames& names )
+{
+    results.push_back( "EOP" );
+}
+
+static void FormatFrame_Reset( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                               const USBFormatNames& names )
+{
+    results.push_back( "Reset" );
+}
+
+static void FormatFrame_Idle( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                              const USBFormatNames& names )
+{
+    results.push_back( "Idle" );
+}
+
+static void FormatFrame_SYNC( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                              const USBFormatNames& names )
+{
+    results.push_back( "SYNC" );
+}
+
+static void FormatFrame_PID( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                             const USBFormatNames& names )
+{
+    results.push_back( std::string( "PID " ) + GetPIDName( USB_PID( f.mData1 ) ) );
+    results.push_back( GetPIDName( USB_PID( f.mData1 ) ) );
+}
+
+static void FormatFrame_FrameNum( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                  const USBFormatNames& names )
+{
+    results.push_back( "Frame # " + int2str_sal( f.mData1, display_base, 11 ) );
+    results.push_back( "F # " + int2str_sal( f.mData1, display_base, 11 ) );
+    results.push_back( "Frame #" );
+    results.push_back( int2str_sal( f.mData1, display_base, 11 ) );
+}
+
+static void FormatFrame_AddrEndp( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                  const USBFormatNames& names )
+{
+    results.push_back( "Address=" + int2str_sal( f.mData1, display_base, 7 ) +
+                       " Endpoint=" + int2str_sal( f.mData2, display_base, 5 ) );
+    results.push_back( "Addr=" + int2str_sal( f.mData1, display_base, 7 ) + " Endp=" + int2str_sal( f.mData2, display_base, 5 ) );
+    results.push_back( "A:" + int2str_sal( f.mData1, display_base, 7 ) + " E:" + int2str_sal( f.mData2, display_base, 5 ) );
+    results.push_back( int2str_sal( f.mData1, display_base, 7 ) + " " + int2str_sal( f.mData2, display_base, 5 ) );
+}
+
+static void FormatFrame_Byte( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                              const USBFormatNames& names )
+{
+    results.push_back( "Byte " + int2str_sal( f.mData1, display_base, 8 ) );
+    results.push_back( int2str_sal( f.mData1, display_base, 8 ) );
+}
+
+static void FormatFrame_KeepAlive( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                   const USBFormatNames& names )
+{
+    results.push_back( "Keep alive" );
+    results.push_back( "KA" );
+}
+
+static void FormatFrame_CRC( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                             const USBFormatNames& names )
+{
+    const int num_bits = f.mType == FT_CRC5 ? 5 : 16;
+    results.push_back( "CRC" );
+    if( f.mData1 == f.mData2 )
+    {
+        results.push_back( "CRC OK " + int2str_sal( f.mData1, display_base, num_bits ) );
+        results.push_back( "CRC OK" );
+    }
+    else
+    {
+        results.push_back( "CRC Bad! Rcvd: " + int2str_sal( f.mData1, display_base, num_bits ) +
+                           " Calc: " + int2str_sal( f.mData2, display_base, num_bits ) );
+        results.push_back( "CRC Bad! Rcvd: " + int2str_sal( f.mData1, display_base, num_bits ) );
+        results.push_back( "CRC Bad" );
+    }
+
+    results.push_back( int2str_sal( f.mData1, display_base, num_bits ) );
+}
+
+static void FormatFrame_Error( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                               const USBFormatNames& names )
+{
+    results.push_back( "Error packet" );
+    results.push_back( "Error" );
+    results.push_back( "Err" );
+    results.push_back( "E" );
+}
+
+static void FormatFrame_HIDReportDescriptorItem( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                                 const USBFormatNames& names )
+{
+    GetHIDReportDescriptorItemFrameDesc( f, display_base, results, names.mpUsbIds );
+}
+
+static void FormatFrame_HIDReportField( const USBFrame& frm, USBDisplayBase display_base, std::vector<std::string>& results,
+                                        const USBFormatNames& names )
+{
+    const USBHidReportFieldFrame& f( static_cast<const USBHidReportFieldFrame&>( frm ) );
+
+    std::string value;
+    if( f.IsSigned() && display_base == DB_Decimal )
+    {
+        char buff[ 16 ];
+        snprintf( buff, sizeof( buff ), "%d", S32( f.GetValue() ) );
+        value = buff;
+    }
+    else
+    {
+        value = int2str_sal( f.GetValue(), display_base, f.GetBitSize() );
+    }
+
+    char buff[ 128 ];
+    const bool hasUsage = f.GetUsagePage() != 0 || f.GetUsageID() != 0;
+    switch( f.GetKind() )
+    {
+    case HRF_ReportID:
+        results.push_back( "Report ID " + value );
+        break;
+    case HRF_Variable:
+        if( hasUsage )
+            results.push_back( std::string( GetHIDUsageName( f.GetUsagePage(), f.GetUsageID(), names.mpUsbIds, buff, sizeof( buff ) ) ) +
+                               ": " + value );
+        else
+            results.push_back( "Field " + value );
+        break;
+    case HRF_Array:
+        // the value is an index into the usages of the array
+        results.push_back( hasUsage ? GetHIDUsageName( f.GetUsagePage(), f.GetUsageID(), names.mpUsbIds, buff, sizeof( buff ) ) : "None" );
+        break;
+    case HRF_Constant:
+        results.push_back( "Padding " + value );
+        break;
+    default:
+        results.push_back( "Data " + value );
+        break;
+    }
+
+    results.push_back( value );
+}
+
+// the formatter registry
+struct USBFormatterTables
+{
+    USBFrameFormatter mFrame[ FT_Count ];
+    U8 mTabularString[ FT_Count ]; // which of the bubble strings goes to the tabular view
+    USBFieldFormatter mField[ Fld_Count ];
+
+    USBFormatterTables();
+};
+
+USBFormatterTables::USBFormatterTables()
+{
+    memset( mFrame, 0, sizeof mFrame );
+    memset( mTabularString, 0, sizeof mTabularString );
+    memset( mField, 0, sizeof mField );
+
+    mField[ Fld_bRequest_Standard ] = FormatField_bRequest_Standard;
+    mField[ Fld_bRequest_Class ] = FormatField_bRequest_Class;
+    mField[ Fld_bRequest_HID ] = FormatField_bRequest_HID;
+    mField[ Fld_bRequest_CDC ] = FormatField_bRequest_CDC;
+    mField[ Fld_bRequest_Vendor ] = FormatField_bRequest_Vendor;
+    mField[ Fld_bmRequestType ] = FormatField_bmRequestType;
+    mField[ Fld_bmRequestType_NoData ] = FormatField_bmRequestType;
+    mField[ Fld_wValue_Address ] = FormatField_wValue_Address;
+    mField[ Fld_wValue_Descriptor ] = FormatField_wValue_Descriptor;
+    mField[ Fld_wValue_HIDSetIdle ] = FormatField_wValue_HIDSetIdle;
+    mField[ Fld_wValue_HIDGetIdle ] = FormatField_wValue_HIDGetIdle;
+    mField[ Fld_wValue_HIDSetProtocol ] = FormatField_wValue_HIDSetProtocol;
+    mField[ Fld_wValue_HIDGetSetReport ] = FormatField_wValue_HIDGetSetReport;
+    mField[ Fld_bDescriptorType ] = FormatField_bDescriptorType;
+    mField[ Fld_bDescriptorType_Other ] = FormatField_bDescriptorType_Other;
+    mField[ Fld_Wchar ] = FormatField_Wchar;
+    mField[ Fld_wLANGID ] = FormatField_wLANGID;
+    mField[ Fld_wVendorId ] = FormatField_wVendorId;
+    mField[ Fld_bMaxPower ] = FormatField_bMaxPower;
+    mField[ Fld_bmAttributes_Endpoint ] = FormatField_bmAttributes_Endpoint;
+    mField[ Fld_bmAttributes_Config ] = FormatField_bmAttributes_Config;
+    mField[ Fld_bEndpointAddress ] = FormatField_bEndpointAddress;
+    mField[ Fld_wIndex_Endpoint ] = FormatField_bEndpointAddress;
+    mField[ Fld_BCD ] = FormatField_BCD;
+    mField[ Fld_ClassCode ] = FormatField_ClassCode;
+    mField[ Fld_HIDSubClass ] = FormatField_HIDSubClass;
+    mField[ Fld_HIDProtocol ] = FormatField_HIDProtocol;
+    mField[ Fld_wIndex_InterfaceNum ] = FormatField_wIndex_InterfaceNum;
+    mField[ Fld_HID_bCountryCode ] = FormatField_HID_bCountryCode;
+    mField[ Fld_String ] = FormatField_String;
+    mField[ Fld_CDC_wValue_CommFeatureSelector ] = FormatField_CDC_wValue_CommFeatureSelector;
+    mField[ Fld_CDC_wValue_DisconnectConnect ] = FormatField_CDC_wValue_DisconnectConnect;
+    mField[ Fld_CDC_wValue_RelayConfig ] = FormatField_CDC_wValue_RelayConfig;
+    mField[ Fld_CDC_wValue_EnableDisable ] = FormatField_CDC_wValue_EnableDisable;
+    mField[ Fld_CDC_wValue_Cycles ] = FormatField_CDC_wValue_Cycles;
+    mField[ Fld_CDC_wValue_Timing ] = FormatField_CDC_wValue_Timing;
+    mField[ Fld_CDC_wValue_NumberOfRings ] = FormatField_CDC_wValue_NumberOfRings;
+    mField[ Fld_CDC_wValue_ControlSignalBitmap ] = FormatField_CDC_wValue_ControlSignalBitmap;
+    mField[ Fld_CDC_wValue_DurationOfBreak ] = FormatField_CDC_wValue_DurationOfBreak;
+    mField[ Fld_CDC_wValue_OperationParms ] = FormatField_CDC_wValue_OperationParms;
+    mField[ Fld_CDC_OperationMode ] = FormatField_CDC_wValue_OperationParms;
+    mField[ Fld_CDC_wValue_LineStateChange ] = FormatField_CDC_wValue_LineStateChange;
+    mField[ Fld_CDC_wValue_UnitParameterStructure ] = FormatField_CDC_wValue_UnitParameterStructure;
+    mField[ Fld_CDC_wValue_NumberOfFilters ] = FormatField_CDC_wValue_NumberOfFilters;
+    mField[ Fld_CDC_wValue_FilterNumber ] = FormatField_CDC_wValue_FilterNumber;
+    mField[ Fld_CDC_wValue_PacketFilterBitmap ] = FormatField_CDC_wValue_PacketFilterBitmap;
+    mField[ Fld_CDC_wValue_EthFeatureSelector ] = FormatField_CDC_wValue_EthFeatureSelector;
+    mField[ Fld_CDC_wValue_ATMDataFormat ] = FormatField_CDC_wValue_ATMDataFormat;
+    mField[ Fld_CDC_wValue_ATMFeatureSelector ] = FormatField_CDC_wValue_ATMFeatureSelector;
+    mField[ Fld_CDC_wValue_ATMVCFeatureSelector ] = FormatField_CDC_wValue_ATMVCFeatureSelector;
+    mField[ Fld_CDC_DescriptorSubtype ] = FormatField_CDC_DescriptorSubtype;
+    mField[ Fld_CDC_bmCapabilities_Call ] = FormatField_CDC_bmCapabilities_Call;
+    mField[ Fld_CDC_bmCapabilities_AbstractCtrl ] = FormatField_CDC_bmCapabilities_AbstractCtrl;
+    mField[ Fld_CDC_bmCapabilities_DataLine ] = FormatField_CDC_bmCapabilities_DataLine;
+    mField[ Fld_CDC_bRingerVolSteps ] = FormatField_CDC_bRingerVolSteps;
+    mField[ Fld_CDC_bmCapabilities_TelOpModes ] = FormatField_CDC_bmCapabilities_TelOpModes;
+    mField[ Fld_CDC_bmCapabilities_TelCallStateRep ] = FormatField_CDC_bmCapabilities_TelCallStateRep;
+    mField[ Fld_CDC_bmOptions ] = FormatField_CDC_bmOptions;
+    mField[ Fld_CDC_bPhysicalInterface ] = FormatField_CDC_bPhysicalInterface;
+    mField[ Fld_CDC_bProtocol ] = FormatField_CDC_bProtocol;
+    mField[ Fld_CDC_bmCapabilities_MultiChannel ] = FormatField_CDC_bmCapabilities_MultiChannel;
+    mField[ Fld_CDC_bmCapabilities_CAPIControl ] = FormatField_CDC_bmCapabilities_CAPIControl;
+    mField[ Fld_CDC_bmEthernetStatistics ] = FormatField_CDC_bmEthernetStatistics;
+    mField[ Fld_CDC_wNumberMCFilters ] = FormatField_CDC_wNumberMCFilters;
+    mField[ Fld_CDC_bmDataCapabilities ] = FormatField_CDC_bmDataCapabilities;
+    mField[ Fld_CDC_bmATMDeviceStatistics ] = FormatField_CDC_bmATMDeviceStatistics;
+    mField[ Fld_CDC_Data_AbstractState ] = FormatField_CDC_Data_AbstractState;
+    mField[ Fld_CDC_Data_CountrySetting ] = FormatField_CDC_Data_CountrySetting;
+    mField[ Fld_CDC_dwDTERate ] = FormatField_CDC_dwDTERate;
+    mField[ Fld_CDC_bCharFormat ] = FormatField_CDC_bCharFormat;
+    mField[ Fld_CDC_bParityType ] = FormatField_CDC_bParityType;
+    mField[ Fld_CDC_bDataBits ] = FormatField_CDC_bDataBits;
+    mField[ Fld_CDC_dwRingerBitmap ] = FormatField_CDC_dwRingerBitmap;
+    mField[ Fld_CDC_dwLineState ] = FormatField_CDC_dwLineState;
+    mField[ Fld_CDC_dwCallState ] = FormatField_CDC_dwCallState;
+
+    mFrame[ FT_Signal ] = FormatFrame_Signal;
+    mFrame[ FT_EOP ] = FormatFrame_EOP;
+    mFrame[ FT_Reset ] = FormatFrame_Reset;
+    mFrame[ FT_Idle ] = FormatFrame_Idle;
+    mFrame[ FT_SYNC ] = FormatFrame_SYNC;
+    mFrame[ FT_PID ] = FormatFrame_PID;
+    mFrame[ FT_FrameNum ] = FormatFrame_FrameNum;
+    mFrame[ FT_AddrEndp ] = FormatFrame_AddrEndp;
+    mFrame[ FT_Byte ] = FormatFrame_Byte;
+    mFrame[ FT_KeepAlive ] = FormatFrame_KeepAlive;
+    mFrame[ FT_CRC5 ] = FormatFrame_CRC;
+    mFrame[ FT_CRC16 ] = FormatFrame_CRC;
+    mFrame[ FT_Error ] = FormatFrame_Error;
+    mFrame[ FT_ControlTransferField ] = GetCtrlTransFrameDesc;
+    mFrame[ FT_HIDReportDescriptorItem ] = FormatFrame_HIDReportDescriptorItem;
+    mFrame[ FT_HIDReportField ] = FormatFrame_HIDReportField;
+
+    // the first CRC bubble string is just "CRC"
+    mTabularString[ FT_CRC5 ] = mTabularString[ FT_CRC16 ] = 1;
+}
+
+static const USBFormatterTables& GetFormatterTables()
+{
+    static const USBFormatterTables tables;
+    return tables;
+}
+
+USBFrameFormatter GetFrameFormatter( U8 frameType )
+{
+    return frameType < FT_Count ? GetFormatterTables().mFrame[ frameType ] : NULL;
+}
+
+USBFieldFormatter GetFieldFormatter( USBCtrlTransFieldType fieldType )
+{
+    return fieldType < Fld_Count ? GetFormatterTables().mField[ fieldType ] : NULL;
+}
+
+void GetFrameDesc( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results, const USBFormatNames& names )
+{
+    results.clear();
+
+    USBFrameFormatter formatter = GetFrameFormatter( f.mType );
+    if( formatter != NULL )
+        formatter( f, display_base, results, names );
+}
+
+std::string GetFrameTabularDesc( const USBFrame& f, USBDisplayBase display_base, const USBFormatNames& names )
+{
+    std::vector<std::string> results;
+    GetFrameDesc( f, display_base, results, names );
+
+    size_t ndx = f.mType < FT_Count ? GetFormatterTables().mTabularString[ f.mType ] : 0;
+    if( ndx < results.size() )
+        return results[ ndx ];
+
+    return std::string();
+}
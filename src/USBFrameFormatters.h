@@ -0,0 +1,49 @@
+#ifndef USB_FRAME_FORMATTERS_H
+#define USB_FRAME_FORMATTERS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+
+class USBCtrlTransFieldFrame;
+class USBIdsDatabase;
+
+// string descriptors by (device address, string index)
+typedef std::map<std::pair<U8, U8>, std::string> USBStringDescriptorMap;
+
+// the names the formatters take from the analyzer: the string descriptors the devices returned, and the
+// usb.ids file of its settings, if there is one
+struct USBFormatNames
+{
+    USBFormatNames( const USBStringDescriptorMap& stringDescriptors, USBIdsDatabase* pUsbIds = NULL )
+        : mStringDescriptors( stringDescriptors ), mpUsbIds( pUsbIds )
+    {
+    }
+
+    const USBStringDescriptorMap& mStringDescriptors;
+    USBIdsDatabase* mpUsbIds;
+};
+
+// makes the bubble text strings for a frame, longest first
+typedef void ( *USBFrameFormatter )( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results,
+                                     const USBFormatNames& names );
+
+// makes the description that follows the value of a control transfer field, e.g. " Endpoint=1, Direction=IN"
+typedef void ( *USBFieldFormatter )( const USBCtrlTransFieldFrame& f, U32 val, USBDisplayBase display_base, const USBFormatNames& names,
+                                     std::string& desc );
+
+// the formatter registry - tables indexed by USBFrameTypes and USBCtrlTransFieldType
+// these return NULL for types without a formatter
+USBFrameFormatter GetFrameFormatter( U8 frameType );
+USBFieldFormatter GetFieldFormatter( USBCtrlTransFieldType fieldType );
+
+// bubble text strings for the frame
+void GetFrameDesc( const USBFrame& f, USBDisplayBase display_base, std::vector<std::string>& results, const USBFormatNames& names );
+
+// the one string for the frame in the tabular view, or empty if there is none
+std::string GetFrameTabularDesc( const USBFrame& f, USBDisplayBase display_base, const USBFormatNames& names );
+
+#endif // USB_FRAME_FORMATTERS_H
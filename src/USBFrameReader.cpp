@@ -0,0 +1,166 @@
+#include "USBFrameReader.h"
+#include "USBControlTransfers.h"
+#include "USBHidReports.h"
+
+void USBFramePacketReader::Clear()
+{
+    mPacket.Clear();
+    mInPacket = false;
+    mHasPID = false;
+    mPIDFlags = FF_None;
+    mCRCStatus = CRCS_None;
+    mFieldBytesDone = 0;
+    mReportBits = 0;
+    mNumReportBits = 0;
+}
+
+void USBFramePacketReader::StartPacket( const USBFrame& f )
+{
+    mPacket.Clear();
+    mPacket.mSampleBegin = f.mStartingSampleInclusive;
+    mInPacket = true;
+    mHasPID = false;
+    mPIDFlags = FF_None;
+    mCRCStatus = CRCS_None;
+    mReportBits = 0;
+    mNumReportBits = 0;
+}
+
+USBFramePacketReader::FrameResult USBFramePacketReader::EndPacket( S64 sampleEnd )
+{
+    mInPacket = false;
+    mPacket.mSampleEnd = sampleEnd;
+
+    // in the Bytes decode level we only have the raw bytes, so get the PID and CRC from them
+    if( !mHasPID )
+    {
+        if( mPacket.mData.size() < 2 )
+            return FR_None;
+
+        mPacket.mPID = USB_PID( mPacket.mData[ 1 ] );
+        if( mPacket.IsDataPacket() && mPacket.mData.size() >= 4 )
+        {
+            mPacket.mCRC = mPacket.GetLastWord();
+            mCRCStatus = mPacket.mCRC == mPacket.CalcCRC16() ? CRCS_OK : CRCS_Bad;
+        }
+        else if( ( mPacket.IsTokenPacket() || mPacket.IsSOFPacket() ) && mPacket.mData.size() == 4 )
+        {
+            mPacket.mCRC = mPacket.GetLastWord() >> 11;
+            mCRCStatus = mPacket.mCRC == USBPacket::CalcCRC5( mPacket.GetLastWord() & 0x7ff ) ? CRCS_OK : CRCS_Bad;
+        }
+    }
+
+    return FR_Packet;
+}
+
+void USBFramePacketReader::AddPayload( U32 data, int numBytes )
+{
+    for( int bc = 0; bc < numBytes; ++bc )
+        mPacket.mData.push_back( U8( data >> ( bc * 8 ) ) );
+}
+
+void USBFramePacketReader::AddWord( U16 word )
+{
+    mPacket.mData.push_back( U8( word ) );
+    mPacket.mData.push_back( U8( word >> 8 ) );
+}
+
+USBFramePacketReader::FrameResult USBFramePacketReader::AddFrame( const USBFrame& f )
+{
+    if( f.mType == FT_SYNC )
+    {
+        StartPacket( f );
+        mPacket.mData.push_back( 0x80 );
+    }
+    else if( f.mType == FT_PID && mInPacket )
+    {
+        mPacket.mPID = USB_PID( f.mData1 );
+        mPacket.mData.push_back( U8( f.mData1 ) );
+        mHasPID = true;
+        mPIDFlags = f.mFlags & 0x3F;
+
+        // PRE packets don't have an EOP
+        if( mPacket.mPID == PID_PRE )
+            return EndPacket( f.mEndingSampleInclusive );
+    }
+    else if( f.mType == FT_AddrEndp || f.mType == FT_FrameNum )
+    {
+        // keep the address/endpoint or frame number until we get the CRC5
+        mPacket.mCRC = f.mType == FT_AddrEndp ? ( ( f.mData2 & 0xf ) << 7 ) | ( f.mData1 & 0x7f ) : ( f.mData1 & 0x7ff );
+    }
+    else if( f.mType == FT_CRC5 )
+    {
+        AddWord( U16( ( f.mData1 << 11 ) | mPacket.mCRC ) );
+        mPacket.mCRC = U16( f.mData1 );
+        mCRCStatus = f.mData1 == f.mData2 ? CRCS_OK : CRCS_Bad;
+    }
+    else if( f.mType == FT_CRC16 )
+    {
+        AddWord( U16( f.mData1 ) );
+        mPacket.mCRC = U16( f.mData1 );
+        mCRCStatus = f.mData1 == f.mData2 ? CRCS_OK : CRCS_Bad;
+    }
+    else if( f.mType == FT_Byte )
+    {
+        // no SYNC frames in the Bytes decode level
+        if( !mInPacket )
+            StartPacket( f );
+
+        mPacket.mData.push_back( U8( f.mData1 ) );
+    }
+    else if( f.mType == FT_ControlTransferField && mInPacket )
+    {
+        const USBCtrlTransFieldFrame& fld( static_cast<const USBCtrlTransFieldFrame&>( f ) );
+
+        if( ( f.mFlags & 0x3F ) == FF_SetupBegin || fld.GetNumBytes() <= mFieldBytesDone )
+            mFieldBytesDone = 0;
+
+        // a field that spans two packets has an incomplete frame with the bytes so far in the first packet,
+        // and a frame with the entire field value in the next one, so skip the bytes we already have
+        AddPayload( fld.GetData() >> ( mFieldBytesDone * 8 ), fld.GetNumBytes() - mFieldBytesDone );
+        mFieldBytesDone = ( f.mFlags & 0x3F ) == FF_FieldIncomplete ? fld.GetNumBytes() : 0;
+    }
+    else if( f.mType == FT_HIDReportDescriptorItem && mInPacket )
+    {
+        const USBHidRepDescItemFrame& item( static_cast<const USBHidRepDescItemFrame&>( f ) );
+        const U8* pItem = item.GetItem();
+
+        // the same goes for HID items
+        const bool isIncomplete = ( f.mFlags & 0x3F ) == FF_FieldIncomplete;
+        const U8 numBytes = isIncomplete ? item.GetNumIncompleteBytes() : U8( GetNumHIDItemDataBytes( pItem[ 0 ] ) + 1 );
+        if( numBytes <= mFieldBytesDone )
+            mFieldBytesDone = 0;
+
+        mPacket.mData.insert( mPacket.mData.end(), pItem + mFieldBytesDone, pItem + numBytes );
+        mFieldBytesDone = isIncomplete ? numBytes : 0;
+    }
+    else if( f.mType == FT_HIDReportField && mInPacket )
+    {
+        const USBHidReportFieldFrame& fld( static_cast<const USBHidReportFieldFrame&>( f ) );
+
+        // the fields are not byte aligned, but they cover all the payload bits in order
+        const int bitSize = fld.GetBitSize();
+        mReportBits |= U64( fld.GetValue() & ( 0xffffffff >> ( 32 - bitSize ) ) ) << mNumReportBits;
+        for( mNumReportBits += bitSize; mNumReportBits >= 8; mNumReportBits -= 8 )
+        {
+            mPacket.mData.push_back( U8( mReportBits ) );
+            mReportBits >>= 8;
+        }
+    }
+    else if( f.mType == FT_EOP && mInPacket )
+    {
+        return EndPacket( f.mEndingSampleInclusive );
+    }
+    else if( f.mType == FT_Reset )
+    {
+        Clear();
+        return FR_Reset;
+    }
+    else if( f.mType == FT_Error )
+    {
+        Clear();
+        return FR_Error;
+    }
+
+    return FR_None;
+}
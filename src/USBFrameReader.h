@@ -0,0 +1,65 @@
+#ifndef USB_FRAME_READER_H
+#define USB_FRAME_READER_H
+
+#include "USBCoreTypes.h"
+#include "USBTypes.h"
+
+// Rebuilds USB packets from the committed analyzer frames, so exporters can work on packets
+// instead of frames. Works with the frames of the Packets, Bytes and Control transfers decode levels.
+// Frames must be fed in order; the reader never looks back.
+class USBFramePacketReader
+{
+  public:
+    enum FrameResult
+    {
+        FR_None,   // nothing complete yet
+        FR_Packet, // a packet is complete - see GetPacket()
+        FR_Reset,  // USB reset on the bus
+        FR_Error,  // the analyzer could not decode a packet
+    };
+
+    USBFramePacketReader()
+    {
+        Clear();
+    }
+
+    void Clear();
+
+    FrameResult AddFrame( const USBFrame& f );
+
+    // the rebuilt packet: mData holds SYNC, PID, payload and CRC just like a freshly decoded packet,
+    // but mBitBeginSamples is empty
+    const USBPacket& GetPacket() const
+    {
+        return mPacket;
+    }
+
+    // the flags the control transfer handler put on the PID frame of this packet
+    U8 GetPIDFlags() const
+    {
+        return mPIDFlags;
+    }
+
+    USBCRCStatus GetCRCStatus() const
+    {
+        return mCRCStatus;
+    }
+
+  private:
+    USBPacket mPacket;
+    bool mInPacket;
+    bool mHasPID; // false in the Bytes decode level where the PID is only a raw byte
+    U8 mPIDFlags;
+    USBCRCStatus mCRCStatus;
+    U8 mFieldBytesDone; // bytes of a split control transfer field or HID item already taken from the previous packet
+    U64 mReportBits;    // the bits of the HID report fields which don't make a whole byte yet
+    int mNumReportBits;
+
+    void StartPacket( const USBFrame& f );
+    FrameResult EndPacket( S64 sampleEnd );
+
+    void AddPayload( U32 data, int numBytes );
+    void AddWord( U16 word );
+};
+
+#endif // USB_FRAME_READER_H
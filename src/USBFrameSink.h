@@ -0,0 +1,46 @@
+#ifndef USB_FRAME_SINK_H
+#define USB_FRAME_SINK_H
+
+#include <string>
+
+#include "USBCoreTypes.h"
+
+// Where the decoder puts its output. The plugin passes the frames on to the analyzer results; other users
+// can keep them, count them or drop them. Only AddFrame is required.
+class USBFrameSink
+{
+  public:
+    virtual ~USBFrameSink()
+    {
+    }
+
+    // the frames come in sample order and don't overlap
+    virtual void AddFrame( const USBFrame& f ) = 0;
+
+    // the frames added so far are complete and can be shown
+    virtual void CommitFrames()
+    {
+    }
+
+    // the middle of a bit of a packet, marked as a zero, a one or a stuff bit
+    virtual void AddBitMarker( U64 /* sample */, USBBitMarker /* markerType */ )
+    {
+    }
+
+    // a string descriptor the device at the address returned
+    virtual void AddStringDescriptor( int /* addr */, int /* id */, const std::string& /* stringDesc */ )
+    {
+    }
+
+    // the device moved to another address, and keeps its string descriptors
+    virtual void CopyStringDescriptors( int /* fromAddr */, int /* toAddr */ )
+    {
+    }
+
+    // the decoder got up to this sample
+    virtual void ReportProgress( U64 /* sample */ )
+    {
+    }
+};
+
+#endif // USB_FRAME_SINK_H
@@ -0,0 +1,406 @@
+#include <string.h>
+#include <algorithm>
+
+#include "USBHidReports.h"
+#include "USBTypes.h"
+#include "USBFrameSink.h"
+#include "USBControlTransfers.h"
+
+// the limits that keep a broken descriptor from making huge layouts
+const U32 MAX_REPORT_BITS = 0xffff; // the bit offsets are 16 bit
+const size_t MAX_LAYOUT_FIELDS = 8192;
+
+// the global items, which are saved and restored with Push and Pop
+struct USBHidReportLayout::GlobalItems
+{
+    U16 usagePage;
+    S32 logicalMin;
+    S32 logicalMax;
+    U32 reportSize;
+    U32 reportCount;
+    U8 reportID;
+};
+
+// the local items, which only apply to the next main item
+struct USBHidReportLayout::LocalItems
+{
+    std::vector<U32> usages; // usage page << 16 | usage ID
+    U32 usageMin;
+    U32 usageMax;
+    bool hasUsageMin;
+    bool hasUsageMax;
+
+    void Clear()
+    {
+        usages.clear();
+        usageMin = usageMax = 0;
+        hasUsageMin = hasUsageMax = false;
+    }
+};
+
+static U32 GetItemData( const U8* pItem, int numBytes )
+{
+    U32 data = 0;
+    for( int bc = 0; bc < numBytes; ++bc )
+        data |= U32( pItem[ 1 + bc ] ) << ( bc * 8 );
+
+    return data;
+}
+
+static S32 GetSignedItemData( const U8* pItem, int numBytes )
+{
+    const U32 data = GetItemData( pItem, numBytes );
+    const int shift = 32 - numBytes * 8;
+
+    return numBytes != 0 ? S32( data << shift ) >> shift : 0;
+}
+
+USBHidReportLayout::USBHidReportLayout()
+{
+    Clear();
+}
+
+void USBHidReportLayout::Clear()
+{
+    mReports.clear();
+    memset( mReportIndex, 0xff, sizeof( mReportIndex ) );
+    mArrayUsages.clear();
+    mNumFields = 0;
+    mHasReportIDs = false;
+}
+
+USBHidReport& USBHidReportLayout::AddReport( USBHidReportType type, U8 reportID )
+{
+    S16& report = mReportIndex[ type ][ reportID ];
+    if( report < 0 )
+    {
+        report = S16( mReports.size() );
+        mReports.push_back( USBHidReport() );
+        mReports.back().reportID = reportID;
+        mReports.back().numBits = 0;
+    }
+
+    return mReports[ report ];
+}
+
+void USBHidReportLayout::Compile( const U8* pDesc, int descBytes )
+{
+    Clear();
+
+    GlobalItems global = {};
+    std::vector<GlobalItems> globalStack;
+    LocalItems local;
+    local.Clear();
+
+    for( int offset = 0; offset < descBytes; )
+    {
+        const U8* pItem = pDesc + offset;
+
+        // long items are not defined by the spec, so they are skipped
+        if( pItem[ 0 ] == 0xfe )
+        {
+            offset += 3 + ( offset + 1 < descBytes ? pItem[ 1 ] : 0 );
+            continue;
+        }
+
+        const int numBytes = GetNumHIDItemDataBytes( pItem[ 0 ] );
+        if( offset + 1 + numBytes > descBytes )
+            break;
+
+        const U32 data = GetItemData( pItem, numBytes );
+
+        // usages of less than 4 bytes are on the current usage page
+        const U32 usage = numBytes == 4 ? data : ( U32( global.usagePage ) << 16 ) | data;
+
+        switch( pItem[ 0 ] & 0xfc )
+        {
+        // main items
+        case 0x80: // Input
+            AddFields( HRT_Input, data, global, local );
+            local.Clear();
+            break;
+        case 0x90: // Output
+            AddFields( HRT_Output, data, global, local );
+            local.Clear();
+            break;
+        case 0xa0: // Collection
+        case 0xb0: // Feature
+        case 0xc0: // End Collection
+            local.Clear();
+            break;
+
+        // global items
+        case 0x04: // Usage Page
+            global.usagePage = U16( data );
+            break;
+        case 0x14: // Logical Minimum
+            global.logicalMin = GetSignedItemData( pItem, numBytes );
+            break;
+        case 0x24: // Logical Maximum
+            // it is only signed if the minimum is negative
+            global.logicalMax = global.logicalMin < 0 ? GetSignedItemData( pItem, numBytes ) : S32( std::min<U32>( data, 0x7fffffff ) );
+            break;
+        case 0x74: // Report Size
+            global.reportSize = data;
+            break;
+        case 0x84: // Report ID
+            global.reportID = U8( data );
+            mHasReportIDs = true;
+            break;
+        case 0x94: // Report Count
+            global.reportCount = data;
+            break;
+        case 0xa4: // Push
+            globalStack.push_back( global );
+            break;
+        case 0xb4: // Pop
+            if( !globalStack.empty() )
+            {
+                global = globalStack.back();
+                globalStack.pop_back();
+            }
+            break;
+
+        // local items
+        case 0x08: // Usage
+            local.usages.push_back( usage );
+            break;
+        case 0x18: // Usage Minimum
+            local.usageMin = usage;
+            local.hasUsageMin = true;
+            break;
+        case 0x28: // Usage Maximum
+            local.usageMax = usage;
+            local.hasUsageMax = true;
+            break;
+        }
+
+        offset += 1 + numBytes;
+    }
+}
+
+void USBHidReportLayout::AddFields( USBHidReportType type, U32 flags, const GlobalItems& global, const LocalItems& local )
+{
+    if( global.reportSize == 0 || global.reportCount == 0 )
+        return;
+
+    USBHidReport& report = AddReport( type, global.reportID );
+
+    // fields over 32 bits and the fields past the limits are shown as data
+    const U64 numBits = U64( global.reportSize ) * global.reportCount;
+    if( global.reportSize > 32 || report.numBits + numBits > MAX_REPORT_BITS || mNumFields + global.reportCount > MAX_LAYOUT_FIELDS )
+    {
+        report.numBits = U32( std::min<U64>( report.numBits + numBits, MAX_REPORT_BITS ) );
+        return;
+    }
+
+    USBHidReportField field;
+    field.bitSize = U8( global.reportSize );
+    field.kind = U8( ( flags & 0x01 ) != 0 ? HRF_Constant : ( flags & 0x02 ) != 0 ? HRF_Variable : HRF_Array );
+    field.mask = field.bitSize == 32 ? 0xffffffff : ( 1u << field.bitSize ) - 1;
+    field.isSigned = global.logicalMin < 0;
+    field.signShift = U8( 32 - field.bitSize );
+    field.logicalMin = global.logicalMin;
+    field.logicalMax = global.logicalMax;
+    field.usage = 0;
+    field.arrayUsagesIndex = -1;
+    field.numArrayUsages = 0;
+
+    const bool hasUsageRange = local.hasUsageMin && local.hasUsageMax && local.usageMin <= local.usageMax;
+    if( field.kind == HRF_Array )
+    {
+        // all the fields of an array share its usages
+        if( !local.usages.empty() )
+        {
+            field.usage = local.usages.front();
+            field.arrayUsagesIndex = int( mArrayUsages.size() );
+            field.numArrayUsages = U32( local.usages.size() );
+            mArrayUsages.insert( mArrayUsages.end(), local.usages.begin(), local.usages.end() );
+        }
+        else if( hasUsageRange )
+        {
+            field.usage = local.usageMin;
+            field.numArrayUsages = local.usageMax - local.usageMin + 1;
+        }
+    }
+
+    for( U32 cnt = 0; cnt < global.reportCount; ++cnt )
+    {
+        const U32 bitOffset = report.numBits + cnt * global.reportSize;
+
+        field.bitOffset = U16( bitOffset );
+        field.byteOffset = U16( bitOffset / 8 );
+        field.shift = U8( bitOffset % 8 );
+        field.numBytes = U8( ( field.shift + field.bitSize + 7 ) / 8 );
+
+        // the last usage of the list is used for the rest of the fields
+        if( field.kind != HRF_Array )
+        {
+            if( !local.usages.empty() )
+                field.usage = local.usages[ std::min<size_t>( cnt, local.usages.size() - 1 ) ];
+            else if( hasUsageRange )
+                field.usage = std::min( local.usageMin + cnt, local.usageMax );
+            else
+                field.usage = 0;
+        }
+
+        report.fields.push_back( field );
+    }
+
+    report.numBits += U32( numBits );
+    mNumFields += global.reportCount;
+}
+
+U32 USBHidReportLayout::GetArrayUsage( const USBHidReportField& field, S32 value ) const
+{
+    const S64 index = S64( value ) - field.logicalMin;
+    if( value > field.logicalMax || index < 0 || index >= field.numArrayUsages )
+        return 0;
+
+    return field.arrayUsagesIndex >= 0 ? mArrayUsages[ field.arrayUsagesIndex + size_t( index ) ] : field.usage + U32( index );
+}
+
+void USBHidReportFieldFrame::PackFrame( U32 value, U8 bitSize, USBHidReportFieldKind kind, U8 reportID, bool isSigned, U32 usage )
+{
+    // mData1 format:
+    // -signed- reportID --kind-- bitSize- ---------------value---------------
+    mData1 = value;
+    mData1 |= U64( bitSize ) << 32;
+    mData1 |= U64( kind ) << 40;
+    mData1 |= U64( reportID ) << 48;
+    mData1 |= U64( isSigned ? 1 : 0 ) << 56;
+
+    mData2 = usage;
+}
+
+// adds the frame of the payload bits [bit, end), for a value of bitSize bits; that is more than the bits of the frame
+// for a field which began in the previous packets
+static void AddReportFieldFrame( USBFrameSink* pSink, const USBPacket& pckt, int bit, int end, int bitSize, U32 value,
+                                 USBHidReportFieldKind kind, U8 reportID, bool isSigned, U32 usage )
+{
+    USBHidReportFieldFrame f;
+    f.mStartingSampleInclusive = pckt.mBitBeginSamples[ 16 + bit ];
+    f.mEndingSampleInclusive = pckt.mBitBeginSamples[ 16 + end ];
+    f.PackFrame( value, U8( bitSize ), kind, reportID, isSigned, usage );
+
+    pSink->AddFrame( f );
+}
+
+// the payload bits [bit, end) that are not in a field are shown as data, split on the byte boundaries
+static void AddReportDataFrames( USBFrameSink* pSink, const USBPacket& pckt, int bit, int end, U8 reportID )
+{
+    while( bit < end )
+    {
+        const int bitSize = std::min( 8 - bit % 8, end - bit );
+        const U32 value = ( pckt.mData[ 2 + bit / 8 ] >> ( bit % 8 ) ) & ( ( 1u << bitSize ) - 1 );
+
+        AddReportFieldFrame( pSink, pckt, bit, bit + bitSize, bitSize, value, HRF_Data, reportID, false, 0 );
+        bit += bitSize;
+    }
+}
+
+U64 USBPacket::AddHIDReportFrames( USBFrameSink* pSink, const USBHidReportLayout& layout, USBHidReportType type,
+                                   U16 maxPacketSize, USBHidReportState& state )
+{
+    AddSyncAndPidFrames( pSink );
+
+    const U8* pPayload = &mData[ 2 ];
+    const int payloadBytes = int( mData.size() ) - 4;
+    const int payloadBits = payloadBytes * 8;
+    int bit = 0; // the first payload bit that is not in a frame yet
+
+    const int idBytes = layout.HasReportIDs() ? 1 : 0;
+    if( state.reportOffset == 0 )
+    {
+        state.reportID = 0;
+        if( idBytes != 0 && payloadBytes > 0 )
+        {
+            state.reportID = pPayload[ 0 ];
+            AddReportFieldFrame( pSink, *this, 0, 8, 8, pPayload[ 0 ], HRF_ReportID, state.reportID, false, 0 );
+            bit = 8;
+        }
+    }
+
+    const USBHidReport* pReport = layout.GetReport( type, state.reportID );
+    if( pReport != NULL )
+    {
+        // report bit n is payload bit base + n; base is negative if this packet continues a report, which goes on
+        // from the field the previous packet couldn't finish
+        const int base = ( idBytes - state.reportOffset ) * 8;
+        size_t cnt = state.reportOffset != 0 ? state.fieldIndex : 0;
+        for( ; cnt < pReport->fields.size(); ++cnt )
+        {
+            const USBHidReportField& field = pReport->fields[ cnt ];
+            const int begin = base + field.bitOffset;
+            const int end = begin + field.bitSize;
+            if( end > payloadBits )
+                break;
+
+            // the bytes of a field which began in the previous packets are partly in the state
+            U64 bytes = 0;
+            for( int bc = 0; bc < field.numBytes; ++bc )
+            {
+                const int payloadByte = base / 8 + field.byteOffset + bc;
+                const size_t pendingByte = size_t( field.byteOffset + bc - state.pendingOffset );
+                U8 byte = 0;
+                if( payloadByte >= 0 )
+                    byte = pPayload[ payloadByte ];
+                else if( pendingByte < state.numPendingBytes )
+                    byte = state.pendingBytes[ pendingByte ];
+
+                bytes |= U64( byte ) << ( bc * 8 );
+            }
+
+            U32 value = U32( bytes >> field.shift ) & field.mask;
+            if( field.isSigned )
+                value = U32( S32( value << field.signShift ) >> field.signShift );
+
+            // a field which began in the previous packets gets its frame on the bits in this one
+            const int first = std::max( begin, bit );
+            AddReportDataFrames( pSink, *this, bit, first, state.reportID );
+
+            const USBHidReportFieldKind kind = USBHidReportFieldKind( field.kind );
+            const U32 usage = kind == HRF_Array ? layout.GetArrayUsage( field, S32( value ) ) : field.usage;
+            AddReportFieldFrame( pSink, *this, first, end, field.bitSize, value, kind, state.reportID, field.isSigned, usage );
+
+            bit = end;
+        }
+
+        // a full packet is followed by the rest of a longer report
+        const U32 reportBytes = idBytes + ( pReport->numBits + 7 ) / 8;
+        const U32 doneBytes = state.reportOffset + payloadBytes;
+        if( payloadBytes == maxPacketSize && doneBytes < reportBytes )
+        {
+            // keep the bytes this packet has of the field the next one finishes, if there is one
+            if( state.reportOffset == 0 || cnt != state.fieldIndex )
+            {
+                state.fieldIndex = U16( cnt );
+                state.pendingOffset = U16( cnt < pReport->fields.size() ? pReport->fields[ cnt ].byteOffset : reportBytes );
+                state.numPendingBytes = 0;
+            }
+
+            for( U32 rb = state.pendingOffset + state.numPendingBytes;
+                 rb + idBytes < doneBytes && state.numPendingBytes < sizeof( state.pendingBytes ); ++rb )
+                state.pendingBytes[ state.numPendingBytes++ ] = pPayload[ base / 8 + int( rb ) ];
+
+            state.reportOffset = U16( doneBytes );
+        }
+        else
+        {
+            state.reportOffset = 0;
+        }
+    }
+    else
+    {
+        state.reportOffset = 0;
+    }
+
+    AddReportDataFrames( pSink, *this, bit, payloadBits, state.reportID );
+
+    AddCRC16Frame( pSink );
+    AddEOPFrame( pSink );
+
+    pSink->CommitFrames();
+
+    return mSampleEnd;
+}
@@ -0,0 +1,149 @@
+#ifndef USB_HID_REPORTS_H
+#define USB_HID_REPORTS_H
+
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+
+// a field of a report, with everything needed to get its value worked out when the report descriptor is compiled
+struct USBHidReportField
+{
+    U16 bitOffset; // in the report, after the report ID
+    U8 bitSize;    // 1 to 32
+    U8 kind;       // USBHidReportFieldKind
+
+    // the value is ( the numBytes bytes from byteOffset >> shift ) & mask, sign extended with signShift
+    U16 byteOffset;
+    U8 numBytes;
+    U8 shift;
+    U32 mask;
+    bool isSigned; // true if the logical minimum is negative
+    U8 signShift;  // 32 - bitSize
+
+    U32 usage; // usage page << 16 | usage ID; for arrays, the usage of logicalMin
+    S32 logicalMin;
+    S32 logicalMax;
+
+    // arrays with a list of usages instead of a usage range have them in USBHidReportLayout::mArrayUsages
+    int arrayUsagesIndex; // -1 for a range
+    U32 numArrayUsages;
+};
+
+struct USBHidReport
+{
+    U8 reportID;
+    U32 numBits; // without the report ID
+    std::vector<USBHidReportField> fields;
+};
+
+// The input and output reports of an interface, compiled from its report descriptor. The reports are found
+// by their ID with a table lookup.
+class USBHidReportLayout
+{
+  public:
+    USBHidReportLayout();
+
+    void Compile( const U8* pDesc, int descBytes );
+
+    // true if the reports begin with the report ID byte
+    bool HasReportIDs() const
+    {
+        return mHasReportIDs;
+    }
+
+    // NULL if the descriptor has no such report
+    const USBHidReport* GetReport( USBHidReportType type, U8 reportID ) const
+    {
+        const S16 report = mReportIndex[ type ][ reportID ];
+
+        return report >= 0 ? &mReports[ report ] : NULL;
+    }
+
+    // the usage that the value of an array field stands for, 0 if the value is out of its range
+    U32 GetArrayUsage( const USBHidReportField& field, S32 value ) const;
+
+  private:
+    struct GlobalItems;
+    struct LocalItems;
+
+    std::vector<USBHidReport> mReports;
+    S16 mReportIndex[ HRT_Count ][ 256 ]; // index in mReports by type and report ID, -1 if none
+    std::vector<U32> mArrayUsages;
+    size_t mNumFields; // in all the reports
+    bool mHasReportIDs;
+
+    void Clear();
+    USBHidReport& AddReport( USBHidReportType type, U8 reportID );
+    void AddFields( USBHidReportType type, U32 flags, const GlobalItems& global, const LocalItems& local );
+};
+
+// where we are in a report which takes more than one packet
+struct USBHidReportState
+{
+    U8 reportID;
+    U16 reportOffset; // the bytes of the report in the previous packets, 0 if the next packet begins a report
+    U16 fieldIndex;   // the first field the previous packets didn't have all the bits of
+
+    // the bytes of that field in the previous packets, from the report byte pendingOffset (after the report ID); a
+    // field has at most five bytes
+    U16 pendingOffset;
+    U8 numPendingBytes;
+    U8 pendingBytes[ 8 ];
+
+    USBHidReportState() : reportID( 0 ), reportOffset( 0 ), fieldIndex( 0 ), pendingOffset( 0 ), numPendingBytes( 0 )
+    {
+    }
+};
+
+class USBHidReportFieldFrame : public USBFrame
+{
+  public:
+    USBHidReportFieldFrame()
+    {
+        mType = FT_HIDReportField;
+        mFlags = FF_None;
+        mData1 = mData2 = 0;
+    }
+
+    void PackFrame( U32 value, U8 bitSize, USBHidReportFieldKind kind, U8 reportID, bool isSigned, U32 usage );
+
+    // sign extended if IsSigned
+    U32 GetValue() const
+    {
+        return mData1 & 0xffffffff;
+    }
+
+    U8 GetBitSize() const
+    {
+        return ( mData1 >> 32 ) & 0xff;
+    }
+
+    USBHidReportFieldKind GetKind() const
+    {
+        return USBHidReportFieldKind( ( mData1 >> 40 ) & 0xff );
+    }
+
+    U8 GetReportID() const
+    {
+        return ( mData1 >> 48 ) & 0xff;
+    }
+
+    bool IsSigned() const
+    {
+        return ( mData1 >> 56 ) != 0;
+    }
+
+    // for arrays this is the usage of the value, 0 if none
+    U16 GetUsagePage() const
+    {
+        return U16( mData2 >> 16 );
+    }
+
+    U16 GetUsageID() const
+    {
+        return U16( mData2 );
+    }
+};
+
+#endif // USB_HID_REPORTS_H
@@ -0,0 +1,160 @@
+#include <string.h>
+#include <algorithm>
+
+#include "USBIdsDatabase.h"
+
+USBIdsDatabase::USBIdsDatabase() : mIndexed( false )
+{
+}
+
+bool USBIdsDatabase::Open( const char* path )
+{
+    mIndexed = false;
+    mVendors.clear();
+    mPages.clear();
+    mUsages.clear();
+    mNames.clear();
+
+    // the index keeps 32 bit offsets
+    return mFile.Open( path ) && mFile.GetSize() <= 0xffffffff;
+}
+
+// parses a hex ID of min_digits to max_digits followed by white space, and moves p to the name after it
+static bool ParseId( const char*& p, const char* end, int min_digits, int max_digits, U32& id )
+{
+    int num_digits = 0;
+    for( id = 0; p != end && num_digits < max_digits; ++p, ++num_digits )
+    {
+        if( *p >= '0' && *p <= '9' )
+            id = ( id << 4 ) | U32( *p - '0' );
+        else if( *p >= 'a' && *p <= 'f' )
+            id = ( id << 4 ) | U32( *p - 'a' + 10 );
+        else if( *p >= 'A' && *p <= 'F' )
+            id = ( id << 4 ) | U32( *p - 'A' + 10 );
+        else
+            break;
+    }
+
+    if( num_digits < min_digits || p == end || ( *p != ' ' && *p != '\t' ) )
+        return false;
+
+    while( p != end && ( *p == ' ' || *p == '\t' ) )
+        ++p;
+
+    return true;
+}
+
+void USBIdsDatabase::BuildIndex()
+{
+    mIndexed = true;
+
+    const char* const pBegin = mFile.GetData();
+    const char* const pEnd = pBegin + mFile.GetSize();
+
+    // vendors are the top level lines with 4 digit IDs, usage pages are the "HUT" lines and the
+    // usages are the lines under them that are indented with one tab
+    bool inHUT = false;
+    U32 usagePage = 0;
+    for( const char* pLine = pBegin; pLine < pEnd; )
+    {
+        const char* pLineEnd = ( const char* )memchr( pLine, '\n', pEnd - pLine );
+        if( pLineEnd == NULL )
+            pLineEnd = pEnd;
+
+        const char* p = pLine;
+        U32 id;
+        IndexEntry entry;
+        if( *p == '\t' )
+        {
+            ++p;
+            if( inHUT && ParseId( p, pLineEnd, 1, 4, id ) )
+            {
+                entry.key = ( usagePage << 16 ) | id;
+                entry.offset = U32( p - pBegin );
+                mUsages.push_back( entry );
+            }
+        }
+        else if( *p != '#' && *p != '\r' && p != pLineEnd )
+        {
+            inHUT = false;
+            if( pLineEnd - p > 4 && memcmp( p, "HUT ", 4 ) == 0 )
+            {
+                p += 4;
+                if( ParseId( p, pLineEnd, 1, 4, id ) )
+                {
+                    inHUT = true;
+                    usagePage = id;
+
+                    entry.key = id;
+                    entry.offset = U32( p - pBegin );
+                    mPages.push_back( entry );
+                }
+            }
+            else if( ParseId( p, pLineEnd, 4, 4, id ) )
+            {
+                entry.key = id;
+                entry.offset = U32( p - pBegin );
+                mVendors.push_back( entry );
+            }
+        }
+
+        pLine = pLineEnd + 1;
+    }
+
+    // the first entry wins if there are duplicates
+    std::stable_sort( mVendors.begin(), mVendors.end() );
+    std::stable_sort( mPages.begin(), mPages.end() );
+    std::stable_sort( mUsages.begin(), mUsages.end() );
+}
+
+void USBIdsDatabase::Index()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if( !mIndexed )
+        BuildIndex();
+}
+
+const char* USBIdsDatabase::FindName( const std::vector<IndexEntry>& index, U32 key )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if( !mIndexed )
+        BuildIndex();
+
+    IndexEntry srch;
+    srch.key = key;
+    std::vector<IndexEntry>::const_iterator res = std::lower_bound( index.begin(), index.end(), srch );
+    if( res == index.end() || res->key != key )
+        return NULL;
+
+    // the names in the file are not terminated, so they are copied on their first lookup
+    std::map<U32, std::string>::iterator srch_name = mNames.find( res->offset );
+    if( srch_name == mNames.end() )
+    {
+        const char* pName = mFile.GetData() + res->offset;
+        const char* pNameEnd = pName;
+        const char* pEnd = mFile.GetData() + mFile.GetSize();
+        while( pNameEnd != pEnd && *pNameEnd != '\n' && *pNameEnd != '\r' )
+            ++pNameEnd;
+
+        srch_name = mNames.insert( std::make_pair( res->offset, std::string( pName, pNameEnd ) ) ).first;
+    }
+
+    return srch_name->second.c_str();
+}
+
+const char* USBIdsDatabase::FindVendorName( U16 vendorID )
+{
+    return FindName( mVendors, vendorID );
+}
+
+const char* USBIdsDatabase::FindHIDUsagePageName( U16 usagePage )
+{
+    return FindName( mPages, usagePage );
+}
+
+const char* USBIdsDatabase::FindHIDUsageName( U16 usagePage, U16 usageID )
+{
+    return FindName( mUsages, ( U32( usagePage ) << 16 ) | usageID );
+}
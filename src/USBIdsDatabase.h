@@ -0,0 +1,59 @@
+#ifndef USB_IDS_DATABASE_H
+#define USB_IDS_DATABASE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBMappedFile.h"
+
+// Names from a file in the usb.ids format (http://www.linux-usb.org/usb.ids): the vendors and the
+// HID usage pages and usages of the HUT section. The file is mapped when opened and indexed on the
+// first lookup, so opening it doesn't read it. Each analyzer results has its own, from its settings, or the
+// one its settings share, and passes it to the lookup functions.
+class USBIdsDatabase
+{
+  public:
+    USBIdsDatabase();
+
+    bool Open( const char* path );
+
+    // indexes the file now instead of on the first lookup, for a database which many decodes share
+    void Index();
+
+    // NULL if the name is not in the file; the names stay valid while the database is open
+    const char* FindVendorName( U16 vendorID );
+    const char* FindHIDUsagePageName( U16 usagePage );
+    const char* FindHIDUsageName( U16 usagePage, U16 usageID );
+
+  private:
+    struct IndexEntry
+    {
+        U32 key;
+        U32 offset; // of the name in the file
+
+        bool operator<( const IndexEntry& rhs ) const
+        {
+            return key < rhs.key;
+        }
+    };
+
+    USBMappedFile mFile;
+
+    // the index and the names are made by the lookups, which come from the UI and the export threads
+    std::mutex mMutex;
+
+    bool mIndexed;
+    std::vector<IndexEntry> mVendors; // key is the vendor ID
+    std::vector<IndexEntry> mPages;   // key is the usage page
+    std::vector<IndexEntry> mUsages;  // key is usage page << 16 | usage ID
+
+    std::map<U32, std::string> mNames; // the names looked up so far, by offset
+
+    void BuildIndex();
+    const char* FindName( const std::vector<IndexEntry>& index, U32 key );
+};
+
+#endif // USB_IDS_DATABASE_H
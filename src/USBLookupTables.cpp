@@ -1,9 +1,47 @@
+#include <stdio.h>
 #include <algorithm>
 #include <string>
 
 #include "USBLookupTables.h"
+#include "USBFormat.h"
+#include "USBIdsDatabase.h"
+#include "USBSortedTables.h"
 #include "USBTypes.h"
 
+// by the PID type in the low nibble, NULL for the PIDs we don't decode
+static const char* const PIDNames[ 16 ] = {
+    NULL,    // reserved
+    "OUT",   // PID_OUT
+    "ACK",   // PID_ACK
+    "DATA0", // PID_DATA0
+    NULL,    // PING
+    "SOF",   // PID_SOF
+    NULL,    // NYET
+    NULL,    // DATA2
+    NULL,    // SPLIT
+    "IN",    // PID_IN
+    "NAK",   // PID_NAK
+    "DATA1", // PID_DATA1
+    "PRE",   // PID_PRE
+    "SETUP", // PID_SETUP
+    "STALL", // PID_STALL
+    NULL,    // MDATA
+};
+
+bool IsSupportedPID( U64 pid )
+{
+    // the high nibble is the complement of the PID type in the low nibble
+    return pid <= 0xff && ( ( pid ^ ( pid >> 4 ) ) & 0x0f ) == 0x0f && PIDNames[ pid & 0x0f ] != NULL;
+}
+
+const char* GetPIDName( USB_PID pid )
+{
+    if( !IsSupportedPID( pid ) )
+        return "<invalid>";
+
+    return PIDNames[ pid & 0x0f ];
+}
+
 const char* GetDescriptorName( U8 descriptor )
 {
     switch( descriptor )
@@ -176,7 +214,7 @@ const char* GetCDCRequestName( U8 request )
 
 const char* GetHIDCountryName( U8 countryCode )
 {
-    const char* CountryNames[] = { "Not Supported",
+    static const char* const CountryNames[] = { "Not Supported",
                                    "Arabic",
                                    "Belgian",
                                    "Canadian-Bilingual",
@@ -221,7 +259,7 @@ const char* GetHIDCountryName( U8 countryCode )
 
 const char* GetCDCEthFeatureSelectorName( U8 feature )
 {
-    const char* Features[] = { "RESERVED",
+    static const char* const Features[] = { "RESERVED",
                                "XMIT_OK",
                                "RCV_OK",
                                "XMIT_ERROR",
@@ -260,7 +298,7 @@ const char* GetCDCEthFeatureSelectorName( U8 feature )
 
 const char* GetCDCATMFeatureSelectorName( U8 feature )
 {
-    const char* Features[] = {
+    static const char* const Features[] = {
         "RESERVED",
         "US_CELLS_SENT",
         "DS_CELLS_RECEIVED",
@@ -278,7 +316,7 @@ const char* GetCDCATMFeatureSelectorName( U8 feature )
 
 const char* GetCDCDescriptorSubtypeName( U8 subtype )
 {
-    const char* Names[] = {
+    static const char* const Names[] = {
         "Header Functional Descriptor",
         "Call Management Functional Descriptor",
         "Abstract Control Management Functional Descriptor",
@@ -309,13 +347,14 @@ struct IdNamePair
     U16 id;
     const char* name;
 
-    bool operator<( const IdNamePair& rhs ) const
+    constexpr bool operator<( const IdNamePair& rhs ) const
     {
         return id < rhs.id;
     }
 };
 
-const IdNamePair USBLangIDs[] = {
+// sorted by ID, checked at compile time with the index below
+constexpr IdNamePair USBLangIDs[] = {
     { 0x0401, "Arabic (Saudi Arabia)" },
     { 0x0402, "Bulgarian" },
     { 0x0403, "Catalan" },
@@ -464,12 +503,10 @@ const IdNamePair USBLangIDs[] = {
     { 0xf4ff, "HID (Vendor Defined 2)" },
     { 0xf8ff, "HID (Vendor Defined 3)" },
     { 0xfcff, "HID (Vendor Defined 4)" },
-
-    { 0xffff, NULL },
 };
 
-
-const IdNamePair VendorIDs[] = {
+// sorted by ID, checked at compile time with the index below
+constexpr IdNamePair VendorIDs[] = {
     { 0x0001, "Fry's Electronics" },
     { 0x0002, "Ingram" },
     { 0x0003, "Club Mac" },
@@ -3317,8 +3354,6 @@ const IdNamePair VendorIDs[] = {
     { 0xeb2a, "KWorld" },
     { 0xf003, "Hewlett Packard" },
     { 0xf4ec, "Atten Electronics / Siglent Technologies" },
-
-    { 0xffff, NULL },
 };
 
 const IdNamePair ClassCodes[] = {
@@ -3350,16 +3385,14 @@ struct UsageTableEntry
     U16 usageID;
     const char* usageName;
 
-    bool operator<( const UsageTableEntry& rhs ) const
+    constexpr bool operator<( const UsageTableEntry& rhs ) const
     {
-        if( usagePage == rhs.usagePage )
-            return usageID < rhs.usageID;
-
-        return usagePage < rhs.usagePage;
+        return usagePage == rhs.usagePage ? usageID < rhs.usageID : usagePage < rhs.usagePage;
     }
 };
 
-const UsageTableEntry UsageTables[] = {
+// sorted by usage page and usage ID, checked at compile time below
+constexpr UsageTableEntry UsageTables[] = {
     // 1	Generic Desktop
     { 1, 0x00, "Undefined" },
     { 1, 0x01, "Pointer" },
@@ -5086,36 +5119,134 @@ const UsageTableEntry UsageTables[] = {
     { 142, 0x22, "Track 2 Data" },
     { 142, 0x23, "Track 3 Data" },
     { 142, 0x24, "Track JIS Data" },
+};
+
+// The vendor and language names are found through an index of the whole U16 ID space, built at compile time.
+// It has a bucket for every 16 IDs with a bit mask of the IDs that are in the table and the table index of the
+// first of them, so the name of an ID is at offset + the number of mask bits below it. The constexpr functions
+// below recurse on halves of the range like IsSortedRange.
 
-    { 0xffff, 0xffff, "<unknown>" },
+struct IdIndexBucket
+{
+    U16 offset; // table index of the first ID in the bucket
+    U16 mask;   // bit n is set if ( bucket << 4 ) + n is in the table
 };
 
-const char* GetLangName( U16 langID )
+const size_t NUM_ID_BUCKETS = 0x10000 >> 4;
+const size_t NUM_LANGS = sizeof( USBLangIDs ) / sizeof( IdNamePair );
+const size_t NUM_VENDORS = sizeof( VendorIDs ) / sizeof( IdNamePair );
+
+static_assert( NUM_LANGS < 0xffff && NUM_VENDORS < 0xffff, "IdIndexBucket can't index the tables" );
+
+static_assert( IsSortedRange( USBLangIDs, 0, NUM_LANGS ), "USBLangIDs must be sorted by ID, without duplicates" );
+static_assert( IsSortedRange( VendorIDs, 0, NUM_VENDORS ), "VendorIDs must be sorted by ID, without duplicates" );
+
+// index of the first entry with an ID >= id
+constexpr U16 FindIdBegin( const IdNamePair* table, U32 id, size_t begin, size_t end )
 {
-    const size_t NUM_LANGS = sizeof( USBLangIDs ) / sizeof( IdNamePair );
+    return begin == end ? U16( begin )
+                        : table[ begin + ( end - begin ) / 2 ].id < id ? FindIdBegin( table, id, begin + ( end - begin ) / 2 + 1, end )
+                                                                       : FindIdBegin( table, id, begin, begin + ( end - begin ) / 2 );
+}
 
-    IdNamePair srch;
-    srch.id = langID;
+constexpr U16 GetIdMask( const IdNamePair* table, size_t begin, size_t end )
+{
+    return begin == end       ? 0
+           : end - begin == 1 ? U16( 1 << ( table[ begin ].id & 0xf ) )
+                              : U16( GetIdMask( table, begin, begin + ( end - begin ) / 2 ) |
+                                     GetIdMask( table, begin + ( end - begin ) / 2, end ) );
+}
+
+// the number of bits set in a U16, in parallel: pairs of bits, nibbles, bytes
+constexpr U32 CountBitPairs( U32 mask )
+{
+    return mask - ( ( mask >> 1 ) & 0x5555 );
+}
 
-    const IdNamePair* res = std::lower_bound( USBLangIDs, USBLangIDs + NUM_LANGS, srch );
+constexpr U32 CountNibbleBits( U32 pairs )
+{
+    return ( pairs & 0x3333 ) + ( ( pairs >> 2 ) & 0x3333 );
+}
 
-    if( res->id == langID && res->name != NULL )
-        return res->name;
+constexpr U32 CountByteBits( U32 nibbles )
+{
+    return ( nibbles + ( nibbles >> 4 ) ) & 0x0f0f;
+}
 
-    return "<unknown>";
+constexpr U32 CountBits( U32 mask )
+{
+    return ( ( CountByteBits( CountNibbleBits( CountBitPairs( mask ) ) ) * 0x0101 ) >> 8 ) & 0x1f;
 }
 
-const char* GetVendorName( U16 vendorID )
+#define ID_BUCKET( table, size, n )                                                                                                        \
+    {                                                                                                                                      \
+        FindIdBegin( table, ( n ) << 4, 0, size ),                                                                                         \
+            GetIdMask( table, FindIdBegin( table, ( n ) << 4, 0, size ), FindIdBegin( table, ( ( n ) + 1 ) << 4, 0, size ) )               \
+    }
+#define ID_BUCKETS_4( t, s, n )                                                                                                            \
+    ID_BUCKET( t, s, n ), ID_BUCKET( t, s, ( n ) + 1 ), ID_BUCKET( t, s, ( n ) + 2 ), ID_BUCKET( t, s, ( n ) + 3 )
+#define ID_BUCKETS_16( t, s, n )                                                                                                           \
+    ID_BUCKETS_4( t, s, n ), ID_BUCKETS_4( t, s, ( n ) + 4 ), ID_BUCKETS_4( t, s, ( n ) + 8 ), ID_BUCKETS_4( t, s, ( n ) + 12 )
+#define ID_BUCKETS_64( t, s, n )                                                                                                           \
+    ID_BUCKETS_16( t, s, n ), ID_BUCKETS_16( t, s, ( n ) + 16 ), ID_BUCKETS_16( t, s, ( n ) + 32 ), ID_BUCKETS_16( t, s, ( n ) + 48 )
+#define ID_BUCKETS_256( t, s, n )                                                                                                          \
+    ID_BUCKETS_64( t, s, n ), ID_BUCKETS_64( t, s, ( n ) + 64 ), ID_BUCKETS_64( t, s, ( n ) + 128 ), ID_BUCKETS_64( t, s, ( n ) + 192 )
+#define ID_BUCKETS_1024( t, s, n )                                                                                                         \
+    ID_BUCKETS_256( t, s, n ), ID_BUCKETS_256( t, s, ( n ) + 256 ), ID_BUCKETS_256( t, s, ( n ) + 512 ), ID_BUCKETS_256( t, s, ( n ) + 768 )
+#define ID_BUCKETS_4096( t, s )                                                                                                            \
+    ID_BUCKETS_1024( t, s, 0 ), ID_BUCKETS_1024( t, s, 1024 ), ID_BUCKETS_1024( t, s, 2048 ), ID_BUCKETS_1024( t, s, 3072 )
+
+constexpr IdIndexBucket USBLangIDIndex[ NUM_ID_BUCKETS ] = { ID_BUCKETS_4096( USBLangIDs, NUM_LANGS ) };
+constexpr IdIndexBucket VendorIDIndex[ NUM_ID_BUCKETS ] = { ID_BUCKETS_4096( VendorIDs, NUM_VENDORS ) };
+
+#undef ID_BUCKETS_4096
+#undef ID_BUCKETS_1024
+#undef ID_BUCKETS_256
+#undef ID_BUCKETS_64
+#undef ID_BUCKETS_16
+#undef ID_BUCKETS_4
+#undef ID_BUCKET
+
+// index of the ID in the table, or size if it's not there
+constexpr size_t FindIdIndex( const IdIndexBucket* index, size_t size, U16 id )
 {
-    const size_t NUM_VENDORS = sizeof( VendorIDs ) / sizeof( IdNamePair );
+    return ( index[ id >> 4 ].mask & ( 1 << ( id & 0xf ) ) ) == 0
+               ? size
+               : index[ id >> 4 ].offset + CountBits( index[ id >> 4 ].mask & ( ( 1 << ( id & 0xf ) ) - 1 ) );
+}
 
-    IdNamePair srch;
-    srch.id = vendorID;
+// every entry of the table must be found at its own index
+constexpr bool AreIdsIndexed( const IdNamePair* table, const IdIndexBucket* index, size_t size, size_t begin, size_t end )
+{
+    return end - begin == 1 ? FindIdIndex( index, size, table[ begin ].id ) == begin
+                            : AreIdsIndexed( table, index, size, begin, begin + ( end - begin ) / 2 ) &&
+                                  AreIdsIndexed( table, index, size, begin + ( end - begin ) / 2, end );
+}
 
-    const IdNamePair* res = std::lower_bound( VendorIDs, VendorIDs + NUM_VENDORS, srch );
+static_assert( AreIdsIndexed( USBLangIDs, USBLangIDIndex, NUM_LANGS, 0, NUM_LANGS ), "USBLangIDIndex is missing IDs" );
+static_assert( AreIdsIndexed( VendorIDs, VendorIDIndex, NUM_VENDORS, 0, NUM_VENDORS ), "VendorIDIndex is missing IDs" );
 
-    if( res->id == vendorID && res->name != NULL )
-        return res->name;
+const char* GetLangName( U16 langID )
+{
+    const size_t idx = FindIdIndex( USBLangIDIndex, NUM_LANGS, langID );
+
+    if( idx < NUM_LANGS )
+        return USBLangIDs[ idx ].name;
+
+    return "<unknown>";
+}
+
+const char* GetVendorName( U16 vendorID, USBIdsDatabase* pUsbIds )
+{
+    // a usb.ids file is newer than the built-in table
+    const char* name = pUsbIds != NULL ? pUsbIds->FindVendorName( vendorID ) : NULL;
+    if( name != NULL )
+        return name;
+
+    const size_t idx = FindIdIndex( VendorIDIndex, NUM_VENDORS, vendorID );
+
+    if( idx < NUM_VENDORS )
+        return VendorIDs[ idx ].name;
 
     return "<unknown>";
 }
@@ -5135,92 +5266,209 @@ const char* GetUSBClassName( U8 classCode )
     return "<unknown>";
 }
 
-std::string GetHIDUsagePageName( U16 usagePage )
+// The HID usage names are found through a two level index: UsagePageSlots maps the usage page to its entry
+// in UsagePages, which knows where the usages of the page are in UsageTables. All of it is built at compile
+// time, by constexpr functions which recurse on halves of the range like IsSortedRange.
+
+const size_t NUM_USAGES = sizeof( UsageTables ) / sizeof( UsageTableEntry );
+
+static_assert( IsSortedRange( UsageTables, 0, NUM_USAGES ), "UsageTables must be sorted by usage page and usage ID, without duplicates" );
+static_assert( NUM_USAGES < 0xffff, "UsagePageEntry can't index UsageTables" );
+
+// index of the first usage of the page, or of a later page
+constexpr U16 FindUsagePageBegin( U32 usagePage, size_t begin = 0, size_t end = NUM_USAGES )
+{
+    return begin == end ? U16( begin )
+                        : UsageTables[ begin + ( end - begin ) / 2 ].usagePage < usagePage
+                              ? FindUsagePageBegin( usagePage, begin + ( end - begin ) / 2 + 1, end )
+                              : FindUsagePageBegin( usagePage, begin, begin + ( end - begin ) / 2 );
+}
+
+// true if the usage IDs in the range have no gaps
+constexpr bool IsUsageRangeDense( U16 begin, U16 end )
+{
+    return begin == end || UsageTables[ end - 1 ].usageID - UsageTables[ begin ].usageID == end - 1 - begin;
+}
+
+struct UsagePageEntry
 {
-    switch( usagePage )
+    U16 usagePage;
+    const char* name;
+
+    // the usages of the page are UsageTables[ begin ] to UsageTables[ end - 1 ]
+    U16 begin;
+    U16 end;
+    bool dense; // the usage is at UsageTables[ begin + usageID - UsageTables[ begin ].usageID ]
+
+    constexpr bool operator<( const UsagePageEntry& rhs ) const
     {
-    case 0x00:
-        return "Undefined";
-    case 0x01:
-        return "Generic Desktop Controls";
-    case 0x02:
-        return "Simulation Controls";
-    case 0x03:
-        return "VR Controls";
-    case 0x04:
-        return "Sport Controls";
-    case 0x05:
-        return "Game Controls";
-    case 0x06:
-        return "Generic Device Controls";
-    case 0x07:
-        return "Keyboard/Keypad";
-    case 0x08:
-        return "LEDs";
-    case 0x09:
-        return "Button";
-    case 0x0A:
-        return "Ordinal";
-    case 0x0B:
-        return "Telephony";
-    case 0x0C:
-        return "Consumer";
-    case 0x0D:
-        return "Digitizer";
-    case 0x0F:
-        return "PID Page";
-    case 0x10:
-        return "Unicode";
-    case 0x14:
-        return "Alphanumeric Display";
-    case 0x40:
-        return "Medical Instruments";
-    case 0x80:
-    case 0x81:
-    case 0x82:
-    case 0x83:
-        return "Monitor page";
-    case 0x84:
-    case 0x85:
-    case 0x86:
-    case 0x87:
-        return "Power page";
-    case 0x8C:
-        return "Bar Code Scanner page";
-    case 0x8D:
-        return "Scale page";
-    case 0x8E:
-        return "Magnetic Stripe Reading (MSR) Devices";
-    case 0x8F:
-        return "Reserved Point of Sale pages";
-    case 0x90:
-        return "Camera Control Page";
-    case 0x91:
-        return "Arcade Page";
+        return usagePage < rhs.usagePage;
     }
+};
+
+#define USAGE_PAGE( page, name )                                                                                                           \
+    {                                                                                                                                      \
+        page, name, FindUsagePageBegin( page ), FindUsagePageBegin( page + 1 ),                                                            \
+            IsUsageRangeDense( FindUsagePageBegin( page ), FindUsagePageBegin( page + 1 ) )                                                \
+    }
+
+// sorted by usage page
+constexpr UsagePageEntry UsagePages[] = {
+    USAGE_PAGE( 0x00, "Undefined" ),
+    USAGE_PAGE( 0x01, "Generic Desktop Controls" ),
+    USAGE_PAGE( 0x02, "Simulation Controls" ),
+    USAGE_PAGE( 0x03, "VR Controls" ),
+    USAGE_PAGE( 0x04, "Sport Controls" ),
+    USAGE_PAGE( 0x05, "Game Controls" ),
+    USAGE_PAGE( 0x06, "Generic Device Controls" ),
+    USAGE_PAGE( 0x07, "Keyboard/Keypad" ),
+    USAGE_PAGE( 0x08, "LEDs" ),
+    USAGE_PAGE( 0x09, "Button" ),
+    USAGE_PAGE( 0x0A, "Ordinal" ),
+    USAGE_PAGE( 0x0B, "Telephony" ),
+    USAGE_PAGE( 0x0C, "Consumer" ),
+    USAGE_PAGE( 0x0D, "Digitizer" ),
+    USAGE_PAGE( 0x0F, "PID Page" ),
+    USAGE_PAGE( 0x10, "Unicode" ),
+    USAGE_PAGE( 0x14, "Alphanumeric Display" ),
+    USAGE_PAGE( 0x40, "Medical Instruments" ),
+    USAGE_PAGE( 0x80, "Monitor page" ),
+    USAGE_PAGE( 0x81, "Monitor page" ),
+    USAGE_PAGE( 0x82, "Monitor page" ),
+    USAGE_PAGE( 0x83, "Monitor page" ),
+    USAGE_PAGE( 0x84, "Power page" ),
+    USAGE_PAGE( 0x85, "Power page" ),
+    USAGE_PAGE( 0x86, "Power page" ),
+    USAGE_PAGE( 0x87, "Power page" ),
+    USAGE_PAGE( 0x8C, "Bar Code Scanner page" ),
+    USAGE_PAGE( 0x8D, "Scale page" ),
+    USAGE_PAGE( 0x8E, "Magnetic Stripe Reading (MSR) Devices" ),
+    USAGE_PAGE( 0x8F, "Reserved Point of Sale pages" ),
+    USAGE_PAGE( 0x90, "Camera Control Page" ),
+    USAGE_PAGE( 0x91, "Arcade Page" ),
+};
+
+#undef USAGE_PAGE
+
+const size_t NUM_USAGE_PAGES = sizeof( UsagePages ) / sizeof( UsagePageEntry );
+const U8 NO_USAGE_PAGE = 0xff;
+const U16 NUM_USAGE_PAGE_SLOTS = 0x100; // the pages with names are all below this
+
+static_assert( IsSortedRange( UsagePages, 0, NUM_USAGE_PAGES ), "UsagePages must be sorted by usage page, without duplicates" );
+static_assert( NUM_USAGE_PAGES < NO_USAGE_PAGE, "too many usage pages for UsagePageSlots" );
+static_assert( UsagePages[ NUM_USAGE_PAGES - 1 ].usagePage < NUM_USAGE_PAGE_SLOTS, "usage page out of the UsagePageSlots range" );
+
+// index of the page in UsagePages, or NO_USAGE_PAGE
+constexpr U8 FindUsagePageSlot( U32 usagePage, size_t begin = 0, size_t end = NUM_USAGE_PAGES )
+{
+    return begin == end ? NO_USAGE_PAGE
+                        : UsagePages[ begin + ( end - begin ) / 2 ].usagePage == usagePage
+                              ? U8( begin + ( end - begin ) / 2 )
+                              : UsagePages[ begin + ( end - begin ) / 2 ].usagePage < usagePage
+                                    ? FindUsagePageSlot( usagePage, begin + ( end - begin ) / 2 + 1, end )
+                                    : FindUsagePageSlot( usagePage, begin, begin + ( end - begin ) / 2 );
+}
+
+constexpr bool AreUsagePagesListed( size_t begin, size_t end )
+{
+    return end - begin == 1 ? FindUsagePageSlot( UsageTables[ begin ].usagePage ) != NO_USAGE_PAGE
+                            : AreUsagePagesListed( begin, begin + ( end - begin ) / 2 ) &&
+                                  AreUsagePagesListed( begin + ( end - begin ) / 2, end );
+}
+
+static_assert( AreUsagePagesListed( 0, NUM_USAGES ), "the pages of all the usages in UsageTables must be in UsagePages" );
+
+#define PAGE_SLOTS_4( n )                                                                                                                  \
+    FindUsagePageSlot( n ), FindUsagePageSlot( ( n ) + 1 ), FindUsagePageSlot( ( n ) + 2 ), FindUsagePageSlot( ( n ) + 3 )
+#define PAGE_SLOTS_16( n ) PAGE_SLOTS_4( n ), PAGE_SLOTS_4( ( n ) + 4 ), PAGE_SLOTS_4( ( n ) + 8 ), PAGE_SLOTS_4( ( n ) + 12 )
+#define PAGE_SLOTS_64( n ) PAGE_SLOTS_16( n ), PAGE_SLOTS_16( ( n ) + 16 ), PAGE_SLOTS_16( ( n ) + 32 ), PAGE_SLOTS_16( ( n ) + 48 )
+
+constexpr U8 UsagePageSlots[ NUM_USAGE_PAGE_SLOTS ] = {
+    PAGE_SLOTS_64( 0 ),
+    PAGE_SLOTS_64( 64 ),
+    PAGE_SLOTS_64( 128 ),
+    PAGE_SLOTS_64( 192 ),
+};
+
+#undef PAGE_SLOTS_64
+#undef PAGE_SLOTS_16
+#undef PAGE_SLOTS_4
+
+static const UsagePageEntry* FindUsagePage( U16 usagePage )
+{
+    if( usagePage >= NUM_USAGE_PAGE_SLOTS || UsagePageSlots[ usagePage ] == NO_USAGE_PAGE )
+        return NULL;
+
+    return &UsagePages[ UsagePageSlots[ usagePage ] ];
+}
 
-    if( usagePage >= 0xff00 )
-        return "Vendor Usage " + int2str_sal( usagePage, Hexadecimal, 16 );
+const char* FindHIDUsagePageName( U16 usagePage )
+{
+    const UsagePageEntry* pPage = FindUsagePage( usagePage );
 
-    return "Reserved " + int2str_sal( usagePage, Hexadecimal, usagePage > 0xff ? 16 : 8 );
+    return pPage != NULL ? pPage->name : NULL;
 }
 
-std::string GetHIDUsageName( U16 usagePage, U16 usageID )
+const char* FindHIDUsageName( U16 usagePage, U16 usageID )
 {
-    const size_t NUM_ITEMS = sizeof( UsageTables ) / sizeof( UsageTableEntry );
+    const UsagePageEntry* pPage = FindUsagePage( usagePage );
+    if( pPage == NULL || pPage->begin == pPage->end )
+        return NULL;
 
-    UsageTableEntry srch;
-    srch.usagePage = usagePage;
-    srch.usageID = usageID;
+    const UsageTableEntry* pBegin = UsageTables + pPage->begin;
+    const UsageTableEntry* pEnd = UsageTables + pPage->end;
 
-    const UsageTableEntry* res = std::lower_bound( UsageTables, UsageTables + NUM_ITEMS, srch );
+    if( pPage->dense )
+    {
+        if( usageID < pBegin->usageID || usageID - pBegin->usageID >= pEnd - pBegin )
+            return NULL;
+
+        return pBegin[ usageID - pBegin->usageID ].usageName;
+    }
 
-    if( res->usagePage == usagePage && res->usageID == usageID )
+    UsageTableEntry srch = { usagePage, usageID, NULL };
+    const UsageTableEntry* res = std::lower_bound( pBegin, pEnd, srch );
+    if( res != pEnd && res->usageID == usageID )
         return res->usageName;
 
+    return NULL;
+}
+
+const char* GetHIDUsagePageName( U16 usagePage, USBIdsDatabase* pUsbIds, char* buff, size_t size )
+{
+    const char* name = FindHIDUsagePageName( usagePage );
+    if( name == NULL && pUsbIds != NULL )
+        name = pUsbIds->FindHIDUsagePageName( usagePage );
+    if( name != NULL )
+        return name;
+
+    char number_str[ 16 ];
+    FormatNumber( number_str, sizeof( number_str ), usagePage, DB_Hexadecimal, usagePage > 0xff ? 16 : 8 );
+    snprintf( buff, size, "%s %s", usagePage >= 0xff00 ? "Vendor Usage" : "Reserved", number_str );
+
+    return buff;
+}
+
+const char* GetHIDUsageName( U16 usagePage, U16 usageID, USBIdsDatabase* pUsbIds, char* buff, size_t size )
+{
+    const char* name = FindHIDUsageName( usagePage, usageID );
+    if( name == NULL && pUsbIds != NULL )
+        name = pUsbIds->FindHIDUsageName( usagePage, usageID );
+    if( name != NULL )
+        return name;
+
     // handle special cases
     if( usagePage == 0x09 ) // button
-        return "Button " + int2str( usageID );
+    {
+        snprintf( buff, size, "Button %u", usageID );
+    }
+    else
+    {
+        char page_str[ 64 ];
+        char number_str[ 16 ];
+        FormatNumber( number_str, sizeof( number_str ), usageID, DB_Hexadecimal, usageID > 0x7f ? 16 : 8 );
+        snprintf( buff, size, "Usage Page=%s ID=%s", GetHIDUsagePageName( usagePage, pUsbIds, page_str, sizeof( page_str ) ), number_str );
+    }
 
-    return "Usage Page=" + GetHIDUsagePageName( usagePage ) + " ID=" + int2str_sal( usageID, Hexadecimal, usageID > 0x7f ? 16 : 8 );
+    return buff;
 }
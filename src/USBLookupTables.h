@@ -1,11 +1,16 @@
 #ifndef USB_LOOKUP_TABLES_H
 #define USB_LOOKUP_TABLES_H
 
-#include <LogicPublicTypes.h>
+#include <stddef.h>
 
+#include "USBCoreTypes.h"
 #include "USBEnums.h"
 
-std::string GetPIDName( USB_PID pid );
+class USBIdsDatabase;
+
+// true for the PIDs the analyzer decodes
+bool IsSupportedPID( U64 pid );
+const char* GetPIDName( USB_PID pid );
 const char* GetDescriptorName( U8 descriptor );
 const char* GetRequestName( U8 request );
 const char* GetHIDRequestName( U8 request );
@@ -15,10 +20,18 @@ const char* GetCDCEthFeatureSelectorName( U8 feature );
 const char* GetCDCATMFeatureSelectorName( U8 feature );
 const char* GetCDCDescriptorSubtypeName( U8 subtype );
 const char* GetLangName( U16 langID );
-const char* GetVendorName( U16 vendorID );
 const char* GetUSBClassName( U8 classCode );
 
-std::string GetHIDUsagePageName( U16 usagePage );
-std::string GetHIDUsageName( U16 usagePage, U16 usageID );
+// pUsbIds is the usb.ids file of the analyzer, NULL for the built-in names only; its vendor names take
+// precedence over the built-in ones, and its HID usages are used for the usages that are not built in
+const char* GetVendorName( U16 vendorID, USBIdsDatabase* pUsbIds );
+
+// NULL if the page or usage is not in the tables
+const char* FindHIDUsagePageName( U16 usagePage );
+const char* FindHIDUsageName( U16 usagePage, U16 usageID );
+
+// same as above, but describes unknown pages and usages in buff
+const char* GetHIDUsagePageName( U16 usagePage, USBIdsDatabase* pUsbIds, char* buff, size_t size );
+const char* GetHIDUsageName( U16 usagePage, U16 usageID, USBIdsDatabase* pUsbIds, char* buff, size_t size );
 
 #endif // USB_LOOKUP_TABLES_H
\ No newline at end of file
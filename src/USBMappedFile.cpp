@@ -0,0 +1,129 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "USBMappedFile.h"
+
+#ifdef _WIN32
+
+USBMappedFile::USBMappedFile()
+    : mIsOpen( false ), mpData( NULL ), mSize( 0 ), mFileHandle( INVALID_HANDLE_VALUE ), mMappingHandle( NULL )
+{
+}
+
+bool USBMappedFile::Open( const char* path )
+{
+    Close();
+
+    mFileHandle = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( mFileHandle == INVALID_HANDLE_VALUE )
+        return false;
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( mFileHandle, &size ) || ULONGLONG( size.QuadPart ) > ULONGLONG( size_t( -1 ) ) )
+    {
+        Close();
+        return false;
+    }
+
+    mSize = size_t( size.QuadPart );
+    mIsOpen = true;
+
+    // empty files can't be mapped
+    if( mSize == 0 )
+        return true;
+
+    mMappingHandle = CreateFileMappingA( mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+    if( mMappingHandle != NULL )
+        mpData = ( const char* )MapViewOfFile( mMappingHandle, FILE_MAP_READ, 0, 0, 0 );
+
+    if( mpData == NULL )
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void USBMappedFile::Close()
+{
+    if( mpData != NULL )
+        UnmapViewOfFile( mpData );
+    if( mMappingHandle != NULL )
+        CloseHandle( mMappingHandle );
+    if( mFileHandle != INVALID_HANDLE_VALUE )
+        CloseHandle( mFileHandle );
+
+    mIsOpen = false;
+    mpData = NULL;
+    mSize = 0;
+    mFileHandle = INVALID_HANDLE_VALUE;
+    mMappingHandle = NULL;
+}
+
+#else
+
+USBMappedFile::USBMappedFile() : mIsOpen( false ), mpData( NULL ), mSize( 0 )
+{
+}
+
+bool USBMappedFile::Open( const char* path )
+{
+    Close();
+
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 )
+        return false;
+
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) )
+    {
+        close( fd );
+        return false;
+    }
+
+    mSize = size_t( st.st_size );
+
+    // empty files can't be mapped
+    if( mSize > 0 )
+    {
+        void* pData = mmap( NULL, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( pData == MAP_FAILED )
+        {
+            close( fd );
+            mSize = 0;
+            return false;
+        }
+
+        mpData = ( const char* )pData;
+    }
+
+    // the mapping stays valid without the descriptor
+    close( fd );
+    mIsOpen = true;
+
+    return true;
+}
+
+void USBMappedFile::Close()
+{
+    if( mpData != NULL )
+        munmap( ( void* )mpData, mSize );
+
+    mIsOpen = false;
+    mpData = NULL;
+    mSize = 0;
+}
+
+#endif
+
+USBMappedFile::~USBMappedFile()
+{
+    Close();
+}
@@ -0,0 +1,48 @@
+#ifndef USB_MAPPED_FILE_H
+#define USB_MAPPED_FILE_H
+
+#include <stddef.h>
+
+// A read-only memory mapping of a whole file. The pages are only read from disk when they are
+// touched, so opening a large file costs the same as opening a small one.
+class USBMappedFile
+{
+  public:
+    USBMappedFile();
+    ~USBMappedFile();
+
+    bool Open( const char* path );
+    void Close();
+
+    bool IsOpen() const
+    {
+        return mIsOpen;
+    }
+
+    // NULL for an empty file
+    const char* GetData() const
+    {
+        return mpData;
+    }
+
+    size_t GetSize() const
+    {
+        return mSize;
+    }
+
+  private:
+    // not copyable
+    USBMappedFile( const USBMappedFile& );
+    USBMappedFile& operator=( const USBMappedFile& );
+
+    bool mIsOpen;
+    const char* mpData;
+    size_t mSize;
+
+#ifdef _WIN32
+    void* mFileHandle;
+    void* mMappingHandle;
+#endif
+};
+
+#endif // USB_MAPPED_FILE_H
@@ -0,0 +1,87 @@
+#include <stdio.h>
+
+#include "USBPerfCounters.h"
+
+void USBPerfCounters::Clear()
+{
+    for( int cc = 0; cc < PC_Count; ++cc )
+        mCounts[ cc ] = 0;
+
+    // the first call of each stage is timed, for itself only
+    for( int sc = 0; sc < PS_Count; ++sc )
+    {
+        mCalls[ sc ] = mTotalNs[ sc ] = mChildNs[ sc ] = 0;
+        mTotalClocks[ sc ] = mChildClocks[ sc ] = 0;
+        mCountdown[ sc ] = mGap[ sc ] = 1;
+    }
+
+    mStage = PS_None;
+    mRandom = 1;
+
+    mTimedCalls = 0;
+
+    // a few checks to start with, for the decodes which time only a few calls
+    mClockNs = mClockChecks = 0;
+    for( int cc = 0; cc < 16; ++cc )
+        CheckClock();
+}
+
+void USBPerfCounters::CheckClock()
+{
+    const U64 begin = GetNanoseconds();
+    const U64 ns = GetNanoseconds() - begin;
+    if( ns <= PERF_SAMPLE_MAX_NS )
+    {
+        mClockNs += ns;
+        ++mClockChecks;
+    }
+}
+
+const char* USBPerfCounters::GetStageName( USBPerfStage stage )
+{
+    static const char* names[ PS_Count ] = { "decode",      "edge fetch", "filter",     "get packet", "packet handler",
+                                             "descriptors", "add frame",  "add marker", "commit" };
+
+    return stage >= 0 && stage < PS_Count ? names[ stage ] : "";
+}
+
+const char* USBPerfCounters::GetCountName( USBPerfCount which )
+{
+    static const char* names[ PC_Count ] = { "edge advances", "states",  "packets",            "bad packets",      "frames",
+                                             "markers",       "commits", "data stage packets", "replayed packets", "parsed packets" };
+
+    return which >= 0 && which < PC_Count ? names[ which ] : "";
+}
+
+std::string USBPerfCounters::Format() const
+{
+    std::string ret_val;
+    char line[ 256 ];
+
+    // the decode stage runs around all the others
+    const double totalMs = GetTotalNanoseconds( PS_Decode ) / 1e6;
+
+    snprintf( line, sizeof( line ), "%-20s %14s %12s %8s %12s\n", "stage", "calls", "self ms", "self %", "ns/call" );
+    ret_val += line;
+
+    for( int sc = 0; sc < PS_Count; ++sc )
+    {
+        const USBPerfStage stage = USBPerfStage( sc );
+        const double selfMs = GetSelfNanoseconds( stage ) / 1e6;
+        const double callNs = mCalls[ sc ] > 0 ? double( GetTotalNanoseconds( stage ) ) / mCalls[ sc ] : 0.0;
+        snprintf( line, sizeof( line ), "%-20s %14llu %12.3f %8.1f %12.1f\n", GetStageName( stage ), ( unsigned long long )mCalls[ sc ],
+                  selfMs, totalMs > 0 ? selfMs * 100 / totalMs : 0.0, callNs );
+        ret_val += line;
+    }
+
+    snprintf( line, sizeof( line ), "%-20s %14s %12.3f\n\n", "total", "", totalMs );
+    ret_val += line;
+
+    for( int cc = 0; cc < PC_Count; ++cc )
+    {
+        snprintf( line, sizeof( line ), "%-20s %14llu\n", GetCountName( USBPerfCount( cc ) ), ( unsigned long long )mCounts[ cc ] );
+        ret_val += line;
+    }
+
+    return ret_val;
+}
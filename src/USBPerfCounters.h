@@ -0,0 +1,351 @@
+#ifndef USB_PERF_COUNTERS_H
+#define USB_PERF_COUNTERS_H
+
+#include <chrono>
+#include <string>
+
+#include "USBCoreTypes.h"
+#include "USBEdgeSource.h"
+#include "USBFrameSink.h"
+
+// the parts of the decoder which are timed
+enum USBPerfStage
+{
+    PS_None = -1,
+
+    PS_Decode,      // the decode loop, and whatever the stages below don't cover
+    PS_EdgeFetch,   // the calls to the edge sources
+    PS_Filter,      // USBSignalFilter::DoFilter, which makes the signal states out of the edges
+    PS_GetPacket,   // USBSignalFilter::GetPacket, the bits and bytes of a packet
+    PS_Handler,     // the frames of a packet: SendPacketToHandler, or the frames of the other levels
+    PS_Descriptors, // the parsing of the data stages of the control transfers
+    PS_AddFrame,    // the sink
+    PS_AddMarker,
+    PS_Commit,
+
+    PS_Count
+};
+
+// the things which are counted
+enum USBPerfCount
+{
+    PC_EdgeAdvances, // AdvanceToNextEdge calls, on both lines
+    PC_States,
+    PC_Packets,
+    PC_BadPackets,
+    PC_Frames,
+    PC_Markers,
+    PC_Commits,
+    PC_DataStagePackets, // the data packets of control transfers which went to the descriptor parser
+    PC_ReplayedPackets,  // of those, the ones the stage cache had
+    PC_ParsedPackets,    // and the ones it had to parse
+
+    PC_Count
+};
+
+// a timed call costs two reads of the clock, which is more than an edge fetch, a signal state or a bit marker
+// takes, so only about one in this many of those is timed, and stands for the others
+enum
+{
+    PERF_SAMPLE_PERIOD = 64,
+
+    // a sampled call which took longer than this was interrupted, and counts for itself only, or the interrupt
+    // would count period times over
+    PERF_SAMPLE_MAX_NS = 20000,
+
+    // what a read of the clock takes is measured again after this many timed calls, since it changes during the
+    // decode, and every call of a sampled stage pays for a mistake in it
+    PERF_CLOCK_CHECK_PERIOD = 16
+};
+
+// Where the time of a decode goes, to profile real captures without a profiler. A stage gets the time spent
+// in it minus the time of the stages it calls, so the stage times add up to the time of the decode. The
+// decoder only keeps the counters when it is given a USBPerfCounters.
+class USBPerfCounters
+{
+  public:
+    USBPerfCounters() : mSampling( true )
+    {
+        Clear();
+    }
+
+    void Clear();
+
+    void Count( USBPerfCount which, U64 num = 1 )
+    {
+        mCounts[ which ] += num;
+    }
+
+    void SetCount( USBPerfCount which, U64 num )
+    {
+        mCounts[ which ] = num;
+    }
+
+    U64 GetCount( USBPerfCount which ) const
+    {
+        return mCounts[ which ];
+    }
+
+    // times every call instead of one in the period, which is slower but exact; for the benchmarks
+    void SetSampling( bool sampling )
+    {
+        mSampling = sampling;
+    }
+
+    // the weight of the call if it is timed, and 0 for the others. The gaps between the timed calls are picked at
+    // random, around period, since the calls come in patterns and a fixed gap would time the same call every time;
+    // a timed call stands for the calls of the gap before it. Only the timed calls draw a gap.
+    U32 CountCall( USBPerfStage stage, U32 period )
+    {
+        ++mCalls[ stage ];
+        if( period == 1 || !mSampling )
+            return 1;
+
+        if( --mCountdown[ stage ] != 0 )
+            return 0;
+
+        const U32 weight = mGap[ stage ];
+        mRandom = mRandom * 1664525 + 1013904223;
+        mGap[ stage ] = mCountdown[ stage ] = 1 + ( mRandom >> 16 ) % ( 2 * period - 1 );
+        return weight;
+    }
+
+    // the stage of the timer which is running is in parent until it ends. The stage is entered even when the call
+    // isn't timed, so the stages it calls are taken off its time and not off that of its parent.
+    void BeginStage( USBPerfStage stage, USBPerfStage& parent, U64& begin, U32 weight )
+    {
+        parent = mStage;
+        mStage = stage;
+        begin = weight != 0 ? GetNanoseconds() : 0;
+    }
+
+    // the time counts weight times for a sampled stage; the reads of the clock count for the parent only. They
+    // are taken off when the times are read, at what the clock took over the whole decode.
+    void EndStage( USBPerfStage parent, U64 begin, U32 weight )
+    {
+        if( weight != 0 )
+        {
+            const U64 ns = GetNanoseconds() - begin;
+            if( ns > PERF_SAMPLE_MAX_NS )
+                weight = 1;
+
+            mTotalNs[ mStage ] += ns * weight;
+            mTotalClocks[ mStage ] += weight;
+            if( parent != PS_None )
+            {
+                mChildNs[ parent ] += ns * weight;
+                mChildClocks[ parent ] += S64( weight ) - 2;
+            }
+
+            if( ++mTimedCalls % PERF_CLOCK_CHECK_PERIOD == 0 )
+                CheckClock();
+        }
+
+        mStage = parent;
+    }
+
+    U64 GetCalls( USBPerfStage stage ) const
+    {
+        return mCalls[ stage ];
+    }
+
+    // without the stages it called
+    U64 GetSelfNanoseconds( USBPerfStage stage ) const
+    {
+        const double ns =
+            GetNanoseconds( mTotalNs[ stage ], mTotalClocks[ stage ] ) - GetNanoseconds( mChildNs[ stage ], mChildClocks[ stage ] );
+        return ns > 0 ? U64( ns ) : 0;
+    }
+
+    U64 GetTotalNanoseconds( USBPerfStage stage ) const
+    {
+        const double ns = GetNanoseconds( mTotalNs[ stage ], mTotalClocks[ stage ] );
+        return ns > 0 ? U64( ns ) : 0;
+    }
+
+    static const char* GetStageName( USBPerfStage stage );
+    static const char* GetCountName( USBPerfCount which );
+
+    // a table of the stages and the counts, for the debug export and the offline decoder
+    std::string Format() const;
+
+    static U64 GetNanoseconds()
+    {
+        return U64( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+    }
+
+  private:
+    // times the reads of the clock back to back, leaving out those which were interrupted
+    void CheckClock();
+
+    // the time of the clock reads taken off
+    double GetNanoseconds( U64 ns, S64 clocks ) const
+    {
+        return double( ns ) - ( mClockChecks > 0 ? double( mClockNs ) / mClockChecks : 0.0 ) * clocks;
+    }
+
+    U64 mCounts[ PC_Count ];
+    U64 mCalls[ PS_Count ];
+    U64 mTotalNs[ PS_Count ];
+    S64 mTotalClocks[ PS_Count ]; // the clock reads in mTotalNs
+    U64 mChildNs[ PS_Count ];
+    S64 mChildClocks[ PS_Count ];
+    U32 mCountdown[ PS_Count ]; // the calls to the next timed one
+    U32 mGap[ PS_Count ];       // the calls the next timed one stands for
+    USBPerfStage mStage;        // the innermost stage which is running
+    U64 mTimedCalls;
+    U64 mClockNs; // what the checked reads of the clock took, together
+    U64 mClockChecks;
+    U32 mRandom; // picks the gaps
+    bool mSampling;
+};
+
+// Times its scope as a stage, or about one in period of the scopes; it does nothing without the counters.
+class USBPerfTimer
+{
+  public:
+    USBPerfTimer( USBPerfCounters* pPerf, USBPerfStage stage, U32 period = 1 ) : mpPerf( pPerf ), mWeight( 0 )
+    {
+        if( mpPerf != NULL )
+        {
+            mWeight = mpPerf->CountCall( stage, period );
+            mpPerf->BeginStage( stage, mParent, mBegin, mWeight );
+        }
+    }
+
+    ~USBPerfTimer()
+    {
+        if( mpPerf != NULL )
+            mpPerf->EndStage( mParent, mBegin, mWeight );
+    }
+
+  private:
+    USBPerfCounters* mpPerf;
+    U32 mWeight;
+    USBPerfStage mParent;
+    U64 mBegin;
+};
+
+// Times the calls to a line and counts its edges. The state getters aren't timed, they are only reads.
+class USBPerfEdgeSource : public USBEdgeSource
+{
+  public:
+    USBPerfEdgeSource( USBEdgeSource* pSource, USBPerfCounters* pPerf ) : mpSource( pSource ), mpPerf( pPerf )
+    {
+    }
+
+    virtual U64 GetSampleNumber()
+    {
+        return mpSource->GetSampleNumber();
+    }
+
+    virtual USBBitState GetBitState()
+    {
+        return mpSource->GetBitState();
+    }
+
+    virtual U64 GetSampleOfNextEdge()
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        return mpSource->GetSampleOfNextEdge();
+    }
+
+    virtual void AdvanceToNextEdge()
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        mpPerf->Count( PC_EdgeAdvances );
+        mpSource->AdvanceToNextEdge();
+    }
+
+    virtual void AdvanceToAbsPosition( U64 sample )
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        mpSource->AdvanceToAbsPosition( sample );
+    }
+
+    virtual bool WouldAdvancingCauseTransition( U32 numSamples )
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        return mpSource->WouldAdvancingCauseTransition( numSamples );
+    }
+
+    virtual bool WouldAdvancingToAbsPositionCauseTransition( U64 sample )
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        return mpSource->WouldAdvancingToAbsPositionCauseTransition( sample );
+    }
+
+    virtual bool DoMoreTransitionsExistInCurrentData()
+    {
+        USBPerfTimer timer( mpPerf, PS_EdgeFetch, PERF_SAMPLE_PERIOD );
+        return mpSource->DoMoreTransitionsExistInCurrentData();
+    }
+
+  private:
+    USBEdgeSource* mpSource;
+    USBPerfCounters* mpPerf;
+};
+
+// Times and counts the output of the decoder on its way to the sink. The frames and the commits come a few to a
+// packet, so they are all timed; a sink grows its buffers now and then, and a sampled call which did that would
+// count it period times over. The markers come one to a bit and are sampled.
+class USBPerfFrameSink : public USBFrameSink
+{
+  public:
+    USBPerfFrameSink() : mpSink( NULL ), mpPerf( NULL )
+    {
+    }
+
+    void SetSink( USBFrameSink* pSink, USBPerfCounters* pPerf )
+    {
+        mpSink = pSink;
+        mpPerf = pPerf;
+    }
+
+    USBFrameSink* GetSink() const
+    {
+        return mpSink;
+    }
+
+    virtual void AddFrame( const USBFrame& f )
+    {
+        USBPerfTimer timer( mpPerf, PS_AddFrame );
+        mpPerf->Count( PC_Frames );
+        mpSink->AddFrame( f );
+    }
+
+    virtual void CommitFrames()
+    {
+        USBPerfTimer timer( mpPerf, PS_Commit );
+        mpPerf->Count( PC_Commits );
+        mpSink->CommitFrames();
+    }
+
+    virtual void AddBitMarker( U64 sample, USBBitMarker markerType )
+    {
+        USBPerfTimer timer( mpPerf, PS_AddMarker, PERF_SAMPLE_PERIOD );
+        mpPerf->Count( PC_Markers );
+        mpSink->AddBitMarker( sample, markerType );
+    }
+
+    virtual void AddStringDescriptor( int addr, int id, const std::string& stringDesc )
+    {
+        mpSink->AddStringDescriptor( addr, id, stringDesc );
+    }
+
+    virtual void CopyStringDescriptors( int fromAddr, int toAddr )
+    {
+        mpSink->CopyStringDescriptors( fromAddr, toAddr );
+    }
+
+    virtual void ReportProgress( U64 sample )
+    {
+        mpSink->ReportProgress( sample );
+    }
+
+  private:
+    USBFrameSink* mpSink;
+    USBPerfCounters* mpPerf;
+};
+
+#endif // USB_PERF_COUNTERS_H
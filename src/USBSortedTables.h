@@ -0,0 +1,27 @@
+#ifndef USB_SORTED_TABLES_H
+#define USB_SORTED_TABLES_H
+
+#include <stddef.h>
+
+// The lookup tables are binary searched, so each one checks at compile time that it is sorted.
+
+struct USBOperatorLess
+{
+    template <typename T>
+    constexpr bool operator()( const T& lhs, const T& rhs ) const
+    {
+        return lhs < rhs;
+    }
+};
+
+// true if table[ lo, hi ) is in increasing order by less, without duplicates. C++11 constexpr functions can't
+// loop, so this recurses on halves of the range, which keeps the recursion as deep as the log of the table size.
+template <typename T, typename Less = USBOperatorLess>
+constexpr bool IsSortedRange( const T* table, size_t lo, size_t hi, Less less = Less() )
+{
+    return hi - lo < 2 || ( IsSortedRange( table, lo, lo + ( hi - lo ) / 2, less ) &&
+                            IsSortedRange( table, lo + ( hi - lo ) / 2, hi, less ) &&
+                            less( table[ lo + ( hi - lo ) / 2 - 1 ], table[ lo + ( hi - lo ) / 2 ] ) );
+}
+
+#endif // USB_SORTED_TABLES_H
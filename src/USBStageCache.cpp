@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include "USBStageCache.h"
+
+USBStageCache::USBStageCache( size_t capacity )
+    : mCapacity( capacity ), mNumDuplicateStages( 0 ), mNumReplayedPackets( 0 ), mNumParsedPackets( 0 )
+{
+}
+
+U64 USBStageCache::Hash( U64 hash, const U8* pData, int numBytes )
+{
+    for( int bc = 0; bc < numBytes; ++bc )
+    {
+        hash ^= pData[ bc ];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+const USBStagePacketResult* USBStageCache::Find( U64 hash, U64 prevHash, const U8* pData, int numBytes )
+{
+    std::map<U64, USBStagePacketResult>::const_iterator srch = mEntries.find( hash );
+    if( srch == mEntries.end() )
+        return NULL;
+
+    // make sure it is not a collision, at least for this packet
+    const USBStagePacketResult& result = srch->second;
+    if( result.prevHash != prevHash || int( result.data.size() ) != numBytes ||
+        !std::equal( pData, pData + numBytes, result.data.begin() ) )
+        return NULL;
+
+    ++mNumReplayedPackets;
+
+    return &result;
+}
+
+void USBStageCache::Insert( U64 hash, USBStagePacketResult& result )
+{
+    // the devices of a long capture come and go, so start over instead of growing without bound
+    if( mEntries.size() >= mCapacity )
+        mEntries.clear();
+
+    std::swap( mEntries[ hash ], result );
+
+    ++mNumParsedPackets;
+}
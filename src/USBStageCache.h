@@ -0,0 +1,123 @@
+#ifndef USB_STAGE_CACHE_H
+#define USB_STAGE_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "USBCoreTypes.h"
+#include "USBEnums.h"
+#include "USBDescriptorSchemas.h"
+
+// the state of the control transfer parser between two data packets
+struct USBStageParseState
+{
+    int parseOffset;
+    int descBegin;
+    int descEnd;
+    USBDescriptorType descType;
+    USBCDCDescriptorSubtype descSubtype;
+    const USBDescriptorSchema* descSchema;
+    int descFieldCnt;
+
+    int hidIndentLevel;
+    int hidItemCnt;
+    std::vector<U16> hidUsagePageStack;
+
+    USBStageParseState()
+        : parseOffset( 0 ),
+          descBegin( 0 ),
+          descEnd( 0 ),
+          descType( DT_Undefined ),
+          descSubtype( DST_Undefined ),
+          descSchema( NULL ),
+          descFieldCnt( 0 ),
+          hidIndentLevel( 0 ),
+          hidItemCnt( 0 )
+    {
+    }
+};
+
+// a frame of the data stage, with the stage bytes it covers instead of its samples
+struct USBStageFrame
+{
+    USBFrame frame;
+    int firstByte;
+    int lastByte;
+};
+
+// everything the parser did with a data packet
+struct USBStagePacketResult
+{
+    U64 prevHash;         // of the request and the data stage before this packet
+    std::vector<U8> data; // of this packet
+
+    std::vector<USBStageFrame> frames;
+    std::vector<std::pair<int, int>> descriptors; // offsets of the descriptors completed in this packet
+    bool hasStringDescriptor;
+    std::string stringDescriptor;
+
+    USBStageParseState state; // after the packet
+
+    USBStagePacketResult() : prevHash( 0 ), hasStringDescriptor( false )
+    {
+    }
+};
+
+// Hosts read the same descriptors again and again, so the parse results of the descriptor data packets are
+// kept by a hash of the request and all the data of the stage up to the end of the packet. The same packet
+// of a repeated request is then replayed at its new samples instead of being parsed again.
+class USBStageCache
+{
+  public:
+    USBStageCache( size_t capacity = 4096 );
+
+    // FNV-1a
+    static U64 Hash( U64 hash, const U8* pData, int numBytes );
+    static U64 GetInitialHash()
+    {
+        return 0xcbf29ce484222325ull;
+    }
+
+    // NULL if we didn't parse this packet of the stage yet
+    const USBStagePacketResult* Find( U64 hash, U64 prevHash, const U8* pData, int numBytes );
+
+    // takes the contents of result
+    void Insert( U64 hash, USBStagePacketResult& result );
+
+    void Clear()
+    {
+        mEntries.clear();
+    }
+
+    // a request whose data stage was all replayed
+    void AddDuplicateStage()
+    {
+        ++mNumDuplicateStages;
+    }
+
+    U64 GetNumDuplicateStages() const
+    {
+        return mNumDuplicateStages;
+    }
+
+    U64 GetNumReplayedPackets() const
+    {
+        return mNumReplayedPackets;
+    }
+
+    U64 GetNumParsedPackets() const
+    {
+        return mNumParsedPackets;
+    }
+
+  private:
+    size_t mCapacity;
+    std::map<U64, USBStagePacketResult> mEntries; // by hash
+
+    U64 mNumDuplicateStages;
+    U64 mNumReplayedPackets;
+    U64 mNumParsedPackets;
+};
+
+#endif // USB_STAGE_CACHE_H
@@ -1,39 +1,10 @@
-#include <AnalyzerChannelData.h>
-#include <AnalyzerHelpers.h>
-
-#include "USBAnalyzer.h"
-#include "USBAnalyzerResults.h"
+#include "USBEdgeSource.h"
+#include "USBFrameSink.h"
+#include "USBFormat.h"
+#include "USBLookupTables.h"
+#include "USBPerfCounters.h"
 #include "USBTypes.h"
 
-std::string GetPIDName( USB_PID pid )
-{
-    switch( pid )
-    {
-    case PID_IN:
-        return "IN";
-    case PID_OUT:
-        return "OUT";
-    case PID_SOF:
-        return "SOF";
-    case PID_SETUP:
-        return "SETUP";
-    case PID_DATA0:
-        return "DATA0";
-    case PID_DATA1:
-        return "DATA1";
-    case PID_ACK:
-        return "ACK";
-    case PID_NAK:
-        return "NAK";
-    case PID_STALL:
-        return "STALL";
-    case PID_PRE:
-        return "PRE";
-    }
-
-    return "<invalid>";
-}
-
 void USBPacket::Clear()
 {
     mData.clear();
@@ -45,8 +16,7 @@ void USBPacket::Clear()
 
 bool USBPacket::IsPIDValid() const
 {
-    return mPID == PID_IN || mPID == PID_OUT || mPID == PID_SOF || mPID == PID_SETUP || mPID == PID_DATA0 || mPID == PID_DATA1 ||
-           mPID == PID_ACK || mPID == PID_NAK || mPID == PID_STALL || mPID == PID_PRE;
+    return IsSupportedPID( mPID );
 }
 
 U8 USBPacket::CalcCRC5( U16 data )
@@ -96,10 +66,10 @@ U16 USBPacket::CalcCRC16() const
     return ~crc_register;
 }
 
-void USBPacket::AddSyncAndPidFrames( USBAnalyzerResults* pResults, USBFrameFlags flagPID )
+void USBPacket::AddSyncAndPidFrames( USBFrameSink* pSink, USBFrameFlags flagPID )
 {
     // make the SYNC and PID analyzer frames for this packet
-    Frame f;
+    USBFrame f;
 
     // SYNC
     f.mStartingSampleInclusive = mBitBeginSamples.front();
@@ -107,7 +77,7 @@ void USBPacket::AddSyncAndPidFrames( USBAnalyzerResults* pResults, USBFrameFlags
     f.mType = FT_SYNC;
     f.mData1 = f.mData2 = 0;
     f.mFlags = FF_None;
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 
     // PID
     f.mStartingSampleInclusive = *( mBitBeginSamples.begin() + 8 );
@@ -116,12 +86,12 @@ void USBPacket::AddSyncAndPidFrames( USBAnalyzerResults* pResults, USBFrameFlags
     f.mData1 = mPID;
     f.mData2 = 0;
     f.mFlags = flagPID;
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 }
 
-void USBPacket::AddEOPFrame( USBAnalyzerResults* pResults )
+void USBPacket::AddEOPFrame( USBFrameSink* pSink )
 {
-    Frame f;
+    USBFrame f;
 
     // add the EOP frame
     f.mStartingSampleInclusive = mBitBeginSamples.back();
@@ -130,12 +100,12 @@ void USBPacket::AddEOPFrame( USBAnalyzerResults* pResults )
     f.mData1 = f.mData2 = 0;
     f.mFlags = FF_None;
     f.mType = FT_EOP;
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 }
 
-void USBPacket::AddCRC16Frame( USBAnalyzerResults* pResults )
+void USBPacket::AddCRC16Frame( USBFrameSink* pSink )
 {
-    Frame f;
+    USBFrame f;
 
     // CRC16
     f.mStartingSampleInclusive = *( mBitBeginSamples.end() - 17 );
@@ -144,15 +114,15 @@ void USBPacket::AddCRC16Frame( USBAnalyzerResults* pResults )
     f.mType = FT_CRC16;
     f.mData1 = mCRC;
     f.mData2 = CalcCRC16();
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 }
 
-U64 USBPacket::AddPacketFrames( USBAnalyzerResults* pResults, USBFrameFlags flagPID )
+U64 USBPacket::AddPacketFrames( USBFrameSink* pSink, USBFrameFlags flagPID )
 {
-    AddSyncAndPidFrames( pResults, flagPID );
+    AddSyncAndPidFrames( pSink, flagPID );
 
     // make the analyzer frames for this packet
-    Frame f;
+    USBFrame f;
     f.mFlags = FF_None;
 
     // do the payload & CRC frames
@@ -176,7 +146,7 @@ U64 USBPacket::AddPacketFrames( USBAnalyzerResults* pResults, USBFrameFlags flag
             f.mData2 = GetEndpoint();
         }
 
-        pResults->AddFrame( f );
+        pSink->AddFrame( f );
 
         // CRC5
         f.mStartingSampleInclusive = *( mBitBeginSamples.begin() + 27 );
@@ -185,7 +155,7 @@ U64 USBPacket::AddPacketFrames( USBAnalyzerResults* pResults, USBFrameFlags flag
         f.mType = FT_CRC5;
         f.mData1 = mCRC;
         f.mData2 = CalcCRC5( GetLastWord() & 0x7ff );
-        pResults->AddFrame( f );
+        pSink->AddFrame( f );
     }
     else if( IsDataPacket() )
     {
@@ -199,37 +169,37 @@ U64 USBPacket::AddPacketFrames( USBAnalyzerResults* pResults, USBFrameFlags flag
             f.mEndingSampleInclusive = *( mBitBeginSamples.begin() + ( bc + 1 ) * 8 );
             f.mData1 = mData[ bc ];
 
-            pResults->AddFrame( f );
+            pSink->AddFrame( f );
         }
 
-        AddCRC16Frame( pResults );
+        AddCRC16Frame( pSink );
     }
 
     if( mPID != PID_PRE )
-        AddEOPFrame( pResults );
+        AddEOPFrame( pSink );
 
-    pResults->CommitResults();
+    pSink->CommitFrames();
 
     return mSampleEnd;
 }
 
-U64 USBPacket::AddRawByteFrames( USBAnalyzerResults* pResults )
+U64 USBPacket::AddRawByteFrames( USBFrameSink* pSink )
 {
     // raw data
     size_t bc;
-    Frame f;
+    USBFrame f;
     f.mType = FT_Byte;
     f.mData2 = 0;
     f.mFlags = FF_None;
     std::string bytes_row;
     for( bc = 0; bc < mData.size(); ++bc )
     {
-        bytes_row += int2str_sal( mData[ bc ], Hexadecimal, 8 ) + ", ";
+        bytes_row += int2str_sal( mData[ bc ], DB_Hexadecimal, 8 ) + ", ";
 
         f.mStartingSampleInclusive = *( mBitBeginSamples.begin() + bc * 8 );
         f.mEndingSampleInclusive = *( mBitBeginSamples.begin() + ( bc + 1 ) * 8 );
         f.mData1 = mData[ bc ];
-        pResults->AddFrame( f );
+        pSink->AddFrame( f );
     }
 
     // add the EOP frame
@@ -239,57 +209,57 @@ U64 USBPacket::AddRawByteFrames( USBAnalyzerResults* pResults )
     f.mData1 = f.mData2 = 0;
     f.mFlags = FF_None;
     f.mType = FT_EOP;
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 
-    pResults->CommitResults();
+    pSink->CommitFrames();
 
     return f.mEndingSampleInclusive;
 }
 
-U64 USBPacket::AddErrorFrame( USBAnalyzerResults* pResults )
+U64 USBPacket::AddErrorFrame( USBFrameSink* pSink )
 {
     // add the Error frame -- parser can't decode the packet
-    Frame f;
+    USBFrame f;
     f.mStartingSampleInclusive = mSampleBegin;
     f.mEndingSampleInclusive = mSampleEnd;
     f.mData1 = f.mData2 = 0;
     f.mFlags = FF_None;
     f.mType = FT_Error;
-    pResults->AddFrame( f );
+    pSink->AddFrame( f );
 
-    pResults->CommitResults();
+    pSink->CommitFrames();
 
     return f.mEndingSampleInclusive;
 }
 
-void USBSignalState::AddFrame( USBAnalyzerResults* res )
+void USBSignalState::AddFrame( USBFrameSink* pSink )
 {
-    Frame f;
+    USBFrame f;
     f.mStartingSampleInclusive = mSampleBegin;
     f.mEndingSampleInclusive = mSampleEnd;
     f.mType = FT_Signal;
     f.mData1 = mState;
     f.mData2 = 0;
 
-    res->AddFrame( f );
-    res->CommitResults();
+    pSink->AddFrame( f );
+    pSink->CommitFrames();
 }
 
-USBSignalFilter::USBSignalFilter( USBAnalyzer* pAnalyzer, USBAnalyzerResults* pResults, USBAnalyzerSettings* pSettings,
-                                  AnalyzerChannelData* pDP, AnalyzerChannelData* pDM, USBSpeed speed )
-    : mAnalyzer( pAnalyzer ),
-      mResults( pResults ),
-      mSettings( pSettings ),
-      mDP( pDP ),
+USBSignalFilter::USBSignalFilter( USBFrameSink* pSink, USBEdgeSource* pDP, USBEdgeSource* pDM, U32 sampleRate, USBSpeed speed,
+                                  USBPerfCounters* pPerf )
+    : mDP( pDP ),
       mDM( pDM ),
+      mSink( pSink ),
+      mpPerf( pPerf ),
+      mBusSpeed( speed ),
       mSpeed( speed ),
       mExpectLowSpeed( false ),
-      mSampleDur( 1e9 / mAnalyzer->GetSampleRate() )
+      mSampleDur( 1e9 / sampleRate )
 {
     mStateStartSample = mDP->GetSampleNumber();
 }
 
-bool USBSignalFilter::SkipNoise( AnalyzerChannelData* pNearer, AnalyzerChannelData* pFurther )
+bool USBSignalFilter::SkipNoise( USBEdgeSource* pNearer, USBEdgeSource* pFurther )
 {
     if( mSampleDur > 20 // sample rate < 50Mhz?
         || mSpeed == FULL_SPEED )
@@ -310,10 +280,10 @@ bool USBSignalFilter::SkipNoise( AnalyzerChannelData* pNearer, AnalyzerChannelDa
     return false;
 }
 
-U64 USBSignalFilter::DoFilter( AnalyzerChannelData* mDP, AnalyzerChannelData* mDM )
+U64 USBSignalFilter::DoFilter( USBEdgeSource* mDP, USBEdgeSource* mDM )
 {
-    AnalyzerChannelData* pFurther;
-    AnalyzerChannelData* pNearer;
+    USBEdgeSource* pFurther;
+    USBEdgeSource* pNearer;
     U64 next_edge_further;
     U64 next_edge_nearer;
 
@@ -332,7 +302,7 @@ U64 USBSignalFilter::DoFilter( AnalyzerChannelData* mDP, AnalyzerChannelData* mD
         pFurther->AdvanceToAbsPosition( next_edge_nearer );
     } while( SkipNoise( pNearer, pFurther ) );
 
-    const int FILTER_THLD = mSettings->mSpeed == LOW_SPEED ? 300 : 50; // filtering threshold in ns
+    const int FILTER_THLD = mBusSpeed == LOW_SPEED ? 300 : 50; // filtering threshold in ns
 
     U64 diff_samples = next_edge_further - next_edge_nearer;
     // if there's a pulse on pNearer and no transition on pFurther
@@ -367,14 +337,18 @@ USBSignalState USBSignalFilter::GetState()
     ret_val.mSampleBegin = mStateStartSample;
 
     // determine the USB signal state
-    BitState dp_state = mDP->GetBitState();
-    BitState dm_state = mDM->GetBitState();
+    USBBitState dp_state = mDP->GetBitState();
+    USBBitState dm_state = mDM->GetBitState();
     if( dp_state == dm_state )
-        ret_val.mState = dp_state == BIT_LOW ? S_SE0 : S_SE1;
+        ret_val.mState = dp_state == BS_Low ? S_SE0 : S_SE1;
     else
-        ret_val.mState = ( mSpeed == LOW_SPEED ? ( dp_state == BIT_LOW ? S_J : S_K ) : ( dp_state == BIT_LOW ? S_K : S_J ) );
+        ret_val.mState = ( mSpeed == LOW_SPEED ? ( dp_state == BS_Low ? S_J : S_K ) : ( dp_state == BS_Low ? S_K : S_J ) );
 
     // do the filtering and remember the sample begin for the next iteration
+    USBPerfTimer timer( mpPerf, PS_Filter, PERF_SAMPLE_PERIOD );
+    if( mpPerf != NULL )
+        mpPerf->Count( PC_States );
+
     mStateStartSample = DoFilter( mDP, mDM );
 
     ret_val.mDur = ( mStateStartSample - ret_val.mSampleBegin ) * mSampleDur;
@@ -418,8 +392,7 @@ bool USBSignalFilter::GetPacket( USBPacket& pckt, USBSignalState& sgnl )
     }
 
     const double BIT_DUR = ( mSpeed == FULL_SPEED ? FS_BIT_DUR : LS_BIT_DUR );
-    const double SAMPLE_DUR = 1e9 / mAnalyzer->GetSampleRate(); // 1 sample duration in ns
-    const double BIT_SAMPLES = BIT_DUR / SAMPLE_DUR;
+    const double BIT_SAMPLES = BIT_DUR / mSampleDur;
 
     std::vector<U8> bits;
 
@@ -450,9 +423,8 @@ bool USBSignalFilter::GetPacket( USBPacket& pckt, USBSignalState& sgnl )
             if( !is_stuff_bit || bc > 0 )
                 pckt.mBitBeginSamples.push_back( sgnl.mSampleBegin + U64( BIT_SAMPLES * bc + .5 ) );
 
-            mResults->AddMarker( sgnl.mSampleBegin + U64( BIT_SAMPLES * ( bc + .5 ) + .5 ),
-                                 bc == 0 ? ( is_stuff_bit ? AnalyzerResults::ErrorX : AnalyzerResults::Zero ) : AnalyzerResults::One,
-                                 mSettings->mDPChannel );
+            mSink->AddBitMarker( sgnl.mSampleBegin + U64( BIT_SAMPLES * ( bc + .5 ) + .5 ),
+                                 bc == 0 ? ( is_stuff_bit ? BM_StuffBit : BM_Zero ) : BM_One );
         }
 
         // check if this is a PRE token, in which case we switch to low-speed,
@@ -488,7 +460,7 @@ bool USBSignalFilter::GetPacket( USBPacket& pckt, USBSignalState& sgnl )
 
     // remember the begin & end samples for the entire packet
     pckt.mSampleBegin = pckt.mBitBeginSamples.front();
-    pckt.mSampleEnd = sgnl.mSampleEnd + S64( BIT_DUR / SAMPLE_DUR + 0.5 );
+    pckt.mSampleEnd = sgnl.mSampleEnd + S64( BIT_DUR / mSampleDur + 0.5 );
 
     // make bytes out of these bits
     U8 val = 0;
@@ -527,9 +499,9 @@ bool USBSignalFilter::GetPacket( USBPacket& pckt, USBSignalState& sgnl )
            ( pckt.IsSOFPacket() && pckt.mData.size() == 4 );
 }
 
-std::string int2str_sal( const U64 i, DisplayBase base, const int max_bits )
+std::string int2str_sal( const U64 i, USBDisplayBase base, const int max_bits )
 {
-    char number_str[ 256 ];
-    AnalyzerHelpers::GetNumberString( i, base, max_bits, number_str, sizeof( number_str ) );
+    char number_str[ 128 ];
+    FormatNumber( number_str, sizeof( number_str ), i, base, max_bits );
     return number_str;
 }
@@ -2,17 +2,18 @@
 #define USB_TYPES_H
 
 #include <map>
+#include <string>
 #include <vector>
 
-#include <LogicPublicTypes.h>
-#include <AnalyzerResults.h>
-#include <AnalyzerChannelData.h>
-#include <AnalyzerHelpers.h>
-
+#include "USBCoreTypes.h"
 #include "USBEnums.h"
 
-class USBAnalyzerResults;
+class USBFrameSink;
+class USBEdgeSource;
+class USBPerfCounters;
 class USBControlTransferParser;
+class USBHidReportLayout;
+struct USBHidReportState;
 
 struct USBPacket
 {
@@ -83,27 +84,30 @@ struct USBPacket
     static U8 CalcCRC5( U16 data );
     U16 CalcCRC16() const;
 
-    void AddSyncAndPidFrames( USBAnalyzerResults* pResults, USBFrameFlags flagPID = FF_None );
-    void AddEOPFrame( USBAnalyzerResults* pResults );
-    void AddCRC16Frame( USBAnalyzerResults* pResults );
+    void AddSyncAndPidFrames( USBFrameSink* pSink, USBFrameFlags flagPID = FF_None );
+    void AddEOPFrame( USBFrameSink* pSink );
+    void AddCRC16Frame( USBFrameSink* pSink );
 
-    U64 AddPacketFrames( USBAnalyzerResults* pResults, USBFrameFlags flagPID = FF_None );
-    U64 AddRawByteFrames( USBAnalyzerResults* pResults );
-    U64 AddErrorFrame( USBAnalyzerResults* pResults );
+    U64 AddPacketFrames( USBFrameSink* pSink, USBFrameFlags flagPID = FF_None );
+    U64 AddRawByteFrames( USBFrameSink* pSink );
+    U64 AddErrorFrame( USBFrameSink* pSink );
 
     // control transfer decoders
     // these are defined in USBControlTransfer.cpp
-    U64 AddSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address );
-    void AddStandardSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address );
-    void AddClassSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address );
-    void AddVendorSetupPacketFrame( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address );
-    U64 AddDataStageFrames( USBAnalyzerResults* pResults, USBControlTransferParser& parser, U8 address );
-
-    Frame GetDataPayloadField( int ndx, int bcnt, U8 address, const char* name, USBCtrlTransFieldType fldHandler = Fld_None,
-                               U8 flags = 0 ) const;
+    U64 AddSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address );
+    void AddStandardSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address );
+    void AddClassSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address );
+    void AddVendorSetupPacketFrame( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address );
+    U64 AddDataStageFrames( USBFrameSink* pSink, USBControlTransferParser& parser, U8 address );
+
+    // the input and output reports of HID interrupt endpoints
+    // this is defined in USBHidReports.cpp
+    U64 AddHIDReportFrames( USBFrameSink* pSink, const USBHidReportLayout& layout, USBHidReportType type, U16 maxPacketSize,
+                            USBHidReportState& state );
+
+    USBFrame GetDataPayloadField( int ndx, int bcnt, U8 address, const char* name, USBCtrlTransFieldType fldHandler = Fld_None,
+                                  U8 flags = 0 ) const;
     U32 GetDataPayload( int ndx, int bcnt ) const;
-
-    Frame GetHIDItem( int offset, int bcnt, U8* pItem, U16 indentLevel, U16 usagePage, U8 flags ) const;
 };
 
 const double FS_BIT_DUR = ( 1000 / 12.0 ); // 83.3 ns
@@ -138,34 +142,30 @@ struct USBSignalState
         return int( mDur / BIT_DUR + 0.5 );
     }
 
-    void AddFrame( USBAnalyzerResults* res );
+    void AddFrame( USBFrameSink* pSink );
 };
 
-class USBAnalyzer;
-class USBAnalyzerResults;
-class USBAnalyzerSettings;
-
 class USBSignalFilter
 {
   private:
-    AnalyzerChannelData* mDP;
-    AnalyzerChannelData* mDM;
+    USBEdgeSource* mDP;
+    USBEdgeSource* mDM;
 
-    USBAnalyzer* mAnalyzer;
-    USBAnalyzerResults* mResults;
-    USBAnalyzerSettings* mSettings;
+    USBFrameSink* mSink; // gets the bit markers
+    USBPerfCounters* mpPerf;
 
-    USBSpeed mSpeed;         // LS or FS
-    bool mExpectLowSpeed;    // this is set to true after a PRE packet
-    const double mSampleDur; // in ns
-    U64 mStateStartSample;   // used for filtered signal state start between calls
+    const USBSpeed mBusSpeed; // the speed of the bus; mSpeed changes after a PRE packet
+    USBSpeed mSpeed;          // LS or FS
+    bool mExpectLowSpeed;     // this is set to true after a PRE packet
+    const double mSampleDur;  // in ns
+    U64 mStateStartSample;    // used for filtered signal state start between calls
 
-    bool SkipNoise( AnalyzerChannelData* pNearer, AnalyzerChannelData* pFurther );
-    U64 DoFilter( AnalyzerChannelData* mDP, AnalyzerChannelData* mDM );
+    bool SkipNoise( USBEdgeSource* pNearer, USBEdgeSource* pFurther );
+    U64 DoFilter( USBEdgeSource* mDP, USBEdgeSource* mDM );
 
   public:
-    USBSignalFilter( USBAnalyzer* pAnalyzer, USBAnalyzerResults* pResults, USBAnalyzerSettings* pSettings, AnalyzerChannelData* pDP,
-                     AnalyzerChannelData* pDM, USBSpeed speed );
+    USBSignalFilter( USBFrameSink* pSink, USBEdgeSource* pDP, USBEdgeSource* pDM, U32 sampleRate, USBSpeed speed,
+                     USBPerfCounters* pPerf = NULL );
 
     bool HasMoreData();
     USBSignalState GetState();
@@ -177,11 +177,11 @@ class USBSignalFilter
     }
 };
 
-std::string int2str_sal( const U64 i, DisplayBase base, const int max_bits = 8 );
+std::string int2str_sal( const U64 i, USBDisplayBase base, const int max_bits = 8 );
 
 inline std::string int2str( const U64 i )
 {
-    return int2str_sal( i, Decimal, 64 );
+    return int2str_sal( i, DB_Decimal, 64 );
 }
 
 /*
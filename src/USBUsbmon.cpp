@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "USBUsbmon.h"
+
+USBUrbBuilder::USBUrbBuilder() : mNextUrbId( 1 )
+{
+    mTransaction.mValid = false;
+}
+
+void USBUrbBuilder::AddPacket( const USBPacket& pckt )
+{
+    if( pckt.IsTokenPacket() )
+    {
+        // a transaction without a handshake we lost is simply dropped
+        mTransaction.mValid = true;
+        mTransaction.mTokenPID = pckt.mPID;
+        mTransaction.mAddress = pckt.GetAddress();
+        mTransaction.mEndpoint = pckt.GetEndpoint();
+        mTransaction.mSampleBegin = pckt.mSampleBegin;
+        mTransaction.mHasData = false;
+        mTransaction.mData.clear();
+    }
+    else if( pckt.IsSOFPacket() )
+    {
+        mTransaction.mValid = false;
+    }
+    else if( pckt.IsDataPacket() )
+    {
+        if( mTransaction.mValid && !mTransaction.mHasData )
+        {
+            mTransaction.mHasData = true;
+            if( pckt.mData.size() > 4 )
+                mTransaction.mData.assign( pckt.mData.begin() + 2, pckt.mData.end() - 2 );
+
+            // isochronous transactions have no handshake
+            const U8 endpoint = mTransaction.mEndpoint | ( mTransaction.mTokenPID == PID_IN ? 0x80 : 0 );
+            if( mTransaction.mEndpoint != 0 && GetTransferType( mTransaction.mAddress, endpoint ) == URB_ISOCHRONOUS )
+            {
+                CompleteTransaction( PID_ACK, pckt.mSampleEnd );
+                mTransaction.mValid = false;
+            }
+        }
+    }
+    else if( pckt.IsHandshakePacket() )
+    {
+        if( mTransaction.mValid )
+            CompleteTransaction( pckt.mPID, pckt.mSampleEnd );
+
+        mTransaction.mValid = false;
+    }
+}
+
+void USBUrbBuilder::Reset( U64 sample )
+{
+    // the host kills all the pending control transfers
+    while( !mControlUrbs.empty() )
+        CompleteControlUrb( mControlUrbs.begin()->first, URB_STATUS_EPROTO, sample );
+
+    // and the device which answers at address 0 now is not configured
+    mDevices.erase( 0 );
+
+    mTransaction.mValid = false;
+}
+
+void USBUrbBuilder::AbortTransaction()
+{
+    mTransaction.mValid = false;
+}
+
+void USBUrbBuilder::CompleteTransaction( USB_PID handshake, U64 sampleEnd )
+{
+    const Transaction& t = mTransaction;
+    const USBPipeId pipe( t.mAddress, t.mEndpoint );
+    const bool tokenIn = t.mTokenPID == PID_IN;
+
+    if( t.mEndpoint != 0 )
+    {
+        // the host retries NAKed transactions, so they are not URBs
+        if( handshake == PID_NAK )
+            return;
+
+        S32 status = handshake == PID_STALL ? URB_STATUS_EPIPE : URB_STATUS_OK;
+        std::vector<U8> data;
+        if( handshake == PID_ACK )
+            data = t.mData;
+
+        const U8 endpoint = t.mEndpoint | ( tokenIn ? 0x80 : 0 );
+        AddEvents( mNextUrbId++, GetTransferType( t.mAddress, endpoint ), t.mAddress, endpoint, NULL, U16( data.size() ), data, status,
+                   t.mSampleBegin, sampleEnd );
+        return;
+    }
+
+    // control transfers
+    if( t.mTokenPID == PID_SETUP )
+    {
+        if( handshake != PID_ACK || t.mData.size() != 8 )
+            return;
+
+        // a new SETUP aborts the previous control transfer on this pipe
+        if( mControlUrbs.find( pipe ) != mControlUrbs.end() )
+            CompleteControlUrb( pipe, URB_STATUS_EPROTO, t.mSampleBegin );
+
+        ControlUrb& urb = mControlUrbs[ pipe ];
+        urb.mId = mNextUrbId++;
+        urb.mSampleBegin = t.mSampleBegin;
+        memcpy( urb.mSetup, &t.mData.front(), sizeof urb.mSetup );
+        urb.mData.clear();
+
+        return;
+    }
+
+    std::map<USBPipeId, ControlUrb>::iterator srch = mControlUrbs.find( pipe );
+    if( srch == mControlUrbs.end() )
+        return;
+
+    if( handshake == PID_STALL )
+    {
+        CompleteControlUrb( pipe, URB_STATUS_EPIPE, sampleEnd );
+    }
+    else if( handshake == PID_ACK )
+    {
+        const bool dataIn = ( srch->second.mSetup[ 0 ] & 0x80 ) != 0;
+        const U16 wLength = srch->second.mSetup[ 6 ] | ( srch->second.mSetup[ 7 ] << 8 );
+
+        // the status stage goes in the direction opposite to the data stage, or IN if there is no data stage
+        if( wLength == 0 ? tokenIn : tokenIn != dataIn )
+            CompleteControlUrb( pipe, URB_STATUS_OK, sampleEnd );
+        else
+            srch->second.mData.insert( srch->second.mData.end(), t.mData.begin(), t.mData.end() );
+    }
+}
+
+void USBUrbBuilder::CompleteControlUrb( const USBPipeId& pipe, S32 status, U64 sampleEnd )
+{
+    std::map<USBPipeId, ControlUrb>::iterator srch = mControlUrbs.find( pipe );
+    const ControlUrb& urb = srch->second;
+
+    AddEvents( urb.mId, URB_CONTROL, pipe.first, pipe.second | ( urb.mSetup[ 0 ] & 0x80 ), urb.mSetup,
+               urb.mSetup[ 6 ] | ( urb.mSetup[ 7 ] << 8 ), urb.mData, status, urb.mSampleBegin, sampleEnd );
+
+    if( status == URB_STATUS_OK )
+        UpdateDevice( pipe.first, urb );
+
+    mControlUrbs.erase( srch );
+}
+
+void USBUrbBuilder::UpdateDevice( U8 address, const ControlUrb& urb )
+{
+    const U8 bmRequestType = urb.mSetup[ 0 ];
+    const U8 bRequest = urb.mSetup[ 1 ];
+    const U8 wValueLo = urb.mSetup[ 2 ];
+    const U8 wIndexLo = urb.mSetup[ 4 ];
+
+    USBDeviceModel& device = mDevices[ address ];
+    if( bmRequestType == 0x80 && bRequest == GET_DESCRIPTOR )
+    {
+        // the descriptors one by one, as the configuration descriptor comes with the ones after it
+        for( size_t offset = 0; offset + 2 <= urb.mData.size() && urb.mData[ offset ] >= 2; offset += urb.mData[ offset ] )
+        {
+            const size_t descBytes = std::min<size_t>( urb.mData[ offset ], urb.mData.size() - offset );
+            device.AddDescriptor( &urb.mData[ offset ], int( descBytes ) );
+        }
+    }
+    else if( bmRequestType == 0x00 && bRequest == SET_ADDRESS )
+    {
+        const U8 newAddress = wValueLo & 0x7f;
+        device.SetAddress( newAddress );
+        if( newAddress != address )
+        {
+            mDevices[ newAddress ] = device;
+            mDevices.erase( address );
+        }
+    }
+    else if( bmRequestType == 0x00 && bRequest == SET_CONFIGURATION )
+    {
+        device.SetConfiguration( wValueLo );
+    }
+    else if( bmRequestType == 0x01 && bRequest == SET_INTERFACE )
+    {
+        device.SetInterface( wIndexLo, wValueLo );
+    }
+}
+
+USBUrbTransferType USBUrbBuilder::GetTransferType( U8 address, U8 endpoint ) const
+{
+    std::map<U8, USBDeviceModel>::const_iterator srch = mDevices.find( address );
+    const USBEndpointType type = srch != mDevices.end() ? srch->second.GetEndpointType( endpoint ) : EPT_Unknown;
+
+    if( type == EPT_Isochronous )
+        return URB_ISOCHRONOUS;
+    else if( type == EPT_Interrupt )
+        return URB_INTERRUPT;
+
+    return URB_BULK;
+}
+
+void USBUrbBuilder::AddEvents( U64 id, USBUrbTransferType xferType, U8 address, U8 endpoint, const U8* pSetup, U16 requested,
+                               const std::vector<U8>& data, S32 status, U64 sampleBegin, U64 sampleEnd )
+{
+    USBUrbEvent ev;
+    ev.mId = id;
+    ev.mXferType = xferType;
+    ev.mAddress = address;
+    ev.mEndpoint = endpoint;
+
+    // submission - OUT data goes with the submission
+    ev.mType = 'S';
+    ev.mSample = sampleBegin;
+    ev.mStatus = URB_STATUS_EINPROGRESS;
+    ev.mLength = requested;
+    ev.mHasSetup = pSetup != NULL;
+    if( ev.mHasSetup )
+        memcpy( ev.mSetup, pSetup, sizeof ev.mSetup );
+    if( !ev.IsIn() )
+        ev.mData = data;
+    ev.mDataFlag = ev.IsIn() ? '<' : 0;
+    mEvents.push_back( ev );
+
+    // callback - IN data goes with the callback
+    ev.mType = 'C';
+    ev.mSample = sampleEnd;
+    ev.mStatus = status;
+    ev.mLength = U32( data.size() );
+    ev.mHasSetup = false;
+    ev.mData.clear();
+    if( ev.IsIn() )
+        ev.mData = data;
+    ev.mDataFlag = ev.IsIn() ? 0 : '>';
+    mEvents.push_back( ev );
+}
+
+static const char* GetUrbTypeStr( const USBUrbEvent& ev )
+{
+    static const char* types[] = { "Zo", "Zi", "Io", "Ii", "Co", "Ci", "Bo", "Bi" };
+    return types[ ev.mXferType * 2 + ( ev.IsIn() ? 1 : 0 ) ];
+}
+
+static U64 GetMicroseconds( U64 sample, U32 sample_rate )
+{
+    return U64( sample * 1e6 / sample_rate );
+}
+
+void WriteUsbmonText( std::ostream& os, const USBUrbEvent& ev, U32 sample_rate )
+{
+    const U32 DATA_MAX = 32; // usbmon text shows at most this many bytes
+    char buff[ 256 ];
+    int len;
+
+    len = snprintf( buff, sizeof buff, "%llx %u %c %s:1:%03u:%u", ( unsigned long long )ev.mId,
+                    U32( GetMicroseconds( ev.mSample, sample_rate ) ), ev.mType, GetUrbTypeStr( ev ), ev.mAddress, ev.mEndpoint & 0x7f );
+
+    if( ev.mHasSetup )
+        len += snprintf( buff + len, sizeof buff - len, " s %02x %02x %04x %04x %04x", ev.mSetup[ 0 ], ev.mSetup[ 1 ],
+                         ev.mSetup[ 2 ] | ( ev.mSetup[ 3 ] << 8 ), ev.mSetup[ 4 ] | ( ev.mSetup[ 5 ] << 8 ),
+                         ev.mSetup[ 6 ] | ( ev.mSetup[ 7 ] << 8 ) );
+    else
+        len += snprintf( buff + len, sizeof buff - len, " %d", ev.mStatus );
+
+    len += snprintf( buff + len, sizeof buff - len, " %u", ev.mLength );
+
+    if( ev.mLength > 0 )
+    {
+        if( ev.mDataFlag == 0 )
+        {
+            len += snprintf( buff + len, sizeof buff - len, " =" );
+            for( U32 bc = 0; bc < ev.mData.size() && bc < DATA_MAX; ++bc )
+                len += snprintf( buff + len, sizeof buff - len, bc % 4 == 0 ? " %02x" : "%02x", ev.mData[ bc ] );
+        }
+        else
+        {
+            len += snprintf( buff + len, sizeof buff - len, " %c", ev.mDataFlag );
+        }
+    }
+
+    os << buff << '\n';
+}
+
+static void PutLE( U8* pDest, U64 val, int numBytes )
+{
+    for( int bc = 0; bc < numBytes; ++bc )
+        pDest[ bc ] = U8( val >> ( bc * 8 ) );
+}
+
+void WriteUsbmonBinary( std::ostream& os, const USBUrbEvent& ev, U32 sample_rate )
+{
+    const size_t PKT_ALIGN = 64;
+    U8 hdr[ PKT_ALIGN ];
+    memset( hdr, 0, sizeof hdr );
+
+    const U64 usec = GetMicroseconds( ev.mSample, sample_rate );
+
+    // struct mon_bin_hdr, little endian
+    PutLE( hdr + 0, ev.mId, 8 );
+    hdr[ 8 ] = ev.mType;
+    hdr[ 9 ] = ev.mXferType;
+    hdr[ 10 ] = ev.mEndpoint;
+    hdr[ 11 ] = ev.mAddress;
+    PutLE( hdr + 12, 1, 2 ); // bus number
+    hdr[ 14 ] = ev.mHasSetup ? 0 : '-';
+    hdr[ 15 ] = ev.mDataFlag;
+    PutLE( hdr + 16, usec / 1000000, 8 );
+    PutLE( hdr + 24, usec % 1000000, 4 );
+    PutLE( hdr + 28, U32( ev.mStatus ), 4 );
+    PutLE( hdr + 32, ev.mLength, 4 );
+    PutLE( hdr + 36, ev.mData.size(), 4 );
+    if( ev.mHasSetup )
+        memcpy( hdr + 40, ev.mSetup, sizeof ev.mSetup );
+    // interval, start_frame, xfer_flags and ndesc stay 0
+
+    os.write( ( const char* )hdr, sizeof hdr );
+
+    if( !ev.mData.empty() )
+    {
+        os.write( ( const char* )&ev.mData.front(), ev.mData.size() );
+
+        // pad to the next record
+        const char pad[ PKT_ALIGN ] = { 0 };
+        if( ev.mData.size() % PKT_ALIGN != 0 )
+            os.write( pad, PKT_ALIGN - ev.mData.size() % PKT_ALIGN );
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef USB_USBMON_H
+#define USB_USBMON_H
+
+#include <map>
+#include <vector>
+#include <ostream>
+
+#include "USBCoreTypes.h"
+#include "USBTypes.h"
+#include "USBDeviceModel.h"
+
+// transfer types as used by the Linux usbmon
+enum USBUrbTransferType
+{
+    URB_ISOCHRONOUS = 0,
+    URB_INTERRUPT = 1,
+    URB_CONTROL = 2,
+    URB_BULK = 3,
+};
+
+// Linux error codes usbmon puts in the status field
+const S32 URB_STATUS_OK = 0;
+const S32 URB_STATUS_EPIPE = -32;        // endpoint stalled
+const S32 URB_STATUS_EPROTO = -71;       // transfer interrupted by a new SETUP or a reset
+const S32 URB_STATUS_EINPROGRESS = -115; // status of all submissions
+
+// one usbmon event: a URB submission ('S') or callback ('C')
+struct USBUrbEvent
+{
+    U64 mId;    // the same for the submission and callback of a URB
+    char mType; // 'S' or 'C'
+    USBUrbTransferType mXferType;
+    U8 mAddress;
+    U8 mEndpoint; // endpoint number with 0x80 set for IN
+    U64 mSample;
+    S32 mStatus;
+    U32 mLength; // requested length for submissions, actual length for callbacks
+
+    bool mHasSetup; // only for control submissions
+    U8 mSetup[ 8 ];
+
+    std::vector<U8> mData; // captured data
+    char mDataFlag;        // 0 if the data is captured, '<' or '>' otherwise
+
+    bool IsIn() const
+    {
+        return ( mEndpoint & 0x80 ) != 0;
+    }
+};
+
+// Rebuilds URB-like records from the USB packets on the bus. Control transfers become one URB from
+// the SETUP to the status stage, other endpoints get one URB per transaction that was not NAKed.
+// The submission is only known when the URB completes, so both events are made at that point.
+// The transfer type of an endpoint comes from the descriptors the device returned in the capture;
+// endpoints we have no descriptor for are taken as bulk.
+class USBUrbBuilder
+{
+  public:
+    USBUrbBuilder();
+
+    void AddPacket( const USBPacket& pckt );
+    void Reset( U64 sample ); // USB reset on the bus
+    void AbortTransaction();  // the analyzer could not decode a packet
+
+    // events made from the packets so far, in order of URB completion
+    std::vector<USBUrbEvent>& GetEvents()
+    {
+        return mEvents;
+    }
+
+  private:
+    struct Transaction
+    {
+        bool mValid;
+        USB_PID mTokenPID;
+        U8 mAddress;
+        U8 mEndpoint;
+        U64 mSampleBegin;
+
+        bool mHasData;
+        std::vector<U8> mData;
+    };
+
+    struct ControlUrb
+    {
+        U64 mId;
+        U64 mSampleBegin;
+        U8 mSetup[ 8 ];
+        std::vector<U8> mData;
+    };
+
+    typedef std::pair<U8, U8> USBPipeId; // address, endpoint
+
+    Transaction mTransaction;
+    std::map<USBPipeId, ControlUrb> mControlUrbs;
+    std::map<U8, USBDeviceModel> mDevices; // by address
+    std::vector<USBUrbEvent> mEvents;
+    U64 mNextUrbId;
+
+    void CompleteTransaction( USB_PID handshake, U64 sampleEnd );
+    void CompleteControlUrb( const USBPipeId& pipe, S32 status, U64 sampleEnd );
+    void UpdateDevice( U8 address, const ControlUrb& urb );
+    USBUrbTransferType GetTransferType( U8 address, U8 endpoint ) const;
+    void AddEvents( U64 id, USBUrbTransferType xferType, U8 address, U8 endpoint, const U8* pSetup, U16 requested,
+                    const std::vector<U8>& data, S32 status, U64 sampleBegin, U64 sampleEnd );
+};
+
+// writes the event in the usbmon text format, see Documentation/usb/usbmon.rst in the Linux kernel
+void WriteUsbmonText( std::ostream& os, const USBUrbEvent& ev, U32 sample_rate );
+
+// writes the event as a mon_bin record: a 64 byte header followed by the data, padded to 64 bytes
+// like the records in the usbmon mmap buffer
+void WriteUsbmonBinary( std::ostream& os, const USBUrbEvent& ev, U32 sample_rate );
+
+#endif // USB_USBMON_H
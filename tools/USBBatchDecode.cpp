@@ -0,0 +1,435 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <AnalyzerStandIn.h>
+
+#include "USBBatchDecode.h"
+#include "USBHeapCounter.h"
+#include "USBIdsDatabase.h"
+
+static bool IsDirectory( const char* path )
+{
+#ifdef _WIN32
+    const DWORD attributes = GetFileAttributesA( path );
+    return attributes != INVALID_FILE_ATTRIBUTES && ( attributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+#else
+    struct stat st;
+    return stat( path, &st ) == 0 && S_ISDIR( st.st_mode );
+#endif
+}
+
+// the files of the directory, without the hidden ones
+static bool GetDirectoryFiles( const std::string& dir, std::vector<std::string>& names )
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA( ( dir + "\\*" ).c_str(), &data );
+    if( find == INVALID_HANDLE_VALUE )
+        return false;
+
+    do
+    {
+        if( data.cFileName[ 0 ] != '.' && ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == 0 )
+            names.push_back( data.cFileName );
+    } while( FindNextFileA( find, &data ) );
+
+    FindClose( find );
+#else
+    DIR* pDir = opendir( dir.c_str() );
+    if( pDir == NULL )
+        return false;
+
+    while( struct dirent* pEntry = readdir( pDir ) )
+    {
+        struct stat st;
+        if( pEntry->d_name[ 0 ] != '.' && stat( ( dir + "/" + pEntry->d_name ).c_str(), &st ) == 0 && S_ISREG( st.st_mode ) )
+            names.push_back( pEntry->d_name );
+    }
+
+    closedir( pDir );
+#endif
+
+    return true;
+}
+
+bool GetBatchInputs( const char* path, std::vector<std::string>& inputs, std::string& error )
+{
+    inputs.clear();
+
+    if( IsDirectory( path ) )
+    {
+        std::vector<std::string> names;
+        if( !GetDirectoryFiles( path, names ) )
+        {
+            error = "can't read the directory";
+            return false;
+        }
+
+        std::sort( names.begin(), names.end() );
+        for( size_t nc = 0; nc < names.size(); ++nc )
+            inputs.push_back( std::string( path ) + "/" + names[ nc ] );
+    }
+    else
+    {
+        // a list, without the empty lines and the # comments
+        FILE* pFile = fopen( path, "r" );
+        if( pFile == NULL )
+        {
+            error = "can't read the file";
+            return false;
+        }
+
+        char line[ 4096 ];
+        while( fgets( line, sizeof( line ), pFile ) != NULL )
+        {
+            std::string input( line );
+            while( !input.empty() && ( input.back() == '\n' || input.back() == '\r' || input.back() == ' ' || input.back() == '\t' ) )
+                input.pop_back();
+
+            if( !input.empty() && input[ 0 ] != '#' )
+                inputs.push_back( input );
+        }
+
+        fclose( pFile );
+    }
+
+    if( inputs.empty() )
+    {
+        error = "no captures";
+        return false;
+    }
+
+    return true;
+}
+
+// what the decode of a capture found
+struct CaptureResult
+{
+    CaptureResult()
+        : ok( false ),
+          sampleRate( 0 ),
+          numSamples( 0 ),
+          numEdges( 0 ),
+          numPackets( 0 ),
+          numBadPackets( 0 ),
+          numUnexpected( 0 ),
+          numFrames( 0 ),
+          decodeSeconds( 0 ),
+          peakHeap( 0 )
+    {
+    }
+
+    bool ok;
+    std::string status; // what went wrong, or "ok"
+
+    U32 sampleRate;
+    U64 numSamples;
+    U64 numEdges;
+    U64 numPackets;
+    U64 numBadPackets; // the packets with a bad PID, CRC, bit stuffing or length
+    U64 numUnexpected; // the packets the device or the host shouldn't have sent then
+    U64 numFrames;
+    double decodeSeconds;
+    U64 peakHeap; // above the heap of the worker before the decode
+};
+
+struct MemoryLimit
+{
+    S64 heapBefore;
+    S64 maxHeap;
+};
+
+static bool IsOverMemoryLimit( void* context )
+{
+    const MemoryLimit* pLimit = static_cast<const MemoryLimit*>( context );
+    return GetHeapBytes() - pLimit->heapBefore > pLimit->maxHeap;
+}
+
+static std::string GetBaseName( const std::string& path )
+{
+    const size_t slash = path.find_last_of( "/\\" );
+    return slash == std::string::npos ? path : path.substr( slash + 1 );
+}
+
+static void DecodeCapture( OfflineAnalyzer& analyzer, const std::string& path, const USBBatchOptions& options, CaptureResult& res )
+{
+    // the heap of the worker, which is what the memory limit looks at: a worker decodes one capture at a time,
+    // and what the decode takes it takes on the worker
+    const S64 heapBefore = GetHeapBytes();
+    ResetPeakHeap();
+
+    USBEdgeInput input;
+    if( !input.Open( path.c_str(), options.inputOptions ) )
+    {
+        res.status = input.GetError();
+        return;
+    }
+
+    const USBAnalyzerSettings& settings = analyzer.GetSettings();
+    StandIn::SetChannelData( &analyzer, settings.mDPChannel, input.GetDP() );
+    StandIn::SetChannelData( &analyzer, settings.mDMChannel, input.GetDM() );
+    StandIn::SetSampleRate( &analyzer, input.GetSampleRate() );
+
+    MemoryLimit limit = { heapBefore, S64( options.maxMemory ) };
+    StandIn::SetExitCheck( &analyzer, options.maxMemory > 0 ? IsOverMemoryLimit : NULL, &limit );
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const bool completed = StandIn::RunWorkerThread( &analyzer );
+    res.decodeSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+    StandIn::SetExitCheck( &analyzer, NULL, NULL );
+
+    res.peakHeap = U64( GetPeakHeapBytes() - heapBefore );
+    res.sampleRate = input.GetSampleRate();
+    res.numSamples = input.GetLastSample() - input.GetFirstSample();
+    res.numEdges = input.GetNumEdges();
+
+    // a packet ends with an EOP at every decode level but the signals
+    res.numPackets = CountFrames( analyzer, FT_EOP );
+    res.numBadPackets = CountFrames( analyzer, FT_Error );
+    res.numUnexpected = CountFrames( analyzer, FT_PID, FF_UnexpectedPacket );
+    res.numFrames = analyzer.GetResults()->GetNumFrames();
+
+    if( !completed )
+    {
+        res.status = "over the memory limit";
+    }
+    else if( !options.outDir.empty() && options.format != OF_None )
+    {
+        const std::string outPath = options.outDir + "/" + GetBaseName( path ) + "." + options.extension;
+        if( WriteOutput( analyzer, options.format, outPath.c_str(), options.displayBase ) )
+        {
+            res.ok = true;
+            res.status = "ok";
+        }
+        else
+        {
+            res.status = "can't write " + outPath;
+        }
+    }
+    else
+    {
+        res.ok = true;
+        res.status = "ok";
+    }
+
+    // the input goes away with this capture
+    StandIn::SetChannelData( &analyzer, settings.mDPChannel, NULL );
+    StandIn::SetChannelData( &analyzer, settings.mDMChannel, NULL );
+    analyzer.ClearResults();
+}
+
+struct BatchState
+{
+    BatchState( const std::vector<std::string>& inputs, const USBBatchOptions& options )
+        : inputs( inputs ), options( options ), results( inputs.size() ), pUsbIds( NULL ), nextInput( 0 ), numDone( 0 )
+    {
+    }
+
+    const std::vector<std::string>& inputs;
+    const USBBatchOptions& options;
+    std::vector<CaptureResult> results;
+    USBIdsDatabase* pUsbIds; // shared by the analyzers of all the workers
+
+    std::atomic<size_t> nextInput;
+    size_t numDone;
+    std::mutex printMutex;
+};
+
+// the signals level has no packets, so the packet counts are n/a rather than 0
+static std::string FormatPacketCount( U64 num, const USBBatchOptions& options )
+{
+    if( options.level == OUT_SIGNALS )
+        return "n/a";
+
+    char text[ 32 ];
+    snprintf( text, sizeof( text ), "%llu", num );
+    return text;
+}
+
+// decodes captures until there are none left, with the same analyzer for all of them
+static void RunWorker( BatchState* pState )
+{
+    const USBBatchOptions& options = pState->options;
+
+    OfflineAnalyzer analyzer;
+    USBAnalyzerSettings& settings = analyzer.GetSettings();
+    settings.mDPChannel = Channel( 0, 0, DIGITAL_CHANNEL );
+    settings.mDMChannel = Channel( 0, 1, DIGITAL_CHANNEL );
+    settings.mSpeed = options.speed;
+    settings.mDecodeLevel = options.level;
+    settings.mUsbIdsFile = options.usbIdsFile;
+    settings.mpSharedUsbIds = pState->pUsbIds;
+    settings.mPerfCounters = false;
+
+    for( ;; )
+    {
+        const size_t index = pState->nextInput++;
+        if( index >= pState->inputs.size() )
+            break;
+
+        CaptureResult& res = pState->results[ index ];
+        DecodeCapture( analyzer, pState->inputs[ index ], options, res );
+
+        std::lock_guard<std::mutex> lock( pState->printMutex );
+        ++pState->numDone;
+        // the failures even when quiet, like the errors of a single decode
+        if( !options.quiet || !res.ok )
+        {
+            fprintf( stderr, "usb-decode: [%u/%u] %s: %s, %s packets, %s bad, %.3f s\n", unsigned( pState->numDone ),
+                     unsigned( pState->inputs.size() ), pState->inputs[ index ].c_str(), res.status.c_str(),
+                     FormatPacketCount( res.numPackets, options ).c_str(), FormatPacketCount( res.numBadPackets, options ).c_str(),
+                     res.decodeSeconds );
+        }
+    }
+}
+
+// quoted if it has to be
+static std::string CsvField( const std::string& text )
+{
+    if( text.find_first_of( ",\"\n" ) == std::string::npos )
+        return text;
+
+    std::string quoted = "\"";
+    for( size_t cc = 0; cc < text.size(); ++cc )
+    {
+        if( text[ cc ] == '"' )
+            quoted += '"';
+
+        quoted += text[ cc ];
+    }
+
+    return quoted + "\"";
+}
+
+// the bad packets of all the packets, as a fraction or in percent
+static std::string FormatErrorRate( const CaptureResult& res, const USBBatchOptions& options, double scale, const char* pFormat )
+{
+    if( options.level == OUT_SIGNALS )
+        return "n/a";
+
+    const U64 numAll = res.numPackets + res.numBadPackets;
+    char text[ 32 ];
+    snprintf( text, sizeof( text ), pFormat, numAll > 0 ? double( res.numBadPackets ) / double( numAll ) * scale : 0.0 );
+    return text;
+}
+
+static void WriteSummaryLine( FILE* pFile, const std::string& name, const std::string& status, const CaptureResult& res,
+                              const USBBatchOptions& options )
+{
+    fprintf( pFile, "%s,%s,%u,%llu,%llu,%s,%s,%s,%llu,%s,%.6f,%.0f,%.3f\n", CsvField( name ).c_str(), CsvField( status ).c_str(),
+             res.sampleRate, res.numSamples, res.numEdges, FormatPacketCount( res.numPackets, options ).c_str(),
+             FormatPacketCount( res.numBadPackets, options ).c_str(), FormatPacketCount( res.numUnexpected, options ).c_str(),
+             res.numFrames, FormatErrorRate( res, options, 1, "%.6f" ).c_str(), res.decodeSeconds,
+             res.decodeSeconds > 0 ? res.numEdges / res.decodeSeconds : 0.0, res.peakHeap / ( 1024.0 * 1024.0 ) );
+}
+
+int RunBatchDecode( const std::vector<std::string>& inputs, const USBBatchOptions& options )
+{
+    BatchState state( inputs, options );
+
+    // the lookup tables are static and shared, and the usb.ids database is opened and indexed once, here, for
+    // the results of all the captures; its lookups take its lock
+    USBIdsDatabase usbIds;
+    if( !options.usbIdsFile.empty() )
+    {
+        if( !usbIds.Open( options.usbIdsFile.c_str() ) )
+        {
+            fprintf( stderr, "usb-decode: can't read %s\n", options.usbIdsFile.c_str() );
+            return int( inputs.size() );
+        }
+
+        usbIds.Index();
+        state.pUsbIds = &usbIds;
+    }
+
+    const int numWorkers = std::max( 1, std::min( options.numWorkers, int( inputs.size() ) ) );
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for( int wc = 0; wc < numWorkers; ++wc )
+        workers.push_back( std::thread( RunWorker, &state ) );
+
+    for( size_t wc = 0; wc < workers.size(); ++wc )
+        workers[ wc ].join();
+
+    const double wallSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+    // the totals of the captures which decoded, with the largest peak heap of a decode; a capture which failed
+    // may have stopped part way, and its counts would be partial
+    CaptureResult total;
+    int numFailed = 0;
+    for( size_t rc = 0; rc < state.results.size(); ++rc )
+    {
+        const CaptureResult& res = state.results[ rc ];
+        if( !res.ok )
+        {
+            ++numFailed;
+            continue;
+        }
+
+        total.numSamples += res.numSamples;
+        total.numEdges += res.numEdges;
+        total.numPackets += res.numPackets;
+        total.numBadPackets += res.numBadPackets;
+        total.numUnexpected += res.numUnexpected;
+        total.numFrames += res.numFrames;
+        total.decodeSeconds += res.decodeSeconds;
+        total.peakHeap = std::max( total.peakHeap, res.peakHeap );
+    }
+
+    const int numOk = int( inputs.size() ) - numFailed;
+
+    if( !options.summary.empty() )
+    {
+        FILE* pFile = fopen( options.summary.c_str(), "w" );
+        if( pFile == NULL )
+        {
+            fprintf( stderr, "usb-decode: can't write %s\n", options.summary.c_str() );
+            return int( inputs.size() );
+        }
+
+        fprintf( pFile, "capture,status,rate,samples,edges,packets,bad_packets,unexpected_packets,frames,error_rate,decode_s,"
+                        "edges_per_s,peak_heap_mb\n" );
+        for( size_t rc = 0; rc < state.results.size(); ++rc )
+            WriteSummaryLine( pFile, inputs[ rc ], state.results[ rc ].status, state.results[ rc ], options );
+
+        char status[ 64 ];
+        snprintf( status, sizeof( status ), "%d ok %d failed", numOk, numFailed );
+        WriteSummaryLine( pFile, "total", status, total, options );
+
+        if( fclose( pFile ) != 0 )
+        {
+            fprintf( stderr, "usb-decode: can't write %s\n", options.summary.c_str() );
+            return int( inputs.size() );
+        }
+    }
+
+    if( !options.quiet )
+    {
+        const double seconds = wallSeconds > 0 ? wallSeconds : 1e-9;
+        fprintf( stderr,
+                 "usb-decode: %d captures ok, %d failed; %llu edges, %s packets, %s bad (%s), %s unexpected, %llu frames\n"
+                 "usb-decode: %d workers, decode %.3f s, wall %.3f s, %.0f edges/s, %s packets/s, peak heap %.1f MB\n",
+                 numOk, numFailed, total.numEdges, FormatPacketCount( total.numPackets, options ).c_str(),
+                 FormatPacketCount( total.numBadPackets, options ).c_str(), FormatErrorRate( total, options, 100, "%.4f%%" ).c_str(),
+                 FormatPacketCount( total.numUnexpected, options ).c_str(), total.numFrames, numWorkers, total.decodeSeconds, wallSeconds,
+                 total.numEdges / seconds, FormatPacketCount( U64( total.numPackets / seconds ), options ).c_str(),
+                 total.peakHeap / ( 1024.0 * 1024.0 ) );
+    }
+
+    return numFailed;
+}
@@ -0,0 +1,50 @@
+#ifndef USB_BATCH_DECODE_H
+#define USB_BATCH_DECODE_H
+
+#include <string>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "USBEnums.h"
+#include "USBEdgeFile.h"
+#include "USBOfflineAnalyzer.h"
+
+// How to decode the captures of a batch; every capture is decoded the same way.
+struct USBBatchOptions
+{
+    USBBatchOptions()
+        : speed( FULL_SPEED ),
+          level( OUT_CONTROL_TRANSFERS ),
+          format( OF_None ),
+          displayBase( Hexadecimal ),
+          numWorkers( 1 ),
+          maxMemory( 0 ),
+          quiet( false )
+    {
+    }
+
+    USBSpeed speed;
+    USBDecodeLevel level;
+    OutputFormat format;
+    DisplayBase displayBase;
+    USBEdgeInputOptions inputOptions;
+    std::string usbIdsFile; // for the names, as in the settings of the analyzer
+
+    std::string outDir;    // the output of each capture goes here, named after the capture; none without it
+    std::string extension; // of the output files
+    std::string summary;   // the CSV with a line for each capture and the totals; none without it
+
+    int numWorkers;
+    U64 maxMemory; // the heap a decode may take, in bytes; 0 for no limit
+    bool quiet;
+};
+
+// the files of a directory, in order, or the paths listed in a file, one per line
+bool GetBatchInputs( const char* path, std::vector<std::string>& inputs, std::string& error );
+
+// Decodes the captures on a pool of worker threads, each with its own analyzer for all the captures it
+// decodes; returns the number of captures which failed.
+int RunBatchDecode( const std::vector<std::string>& inputs, const USBBatchOptions& options );
+
+#endif // USB_BATCH_DECODE_H
@@ -0,0 +1,341 @@
+// Decodes a capture of D+ and D- without the Logic app, through the SDK stand-in in tools/sdk. The analyzer
+// runs exactly as it does in the app: the same settings, the same worker thread and the same exports.
+//
+// usage: usb-decode [options] <edge file>
+//        usb-decode [options] --simulate <samples>
+//        usb-decode [options] --batch <directory or list>
+//
+// The edge file is the text format below, a capture file (USBEdgeCapture.h), which is mapped and can
+// start decoding at any sample, a VCD, or the D+ file of a Logic 2 binary export. A batch decodes many
+// captures on a pool of threads (USBBatchDecode.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <AnalyzerStandIn.h>
+#include <AnalyzerHelpers.h>
+
+#include "USBIdsDatabase.h"
+#include "USBBatchDecode.h"
+#include "USBEdgeFile.h"
+#include "USBOfflineAnalyzer.h"
+
+struct NamedValue
+{
+    const char* name;
+    int value;
+};
+
+static const NamedValue Speeds[] = { { "low", LOW_SPEED }, { "full", FULL_SPEED }, { NULL, 0 } };
+
+static const NamedValue Levels[] = {
+    { "control", OUT_CONTROL_TRANSFERS }, { "packets", OUT_PACKETS }, { "bytes", OUT_BYTES }, { "signals", OUT_SIGNALS }, { NULL, 0 } };
+
+static const NamedValue Formats[] = { { "text", OF_Text },       { "usbmon", OF_UsbmonText }, { "usbmon-bin", OF_UsbmonBinary },
+                                      { "columns", OF_Columns }, { "frames", OF_Frames },     { "none", OF_None },
+                                      { NULL, 0 } };
+
+static const NamedValue Bases[] = { { "hex", Hexadecimal }, { "dec", Decimal }, { "bin", Binary }, { "ascii", ASCII }, { NULL, 0 } };
+
+static bool FindValue( const NamedValue* pValues, const char* name, int& value )
+{
+    for( ; pValues->name != NULL; ++pValues )
+    {
+        if( strcmp( pValues->name, name ) == 0 )
+        {
+            value = pValues->value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void PrintUsage()
+{
+    fprintf( stderr, "usage: usb-decode [options] <edge file>\n"
+                     "       usb-decode [options] --simulate <samples>\n"
+                     "       usb-decode [options] --batch <directory or list>\n"
+                     "\n"
+                     "  --speed low|full           bus speed (full)\n"
+                     "  --level control|packets|bytes|signals\n"
+                     "                             decode level (control)\n"
+                     "  --format text|usbmon|usbmon-bin|columns|frames|none\n"
+                     "                             the export, or a dump of the frames (frames)\n"
+                     "  --base hex|dec|bin|ascii   display base of the text output (hex)\n"
+                     "  --usb-ids <file>           usb.ids file for the vendor and usage names\n"
+                     "  -o <file>                  output file; the frames go to stdout without it\n"
+                     "  --simulate <samples>       decode the simulated traffic of the analyzer\n"
+                     "  --save-edges <file>        write the input edges as a text edge file\n"
+                     "  --save-capture <file>      write the input edges as a capture file\n"
+                     "  --start <sample>           decode a capture file from this sample on\n"
+                     "  --splits <n>               print the samples which split a capture file in n segments, at bus idle\n"
+                     "  --dp-signal <name>         the D+ wire of a VCD (D+)\n"
+                     "  --dm-signal <name>         the D- wire of a VCD (D-)\n"
+                     "  --dm-file <file>           the D- file of a Logic 2 binary export\n"
+                     "  --rate <Hz>                the sample rate for the times of a VCD or a Logic 2 export\n"
+                     "  --perf                     time the stages of the decoder and print the counters\n"
+                     "  --quiet                    don't report the throughput\n"
+                     "  --batch <dir|list>         decode every file of the directory, or every path of the list file\n"
+                     "  --jobs <n>                 the captures a batch decodes at once (one per core)\n"
+                     "  --out-dir <dir>            where a batch writes the output of each capture, named after it\n"
+                     "  --summary <file>           write a CSV of the batch, a line per capture and the totals\n"
+                     "  --max-memory <MB>          stop the decode of a capture of the batch which takes more heap\n"
+                     "\n"
+                     "The text edge file has a 'rate <Hz>' line, and then a '<sample> <D+> <D->' line for each change of the\n"
+                     "lines. The capture, VCD and Logic 2 files are told by their start.\n" );
+}
+
+static double GetSeconds( std::chrono::steady_clock::time_point begin )
+{
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+}
+
+int main( int argc, char* argv[] )
+{
+    int speed = FULL_SPEED;
+    int level = OUT_CONTROL_TRANSFERS;
+    int format = OF_Frames;
+    int base = Hexadecimal;
+    const char* pUsbIdsFile = NULL;
+    const char* pOutput = NULL;
+    const char* pInput = NULL;
+    const char* pSaveEdges = NULL;
+    const char* pSaveCapture = NULL;
+    U64 simulateSamples = 0;
+    USBEdgeInputOptions inputOptions;
+    int numSplits = 0;
+    bool quiet = false;
+    bool perf = false;
+    const char* pBatch = NULL;
+    USBBatchOptions batchOptions;
+    batchOptions.numWorkers = std::max( 1, int( std::thread::hardware_concurrency() ) );
+
+    for( int ac = 1; ac < argc; ++ac )
+    {
+        std::string arg( argv[ ac ] );
+        const char* pValue = ac + 1 < argc ? argv[ ac + 1 ] : NULL;
+
+        bool ok = true;
+        if( arg == "--quiet" )
+            quiet = true;
+        else if( arg == "--perf" )
+            perf = true;
+        else if( arg[ 0 ] != '-' && pInput == NULL )
+            pInput = argv[ ac ];
+        else if( arg == "--speed" && pValue != NULL )
+            ok = FindValue( Speeds, pValue, speed );
+        else if( arg == "--level" && pValue != NULL )
+            ok = FindValue( Levels, pValue, level );
+        else if( arg == "--format" && pValue != NULL )
+            ok = FindValue( Formats, pValue, format );
+        else if( arg == "--base" && pValue != NULL )
+            ok = FindValue( Bases, pValue, base );
+        else if( arg == "--usb-ids" && pValue != NULL )
+            pUsbIdsFile = pValue;
+        else if( arg == "-o" && pValue != NULL )
+            pOutput = pValue;
+        else if( arg == "--simulate" && pValue != NULL )
+            ok = ( simulateSamples = strtoull( pValue, NULL, 10 ) ) > 0;
+        else if( arg == "--save-edges" && pValue != NULL )
+            pSaveEdges = pValue;
+        else if( arg == "--save-capture" && pValue != NULL )
+            pSaveCapture = pValue;
+        else if( arg == "--start" && pValue != NULL )
+            inputOptions.startSample = strtoull( pValue, NULL, 10 );
+        else if( arg == "--splits" && pValue != NULL )
+            ok = ( numSplits = atoi( pValue ) ) > 0;
+        else if( arg == "--dp-signal" && pValue != NULL )
+            inputOptions.dpSignal = pValue;
+        else if( arg == "--dm-signal" && pValue != NULL )
+            inputOptions.dmSignal = pValue;
+        else if( arg == "--dm-file" && pValue != NULL )
+            inputOptions.dmFile = pValue;
+        else if( arg == "--rate" && pValue != NULL )
+            ok = ( inputOptions.sampleRate = U32( strtoul( pValue, NULL, 10 ) ) ) > 0;
+        else if( arg == "--batch" && pValue != NULL )
+            pBatch = pValue;
+        else if( arg == "--jobs" && pValue != NULL )
+            ok = ( batchOptions.numWorkers = atoi( pValue ) ) > 0;
+        else if( arg == "--out-dir" && pValue != NULL )
+            batchOptions.outDir = pValue;
+        else if( arg == "--summary" && pValue != NULL )
+            batchOptions.summary = pValue;
+        else if( arg == "--max-memory" && pValue != NULL )
+            ok = ( batchOptions.maxMemory = strtoull( pValue, NULL, 10 ) * 1024 * 1024 ) > 0;
+        else
+            ok = false;
+
+        // the options with a value
+        if( ok && arg[ 0 ] == '-' && arg != "--quiet" && arg != "--perf" )
+            ++ac;
+
+        if( !ok )
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    const int numInputs = ( pInput != NULL ) + ( simulateSamples > 0 ) + ( pBatch != NULL );
+    if( numInputs != 1 || ( pBatch == NULL && format != OF_Frames && format != OF_None && pOutput == NULL ) )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if( pBatch != NULL )
+    {
+        std::vector<std::string> inputs;
+        std::string error;
+        if( !GetBatchInputs( pBatch, inputs, error ) )
+        {
+            fprintf( stderr, "usb-decode: %s: %s\n", pBatch, error.c_str() );
+            return 1;
+        }
+
+        batchOptions.speed = USBSpeed( speed );
+        batchOptions.level = USBDecodeLevel( level );
+        batchOptions.format = OutputFormat( format );
+        batchOptions.displayBase = DisplayBase( base );
+        batchOptions.inputOptions = inputOptions;
+        batchOptions.usbIdsFile = pUsbIdsFile != NULL ? pUsbIdsFile : "";
+        batchOptions.quiet = quiet;
+
+        // the output files are named after the format
+        for( const NamedValue* pFormat = Formats; pFormat->name != NULL; ++pFormat )
+        {
+            if( pFormat->value == format )
+                batchOptions.extension = pFormat->name;
+        }
+
+        return RunBatchDecode( inputs, batchOptions ) > 0 ? 1 : 0;
+    }
+
+    // opened here, so a bad file is an error, and shared with the analyzer; a batch opens its own
+    USBIdsDatabase usbIds;
+    if( pUsbIdsFile != NULL && !usbIds.Open( pUsbIdsFile ) )
+    {
+        fprintf( stderr, "usb-decode: can't read %s\n", pUsbIdsFile );
+        return 1;
+    }
+
+    OfflineAnalyzer analyzer;
+    USBAnalyzerSettings& settings = analyzer.GetSettings();
+    settings.mDPChannel = Channel( 0, 0, DIGITAL_CHANNEL );
+    settings.mDMChannel = Channel( 0, 1, DIGITAL_CHANNEL );
+    settings.mSpeed = USBSpeed( speed );
+    settings.mDecodeLevel = USBDecodeLevel( level );
+    settings.mPerfCounters = perf;
+    settings.mUsbIdsFile = pUsbIdsFile != NULL ? pUsbIdsFile : "";
+    settings.mpSharedUsbIds = pUsbIdsFile != NULL ? &usbIds : NULL;
+
+    // the input
+    USBEdgeInput input;
+    if( pInput != NULL )
+    {
+        if( !input.Open( pInput, inputOptions ) )
+        {
+            fprintf( stderr, "usb-decode: %s: %s\n", pInput, input.GetError().c_str() );
+            return 1;
+        }
+    }
+    else
+    {
+        // the simulation of a separate analyzer, with the same settings
+        OfflineAnalyzer generator;
+        generator.GetSettings().mDPChannel = settings.mDPChannel;
+        generator.GetSettings().mDMChannel = settings.mDMChannel;
+        generator.GetSettings().mSpeed = settings.mSpeed;
+        generator.GetSettings().mDecodeLevel = settings.mDecodeLevel;
+
+        const U32 rate = generator.GetMinimumSampleRateHz();
+        StandIn::SetSampleRate( &generator, rate );
+
+        SimulationChannelDescriptor* pChannels;
+        generator.GenerateSimulationData( simulateSamples, rate, &pChannels );
+
+        input.SetEdges( rate, pChannels[ 0 ].GetInitialBitState(), pChannels[ 0 ].GetTransitions(), pChannels[ 1 ].GetInitialBitState(),
+                        pChannels[ 1 ].GetTransitions() );
+    }
+
+    if( numSplits > 0 )
+    {
+        std::vector<U64> splits;
+        if( !input.GetSplitSamples( numSplits, splits ) )
+        {
+            fprintf( stderr, "usb-decode: only a capture file has an index to split it\n" );
+            return 1;
+        }
+
+        for( size_t sc = 0; sc < splits.size(); ++sc )
+            printf( "%llu\n", ( unsigned long long )splits[ sc ] );
+
+        return 0;
+    }
+
+    if( pSaveEdges != NULL && !SaveEdgeTextFile( pSaveEdges, input ) )
+    {
+        fprintf( stderr, "usb-decode: can't write %s\n", pSaveEdges );
+        return 1;
+    }
+
+    if( pSaveCapture != NULL && !SaveEdgeCaptureFile( pSaveCapture, input ) )
+    {
+        fprintf( stderr, "usb-decode: can't write %s\n", pSaveCapture );
+        return 1;
+    }
+
+    const U32 sampleRate = input.GetSampleRate();
+    const U64 firstSample = input.GetFirstSample();
+    const U64 lastSample = input.GetLastSample();
+
+    StandIn::SetChannelData( &analyzer, settings.mDPChannel, input.GetDP() );
+    StandIn::SetChannelData( &analyzer, settings.mDMChannel, input.GetDM() );
+    StandIn::SetSampleRate( &analyzer, sampleRate );
+
+    // decode
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    StandIn::RunWorkerThread( &analyzer );
+    const double decodeSeconds = GetSeconds( begin );
+
+    // the streaming inputs only know their edges once they are read
+    const U64 numEdges = input.GetNumEdges();
+
+    // and write the output
+    begin = std::chrono::steady_clock::now();
+
+    if( !WriteOutput( analyzer, OutputFormat( format ), pOutput, DisplayBase( base ) ) )
+    {
+        fprintf( stderr, "usb-decode: can't write %s\n", pOutput );
+        return 1;
+    }
+
+    const double outputSeconds = GetSeconds( begin );
+
+    if( !quiet )
+    {
+        // a packet ends with an EOP at every decode level but the signals
+        const U64 numPackets = CountFrames( analyzer, FT_EOP );
+        const U64 numFrames = analyzer.GetResults()->GetNumFrames();
+
+        const double numSamples = double( lastSample - firstSample );
+        const double seconds = decodeSeconds > 0 ? decodeSeconds : 1e-9;
+        fprintf( stderr,
+                 "usb-decode: %llu samples at %u Hz, %llu edges, %llu packets, %llu frames\n"
+                 "usb-decode: decode %.3f s, %.0f samples/s, %.0f edges/s, %.0f packets/s; output %.3f s\n",
+                 lastSample - firstSample, sampleRate, numEdges, numPackets, numFrames, decodeSeconds, numSamples / seconds,
+                 numEdges / seconds, numPackets / seconds, outputSeconds );
+    }
+
+    if( perf )
+        fprintf( stderr, "\n%s", analyzer.GetPerfCounters().Format().c_str() );
+
+    return 0;
+}
@@ -0,0 +1,521 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "USBEdgeFile.h"
+
+static void SkipSpaces( const char*& pPos, const char* pEnd )
+{
+    while( pPos < pEnd && ( *pPos == ' ' || *pPos == '\t' || *pPos == '\r' ) )
+        ++pPos;
+}
+
+// to the start of the next line which is not empty or a comment
+static void SkipEmptyLines( const char*& pPos, const char* pEnd )
+{
+    for( ;; )
+    {
+        SkipSpaces( pPos, pEnd );
+        if( pPos < pEnd && *pPos == '#' )
+        {
+            const char* pEol = static_cast<const char*>( memchr( pPos, '\n', pEnd - pPos ) );
+            pPos = pEol == NULL ? pEnd : pEol;
+        }
+
+        if( pPos == pEnd || *pPos != '\n' )
+            return;
+
+        ++pPos;
+    }
+}
+
+static bool ParseNumber( const char*& pPos, const char* pEnd, U64& number )
+{
+    SkipSpaces( pPos, pEnd );
+    if( pPos == pEnd || *pPos < '0' || *pPos > '9' )
+        return false;
+
+    number = 0;
+    for( ; pPos < pEnd && *pPos >= '0' && *pPos <= '9'; ++pPos )
+    {
+        if( number > ( ~0ull - 9 ) / 10 )
+            return false;
+
+        number = number * 10 + ( *pPos - '0' );
+    }
+
+    return true;
+}
+
+static bool ParseEndOfLine( const char*& pPos, const char* pEnd )
+{
+    SkipSpaces( pPos, pEnd );
+    if( pPos == pEnd )
+        return true;
+
+    if( *pPos != '\n' )
+        return false;
+
+    ++pPos;
+    return true;
+}
+
+void USBEdgeTextFile::Line::Init( const char* pRecords, const char* pEnd, int column, BitState initialState, U64 firstSample )
+{
+    mpPos = pRecords;
+    mpEnd = pEnd;
+    mColumn = column;
+    mInitialState = mState = initialState;
+    mFirstSample = firstSample;
+}
+
+bool USBEdgeTextFile::Line::GetNextEdge( U64& sample )
+{
+    BitState states[ 2 ];
+    while( ParseRecord( mpPos, mpEnd, sample, states ) == PR_Record )
+    {
+        if( states[ mColumn ] != mState )
+        {
+            mState = states[ mColumn ];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+USBEdgeTextFile::USBEdgeTextFile() : mSampleRate( 0 ), mFirstSample( 0 ), mLastSample( 0 ), mNumEdges( 0 ), mpRecords( NULL )
+{
+    mInitialStates[ 0 ] = mInitialStates[ 1 ] = BIT_LOW;
+}
+
+USBEdgeTextFile::ParseResult USBEdgeTextFile::ParseRecord( const char*& pPos, const char* pEnd, U64& sample, BitState states[ 2 ] )
+{
+    SkipEmptyLines( pPos, pEnd );
+    if( pPos == pEnd )
+        return PR_End;
+
+    if( !ParseNumber( pPos, pEnd, sample ) )
+        return PR_Error;
+
+    for( int lc = 0; lc < 2; ++lc )
+    {
+        U64 state;
+        if( !ParseNumber( pPos, pEnd, state ) || state > 1 )
+            return PR_Error;
+
+        states[ lc ] = state == 0 ? BIT_LOW : BIT_HIGH;
+    }
+
+    return ParseEndOfLine( pPos, pEnd ) ? PR_Record : PR_Error;
+}
+
+bool USBEdgeTextFile::Open( const char* path )
+{
+    if( !mFile.Open( path ) )
+    {
+        mError = std::string( "can't open " ) + path;
+        return false;
+    }
+
+    const char* pPos = mFile.GetData();
+    const char* pEnd = pPos + mFile.GetSize();
+
+    // the header
+    U64 rate = 0;
+    SkipEmptyLines( pPos, pEnd );
+    bool isRate = pEnd - pPos > 4 && memcmp( pPos, "rate", 4 ) == 0;
+    if( isRate )
+        pPos += 4;
+
+    if( !isRate || !ParseNumber( pPos, pEnd, rate ) || !ParseEndOfLine( pPos, pEnd ) || rate == 0 || rate > 0xffffffff )
+    {
+        mError = "the file doesn't start with the sample rate";
+        return false;
+    }
+
+    mSampleRate = U32( rate );
+
+    // check all the records, so the lines don't have to
+    const char* pRecords = pPos;
+    BitState prev[ 2 ];
+    BitState states[ 2 ];
+    U64 sample;
+    int numRecords = 0;
+    mNumEdges = 0;
+
+    ParseResult res;
+    const char* pRecord;
+    for( ;; )
+    {
+        SkipEmptyLines( pPos, pEnd );
+        pRecord = pPos;
+
+        res = ParseRecord( pPos, pEnd, sample, states );
+        if( res != PR_Record )
+            break;
+
+        if( numRecords == 0 )
+        {
+            mFirstSample = sample;
+            prev[ 0 ] = states[ 0 ];
+            prev[ 1 ] = states[ 1 ];
+        }
+        else if( sample <= mLastSample )
+        {
+            res = PR_Error;
+            break;
+        }
+        else
+        {
+            mNumEdges += ( states[ 0 ] != prev[ 0 ] ) + ( states[ 1 ] != prev[ 1 ] );
+            prev[ 0 ] = states[ 0 ];
+            prev[ 1 ] = states[ 1 ];
+        }
+
+        mLastSample = sample;
+        ++numRecords;
+    }
+
+    if( res == PR_Error )
+    {
+        // count the lines up to the bad record
+        int lineNum = 1;
+        for( const char* pLine = mFile.GetData(); pLine < pRecord; ++pLine )
+            lineNum += *pLine == '\n';
+
+        char buf[ 64 ];
+        snprintf( buf, sizeof( buf ), "bad record at line %d", lineNum );
+        mError = buf;
+        return false;
+    }
+
+    if( numRecords == 0 )
+    {
+        mError = "the file has no records";
+        return false;
+    }
+
+    // the lines start after the first record
+    ParseRecord( pRecords, pEnd, sample, states );
+    mpRecords = pRecords;
+    mInitialStates[ 0 ] = states[ 0 ];
+    mInitialStates[ 1 ] = states[ 1 ];
+    Rewind();
+
+    return true;
+}
+
+void USBEdgeTextFile::Rewind()
+{
+    const char* pEnd = mFile.GetData() + mFile.GetSize();
+    mDP.Init( mpRecords, pEnd, 0, mInitialStates[ 0 ], mFirstSample );
+    mDM.Init( mpRecords, pEnd, 1, mInitialStates[ 1 ], mFirstSample );
+}
+
+USBEdgeInput::USBEdgeInput() : mSource( ES_None ), mStartSample( 0 ), mSampleRate( 0 )
+{
+}
+
+bool USBEdgeInput::Open( const char* path, const USBEdgeInputOptions& options )
+{
+    // tell the format from the first bytes
+    char magic[ 64 ];
+    size_t magicSize = 0;
+    FILE* pFile = fopen( path, "rb" );
+    if( pFile != NULL )
+    {
+        magicSize = fread( magic, 1, sizeof( magic ), pFile );
+        fclose( pFile );
+    }
+
+    if( USBEdgeCaptureFile::IsCaptureFile( magic, magicSize ) )
+    {
+        if( !mCaptureFile.Open( path ) )
+        {
+            mError = mCaptureFile.GetError();
+            return false;
+        }
+
+        if( options.startSample > mCaptureFile.GetLastSample() )
+        {
+            mError = "the start is after the end of the capture";
+            return false;
+        }
+
+        mSource = ES_Capture;
+        mStartSample = std::max( options.startSample, mCaptureFile.GetFirstSample() );
+        Rewind();
+        return true;
+    }
+
+    if( options.startSample != 0 )
+    {
+        mError = "only a capture file can start at a sample";
+        return false;
+    }
+
+    if( USBLogic2BinaryFile::IsLogic2File( magic, magicSize ) )
+    {
+        if( options.dmFile.empty() )
+        {
+            mError = "a Logic 2 export needs the file of D- too";
+            return false;
+        }
+
+        if( !mLogic2File.Open( path, options.dmFile.c_str(), options.sampleRate ) )
+        {
+            mError = mLogic2File.GetError();
+            return false;
+        }
+
+        mSource = ES_Logic2;
+        return true;
+    }
+
+    // a VCD starts with a section, a text file with a comment or the rate
+    const char* pStart = magic;
+    while( pStart < magic + magicSize && ( *pStart == ' ' || *pStart == '\t' || *pStart == '\r' || *pStart == '\n' ) )
+        ++pStart;
+
+    if( pStart < magic + magicSize && *pStart == '$' )
+    {
+        if( !mVcdFile.Open( path, options.dpSignal, options.dmSignal, options.sampleRate ) )
+        {
+            mError = mVcdFile.GetError();
+            return false;
+        }
+
+        mSource = ES_Vcd;
+        return true;
+    }
+
+    if( !mTextFile.Open( path ) )
+    {
+        mError = mTextFile.GetError();
+        return false;
+    }
+
+    mSource = ES_Text;
+    return true;
+}
+
+void USBEdgeInput::SetEdges( U32 sampleRate, BitState initialDP, const std::vector<U64>& dpEdges, BitState initialDM,
+                             const std::vector<U64>& dmEdges )
+{
+    mSource = ES_Memory;
+    mSampleRate = sampleRate;
+    mMemoryDP.Assign( initialDP, dpEdges );
+    mMemoryDM.Assign( initialDM, dmEdges );
+}
+
+void USBEdgeInput::Rewind()
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        mTextFile.Rewind();
+        break;
+    case ES_Capture:
+        mCaptureDP.Init( &mCaptureFile, ECL_DP, mStartSample );
+        mCaptureDM.Init( &mCaptureFile, ECL_DM, mStartSample );
+        break;
+    case ES_Vcd:
+        mVcdFile.Rewind();
+        break;
+    case ES_Logic2:
+        mLogic2File.Rewind();
+        break;
+    case ES_Memory:
+        mMemoryDP.Rewind();
+        mMemoryDM.Rewind();
+        break;
+    default:
+        break;
+    }
+}
+
+bool USBEdgeInput::GetSplitSamples( int numSegments, std::vector<U64>& samples ) const
+{
+    if( mSource != ES_Capture )
+        return false;
+
+    // only the ones after the start
+    mCaptureFile.GetSplitSamples( numSegments, samples );
+    samples.erase( samples.begin(), std::upper_bound( samples.begin(), samples.end(), mStartSample ) );
+
+    return true;
+}
+
+U32 USBEdgeInput::GetSampleRate() const
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetSampleRate();
+    case ES_Capture:
+        return mCaptureFile.GetSampleRate();
+    case ES_Vcd:
+        return mVcdFile.GetSampleRate();
+    case ES_Logic2:
+        return mLogic2File.GetSampleRate();
+    case ES_Memory:
+        return mSampleRate;
+    default:
+        return 0;
+    }
+}
+
+U64 USBEdgeInput::GetFirstSample() const
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetFirstSample();
+    case ES_Capture:
+        return mStartSample;
+    case ES_Vcd:
+        return mVcdFile.GetFirstSample();
+    case ES_Logic2:
+        return mLogic2File.GetFirstSample();
+    default:
+        return 0;
+    }
+}
+
+U64 USBEdgeInput::GetLastSample() const
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetLastSample();
+    case ES_Capture:
+        return mCaptureFile.GetLastSample();
+    case ES_Vcd:
+        return mVcdFile.GetLastSample();
+    case ES_Logic2:
+        return mLogic2File.GetLastSample();
+    case ES_Memory:
+        return mMemoryDP.GetLastEdge() > mMemoryDM.GetLastEdge() ? mMemoryDP.GetLastEdge() : mMemoryDM.GetLastEdge();
+    default:
+        return 0;
+    }
+}
+
+U64 USBEdgeInput::GetNumEdges() const
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetNumEdges();
+    case ES_Capture:
+        return mCaptureFile.GetNumEdges( ECL_DP ) + mCaptureFile.GetNumEdges( ECL_DM );
+    case ES_Vcd:
+        return mVcdFile.GetNumEdges();
+    case ES_Logic2:
+        return mLogic2File.GetNumEdges();
+    case ES_Memory:
+        return mMemoryDP.GetNumEdges() + mMemoryDM.GetNumEdges();
+    default:
+        return 0;
+    }
+}
+
+ChannelData* USBEdgeInput::GetDP()
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetDP();
+    case ES_Capture:
+        return &mCaptureDP;
+    case ES_Vcd:
+        return mVcdFile.GetDP();
+    case ES_Logic2:
+        return mLogic2File.GetDP();
+    default:
+        return &mMemoryDP;
+    }
+}
+
+ChannelData* USBEdgeInput::GetDM()
+{
+    switch( mSource )
+    {
+    case ES_Text:
+        return mTextFile.GetDM();
+    case ES_Capture:
+        return &mCaptureDM;
+    case ES_Vcd:
+        return mVcdFile.GetDM();
+    case ES_Logic2:
+        return mLogic2File.GetDM();
+    default:
+        return &mMemoryDM;
+    }
+}
+
+bool SaveEdgeTextFile( const char* path, USBEdgeInput& input )
+{
+    FILE* pFile = fopen( path, "w" );
+    if( pFile == NULL )
+        return false;
+
+    ChannelData* lines[ 2 ] = { input.GetDP(), input.GetDM() };
+    BitState states[ 2 ] = { lines[ 0 ]->GetInitialBitState(), lines[ 1 ]->GetInitialBitState() };
+    U64 next[ 2 ];
+    bool more[ 2 ];
+    for( int lc = 0; lc < 2; ++lc )
+        more[ lc ] = lines[ lc ]->GetNextEdge( next[ lc ] );
+
+    fprintf( pFile, "rate %u\n", input.GetSampleRate() );
+    fprintf( pFile, "%llu %d %d\n", ( unsigned long long )input.GetFirstSample(), states[ 0 ] == BIT_HIGH, states[ 1 ] == BIT_HIGH );
+
+    // merge the edges of the two lines, one record per sample
+    while( more[ 0 ] || more[ 1 ] )
+    {
+        const U64 sample = !more[ 1 ] || ( more[ 0 ] && next[ 0 ] < next[ 1 ] ) ? next[ 0 ] : next[ 1 ];
+        // the generator can toggle a line more than once at the same sample
+        for( int lc = 0; lc < 2; ++lc )
+        {
+            while( more[ lc ] && next[ lc ] == sample )
+            {
+                states[ lc ] = Toggle( states[ lc ] );
+                more[ lc ] = lines[ lc ]->GetNextEdge( next[ lc ] );
+            }
+        }
+
+        fprintf( pFile, "%llu %d %d\n", ( unsigned long long )sample, states[ 0 ] == BIT_HIGH, states[ 1 ] == BIT_HIGH );
+    }
+
+    input.Rewind();
+
+    return fclose( pFile ) == 0;
+}
+
+bool SaveEdgeCaptureFile( const char* path, USBEdgeInput& input )
+{
+    ChannelData* lines[ ECL_Count ] = { input.GetDP(), input.GetDM() };
+
+    USBEdgeCaptureWriter writer;
+    if( !writer.Open( path, input.GetSampleRate(), input.GetFirstSample(), ToUSBBitState( lines[ ECL_DP ]->GetInitialBitState() ),
+                      ToUSBBitState( lines[ ECL_DM ]->GetInitialBitState() ) ) )
+        return false;
+
+    bool ok = true;
+    U64 lastSample = input.GetLastSample();
+    for( int lc = 0; lc < ECL_Count && ok; ++lc )
+    {
+        U64 sample;
+        while( ok && lines[ lc ]->GetNextEdge( sample ) )
+        {
+            ok = writer.AddEdge( USBEdgeCaptureLine( lc ), sample );
+            if( sample > lastSample )
+                lastSample = sample;
+        }
+    }
+
+    input.Rewind();
+
+    return writer.Close( lastSample ) && ok;
+}
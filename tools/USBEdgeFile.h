@@ -0,0 +1,309 @@
+#ifndef USB_EDGE_FILE_H
+#define USB_EDGE_FILE_H
+
+#include <string>
+#include <vector>
+
+#include <AnalyzerChannelData.h>
+
+#include "USBMappedFile.h"
+#include "USBEdgeCapture.h"
+#include "USBEdgeImport.h"
+
+// the channels of the SDK have their own states, the decoder core its own
+inline USBBitState ToUSBBitState( BitState state )
+{
+    return state == BIT_HIGH ? BS_High : BS_Low;
+}
+
+inline BitState ToBitState( USBBitState state )
+{
+    return state == BS_High ? BIT_HIGH : BIT_LOW;
+}
+
+// The edges of one channel held in memory, like the ones the simulation data generator makes.
+class USBEdgeVector : public ChannelData
+{
+  public:
+    USBEdgeVector() : mInitialState( BIT_LOW ), mNextEdge( 0 )
+    {
+    }
+
+    void Assign( BitState initialState, const std::vector<U64>& edges )
+    {
+        mInitialState = initialState;
+        mEdges = edges;
+        mNextEdge = 0;
+    }
+
+    void Rewind()
+    {
+        mNextEdge = 0;
+    }
+
+    virtual BitState GetInitialBitState()
+    {
+        return mInitialState;
+    }
+
+    virtual U64 GetStartingSample()
+    {
+        return 0;
+    }
+
+    virtual bool GetNextEdge( U64& sample )
+    {
+        if( mNextEdge >= mEdges.size() )
+            return false;
+
+        sample = mEdges[ mNextEdge++ ];
+        return true;
+    }
+
+    size_t GetNumEdges() const
+    {
+        return mEdges.size();
+    }
+
+    U64 GetLastEdge() const
+    {
+        return mEdges.empty() ? 0 : mEdges.back();
+    }
+
+  private:
+    BitState mInitialState;
+    std::vector<U64> mEdges;
+    size_t mNextEdge;
+};
+
+// A text file with the D+ and D- states of a capture:
+//
+//   # comment
+//   rate 24000000
+//   0 1 0
+//   1200 0 1
+//
+// Each record is a sample number and the states of D+ and D- from that sample on. The sample numbers
+// increase, and the first record has the states at the start of the capture. The file is mapped, and D+
+// and D- each read it with their own cursor, so a capture of any size takes no memory.
+class USBEdgeTextFile
+{
+  public:
+    USBEdgeTextFile();
+
+    // checks the whole file; GetError says what is wrong with it
+    bool Open( const char* path );
+
+    // back to the first record
+    void Rewind();
+
+    const std::string& GetError() const
+    {
+        return mError;
+    }
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    U64 GetFirstSample() const
+    {
+        return mFirstSample;
+    }
+
+    U64 GetLastSample() const
+    {
+        return mLastSample;
+    }
+
+    U64 GetNumEdges() const
+    {
+        return mNumEdges;
+    }
+
+    ChannelData* GetDP()
+    {
+        return &mDP;
+    }
+
+    ChannelData* GetDM()
+    {
+        return &mDM;
+    }
+
+  private:
+    // reads one line of the file
+    class Line : public ChannelData
+    {
+      public:
+        void Init( const char* pRecords, const char* pEnd, int column, BitState initialState, U64 firstSample );
+
+        virtual BitState GetInitialBitState()
+        {
+            return mInitialState;
+        }
+
+        virtual U64 GetStartingSample()
+        {
+            return mFirstSample;
+        }
+
+        virtual bool GetNextEdge( U64& sample );
+
+      private:
+        const char* mpPos;
+        const char* mpEnd;
+        int mColumn; // 0 for D+, 1 for D-
+        BitState mInitialState;
+        BitState mState;
+        U64 mFirstSample;
+    };
+
+    enum ParseResult
+    {
+        PR_Record,
+        PR_End,
+        PR_Error,
+    };
+
+    // skips the empty lines and the comments
+    static ParseResult ParseRecord( const char*& pPos, const char* pEnd, U64& sample, BitState states[ 2 ] );
+
+    USBMappedFile mFile;
+    std::string mError;
+
+    U32 mSampleRate;
+    U64 mFirstSample;
+    U64 mLastSample;
+    U64 mNumEdges;
+
+    const char* mpRecords;
+    BitState mInitialStates[ 2 ];
+
+    Line mDP;
+    Line mDM;
+};
+
+// One line of a mapped USBEdgeCaptureFile.
+class USBEdgeCaptureData : public ChannelData
+{
+  public:
+    USBEdgeCaptureData() : mStartingSample( 0 ), mInitialState( BIT_LOW )
+    {
+    }
+
+    // the line starts at startSample, with the state it has there
+    void Init( const USBEdgeCaptureFile* pFile, USBEdgeCaptureLine line, U64 startSample )
+    {
+        mCursor.Init( pFile, line );
+        mCursor.Seek( startSample );
+        mStartingSample = startSample;
+        mInitialState = ToBitState( mCursor.GetState() );
+    }
+
+    virtual BitState GetInitialBitState()
+    {
+        return mInitialState;
+    }
+
+    virtual U64 GetStartingSample()
+    {
+        return mStartingSample;
+    }
+
+    virtual bool GetNextEdge( U64& sample )
+    {
+        return mCursor.GetNextEdge( sample );
+    }
+
+  private:
+    USBEdgeCaptureCursor mCursor;
+    U64 mStartingSample;
+    BitState mInitialState;
+};
+
+// How to read the formats which need more than the file.
+struct USBEdgeInputOptions
+{
+    USBEdgeInputOptions() : startSample( 0 ), sampleRate( 0 ), dpSignal( "D+" ), dmSignal( "D-" )
+    {
+    }
+
+    U64 startSample;      // capture files only
+    U32 sampleRate;       // the rate to convert the times of VCD and Logic 2 files at; 0 for their default
+    std::string dpSignal; // the wires of a VCD file
+    std::string dmSignal;
+    std::string dmFile; // the D- channel of a Logic 2 export, which has a file per channel
+};
+
+// The D+ and D- of an edge file of any format, or of edges in memory.
+class USBEdgeInput
+{
+  public:
+    USBEdgeInput();
+
+    // a text, capture, VCD or Logic 2 binary file, told by its start
+    bool Open( const char* path, const USBEdgeInputOptions& options );
+
+    void SetEdges( U32 sampleRate, BitState initialDP, const std::vector<U64>& dpEdges, BitState initialDM,
+                   const std::vector<U64>& dmEdges );
+
+    // reads the edges from the start again
+    void Rewind();
+
+    const std::string& GetError() const
+    {
+        return mError;
+    }
+
+    bool IsCaptureFile() const
+    {
+        return mSource == ES_Capture;
+    }
+
+    // the split points of a capture file, from its index and at bus idle; false for the other inputs
+    bool GetSplitSamples( int numSegments, std::vector<U64>& samples ) const;
+
+    U32 GetSampleRate() const;
+    U64 GetFirstSample() const;
+    U64 GetLastSample() const;
+    U64 GetNumEdges() const;
+
+    ChannelData* GetDP();
+    ChannelData* GetDM();
+
+  private:
+    enum EdgeSource
+    {
+        ES_None,
+        ES_Text,
+        ES_Capture,
+        ES_Vcd,
+        ES_Logic2,
+        ES_Memory,
+    };
+
+    EdgeSource mSource;
+    std::string mError;
+    U64 mStartSample;
+
+    USBEdgeTextFile mTextFile;
+
+    USBEdgeCaptureFile mCaptureFile;
+    USBEdgeCaptureData mCaptureDP;
+    USBEdgeCaptureData mCaptureDM;
+
+    USBVcdFile mVcdFile;
+    USBLogic2BinaryFile mLogic2File;
+
+    U32 mSampleRate;
+    USBEdgeVector mMemoryDP;
+    USBEdgeVector mMemoryDM;
+};
+
+// Write all the edges of the input in the text or the capture format, and rewind it.
+bool SaveEdgeTextFile( const char* path, USBEdgeInput& input );
+bool SaveEdgeCaptureFile( const char* path, USBEdgeInput& input );
+
+#endif // USB_EDGE_FILE_H
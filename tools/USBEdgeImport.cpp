@@ -0,0 +1,537 @@
+#include <string.h>
+#include <algorithm>
+
+#include "USBEdgeImport.h"
+
+static U64 Gcd( U64 a, U64 b )
+{
+    while( b != 0 )
+    {
+        const U64 r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+void USBTimeScale::Init( U64 num, U64 den, U32 sampleRate )
+{
+    mMul = num * sampleRate;
+    mDiv = den;
+
+    const U64 gcd = Gcd( mMul, mDiv );
+    mMul /= gcd;
+    mDiv /= gcd;
+
+    // such as a 1 fs timescale with a sample rate that has few factors in common with 10^15
+    mWideRemainder = mMul != 0 && mDiv - 1 > ~0ull / mMul;
+}
+
+U64 USBTimeScale::MulDiv( U64 a, U64 b, U64 c )
+{
+#if defined( __SIZEOF_INT128__ )
+    return U64( static_cast<unsigned __int128>( a ) * b / c );
+#else
+    // a long division which takes the bits of b from the top: a * b = quot * c + rem, with rem < c so the
+    // doubling and the adding can't overflow
+    U64 quot = 0;
+    U64 rem = 0;
+    for( int bit = 63; bit >= 0; --bit )
+    {
+        quot <<= 1;
+        if( rem >= c - rem )
+        {
+            rem -= c - rem;
+            ++quot;
+        }
+        else
+        {
+            rem += rem;
+        }
+
+        if( ( ( b >> bit ) & 1 ) != 0 )
+        {
+            if( rem >= c - a )
+            {
+                rem -= c - a;
+                ++quot;
+            }
+            else
+            {
+                rem += a;
+            }
+        }
+    }
+
+    return quot;
+#endif
+}
+
+//
+// VCD
+//
+
+static bool IsBlank( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void SkipBlanks( const char*& pPos, const char* pEnd )
+{
+    while( pPos < pEnd && IsBlank( *pPos ) )
+        ++pPos;
+}
+
+static void SkipToken( const char*& pPos, const char* pEnd )
+{
+    while( pPos < pEnd && !IsBlank( *pPos ) )
+        ++pPos;
+}
+
+// the next token, or false at the end of the file
+static bool NextToken( const char*& pPos, const char* pEnd, const char*& pToken, size_t& length )
+{
+    SkipBlanks( pPos, pEnd );
+    if( pPos == pEnd )
+        return false;
+
+    pToken = pPos;
+    SkipToken( pPos, pEnd );
+    length = pPos - pToken;
+    return true;
+}
+
+static bool TokenIs( const char* pToken, size_t length, const char* word )
+{
+    return strlen( word ) == length && memcmp( pToken, word, length ) == 0;
+}
+
+// past the $end of a section
+static bool SkipSection( const char*& pPos, const char* pEnd )
+{
+    const char* pToken;
+    size_t length;
+    while( NextToken( pPos, pEnd, pToken, length ) )
+    {
+        if( TokenIs( pToken, length, "$end" ) )
+            return true;
+    }
+
+    return false;
+}
+
+static bool ParseTime( const char* pToken, size_t length, U64& time )
+{
+    if( length == 0 )
+        return false;
+
+    time = 0;
+    for( size_t cc = 0; cc < length; ++cc )
+    {
+        if( pToken[ cc ] < '0' || pToken[ cc ] > '9' || time > ( ~0ull - 9 ) / 10 )
+            return false;
+
+        time = time * 10 + ( pToken[ cc ] - '0' );
+    }
+
+    return true;
+}
+
+enum VcdChange
+{
+    VC_Time,
+    VC_Scalar,
+    VC_End,
+};
+
+// The next time stamp or scalar change of the value changes. The vectors, the reals, the keywords and
+// the comments are stepped over without looking into them.
+static VcdChange NextChange( const char*& pPos, const char* pEnd, U64& time, char& value, const char*& pId, size_t& idLength )
+{
+    const char* pToken;
+    size_t length;
+    while( NextToken( pPos, pEnd, pToken, length ) )
+    {
+        switch( pToken[ 0 ] )
+        {
+        case '#':
+            if( ParseTime( pToken + 1, length - 1, time ) )
+                return VC_Time;
+            break;
+        case '0':
+        case '1':
+        case 'x':
+        case 'X':
+        case 'z':
+        case 'Z':
+            value = pToken[ 0 ];
+            pId = pToken + 1;
+            idLength = length - 1;
+            return VC_Scalar;
+        case 'b':
+        case 'B':
+        case 'r':
+        case 'R':
+            // the identifier of the vector follows
+            SkipBlanks( pPos, pEnd );
+            SkipToken( pPos, pEnd );
+            break;
+        case '$':
+            if( TokenIs( pToken, length, "$comment" ) )
+                SkipSection( pPos, pEnd );
+            break;
+        default:
+            break;
+        }
+    }
+
+    return VC_End;
+}
+
+USBVcdFile::USBVcdFile() : mSampleRate( 0 ), mFirstTime( 0 ), mLastTime( 0 ), mpChanges( NULL )
+{
+    mInitialStates[ 0 ] = mInitialStates[ 1 ] = BIT_LOW;
+}
+
+bool USBVcdFile::ParseHeader( const char*& pPos, const char* pEnd, const std::string& dpSignal, const std::string& dmSignal )
+{
+    U64 tsNum = 1;
+    U64 tsDen = 1000000000; // 1 ns if there is no $timescale
+    std::string scope;
+
+    const char* pToken;
+    size_t length;
+    while( NextToken( pPos, pEnd, pToken, length ) )
+    {
+        if( TokenIs( pToken, length, "$enddefinitions" ) )
+        {
+            if( !SkipSection( pPos, pEnd ) )
+                break;
+
+            if( mIds[ 0 ].empty() || mIds[ 1 ].empty() )
+            {
+                mError = "no wire named " + ( mIds[ 0 ].empty() ? dpSignal : dmSignal );
+                return false;
+            }
+
+            if( mSampleRate == 0 )
+            {
+                // the rate of the time unit, if it fits
+                mSampleRate = tsDen % tsNum == 0 && tsDen / tsNum <= 0xffffffff ? U32( tsDen / tsNum ) : 1000000000;
+            }
+
+            mTimeScale.Init( tsNum, tsDen, mSampleRate );
+            return true;
+        }
+        else if( TokenIs( pToken, length, "$timescale" ) )
+        {
+            // 10ns, or 10 ns
+            const char* pUnit;
+            if( !NextToken( pPos, pEnd, pToken, length ) )
+                break;
+
+            for( pUnit = pToken; pUnit < pToken + length && *pUnit >= '0' && *pUnit <= '9'; ++pUnit )
+                ;
+
+            if( !ParseTime( pToken, pUnit - pToken, tsNum ) || tsNum == 0 )
+                break;
+
+            length -= pUnit - pToken;
+            if( length == 0 && !NextToken( pPos, pEnd, pUnit, length ) )
+                break;
+
+            static const char* Units[] = { "s", "ms", "us", "ns", "ps", "fs" };
+            size_t uc = 0;
+            for( ; uc < sizeof( Units ) / sizeof( Units[ 0 ] ) && !TokenIs( pUnit, length, Units[ uc ] ); ++uc )
+                ;
+
+            if( uc == sizeof( Units ) / sizeof( Units[ 0 ] ) || !SkipSection( pPos, pEnd ) )
+                break;
+
+            for( tsDen = 1; uc > 0; --uc )
+                tsDen *= 1000;
+        }
+        else if( TokenIs( pToken, length, "$scope" ) )
+        {
+            // $scope module name $end
+            const char* pName;
+            size_t nameLength;
+            if( !NextToken( pPos, pEnd, pToken, length ) || !NextToken( pPos, pEnd, pName, nameLength ) || !SkipSection( pPos, pEnd ) )
+                break;
+
+            scope += std::string( pName, nameLength ) + ".";
+        }
+        else if( TokenIs( pToken, length, "$upscope" ) )
+        {
+            const size_t dot = scope.empty() ? std::string::npos : scope.rfind( '.', scope.size() - 2 );
+            scope.erase( dot == std::string::npos ? 0 : dot + 1 );
+            if( !SkipSection( pPos, pEnd ) )
+                break;
+        }
+        else if( TokenIs( pToken, length, "$var" ) )
+        {
+            // $var wire 1 id name $end
+            const char* pSize;
+            const char* pId;
+            const char* pName;
+            size_t sizeLength, idLength, nameLength;
+            if( !NextToken( pPos, pEnd, pToken, length ) || !NextToken( pPos, pEnd, pSize, sizeLength ) ||
+                !NextToken( pPos, pEnd, pId, idLength ) || !NextToken( pPos, pEnd, pName, nameLength ) || !SkipSection( pPos, pEnd ) )
+                break;
+
+            const std::string name( pName, nameLength );
+            for( int lc = 0; lc < 2; ++lc )
+            {
+                const std::string& signal = lc == 0 ? dpSignal : dmSignal;
+                if( mIds[ lc ].empty() && TokenIs( pSize, sizeLength, "1" ) && ( name == signal || scope + name == signal ) )
+                    mIds[ lc ].assign( pId, idLength );
+            }
+        }
+        else if( length > 0 && pToken[ 0 ] == '$' )
+        {
+            // $date, $version, $comment
+            if( !SkipSection( pPos, pEnd ) )
+                break;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    mError = "bad header";
+    return false;
+}
+
+bool USBVcdFile::Open( const char* path, const std::string& dpSignal, const std::string& dmSignal, U32 sampleRate )
+{
+    if( !mFile.Open( path ) )
+    {
+        mError = std::string( "can't open " ) + path;
+        return false;
+    }
+
+    const char* pPos = mFile.GetData();
+    const char* pEnd = pPos + mFile.GetSize();
+
+    mSampleRate = sampleRate;
+    if( !ParseHeader( pPos, pEnd, dpSignal, dmSignal ) )
+        return false;
+
+    mpChanges = pPos;
+
+    // the first time and the first value of each wire, which is usually in the $dumpvars at the start
+    bool haveTime = false;
+    bool haveState[ 2 ] = { false, false };
+    U64 time;
+    char value;
+    const char* pId;
+    size_t idLength;
+    while( !haveState[ 0 ] || !haveState[ 1 ] )
+    {
+        const VcdChange change = NextChange( pPos, pEnd, time, value, pId, idLength );
+        if( change == VC_End )
+            break;
+
+        if( change == VC_Time && !haveTime )
+        {
+            mFirstTime = mLastTime = time;
+            haveTime = true;
+        }
+        else if( change == VC_Scalar && ( value == '0' || value == '1' ) )
+        {
+            for( int lc = 0; lc < 2; ++lc )
+            {
+                if( !haveState[ lc ] && TokenIs( pId, idLength, mIds[ lc ].c_str() ) )
+                {
+                    mInitialStates[ lc ] = value == '1' ? BIT_HIGH : BIT_LOW;
+                    haveState[ lc ] = true;
+                }
+            }
+        }
+    }
+
+    // the last time stamp is the last line which starts with #
+    for( const char* pLine = pEnd; pLine > mpChanges; )
+    {
+        --pLine;
+        if( *pLine == '#' && ( pLine[ -1 ] == '\n' || pLine[ -1 ] == '\r' ) )
+        {
+            const char* pToken = pLine + 1;
+            const char* pTokenEnd = pToken;
+            SkipToken( pTokenEnd, pEnd );
+            if( ParseTime( pToken, pTokenEnd - pToken, time ) && time > mLastTime )
+                mLastTime = time;
+            break;
+        }
+    }
+
+    Rewind();
+    return true;
+}
+
+void USBVcdFile::Rewind()
+{
+    const char* pEnd = mFile.GetData() + mFile.GetSize();
+    mDP.Init( mpChanges, pEnd, mIds[ 0 ], mInitialStates[ 0 ], this );
+    mDM.Init( mpChanges, pEnd, mIds[ 1 ], mInitialStates[ 1 ], this );
+}
+
+void USBVcdFile::Wire::Init( const char* pChanges, const char* pEnd, const std::string& id, BitState initialState, const USBVcdFile* pFile )
+{
+    mpPos = pChanges;
+    mpEnd = pEnd;
+    mId = id;
+    mInitialState = mState = initialState;
+    mTime = pFile->mFirstTime;
+    mNumEdges = 0;
+    mpFile = pFile;
+}
+
+bool USBVcdFile::Wire::GetNextEdge( U64& sample )
+{
+    char value;
+    const char* pId;
+    size_t idLength;
+    for( VcdChange change; ( change = NextChange( mpPos, mpEnd, mTime, value, pId, idLength ) ) != VC_End; )
+    {
+        // x and z keep the state
+        if( change != VC_Scalar || ( value != '0' && value != '1' ) || idLength != mId.size() || memcmp( pId, mId.data(), idLength ) != 0 )
+            continue;
+
+        const BitState state = value == '1' ? BIT_HIGH : BIT_LOW;
+        if( state != mState )
+        {
+            mState = state;
+            ++mNumEdges;
+            sample = mpFile->mTimeScale.ToSample( mTime );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// Logic 2 binary export
+//
+
+namespace
+{
+    const char Logic2Magic[ 8 ] = { '<', 'S', 'A', 'L', 'E', 'A', 'E', '>' };
+    const size_t LOGIC2_HEADER_SIZE = 44;
+    const U32 LOGIC2_DEFAULT_RATE = 500000000; // the fastest digital rate of Logic Pro
+}
+
+// the files are little endian, like the machines which write them
+template <typename T> static T Read( const char* pData )
+{
+    T value;
+    memcpy( &value, pData, sizeof( value ) );
+    return value;
+}
+
+bool USBLogic2BinaryFile::IsLogic2File( const char* pData, size_t size )
+{
+    return size >= sizeof( Logic2Magic ) && memcmp( pData, Logic2Magic, sizeof( Logic2Magic ) ) == 0;
+}
+
+USBLogic2BinaryFile::USBLogic2BinaryFile() : mSampleRate( 0 ), mLastSample( 0 )
+{
+}
+
+USBLogic2BinaryFile::Channel::Channel()
+    : mInitialState( BIT_LOW ),
+      mBeginTime( 0 ),
+      mEndTime( 0 ),
+      mNumTransitions( 0 ),
+      mpTransitions( NULL ),
+      mNextTransition( 0 ),
+      mLastEdge( 0 ),
+      mStart( 0 ),
+      mRate( 0 )
+{
+}
+
+bool USBLogic2BinaryFile::Channel::Open( const char* path, std::string& error )
+{
+    if( !mFile.Open( path ) )
+    {
+        error = std::string( "can't open " ) + path;
+        return false;
+    }
+
+    const char* pData = mFile.GetData();
+    const size_t size = mFile.GetSize();
+    if( size < LOGIC2_HEADER_SIZE || !IsLogic2File( pData, size ) )
+    {
+        error = std::string( path ) + " is not a Logic 2 binary export";
+        return false;
+    }
+
+    // version 0 and 1 have the same digital header
+    const S32 version = Read<S32>( pData + 8 );
+    const S32 type = Read<S32>( pData + 12 );
+    const U32 initialState = Read<U32>( pData + 16 );
+    mBeginTime = Read<double>( pData + 20 );
+    mEndTime = Read<double>( pData + 28 );
+    mNumTransitions = Read<U64>( pData + 36 );
+    if( version < 0 || version > 1 || type != 0 || initialState > 1 || mNumTransitions > ( size - LOGIC2_HEADER_SIZE ) / sizeof( double ) )
+    {
+        error = std::string( path ) + " is not a digital channel";
+        return false;
+    }
+
+    mInitialState = initialState != 0 ? BIT_HIGH : BIT_LOW;
+    mpTransitions = pData + LOGIC2_HEADER_SIZE;
+    return true;
+}
+
+void USBLogic2BinaryFile::Channel::Init( double start, U32 sampleRate )
+{
+    mStart = start;
+    mRate = sampleRate;
+    mNextTransition = 0;
+    mLastEdge = 0;
+}
+
+bool USBLogic2BinaryFile::Channel::GetNextEdge( U64& sample )
+{
+    if( mNextTransition >= mNumTransitions )
+        return false;
+
+    const double time = ( Read<double>( mpTransitions + mNextTransition * sizeof( double ) ) - mStart ) * mRate;
+    ++mNextTransition;
+
+    // the edges never go back, even for a broken file
+    sample = time > 0 ? U64( time + 0.5 ) : 0;
+    if( sample < mLastEdge )
+        sample = mLastEdge;
+
+    mLastEdge = sample;
+    return true;
+}
+
+bool USBLogic2BinaryFile::Open( const char* dpPath, const char* dmPath, U32 sampleRate )
+{
+    if( !mChannels[ 0 ].Open( dpPath, mError ) || !mChannels[ 1 ].Open( dmPath, mError ) )
+        return false;
+
+    mSampleRate = sampleRate != 0 ? sampleRate : LOGIC2_DEFAULT_RATE;
+
+    const double start = std::min( mChannels[ 0 ].GetBeginTime(), mChannels[ 1 ].GetBeginTime() );
+    const double end = std::max( mChannels[ 0 ].GetEndTime(), mChannels[ 1 ].GetEndTime() );
+    mLastSample = end > start ? U64( ( end - start ) * mSampleRate + 0.5 ) : 0;
+
+    mChannels[ 0 ].Init( start, mSampleRate );
+    mChannels[ 1 ].Init( start, mSampleRate );
+    return true;
+}
+
+void USBLogic2BinaryFile::Rewind()
+{
+    const double start = std::min( mChannels[ 0 ].GetBeginTime(), mChannels[ 1 ].GetBeginTime() );
+    mChannels[ 0 ].Init( start, mSampleRate );
+    mChannels[ 1 ].Init( start, mSampleRate );
+}
@@ -0,0 +1,247 @@
+#ifndef USB_EDGE_IMPORT_H
+#define USB_EDGE_IMPORT_H
+
+#include <string>
+
+#include <AnalyzerChannelData.h>
+
+#include "USBMappedFile.h"
+
+// Converts the times of a capture to samples at the decoding sample rate: sample = time * mul / div.
+class USBTimeScale
+{
+  public:
+    USBTimeScale() : mMul( 1 ), mDiv( 1 ), mWideRemainder( false )
+    {
+    }
+
+    // a time unit of num / den seconds, to samples at sampleRate
+    void Init( U64 num, U64 den, U32 sampleRate );
+
+    U64 ToSample( U64 time ) const
+    {
+        const U64 rem = time % mDiv;
+        return time / mDiv * mMul + ( mWideRemainder ? MulDiv( rem, mMul, mDiv ) : rem * mMul / mDiv );
+    }
+
+  private:
+    // a * b / c for a < c, with a * b in 128 bits
+    static U64 MulDiv( U64 a, U64 b, U64 c );
+
+    U64 mMul;
+    U64 mDiv;
+    bool mWideRemainder; // true if remainder * mMul can overflow 64 bits
+};
+
+// A Value Change Dump from a simulator or another logic analyzer. Only the two wires of D+ and D- are
+// read: each has its own cursor through the mapped file, which compares the identifier of every scalar
+// change with its own and skips all the other changes up to the next blank, so the memory does not
+// grow with the file and the other signals cost next to nothing.
+class USBVcdFile
+{
+  public:
+    USBVcdFile();
+
+    // reads the header, the initial states and the last time stamp; the signals are found by their
+    // reference, or by their full name with the scopes, like top.usb.dp
+    bool Open( const char* path, const std::string& dpSignal, const std::string& dmSignal, U32 sampleRate );
+
+    const std::string& GetError() const
+    {
+        return mError;
+    }
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    U64 GetFirstSample() const
+    {
+        return mTimeScale.ToSample( mFirstTime );
+    }
+
+    U64 GetLastSample() const
+    {
+        return mTimeScale.ToSample( mLastTime );
+    }
+
+    // the edges read so far
+    U64 GetNumEdges() const
+    {
+        return mDP.GetNumEdges() + mDM.GetNumEdges();
+    }
+
+    void Rewind();
+
+    ChannelData* GetDP()
+    {
+        return &mDP;
+    }
+
+    ChannelData* GetDM()
+    {
+        return &mDM;
+    }
+
+  private:
+    class Wire : public ChannelData
+    {
+      public:
+        void Init( const char* pChanges, const char* pEnd, const std::string& id, BitState initialState, const USBVcdFile* pFile );
+
+        virtual BitState GetInitialBitState()
+        {
+            return mInitialState;
+        }
+
+        virtual U64 GetStartingSample()
+        {
+            return mpFile->GetFirstSample();
+        }
+
+        virtual bool GetNextEdge( U64& sample );
+
+        U64 GetNumEdges() const
+        {
+            return mNumEdges;
+        }
+
+      private:
+        const char* mpPos;
+        const char* mpEnd;
+        std::string mId;
+        BitState mInitialState;
+        BitState mState;
+        U64 mTime;
+        U64 mNumEdges;
+        const USBVcdFile* mpFile;
+    };
+
+    friend class Wire;
+
+    bool ParseHeader( const char*& pPos, const char* pEnd, const std::string& dpSignal, const std::string& dmSignal );
+
+    USBMappedFile mFile;
+    std::string mError;
+
+    U32 mSampleRate;
+    USBTimeScale mTimeScale;
+    U64 mFirstTime;
+    U64 mLastTime;
+
+    const char* mpChanges;
+    std::string mIds[ 2 ];
+    BitState mInitialStates[ 2 ];
+
+    Wire mDP;
+    Wire mDM;
+};
+
+// The binary export of Logic 2, with one file per channel: a "<SALEAE>" header, the initial state, the
+// begin and end time, and the times of the transitions in seconds as doubles. The files are mapped and
+// read in place.
+class USBLogic2BinaryFile
+{
+  public:
+    USBLogic2BinaryFile();
+
+    // the magic at the start of a file
+    static bool IsLogic2File( const char* pData, size_t size );
+
+    bool Open( const char* dpPath, const char* dmPath, U32 sampleRate );
+
+    const std::string& GetError() const
+    {
+        return mError;
+    }
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    U64 GetFirstSample() const
+    {
+        return 0;
+    }
+
+    U64 GetLastSample() const
+    {
+        return mLastSample;
+    }
+
+    U64 GetNumEdges() const
+    {
+        return mChannels[ 0 ].GetNumTransitions() + mChannels[ 1 ].GetNumTransitions();
+    }
+
+    void Rewind();
+
+    ChannelData* GetDP()
+    {
+        return &mChannels[ 0 ];
+    }
+
+    ChannelData* GetDM()
+    {
+        return &mChannels[ 1 ];
+    }
+
+  private:
+    class Channel : public ChannelData
+    {
+      public:
+        Channel();
+
+        bool Open( const char* path, std::string& error );
+        void Init( double beginTime, U32 sampleRate );
+
+        double GetBeginTime() const
+        {
+            return mBeginTime;
+        }
+
+        double GetEndTime() const
+        {
+            return mEndTime;
+        }
+
+        U64 GetNumTransitions() const
+        {
+            return mNumTransitions;
+        }
+
+        virtual BitState GetInitialBitState()
+        {
+            return mInitialState;
+        }
+
+        virtual U64 GetStartingSample()
+        {
+            return 0;
+        }
+
+        virtual bool GetNextEdge( U64& sample );
+
+      private:
+        USBMappedFile mFile;
+        BitState mInitialState;
+        double mBeginTime;
+        double mEndTime;
+        U64 mNumTransitions;
+        const char* mpTransitions;
+
+        U64 mNextTransition;
+        U64 mLastEdge;
+        double mStart; // the time of sample 0
+        double mRate;
+    };
+
+    std::string mError;
+    U32 mSampleRate;
+    U64 mLastSample;
+    Channel mChannels[ 2 ];
+};
+
+#endif // USB_EDGE_IMPORT_H
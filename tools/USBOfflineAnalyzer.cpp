@@ -0,0 +1,66 @@
+#include <stdio.h>
+
+#include "USBOfflineAnalyzer.h"
+
+static void DumpFrames( FILE* pFile, OfflineAnalyzer& analyzer, DisplayBase displayBase )
+{
+    USBAnalyzerResults* pResults = analyzer.GetResults();
+    Channel channel = analyzer.GetSettings().mDPChannel;
+
+    const U64 numFrames = pResults->GetNumFrames();
+    for( U64 fcnt = 0; fcnt < numFrames; ++fcnt )
+    {
+        Frame f = pResults->GetFrame( fcnt );
+
+        // the longest bubble text is the last one
+        const char** ppStrings;
+        U32 numStrings;
+        pResults->GetResultStrings( fcnt, channel, displayBase, &ppStrings, &numStrings );
+
+        fprintf( pFile, "%lld\t%lld\t%s\n", f.mStartingSampleInclusive, f.mEndingSampleInclusive,
+                 numStrings > 0 ? ppStrings[ numStrings - 1 ] : "" );
+    }
+}
+
+bool WriteOutput( OfflineAnalyzer& analyzer, OutputFormat format, const char* pPath, DisplayBase displayBase )
+{
+    if( format == OF_Frames )
+    {
+        FILE* pFile = pPath == NULL ? stdout : fopen( pPath, "w" );
+        if( pFile == NULL )
+            return false;
+
+        DumpFrames( pFile, analyzer, displayBase );
+
+        return pFile == stdout || fclose( pFile ) == 0;
+    }
+    else if( format != OF_None )
+    {
+        // the exports don't say if they could write the file
+        FILE* pFile = fopen( pPath, "a" );
+        if( pFile == NULL )
+            return false;
+
+        fclose( pFile );
+
+        const U32 exportTypes[] = { EXP_TEXT, EXP_USBMON_TEXT, EXP_USBMON_BINARY, EXP_COLUMNS };
+        analyzer.GetResults()->GenerateExportFile( pPath, displayBase, exportTypes[ format ] );
+    }
+
+    return true;
+}
+
+U64 CountFrames( OfflineAnalyzer& analyzer, USBFrameTypes type, USBFrameFlags flag )
+{
+    USBAnalyzerResults* pResults = analyzer.GetResults();
+
+    U64 count = 0;
+    const U64 numFrames = pResults->GetNumFrames();
+    for( U64 fcnt = 0; fcnt < numFrames; ++fcnt )
+    {
+        const Frame f = pResults->GetFrame( fcnt );
+        count += f.mType == type && ( flag == FF_None || f.mFlags == flag );
+    }
+
+    return count;
+}
@@ -0,0 +1,48 @@
+#ifndef USB_OFFLINE_ANALYZER_H
+#define USB_OFFLINE_ANALYZER_H
+
+#include <LogicPublicTypes.h>
+
+#include "USBAnalyzer.h"
+#include "USBAnalyzerSettings.h"
+#include "USBAnalyzerResults.h"
+
+// the analyzer, with its settings and results in reach
+class OfflineAnalyzer : public USBAnalyzer
+{
+  public:
+    USBAnalyzerSettings& GetSettings()
+    {
+        return mSettings;
+    }
+
+    USBAnalyzerResults* GetResults()
+    {
+        return mResults.get();
+    }
+
+    // frees the results of the last decode, so their frames can go to the next one
+    void ClearResults()
+    {
+        SetAnalyzerResults( NULL );
+        mResults.reset();
+    }
+};
+
+enum OutputFormat
+{
+    OF_Text,
+    OF_UsbmonText,
+    OF_UsbmonBinary,
+    OF_Columns,
+    OF_Frames,
+    OF_None,
+};
+
+// writes the frames or one of the exports of the last decode; the frames go to stdout without a path
+bool WriteOutput( OfflineAnalyzer& analyzer, OutputFormat format, const char* pPath, DisplayBase displayBase );
+
+// the number of frames of the last decode which are of the type, and have the flag if it isn't FF_None
+U64 CountFrames( OfflineAnalyzer& analyzer, USBFrameTypes type, USBFrameFlags flag = FF_None );
+
+#endif // USB_OFFLINE_ANALYZER_H
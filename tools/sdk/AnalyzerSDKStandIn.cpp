@@ -0,0 +1,1432 @@
+// The parts of the Logic AnalyzerSDK that the USB analyzer uses, so the analyzer can be built and run without
+// the SDK and the Logic app. The application side (the capture, the sample rate, the worker thread) is in
+// the StandIn hooks of AnalyzerStandIn.h.
+
+#include <AnalyzerStandIn.h>
+#include <AnalyzerHelpers.h>
+#include <AnalyzerChannelData.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//
+// Channel
+//
+
+Channel::Channel() : mDeviceId( 0 ), mChannelIndex( 0 ), mDataType( DIGITAL_CHANNEL )
+{
+}
+
+Channel::Channel( const Channel& channel )
+    : mDeviceId( channel.mDeviceId ), mChannelIndex( channel.mChannelIndex ), mDataType( channel.mDataType )
+{
+}
+
+Channel::Channel( U64 device_id, U32 channel_index, ChannelDataType data_type )
+    : mDeviceId( device_id ), mChannelIndex( channel_index ), mDataType( data_type )
+{
+}
+
+Channel::~Channel()
+{
+}
+
+Channel& Channel::operator=( const Channel& channel )
+{
+    mDeviceId = channel.mDeviceId;
+    mChannelIndex = channel.mChannelIndex;
+    mDataType = channel.mDataType;
+    return *this;
+}
+
+bool Channel::operator==( const Channel& channel ) const
+{
+    return mDeviceId == channel.mDeviceId && mChannelIndex == channel.mChannelIndex && mDataType == channel.mDataType;
+}
+
+bool Channel::operator!=( const Channel& channel ) const
+{
+    return !( *this == channel );
+}
+
+bool Channel::operator>( const Channel& channel ) const
+{
+    return channel < *this;
+}
+
+bool Channel::operator<( const Channel& channel ) const
+{
+    if( mDeviceId != channel.mDeviceId )
+        return mDeviceId < channel.mDeviceId;
+
+    if( mChannelIndex != channel.mChannelIndex )
+        return mChannelIndex < channel.mChannelIndex;
+
+    return mDataType < channel.mDataType;
+}
+
+//
+// Frame
+//
+
+Frame::Frame() : mStartingSampleInclusive( 0 ), mEndingSampleInclusive( 0 ), mData1( 0 ), mData2( 0 ), mType( 0 ), mFlags( 0 )
+{
+}
+
+Frame::Frame( const Frame& frame )
+    : mStartingSampleInclusive( frame.mStartingSampleInclusive ),
+      mEndingSampleInclusive( frame.mEndingSampleInclusive ),
+      mData1( frame.mData1 ),
+      mData2( frame.mData2 ),
+      mType( frame.mType ),
+      mFlags( frame.mFlags )
+{
+}
+
+Frame::~Frame()
+{
+}
+
+bool Frame::HasFlag( U8 flag )
+{
+    return ( mFlags & flag ) != 0;
+}
+
+//
+// AnalyzerResults
+//
+
+struct AnalyzerResultsData
+{
+    std::vector<Frame> mFrames;
+    U64 mCommittedFrames;
+    U64 mNumMarkers;
+    U64 mNumPackets;
+    std::vector<std::string> mResultStrings;
+    std::string mTabularText;
+};
+
+AnalyzerResults::AnalyzerResults() : mData( new AnalyzerResultsData )
+{
+    mData->mCommittedFrames = 0;
+    mData->mNumMarkers = 0;
+    mData->mNumPackets = 0;
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+    delete mData;
+}
+
+void AnalyzerResults::AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel )
+{
+    ++mData->mNumMarkers;
+}
+
+U64 AnalyzerResults::AddFrame( const Frame& frame )
+{
+    mData->mFrames.push_back( frame );
+    return mData->mFrames.size() - 1;
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+    return mData->mNumPackets++;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn( const Channel& channel )
+{
+}
+
+void AnalyzerResults::CommitResults()
+{
+    mData->mCommittedFrames = mData->mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumFrames()
+{
+    return mData->mCommittedFrames;
+}
+
+U64 AnalyzerResults::GetNumPackets()
+{
+    return mData->mNumPackets;
+}
+
+Frame AnalyzerResults::GetFrame( U64 frame_id )
+{
+    return mData->mFrames[ frame_id ];
+}
+
+U64 AnalyzerResults::GetNumMarkers( Channel& channel )
+{
+    return mData->mNumMarkers;
+}
+
+void AnalyzerResults::ClearResultStrings()
+{
+    mData->mResultStrings.clear();
+}
+
+void AnalyzerResults::AddResultString( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5,
+                                       const char* str6 )
+{
+    std::string str( str1 );
+    const char* rest[] = { str2, str3, str4, str5, str6 };
+    for( int i = 0; i < 5 && rest[ i ] != NULL; ++i )
+        str += rest[ i ];
+
+    mData->mResultStrings.push_back( str );
+}
+
+void AnalyzerResults::GetResultStrings( U64 frame_index, Channel& channel, DisplayBase display_base, const char*** result_string_array,
+                                        U32* num_strings )
+{
+    // valid until the next call on the same thread
+    static thread_local std::vector<const char*> pointers;
+
+    GenerateBubbleText( frame_index, channel, display_base );
+
+    pointers.clear();
+    for( size_t i = 0; i < mData->mResultStrings.size(); ++i )
+        pointers.push_back( mData->mResultStrings[ i ].c_str() );
+
+    *result_string_array = pointers.empty() ? NULL : &pointers.front();
+    *num_strings = U32( pointers.size() );
+}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel( U64 completed_frames, U64 total_frames )
+{
+    return false;
+}
+
+void AnalyzerResults::ClearTabularText()
+{
+    mData->mTabularText.clear();
+}
+
+void AnalyzerResults::AddTabularText( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5,
+                                      const char* str6 )
+{
+    if( !mData->mTabularText.empty() )
+        mData->mTabularText += '\n';
+
+    mData->mTabularText += str1;
+    const char* rest[] = { str2, str3, str4, str5, str6 };
+    for( int i = 0; i < 5 && rest[ i ] != NULL; ++i )
+        mData->mTabularText += rest[ i ];
+}
+
+const char* AnalyzerResults::GetTabularTextString()
+{
+    return mData->mTabularText.c_str();
+}
+
+//
+// AnalyzerChannelData
+//
+
+struct AnalyzerChannelDataData
+{
+    ChannelData* mSource;
+    U64 mSampleNumber;
+    BitState mBitState;
+
+    bool mHasNextEdge;
+    U64 mNextEdge;
+
+    bool mTrackMinimumPulse;
+    U64 mLastEdge;
+    U64 mMinimumPulse;
+
+    void FetchNextEdge()
+    {
+        mHasNextEdge = mSource->GetNextEdge( mNextEdge );
+    }
+
+    U64 NextEdgeOrThrow()
+    {
+        if( !mHasNextEdge )
+            throw StandIn::EndOfCapture();
+
+        return mNextEdge;
+    }
+
+    void CrossEdge()
+    {
+        if( mTrackMinimumPulse && mNextEdge - mLastEdge < mMinimumPulse )
+            mMinimumPulse = mNextEdge - mLastEdge;
+
+        mLastEdge = mNextEdge;
+        mBitState = Toggle( mBitState );
+        FetchNextEdge();
+    }
+};
+
+AnalyzerChannelData::AnalyzerChannelData( ChannelData* channel_data ) : mData( new AnalyzerChannelDataData )
+{
+    mData->mSource = channel_data;
+    mData->mSampleNumber = channel_data->GetStartingSample();
+    mData->mBitState = channel_data->GetInitialBitState();
+    mData->mTrackMinimumPulse = false;
+    mData->mLastEdge = mData->mSampleNumber;
+    mData->mMinimumPulse = ~0ull;
+    mData->FetchNextEdge();
+}
+
+AnalyzerChannelData::~AnalyzerChannelData()
+{
+    delete mData;
+}
+
+U64 AnalyzerChannelData::GetSampleNumber()
+{
+    return mData->mSampleNumber;
+}
+
+BitState AnalyzerChannelData::GetBitState()
+{
+    return mData->mBitState;
+}
+
+U32 AnalyzerChannelData::Advance( U32 num_samples )
+{
+    return AdvanceToAbsPosition( mData->mSampleNumber + num_samples );
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition( U64 sample_number )
+{
+    U32 transitions = 0;
+
+    // the application blocks until it has data up to the requested sample
+    while( mData->NextEdgeOrThrow() <= sample_number )
+    {
+        mData->CrossEdge();
+        ++transitions;
+    }
+
+    if( sample_number > mData->mSampleNumber )
+        mData->mSampleNumber = sample_number;
+
+    return transitions;
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+    mData->mSampleNumber = mData->NextEdgeOrThrow();
+    mData->CrossEdge();
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+    return mData->NextEdgeOrThrow();
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition( U32 num_samples )
+{
+    return mData->NextEdgeOrThrow() <= mData->mSampleNumber + num_samples;
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition( U64 sample_number )
+{
+    return mData->NextEdgeOrThrow() <= sample_number;
+}
+
+void AnalyzerChannelData::TrackMinimumPulseWidth()
+{
+    mData->mTrackMinimumPulse = true;
+}
+
+U64 AnalyzerChannelData::GetMinimumPulseWidthSoFar()
+{
+    return mData->mMinimumPulse;
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+    return mData->mHasNextEdge;
+}
+
+//
+// AnalyzerSettingInterface
+//
+
+AnalyzerSettingInterface::AnalyzerSettingInterface()
+{
+}
+
+AnalyzerSettingInterface::~AnalyzerSettingInterface()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterface::GetType()
+{
+    return INTERFACE_BASE;
+}
+
+const char* AnalyzerSettingInterface::GetToolTip()
+{
+    return mTooltip.c_str();
+}
+
+const char* AnalyzerSettingInterface::GetTitle()
+{
+    return mTitle.c_str();
+}
+
+bool AnalyzerSettingInterface::IsDisabled()
+{
+    return false;
+}
+
+void AnalyzerSettingInterface::SetTitleAndTooltip( const char* title, const char* tooltip )
+{
+    mTitle = title;
+    mTooltip = tooltip;
+}
+
+AnalyzerSettingInterfaceChannel::AnalyzerSettingInterfaceChannel() : mChannel( UNDEFINED_CHANNEL ), mNoneAllowed( false )
+{
+}
+
+AnalyzerSettingInterfaceChannel::~AnalyzerSettingInterfaceChannel()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceChannel::GetType()
+{
+    return INTERFACE_CHANNEL;
+}
+
+Channel AnalyzerSettingInterfaceChannel::GetChannel()
+{
+    return mChannel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetChannel( const Channel& channel )
+{
+    mChannel = channel;
+}
+
+bool AnalyzerSettingInterfaceChannel::GetSelectionOfNoneIsAllowed()
+{
+    return mNoneAllowed;
+}
+
+void AnalyzerSettingInterfaceChannel::SetSelectionOfNoneIsAllowed( bool is_allowed )
+{
+    mNoneAllowed = is_allowed;
+}
+
+AnalyzerSettingInterfaceNumberList::AnalyzerSettingInterfaceNumberList() : mNumber( 0 )
+{
+}
+
+AnalyzerSettingInterfaceNumberList::~AnalyzerSettingInterfaceNumberList()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceNumberList::GetType()
+{
+    return INTERFACE_NUMBER_LIST;
+}
+
+double AnalyzerSettingInterfaceNumberList::GetNumber()
+{
+    return mNumber;
+}
+
+void AnalyzerSettingInterfaceNumberList::SetNumber( double number )
+{
+    mNumber = number;
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxNumbersCount()
+{
+    return U32( mNumbers.size() );
+}
+
+double AnalyzerSettingInterfaceNumberList::GetListboxNumber( U32 index )
+{
+    return mNumbers[ index ];
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxStringsCount()
+{
+    return U32( mStrings.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxString( U32 index )
+{
+    return mStrings[ index ].c_str();
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxTooltipsCount()
+{
+    return U32( mTooltips.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxTooltip( U32 index )
+{
+    return mTooltips[ index ].c_str();
+}
+
+void AnalyzerSettingInterfaceNumberList::AddNumber( double number, const char* str, const char* tooltip )
+{
+    mNumbers.push_back( number );
+    mStrings.push_back( str );
+    mTooltips.push_back( tooltip );
+}
+
+void AnalyzerSettingInterfaceNumberList::ClearNumbers()
+{
+    mNumbers.clear();
+    mStrings.clear();
+    mTooltips.clear();
+}
+
+AnalyzerSettingInterfaceInteger::AnalyzerSettingInterfaceInteger() : mInteger( 0 ), mMin( 0 ), mMax( 0 )
+{
+}
+
+AnalyzerSettingInterfaceInteger::~AnalyzerSettingInterfaceInteger()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceInteger::GetType()
+{
+    return INTERFACE_INTEGER;
+}
+
+int AnalyzerSettingInterfaceInteger::GetInteger()
+{
+    return mInteger;
+}
+
+void AnalyzerSettingInterfaceInteger::SetInteger( int integer )
+{
+    mInteger = integer;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMax()
+{
+    return mMax;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMin()
+{
+    return mMin;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMax( int max )
+{
+    mMax = max;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMin( int min )
+{
+    mMin = min;
+}
+
+AnalyzerSettingInterfaceText::AnalyzerSettingInterfaceText() : mTextType( NormalText )
+{
+}
+
+AnalyzerSettingInterfaceText::~AnalyzerSettingInterfaceText()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceText::GetType()
+{
+    return INTERFACE_TEXT;
+}
+
+const char* AnalyzerSettingInterfaceText::GetText()
+{
+    return mText.c_str();
+}
+
+void AnalyzerSettingInterfaceText::SetText( const char* text )
+{
+    mText = text;
+}
+
+AnalyzerSettingInterfaceText::TextType AnalyzerSettingInterfaceText::GetTextType()
+{
+    return mTextType;
+}
+
+void AnalyzerSettingInterfaceText::SetTextType( TextType text_type )
+{
+    mTextType = text_type;
+}
+
+AnalyzerSettingInterfaceBool::AnalyzerSettingInterfaceBool() : mValue( false )
+{
+}
+
+AnalyzerSettingInterfaceBool::~AnalyzerSettingInterfaceBool()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceBool::GetType()
+{
+    return INTERFACE_BOOL;
+}
+
+bool AnalyzerSettingInterfaceBool::GetValue()
+{
+    return mValue;
+}
+
+void AnalyzerSettingInterfaceBool::SetValue( bool value )
+{
+    mValue = value;
+}
+
+const char* AnalyzerSettingInterfaceBool::GetCheckBoxText()
+{
+    return mCheckBoxText.c_str();
+}
+
+void AnalyzerSettingInterfaceBool::SetCheckBoxText( const char* text )
+{
+    mCheckBoxText = text;
+}
+
+//
+// AnalyzerSettings
+//
+
+struct AnalyzerSettingsData
+{
+    struct ChannelEntry
+    {
+        Channel mChannel;
+        std::string mLabel;
+        bool mIsUsed;
+    };
+
+    struct ExportOption
+    {
+        U32 mUserId;
+        std::string mMenuText;
+    };
+
+    struct ExportExtension
+    {
+        U32 mUserId;
+        std::string mDescription;
+        std::string mExtension;
+    };
+
+    std::vector<AnalyzerSettingInterface*> mInterfaces;
+    std::vector<ChannelEntry> mChannels;
+    std::vector<ExportOption> mExportOptions;
+    std::vector<ExportExtension> mExportExtensions;
+    std::string mErrorText;
+    std::string mReturnString;
+    bool mUseSystemDisplayBase;
+    DisplayBase mDisplayBase;
+};
+
+AnalyzerSettings::AnalyzerSettings() : mData( new AnalyzerSettingsData )
+{
+    mData->mUseSystemDisplayBase = true;
+    mData->mDisplayBase = Hexadecimal;
+}
+
+AnalyzerSettings::~AnalyzerSettings()
+{
+    delete mData;
+}
+
+U32 AnalyzerSettings::GetSettingsInterfacesCount()
+{
+    return U32( mData->mInterfaces.size() );
+}
+
+AnalyzerSettingInterface* AnalyzerSettings::GetSettingsInterface( U32 index )
+{
+    return mData->mInterfaces[ index ];
+}
+
+U32 AnalyzerSettings::GetFileExtensionCount()
+{
+    return U32( mData->mExportExtensions.size() );
+}
+
+void AnalyzerSettings::GetFileExtension( U32 index, char const** extension_type, char const** extension )
+{
+    *extension_type = mData->mExportExtensions[ index ].mDescription.c_str();
+    *extension = mData->mExportExtensions[ index ].mExtension.c_str();
+}
+
+U32 AnalyzerSettings::GetChannelsCount()
+{
+    return U32( mData->mChannels.size() );
+}
+
+Channel AnalyzerSettings::GetChannel( U32 index, char const** channel_label, bool* channel_is_used )
+{
+    *channel_label = mData->mChannels[ index ].mLabel.c_str();
+    *channel_is_used = mData->mChannels[ index ].mIsUsed;
+    return mData->mChannels[ index ].mChannel;
+}
+
+U32 AnalyzerSettings::GetExportOptionsCount()
+{
+    return U32( mData->mExportOptions.size() );
+}
+
+void AnalyzerSettings::GetExportOption( U32 index, U32* user_id, char const** menu_text )
+{
+    *user_id = mData->mExportOptions[ index ].mUserId;
+    *menu_text = mData->mExportOptions[ index ].mMenuText.c_str();
+}
+
+const char* AnalyzerSettings::GetSaveErrorMessage()
+{
+    return mData->mErrorText.c_str();
+}
+
+bool AnalyzerSettings::GetUseSystemDisplayBase()
+{
+    return mData->mUseSystemDisplayBase;
+}
+
+void AnalyzerSettings::SetUseSystemDisplayBase( bool use_system_display_base )
+{
+    mData->mUseSystemDisplayBase = use_system_display_base;
+}
+
+DisplayBase AnalyzerSettings::GetAnalyzerDisplayBase()
+{
+    return mData->mDisplayBase;
+}
+
+void AnalyzerSettings::SetAnalyzerDisplayBase( DisplayBase analyzer_display_base )
+{
+    mData->mDisplayBase = analyzer_display_base;
+}
+
+void AnalyzerSettings::ClearChannels()
+{
+    mData->mChannels.clear();
+}
+
+void AnalyzerSettings::AddChannel( Channel& channel, const char* channel_label, bool is_used )
+{
+    AnalyzerSettingsData::ChannelEntry entry;
+    entry.mChannel = channel;
+    entry.mLabel = channel_label;
+    entry.mIsUsed = is_used;
+    mData->mChannels.push_back( entry );
+}
+
+void AnalyzerSettings::SetErrorText( const char* error_text )
+{
+    mData->mErrorText = error_text;
+}
+
+void AnalyzerSettings::AddInterface( AnalyzerSettingInterface* analyzer_setting_interface )
+{
+    mData->mInterfaces.push_back( analyzer_setting_interface );
+}
+
+void AnalyzerSettings::AddExportOption( U32 user_id, const char* menu_text )
+{
+    AnalyzerSettingsData::ExportOption option;
+    option.mUserId = user_id;
+    option.mMenuText = menu_text;
+    mData->mExportOptions.push_back( option );
+}
+
+void AnalyzerSettings::AddExportExtension( U32 user_id, const char* extension_description, const char* extension )
+{
+    AnalyzerSettingsData::ExportExtension ext;
+    ext.mUserId = user_id;
+    ext.mDescription = extension_description;
+    ext.mExtension = extension;
+    mData->mExportExtensions.push_back( ext );
+}
+
+const char* AnalyzerSettings::SetReturnString( const char* str )
+{
+    mData->mReturnString = str;
+    return mData->mReturnString.c_str();
+}
+
+//
+// SimulationChannelDescriptor
+//
+
+struct SimulationChannelDescriptorData
+{
+    Channel mChannel;
+    U32 mSampleRate;
+    BitState mInitialBitState;
+    BitState mCurrentBitState;
+    U64 mCurrentSample;
+    std::vector<U64> mTransitions;
+};
+
+SimulationChannelDescriptor::SimulationChannelDescriptor() : mData( new SimulationChannelDescriptorData )
+{
+    mData->mSampleRate = 0;
+    mData->mInitialBitState = mData->mCurrentBitState = BIT_LOW;
+    mData->mCurrentSample = 0;
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor( const SimulationChannelDescriptor& other )
+    : mData( new SimulationChannelDescriptorData( *other.mData ) )
+{
+}
+
+SimulationChannelDescriptor::~SimulationChannelDescriptor()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor& SimulationChannelDescriptor::operator=( const SimulationChannelDescriptor& other )
+{
+    *mData = *other.mData;
+    return *this;
+}
+
+void SimulationChannelDescriptor::Transition()
+{
+    mData->mCurrentBitState = Toggle( mData->mCurrentBitState );
+    mData->mTransitions.push_back( mData->mCurrentSample );
+}
+
+void SimulationChannelDescriptor::TransitionIfNeeded( BitState bit_state )
+{
+    if( mData->mCurrentBitState != bit_state )
+        Transition();
+}
+
+void SimulationChannelDescriptor::Advance( U32 num_samples_to_advance )
+{
+    mData->mCurrentSample += num_samples_to_advance;
+}
+
+BitState SimulationChannelDescriptor::GetCurrentBitState()
+{
+    return mData->mCurrentBitState;
+}
+
+U64 SimulationChannelDescriptor::GetCurrentSampleNumber()
+{
+    return mData->mCurrentSample;
+}
+
+void SimulationChannelDescriptor::SetChannel( Channel& channel )
+{
+    mData->mChannel = channel;
+}
+
+void SimulationChannelDescriptor::SetSampleRate( U32 sample_rate_hz )
+{
+    mData->mSampleRate = sample_rate_hz;
+}
+
+void SimulationChannelDescriptor::SetInitialBitState( BitState intial_bit_state )
+{
+    mData->mInitialBitState = mData->mCurrentBitState = intial_bit_state;
+}
+
+Channel SimulationChannelDescriptor::GetChannel()
+{
+    return mData->mChannel;
+}
+
+U32 SimulationChannelDescriptor::GetSampleRate()
+{
+    return mData->mSampleRate;
+}
+
+BitState SimulationChannelDescriptor::GetInitialBitState()
+{
+    return mData->mInitialBitState;
+}
+
+void* SimulationChannelDescriptor::GetData()
+{
+    return mData;
+}
+
+const std::vector<U64>& SimulationChannelDescriptor::GetTransitions() const
+{
+    return mData->mTransitions;
+}
+
+struct SimulationChannelDescriptorGroupData
+{
+    // a std::vector would move the descriptors the analyzer holds pointers to
+    SimulationChannelDescriptor mChannels[ 32 ];
+    U32 mCount;
+};
+
+SimulationChannelDescriptorGroup::SimulationChannelDescriptorGroup() : mData( new SimulationChannelDescriptorGroupData )
+{
+    mData->mCount = 0;
+}
+
+SimulationChannelDescriptorGroup::~SimulationChannelDescriptorGroup()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::Add( Channel& channel, U32 sample_rate, BitState intial_bit_state )
+{
+    SimulationChannelDescriptor* desc = &mData->mChannels[ mData->mCount++ ];
+    desc->SetChannel( channel );
+    desc->SetSampleRate( sample_rate );
+    desc->SetInitialBitState( intial_bit_state );
+    return desc;
+}
+
+void SimulationChannelDescriptorGroup::AdvanceAll( U32 num_samples_to_advance )
+{
+    for( U32 i = 0; i < mData->mCount; ++i )
+        mData->mChannels[ i ].Advance( num_samples_to_advance );
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::GetArray()
+{
+    return mData->mChannels;
+}
+
+U32 SimulationChannelDescriptorGroup::GetCount()
+{
+    return mData->mCount;
+}
+
+//
+// AnalyzerHelpers
+//
+
+bool AnalyzerHelpers::IsEven( U64 value )
+{
+    return ( value & 1 ) == 0;
+}
+
+bool AnalyzerHelpers::IsOdd( U64 value )
+{
+    return ( value & 1 ) != 0;
+}
+
+U32 AnalyzerHelpers::GetOnesCount( U64 value )
+{
+    U32 count = 0;
+    for( ; value != 0; value &= value - 1 )
+        ++count;
+
+    return count;
+}
+
+U32 AnalyzerHelpers::Diff32( U32 a, U32 b )
+{
+    return a > b ? a - b : b - a;
+}
+
+void AnalyzerHelpers::GetNumberString( U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string,
+                                       U32 result_string_max_length )
+{
+    if( num_data_bits < 64 )
+        number &= ( 1ull << num_data_bits ) - 1;
+
+    if( display_base == Binary )
+    {
+        std::string str( "0b" );
+        for( S32 bit = S32( num_data_bits ) - 1; bit >= 0; --bit )
+            str += ( ( number >> bit ) & 1 ) ? '1' : '0';
+
+        snprintf( result_string, result_string_max_length, "%s", str.c_str() );
+    }
+    else if( display_base == Decimal )
+    {
+        snprintf( result_string, result_string_max_length, "%llu", number );
+    }
+    else if( display_base == Hexadecimal )
+    {
+        snprintf( result_string, result_string_max_length, "0x%0*llX", int( ( num_data_bits + 3 ) / 4 ), number );
+    }
+    else if( display_base == ASCII || display_base == AsciiHex )
+    {
+        char ascii[ 24 ];
+        if( number >= 0x20 && number < 0x7f )
+            snprintf( ascii, sizeof( ascii ), "%c", char( number ) );
+        else
+            snprintf( ascii, sizeof( ascii ), "'%llu'", number );
+
+        if( display_base == ASCII )
+            snprintf( result_string, result_string_max_length, "%s", ascii );
+        else
+            snprintf( result_string, result_string_max_length, "%s (0x%0*llX)", ascii, int( ( num_data_bits + 3 ) / 4 ), number );
+    }
+}
+
+void AnalyzerHelpers::GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string,
+                                     U32 result_string_max_length )
+{
+    S64 rel = S64( sample ) - S64( trigger_sample );
+
+    // enough decimals to resolve a single sample
+    int decimals = 0;
+    for( U64 scale = 1; scale < sample_rate_hz; scale *= 10 )
+        ++decimals;
+
+    S64 whole = rel / S64( sample_rate_hz );
+    S64 frac = rel % S64( sample_rate_hz );
+    const char* sign = "";
+    if( rel < 0 )
+    {
+        sign = "-";
+        whole = -whole;
+        frac = -frac;
+    }
+
+    U64 frac_digits = 1;
+    for( int i = 0; i < decimals; ++i )
+        frac_digits *= 10;
+
+    snprintf( result_string, result_string_max_length, "%s%lld.%0*llu", sign, whole, decimals,
+              U64( frac ) * frac_digits / sample_rate_hz );
+}
+
+void AnalyzerHelpers::Assert( const char* message )
+{
+    fprintf( stderr, "Assert: %s\n", message );
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample( U64 target_sample, U32 sample_rate, U32 simulation_sample_rate )
+{
+    if( sample_rate == simulation_sample_rate )
+        return target_sample;
+
+    return U64( double( target_sample ) * double( simulation_sample_rate ) / double( sample_rate ) );
+}
+
+bool AnalyzerHelpers::DoChannelsOverlap( const Channel* channel_array, U32 num_channels )
+{
+    for( U32 i = 0; i < num_channels; ++i )
+        for( U32 j = i + 1; j < num_channels; ++j )
+            if( channel_array[ i ] == channel_array[ j ] )
+                return true;
+
+    return false;
+}
+
+void AnalyzerHelpers::SaveFile( const char* file_name, const U8* data, U32 data_length, bool is_binary )
+{
+    void* f = StartFile( file_name, is_binary );
+    AppendToFile( data, data_length, f );
+    EndFile( f );
+}
+
+S64 AnalyzerHelpers::ConvertToSignedNumber( U64 number, U32 num_bits )
+{
+    if( num_bits == 0 || num_bits >= 64 )
+        return S64( number );
+
+    U64 sign = 1ull << ( num_bits - 1 );
+    if( number & sign )
+        return S64( number | ~( ( sign << 1 ) - 1 ) );
+
+    return S64( number );
+}
+
+void* AnalyzerHelpers::StartFile( const char* file_name, bool is_binary )
+{
+    return fopen( file_name, is_binary ? "wb" : "w" );
+}
+
+void AnalyzerHelpers::AppendToFile( const U8* data, U32 data_length, void* file )
+{
+    if( file != NULL )
+        fwrite( data, 1, data_length, ( FILE* )file );
+}
+
+void AnalyzerHelpers::EndFile( void* file )
+{
+    if( file != NULL )
+        fclose( ( FILE* )file );
+}
+
+//
+// ClockGenerator
+//
+
+struct ClockGeneratorData
+{
+    double mSampleRateHz;
+    double mHalfPeriodSamples;
+    double mError; // fractional samples carried between calls
+};
+
+ClockGenerator::ClockGenerator() : mData( new ClockGeneratorData )
+{
+    mData->mSampleRateHz = 1;
+    mData->mHalfPeriodSamples = 1;
+    mData->mError = 0;
+}
+
+ClockGenerator::~ClockGenerator()
+{
+    delete mData;
+}
+
+void ClockGenerator::Init( double target_frequency, U32 sample_rate_hz )
+{
+    mData->mSampleRateHz = sample_rate_hz;
+    mData->mHalfPeriodSamples = sample_rate_hz / ( target_frequency * 2.0 );
+    mData->mError = 0;
+}
+
+U32 ClockGenerator::AdvanceByHalfPeriod( double multiple )
+{
+    double samples = mData->mHalfPeriodSamples * multiple + mData->mError;
+    U32 whole = U32( samples + 0.5 );
+    mData->mError = samples - whole;
+    return whole;
+}
+
+U32 ClockGenerator::AdvanceByTimeS( double time_s )
+{
+    double samples = time_s * mData->mSampleRateHz + mData->mError;
+    if( samples < 0 )
+        samples = 0;
+
+    U32 whole = U32( samples + 0.5 );
+    mData->mError = samples - whole;
+    return whole;
+}
+
+//
+// SimpleArchive
+//
+
+struct SimpleArchiveData
+{
+    std::stringstream mStream;
+    std::string mString;
+    std::string mLastString;
+};
+
+SimpleArchive::SimpleArchive() : mData( new SimpleArchiveData )
+{
+}
+
+SimpleArchive::~SimpleArchive()
+{
+    delete mData;
+}
+
+void SimpleArchive::SetString( const char* archive_string )
+{
+    mData->mStream.str( archive_string );
+    mData->mStream.clear();
+}
+
+const char* SimpleArchive::GetString()
+{
+    mData->mString = mData->mStream.str();
+    return mData->mString.c_str();
+}
+
+bool SimpleArchive::operator<<( U64 data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( U32 data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( S64 data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( S32 data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( double data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( bool data )
+{
+    mData->mStream << ( data ? 1 : 0 ) << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( const char* data )
+{
+    mData->mStream << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( Channel& data )
+{
+    mData->mStream << data.mDeviceId << ' ' << data.mChannelIndex << ' ' << int( data.mDataType ) << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator>>( U64& data )
+{
+    return bool( mData->mStream >> data );
+}
+
+bool SimpleArchive::operator>>( U32& data )
+{
+    return bool( mData->mStream >> data );
+}
+
+bool SimpleArchive::operator>>( S64& data )
+{
+    return bool( mData->mStream >> data );
+}
+
+bool SimpleArchive::operator>>( S32& data )
+{
+    return bool( mData->mStream >> data );
+}
+
+bool SimpleArchive::operator>>( double& data )
+{
+    return bool( mData->mStream >> data );
+}
+
+bool SimpleArchive::operator>>( bool& data )
+{
+    int val = 0;
+    bool ok = bool( mData->mStream >> val );
+    data = val != 0;
+    return ok;
+}
+
+bool SimpleArchive::operator>>( char const** data )
+{
+    bool ok = bool( mData->mStream >> mData->mLastString );
+    *data = mData->mLastString.c_str();
+    return ok;
+}
+
+bool SimpleArchive::operator>>( Channel& data )
+{
+    int type = 0;
+    bool ok = bool( mData->mStream >> data.mDeviceId >> data.mChannelIndex >> type );
+    data.mDataType = ChannelDataType( type );
+    return ok;
+}
+
+//
+// Analyzer
+//
+
+struct AnalyzerData
+{
+    AnalyzerSettings* mSettings;
+    AnalyzerResults* mResults;
+    U32 mSampleRate;
+    U64 mTriggerSample;
+    U64 mProgress;
+    StandIn::ExitCheck mExitCheck;
+    void* mExitContext;
+
+    typedef std::map<Channel, AnalyzerChannelData*> ChannelMap;
+    ChannelMap mChannels;
+};
+
+Analyzer::Analyzer() : mData( new AnalyzerData )
+{
+    mData->mSettings = NULL;
+    mData->mResults = NULL;
+    mData->mSampleRate = 24000000;
+    mData->mTriggerSample = 0;
+    mData->mProgress = 0;
+    mData->mExitCheck = NULL;
+    mData->mExitContext = NULL;
+}
+
+Analyzer::~Analyzer()
+{
+    for( AnalyzerData::ChannelMap::iterator i( mData->mChannels.begin() ); i != mData->mChannels.end(); ++i )
+        delete i->second;
+
+    delete mData;
+}
+
+void Analyzer::SetAnalyzerSettings( AnalyzerSettings* settings )
+{
+    mData->mSettings = settings;
+}
+
+AnalyzerChannelData* Analyzer::GetAnalyzerChannelData( Channel& channel )
+{
+    AnalyzerData::ChannelMap::iterator srch( mData->mChannels.find( channel ) );
+    if( srch == mData->mChannels.end() )
+        return NULL;
+
+    return srch->second;
+}
+
+void Analyzer::ReportProgress( U64 sample_number )
+{
+    mData->mProgress = sample_number;
+}
+
+void Analyzer::SetAnalyzerResults( AnalyzerResults* results )
+{
+    mData->mResults = results;
+}
+
+U32 Analyzer::GetSimulationSampleRate()
+{
+    return mData->mSampleRate;
+}
+
+U32 Analyzer::GetSampleRate()
+{
+    return mData->mSampleRate;
+}
+
+U64 Analyzer::GetTriggerSample()
+{
+    return mData->mTriggerSample;
+}
+
+void Analyzer::CheckIfThreadShouldExit()
+{
+    if( mData->mExitCheck != NULL && mData->mExitCheck( mData->mExitContext ) )
+        throw StandIn::ThreadExit();
+}
+
+void Analyzer::SetupResults()
+{
+}
+
+void Analyzer::KillThread()
+{
+}
+
+AnalyzerSettings* Analyzer::GetAnalyzerSettings()
+{
+    return mData->mSettings;
+}
+
+AnalyzerResults* Analyzer::GetAnalyzerResults()
+{
+    return mData->mResults;
+}
+
+Analyzer2::Analyzer2()
+{
+}
+
+void Analyzer2::SetupResults()
+{
+}
+
+//
+// stand-in hooks
+//
+
+struct AnalyzerStandInAccess
+{
+    static AnalyzerData* Get( Analyzer* analyzer )
+    {
+        return analyzer->mData;
+    }
+
+    static AnalyzerResultsData* Get( AnalyzerResults* results )
+    {
+        return results->mData;
+    }
+};
+
+void StandIn::SetSampleRate( Analyzer* analyzer, U32 sample_rate_hz )
+{
+    AnalyzerStandInAccess::Get( analyzer )->mSampleRate = sample_rate_hz;
+}
+
+void StandIn::SetTriggerSample( Analyzer* analyzer, U64 trigger_sample )
+{
+    AnalyzerStandInAccess::Get( analyzer )->mTriggerSample = trigger_sample;
+}
+
+void StandIn::SetChannelData( Analyzer* analyzer, const Channel& channel, ChannelData* channel_data )
+{
+    AnalyzerData* data = AnalyzerStandInAccess::Get( analyzer );
+
+    AnalyzerData::ChannelMap::iterator srch( data->mChannels.find( channel ) );
+    if( srch != data->mChannels.end() )
+    {
+        delete srch->second;
+        data->mChannels.erase( srch );
+    }
+
+    if( channel_data != NULL )
+        data->mChannels[ channel ] = new AnalyzerChannelData( channel_data );
+}
+
+void StandIn::SetExitCheck( Analyzer* analyzer, ExitCheck check, void* context )
+{
+    AnalyzerStandInAccess::Get( analyzer )->mExitCheck = check;
+    AnalyzerStandInAccess::Get( analyzer )->mExitContext = context;
+}
+
+bool StandIn::RunWorkerThread( Analyzer* analyzer )
+{
+    analyzer->SetupResults();
+
+    bool completed = true;
+    try
+    {
+        analyzer->WorkerThread();
+    }
+    catch( const EndOfCapture& )
+    {
+    }
+    catch( const ThreadExit& )
+    {
+        completed = false;
+    }
+
+    AnalyzerResults* results = AnalyzerStandInAccess::Get( analyzer )->mResults;
+    if( results != NULL )
+        results->CommitResults();
+
+    return completed;
+}
+
+U64 StandIn::GetReportedProgress( Analyzer* analyzer )
+{
+    return AnalyzerStandInAccess::Get( analyzer )->mProgress;
+}
+
+U64 StandIn::GetNumMarkers( AnalyzerResults* results )
+{
+    return AnalyzerStandInAccess::Get( results )->mNumMarkers;
+}
@@ -0,0 +1,55 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettings.h"
+#include "AnalyzerResults.h"
+#include "SimulationChannelDescriptor.h"
+
+class AnalyzerChannelData;
+struct AnalyzerData;
+
+class LOGICAPI Analyzer
+{
+  public:
+    Analyzer();
+    virtual ~Analyzer() = 0;
+    virtual void WorkerThread() = 0;
+
+    virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate,
+                                        SimulationChannelDescriptor** simulation_channels ) = 0;
+    virtual U32 GetMinimumSampleRateHz() = 0;
+    virtual const char* GetAnalyzerName() const = 0;
+    virtual bool NeedsRerun() = 0;
+
+  public:
+    void SetAnalyzerSettings( AnalyzerSettings* settings );
+    AnalyzerChannelData* GetAnalyzerChannelData( Channel& channel );
+    void ReportProgress( U64 sample_number );
+    void SetAnalyzerResults( AnalyzerResults* results );
+    U32 GetSimulationSampleRate();
+    U32 GetSampleRate();
+    U64 GetTriggerSample();
+
+    void CheckIfThreadShouldExit();
+
+    virtual void SetupResults();
+
+    void KillThread();
+
+    AnalyzerSettings* GetAnalyzerSettings();
+    AnalyzerResults* GetAnalyzerResults();
+
+  protected:
+    friend struct AnalyzerStandInAccess;
+    struct AnalyzerData* mData;
+};
+
+class LOGICAPI Analyzer2 : public Analyzer
+{
+  public:
+    Analyzer2();
+    virtual void SetupResults();
+};
+
+#endif // ANALYZER_H
@@ -0,0 +1,54 @@
+#ifndef ANALYZERCHANNELDATA
+#define ANALYZERCHANNELDATA
+
+#include "LogicPublicTypes.h"
+
+// In the stand-in, a ChannelData is any source of rising/falling edges for one digital channel.
+class ChannelData
+{
+  public:
+    virtual ~ChannelData()
+    {
+    }
+
+    virtual BitState GetInitialBitState() = 0;
+    virtual U64 GetStartingSample() = 0;
+
+    // returns false when there are no more edges in the capture
+    virtual bool GetNextEdge( U64& sample ) = 0;
+};
+
+struct AnalyzerChannelDataData;
+
+class LOGICAPI AnalyzerChannelData
+{
+  public:
+    AnalyzerChannelData( ChannelData* channel_data );
+    ~AnalyzerChannelData();
+
+    // State
+    U64 GetSampleNumber();
+    BitState GetBitState();
+
+    // Basic
+    U32 Advance( U32 num_samples );
+    U32 AdvanceToAbsPosition( U64 sample_number );
+    void AdvanceToNextEdge();
+
+    // Fancier
+    U64 GetSampleOfNextEdge();
+    bool WouldAdvancingCauseTransition( U32 num_samples );
+    bool WouldAdvancingToAbsPositionCauseTransition( U64 sample_number );
+
+    // minimum pulse tracking
+    void TrackMinimumPulseWidth();
+    U64 GetMinimumPulseWidthSoFar();
+
+    // Fancier, part II
+    bool DoMoreTransitionsExistInCurrentData();
+
+  protected:
+    struct AnalyzerChannelDataData* mData;
+};
+
+#endif // ANALYZERCHANNELDATA
@@ -0,0 +1,96 @@
+#ifndef ANALYZERRESULTS
+#define ANALYZERRESULTS
+
+#include "LogicPublicTypes.h"
+
+#include <string>
+#include <vector>
+
+#define DISPLAY_AS_ERROR_FLAG ( 1 << 7 )
+#define DISPLAY_AS_WARNING_FLAG ( 1 << 6 )
+
+#define INVALID_RESULT_INDEX 0xFFFFFFFFFFFFFFFFull
+
+class LOGICAPI Frame
+{
+  public:
+    Frame();
+    Frame( const Frame& frame );
+    ~Frame();
+
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U64 mData1;
+    U64 mData2;
+    U8 mType;
+    U8 mFlags;
+
+    bool HasFlag( U8 flag );
+};
+
+struct AnalyzerResultsData;
+
+class LOGICAPI AnalyzerResults
+{
+  public:
+    enum MarkerType
+    {
+        Dot,
+        ErrorDot,
+        Square,
+        ErrorSquare,
+        UpArrow,
+        DownArrow,
+        X,
+        ErrorX,
+        Start,
+        Stop,
+        One,
+        Zero
+    };
+
+    AnalyzerResults();
+    virtual ~AnalyzerResults();
+
+    virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base ) = 0;
+    virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id ) = 0;
+    virtual void GenerateFrameTabularText( U64 frame_index, DisplayBase display_base ) = 0;
+    virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) = 0;
+    virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) = 0;
+
+  public: // adding/setting data
+    void AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel );
+    U64 AddFrame( const Frame& frame );
+    U64 CommitPacketAndStartNewPacket();
+    void CancelPacketAndStartNewPacket();
+    void AddChannelBubblesWillAppearOn( const Channel& channel );
+    void CommitResults();
+
+  public: // data access
+    U64 GetNumFrames();
+    U64 GetNumPackets();
+    Frame GetFrame( U64 frame_id );
+    U64 GetNumMarkers( Channel& channel );
+
+  public: // text results setting and access
+    void ClearResultStrings();
+    void AddResultString( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL,
+                          const char* str5 = NULL, const char* str6 = NULL );
+    void GetResultStrings( U64 frame_index, Channel& channel, DisplayBase display_base, const char*** result_string_array,
+                           U32* num_strings );
+
+  protected: // use these when exporting data.
+    bool UpdateExportProgressAndCheckForCancel( U64 completed_frames, U64 total_frames );
+
+  public: // tabular text
+    void ClearTabularText();
+    void AddTabularText( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL,
+                         const char* str5 = NULL, const char* str6 = NULL );
+    const char* GetTabularTextString();
+
+  protected:
+    friend struct AnalyzerStandInAccess;
+    struct AnalyzerResultsData* mData;
+};
+
+#endif // ANALYZERRESULTS
@@ -0,0 +1,54 @@
+#ifndef ANALYZER_SETTINGS
+#define ANALYZER_SETTINGS
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettingInterface.h"
+
+#include <string>
+#include <vector>
+
+class LOGICAPI AnalyzerSettings
+{
+  public:
+    AnalyzerSettings();
+    virtual ~AnalyzerSettings();
+
+    virtual bool SetSettingsFromInterfaces() = 0;
+    virtual void LoadSettings( const char* settings ) = 0;
+    virtual const char* SaveSettings() = 0;
+
+    U32 GetSettingsInterfacesCount();
+    AnalyzerSettingInterface* GetSettingsInterface( U32 index );
+
+    U32 GetFileExtensionCount();
+    void GetFileExtension( U32 index, char const** extension_type, char const** extension );
+
+    U32 GetChannelsCount();
+    Channel GetChannel( U32 index, char const** channel_label, bool* channel_is_used );
+
+    U32 GetExportOptionsCount();
+    void GetExportOption( U32 index, U32* user_id, char const** menu_text );
+
+    const char* GetSaveErrorMessage();
+
+    bool GetUseSystemDisplayBase();
+    void SetUseSystemDisplayBase( bool use_system_display_base );
+    DisplayBase GetAnalyzerDisplayBase();
+    void SetAnalyzerDisplayBase( DisplayBase analyzer_display_base );
+
+  protected:
+    void ClearChannels();
+    void AddChannel( Channel& channel, const char* channel_label, bool is_used );
+
+    void SetErrorText( const char* error_text );
+    void AddInterface( AnalyzerSettingInterface* analyzer_setting_interface );
+
+    void AddExportOption( U32 user_id, const char* menu_text );
+    void AddExportExtension( U32 user_id, const char* extension_description, const char* extension );
+
+    const char* SetReturnString( const char* str );
+
+    struct AnalyzerSettingsData* mData;
+};
+
+#endif // ANALYZER_SETTINGS
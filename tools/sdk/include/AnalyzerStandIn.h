@@ -0,0 +1,42 @@
+#ifndef ANALYZER_STAND_IN_H
+#define ANALYZER_STAND_IN_H
+
+#include "Analyzer.h"
+#include "AnalyzerChannelData.h"
+
+// Hooks that only exist in the stand-in: they take the place of the Logic application
+// which would normally provide the capture, the sample rate and drive the worker thread.
+namespace StandIn
+{
+    // thrown by AnalyzerChannelData when the analyzer asks for an edge past the end of the capture.
+    // The Logic application would block the worker thread forever at this point.
+    struct EndOfCapture
+    {
+    };
+
+    // thrown by Analyzer::CheckIfThreadShouldExit() when the exit check says so, which is how the Logic
+    // application ends a worker thread too
+    struct ThreadExit
+    {
+    };
+
+    // called by CheckIfThreadShouldExit(), which the analyzer calls as it goes; true stops the worker thread
+    typedef bool ( *ExitCheck )( void* context );
+
+    void SetSampleRate( Analyzer* analyzer, U32 sample_rate_hz );
+    void SetTriggerSample( Analyzer* analyzer, U64 trigger_sample );
+    void SetChannelData( Analyzer* analyzer, const Channel& channel, ChannelData* channel_data );
+
+    // NULL for none
+    void SetExitCheck( Analyzer* analyzer, ExitCheck check, void* context );
+
+    // runs SetupResults() and WorkerThread() until the capture is exhausted; false if the exit check stopped it
+    bool RunWorkerThread( Analyzer* analyzer );
+
+    // the furthest sample passed to ReportProgress()
+    U64 GetReportedProgress( Analyzer* analyzer );
+
+    U64 GetNumMarkers( AnalyzerResults* results );
+}
+
+#endif // ANALYZER_STAND_IN_H
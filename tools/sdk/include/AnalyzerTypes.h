@@ -0,0 +1,6 @@
+#ifndef ANALYZER_TYPES
+#define ANALYZER_TYPES
+
+#include "LogicPublicTypes.h"
+
+#endif // ANALYZER_TYPES
@@ -0,0 +1,80 @@
+#ifndef LOGICPUBLICTYPES
+#define LOGICPUBLICTYPES
+
+#ifndef WIN32
+#define __cdecl
+#define __stdcall
+#define __fastcall
+#endif
+
+#ifndef LOGICAPI
+#define LOGICAPI
+#endif
+
+#ifndef ANALYZER_EXPORT
+#if defined( WIN32 )
+#define ANALYZER_EXPORT __declspec( dllexport )
+#else
+#define ANALYZER_EXPORT __attribute__( ( visibility( "default" ) ) )
+#endif
+#endif
+
+#include <memory>
+#include <cstring>
+
+typedef signed char S8;
+typedef short S16;
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+enum DisplayBase
+{
+    Binary,
+    Decimal,
+    Hexadecimal,
+    ASCII,
+    AsciiHex
+};
+
+enum BitState
+{
+    BIT_LOW,
+    BIT_HIGH
+};
+
+#define Toggle( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+#define Invert( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+
+enum ChannelDataType
+{
+    ANALOG_CHANNEL,
+    DIGITAL_CHANNEL
+};
+
+class LOGICAPI Channel
+{
+  public:
+    Channel();
+    Channel( const Channel& channel );
+    Channel( U64 device_id, U32 channel_index, ChannelDataType data_type );
+    ~Channel();
+
+    Channel& operator=( const Channel& channel );
+    bool operator==( const Channel& channel ) const;
+    bool operator!=( const Channel& channel ) const;
+    bool operator>( const Channel& channel ) const;
+    bool operator<( const Channel& channel ) const;
+
+    U64 mDeviceId;
+    U32 mChannelIndex;
+    ChannelDataType mDataType;
+};
+
+#define UNDEFINED_CHANNEL Channel( 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF, DIGITAL_CHANNEL )
+
+#endif // LOGICPUBLICTYPES
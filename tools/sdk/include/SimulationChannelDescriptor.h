@@ -0,0 +1,62 @@
+#ifndef SIMULATION_CHANNEL_DESCRIPTOR
+#define SIMULATION_CHANNEL_DESCRIPTOR
+
+#include "LogicPublicTypes.h"
+
+#include <vector>
+
+struct SimulationChannelDescriptorData;
+
+class LOGICAPI SimulationChannelDescriptor
+{
+  public:
+    void Transition();
+    void TransitionIfNeeded( BitState bit_state );
+    void Advance( U32 num_samples_to_advance );
+
+    BitState GetCurrentBitState();
+    U64 GetCurrentSampleNumber();
+
+  public:
+    SimulationChannelDescriptor();
+    SimulationChannelDescriptor( const SimulationChannelDescriptor& other );
+    ~SimulationChannelDescriptor();
+    SimulationChannelDescriptor& operator=( const SimulationChannelDescriptor& other );
+
+    void SetChannel( Channel& channel );
+    void SetSampleRate( U32 sample_rate_hz );
+    void SetInitialBitState( BitState intial_bit_state );
+
+    Channel GetChannel();
+    U32 GetSampleRate();
+    BitState GetInitialBitState();
+    void* GetData();
+
+    // stand-in only: the sample numbers of all transitions generated so far
+    const std::vector<U64>& GetTransitions() const;
+
+  protected:
+    struct SimulationChannelDescriptorData* mData;
+};
+
+struct SimulationChannelDescriptorGroupData;
+
+class LOGICAPI SimulationChannelDescriptorGroup
+{
+  public:
+    SimulationChannelDescriptorGroup();
+    ~SimulationChannelDescriptorGroup();
+
+    SimulationChannelDescriptor* Add( Channel& channel, U32 sample_rate, BitState intial_bit_state );
+
+    void AdvanceAll( U32 num_samples_to_advance );
+
+  public:
+    SimulationChannelDescriptor* GetArray();
+    U32 GetCount();
+
+  protected:
+    struct SimulationChannelDescriptorGroupData* mData;
+};
+
+#endif // SIMULATION_CHANNEL_DESCRIPTOR